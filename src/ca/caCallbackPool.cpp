@@ -0,0 +1,177 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <deque>
+#include <sstream>
+
+#include <epicsVersion.h>
+#include <epicsThread.h>
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+#include <epicsEvent.h>
+#include <pv/logger.h>
+#include <pv/pvaVersion.h>
+#include <pv/configuration.h>
+
+#define epicsExportSharedSymbols
+#include "caCallbackPool.h"
+
+namespace epics {
+namespace pvAccess {
+namespace ca {
+
+typedef epicsGuard<epicsMutex> Guard;
+typedef epicsGuardRelease<epicsMutex> UnGuard;
+
+class CACallbackPool::Worker :
+    public epicsThreadRunable,
+    public std::tr1::enable_shared_from_this<Worker>
+{
+public:
+    explicit Worker(size_t index)
+        :isStop(false)
+    {
+        std::ostringstream strm;
+        strm<<"caCallback"<<index;
+        name = strm.str();
+    }
+    virtual ~Worker() {}
+
+    void start()
+    {
+        // kept by run() in case the pool is destroyed by a callback
+        self = shared_from_this();
+        thread.reset(new epicsThread(*this, name.c_str(),
+                                     epicsThreadGetStackSize(epicsThreadStackBig),
+                                     epicsThreadPriorityLow));
+        thread->start();
+    }
+
+    void stop()
+    {
+        {
+            Guard G(mutex);
+            if(isStop) return;
+            isStop = true;
+        }
+        wakeup.signal();
+        // can't join from a callback.  run() will exit after the callback returns.
+        if(thread && !thread->isCurrentThread())
+            thread->exitWait();
+    }
+
+    void notify(CACallback::shared_pointer const & callback)
+    {
+        bool wake;
+        {
+            Guard G(mutex);
+            if(isStop || callback->isOnQueue) return;
+            callback->isOnQueue = true;
+            wake = queue.empty();
+            queue.push_back(callback);
+        }
+        if(wake)
+            wakeup.signal();
+    }
+
+    virtual void run()
+    {
+        std::tr1::shared_ptr<Worker> keep;
+        Guard G(mutex);
+        keep.swap(self);
+
+        while(true) {
+            if(queue.empty()) {
+                if(isStop) break;
+                UnGuard U(G);
+                wakeup.wait();
+                continue;
+            }
+
+            CACallbackClient::shared_pointer client;
+            {
+                CACallback::shared_pointer callback;
+                callback.swap(queue.front());
+                queue.pop_front();
+                callback->isOnQueue = false;
+                client = callback->client.lock();
+            }
+            if(!client) continue;
+
+            UnGuard U(G);
+            try {
+                client->notifyClient();
+            } catch(std::exception& e) {
+                LOG(logLevelError, "Unhandled exception from CA callback: %s", e.what());
+            }
+            // release client without our lock
+            client.reset();
+        }
+    }
+
+private:
+    std::string name;
+    std::tr1::shared_ptr<epicsThread> thread;
+    std::tr1::shared_ptr<Worker> self;
+
+    epicsMutex mutex;
+    epicsEvent wakeup;
+    bool isStop;
+    std::deque<CACallback::shared_pointer> queue;
+};
+
+size_t CACallbackPool::defaultWorkers()
+{
+    int ncpus = 1;
+#if defined(EPICS_VERSION_INT) && EPICS_VERSION_INT>=VERSION_INT(3,15,0,2)
+    ncpus = epicsThreadGetCPUs();
+#endif
+    if(ncpus > 4)
+        ncpus = 4;
+
+    Configuration::const_shared_pointer env(ConfigurationBuilder().push_env().build());
+    epics::pvData::int32 nworkers = env->getPropertyAsInteger("EPICS_CA_PROVIDER_WORKERS", ncpus);
+    return nworkers > 0 ? size_t(nworkers) : 1u;
+}
+
+CACallbackPool::CACallbackPool(size_t nworkers)
+{
+    if(nworkers==0u)
+        nworkers = 1u;
+    workers.reserve(nworkers);
+    for(size_t i=0; i<nworkers; i++)
+        workers.push_back(std::tr1::shared_ptr<Worker>(new Worker(i)));
+}
+
+CACallbackPool::~CACallbackPool()
+{
+    stop();
+}
+
+void CACallbackPool::start()
+{
+    for(size_t i=0; i<workers.size(); i++)
+        workers[i]->start();
+}
+
+void CACallbackPool::stop()
+{
+    for(size_t i=0; i<workers.size(); i++)
+        workers[i]->stop();
+}
+
+void CACallbackPool::notify(CACallback::shared_pointer const & callback)
+{
+    // Fibonacci hash of the key.  Allocations share their low bits, so use the high bits of the product.
+    size_t idx = 0u;
+    if(workers.size()>1u) {
+        epicsUInt32 hash = epicsUInt32(size_t(callback->key)) * 2654435769u;
+        idx = (hash>>16) % workers.size();
+    }
+    workers[idx]->notify(callback);
+}
+
+}}}
@@ -0,0 +1,88 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef CaCallbackPool_H
+#define CaCallbackPool_H
+#include <vector>
+#include <shareLib.h>
+#include <pv/sharedPtr.h>
+#include <pv/noDefaultMethods.h>
+
+namespace epics {
+namespace pvAccess {
+namespace ca {
+
+/** Notified on a CACallbackPool worker, rather than on a CA client library thread.
+ */
+class epicsShareClass CACallbackClient
+{
+public:
+    POINTER_DEFINITIONS(CACallbackClient);
+    virtual ~CACallbackClient() {}
+    virtual void notifyClient() = 0;
+};
+
+/** A call to CACallbackClient::notifyClient() which is queued at most once
+ *  until the call begins.
+ */
+class epicsShareClass CACallback
+{
+public:
+    POINTER_DEFINITIONS(CACallback);
+    /** @param client called while it is still referenced elsewhere.
+     *  @param key callbacks with the same key are called in order, by the same worker.
+     *         eg. the CAChannel.
+     */
+    CACallback(CACallbackClient::shared_pointer const & client, const void *key)
+        :client(client), key(key), isOnQueue(false)
+    {}
+private:
+    friend class CACallbackPool;
+    const CACallbackClient::weak_pointer client;
+    const void * const key;
+    bool isOnQueue;
+};
+
+/** Worker threads which call CACallbackClient::notifyClient()
+ *  for all channels of a CAChannelProvider.
+ *
+ * Each key is assigned to one worker, so callbacks of one channel are never concurrent,
+ * and are made in the order queued.  Different channels are spread across workers.
+ */
+class epicsShareClass CACallbackPool
+{
+public:
+    POINTER_DEFINITIONS(CACallbackPool);
+
+    /** Number of workers from $EPICS_CA_PROVIDER_WORKERS.
+     *  Default is the number of CPUs, at most 4.
+     */
+    static size_t defaultWorkers();
+
+    //! @param nworkers number of threads, at least 1.
+    explicit CACallbackPool(size_t nworkers);
+    //! Calls stop()
+    ~CACallbackPool();
+
+    size_t size() const { return workers.size(); }
+
+    void start();
+    /** Complete callbacks already queued, and then join workers.
+     *  Later callbacks are ignored.
+     */
+    void stop();
+
+    void notify(CACallback::shared_pointer const & callback);
+
+private:
+    class Worker;
+    std::vector<std::tr1::shared_ptr<Worker> > workers;
+
+    EPICS_NOT_COPYABLE(CACallbackPool)
+};
+
+}}}
+
+#endif  /* CaCallbackPool_H */
@@ -10,13 +10,10 @@
 #include <pv/standardField.h>
 #include <pv/logger.h>
 #include <pv/pvAccess.h>
-#include "channelConnectThread.h"
-#include "monitorEventThread.h"
-#include "getDoneThread.h"
-#include "putDoneThread.h"
 
 #define epicsExportSharedSymbols
 #include "caChannel.h"
+#include "caMonitorQueue.h"
 
 using namespace epics::pvData;
 using std::string;
@@ -67,7 +64,7 @@ void CAChannel::connect(bool isConnected)
          Lock lock(requestsMutex);
          channelConnected = isConnected;
     }
-    channelConnectThread->channelConnected(notifyChannelRequester);
+    callbackPool->notify(connectCallback);
 }
 
 void CAChannel::notifyClient()
@@ -125,7 +122,7 @@ CAChannel::CAChannel(std::string const & channelName,
     channelID(0),
     channelCreated(false),
     channelConnected(false),
-    channelConnectThread(ChannelConnectThread::get())
+    callbackPool(channelProvider->getCallbackPool())
 {
     if(DEBUG_LEVEL>0) {
           cout<< "CAChannel::CAChannel " << channelName << endl;
@@ -139,8 +136,7 @@ void CAChannel::activate(short priority)
     if(DEBUG_LEVEL>0) {
           cout<< "CAChannel::activate " << channelName << endl;
     }
-    notifyChannelRequester = NotifyChannelRequesterPtr(new NotifyChannelRequester());
-    notifyChannelRequester->setChannel(shared_from_this());
+    connectCallback = CACallback::shared_pointer(new CACallback(shared_from_this(), this));
     attachContext();
     int result = ca_create_channel(channelName.c_str(),
          ca_connection_handler,
@@ -452,7 +448,7 @@ CAChannelGet::CAChannelGet(CAChannel::shared_pointer const & channel,
     channelGetRequester(channelGetRequester),
     pvRequest(pvRequest),
     getStatus(Status::Ok),
-    getDoneThread(GetDoneThread::get())
+    callbackPool(channel->getCallbackPool())
 {}
 
 CAChannelGet::~CAChannelGet()
@@ -473,8 +469,7 @@ void CAChannelGet::activate()
     dbdToPv->getChoices(channel);
     pvStructure = dbdToPv->createPVStructure();
     bitSet = BitSetPtr(new BitSet(pvStructure->getStructure()->getNumberFields()));
-    notifyGetRequester = NotifyGetRequesterPtr(new NotifyGetRequester());
-    notifyGetRequester->setChannelGet(shared_from_this());
+    getCallback = CACallback::shared_pointer(new CACallback(shared_from_this(), channel.get()));
     EXCEPTION_GUARD(getRequester->channelGetConnect(Status::Ok, shared_from_this(),
                     pvStructure->getStructure()));
 }
@@ -503,7 +498,7 @@ void CAChannelGet::getDone(struct event_handler_args &args)
     ChannelGetRequester::shared_pointer getRequester(channelGetRequester.lock());
     if(!getRequester) return;
     getStatus = dbdToPv->getFromDBD(pvStructure,bitSet,args);
-    getDoneThread->getDone(notifyGetRequester);
+    callbackPool->notify(getCallback);
 }
 
 void CAChannelGet::notifyClient()
@@ -576,7 +571,7 @@ CAChannelPut::CAChannelPut(CAChannel::shared_pointer const & channel,
     isPut(false),
     getStatus(Status::Ok),
     putStatus(Status::Ok),
-    putDoneThread(PutDoneThread::get())
+    callbackPool(channel->getCallbackPool())
 {}
 
 CAChannelPut::~CAChannelPut()
@@ -603,8 +598,7 @@ void CAChannelPut::activate()
         std::string val = pvString->get();
         if(val.compare("true")==0) block = true;
     }
-    notifyPutRequester = NotifyPutRequesterPtr(new NotifyPutRequester());
-    notifyPutRequester->setChannelPut(shared_from_this());
+    putCallback = CACallback::shared_pointer(new CACallback(shared_from_this(), channel.get()));
     EXCEPTION_GUARD(putRequester->channelPutConnect(Status::Ok, shared_from_this(),
                     pvStructure->getStructure()));
 }
@@ -663,7 +657,7 @@ void CAChannelPut::putDone(struct event_handler_args &args)
     } else {
         putStatus = Status::Ok;
     }
-    putDoneThread->putDone(notifyPutRequester);
+    callbackPool->notify(putCallback);
 }
 
 void CAChannelPut::getDone(struct event_handler_args &args)
@@ -675,7 +669,7 @@ void CAChannelPut::getDone(struct event_handler_args &args)
     ChannelPutRequester::shared_pointer putRequester(channelPutRequester.lock());
     if(!putRequester) return;
     getStatus = dbdToPv->getFromDBD(pvStructure,bitSet,args);
-    putDoneThread->putDone(notifyPutRequester);
+    callbackPool->notify(putCallback);
 }
 
 void CAChannelPut::notifyClient()
@@ -744,74 +738,6 @@ static void ca_subscription_handler(struct event_handler_args args)
     channelMonitor->subscriptionEvent(args);
 }
 
-class CACMonitorQueue :
-    public std::tr1::enable_shared_from_this<CACMonitorQueue>
-{
-public:
-    POINTER_DEFINITIONS(CACMonitorQueue);
-private:
-    size_t queueSize;
-    bool isStarted;
-    Mutex mutex;
-    
-    std::queue<MonitorElementPtr> monitorElementQueue;
-public:
-    CACMonitorQueue(
-        int32 queueSize)
-     : queueSize(queueSize),
-       isStarted(false)
-     {}
-     ~CACMonitorQueue()
-     {
-     } 
-     void start()
-     {
-         Lock guard(mutex);
-         while(!monitorElementQueue.empty()) monitorElementQueue.pop();
-         isStarted = true;
-     }
-     void stop()
-     {
-         Lock guard(mutex);
-         while(!monitorElementQueue.empty()) monitorElementQueue.pop();
-         isStarted = false;
-     }
-
-     bool event(
-          const PVStructurePtr &pvStructure,
-          const MonitorElementPtr & activeElement)
-     {
-         Lock guard(mutex);
-         if(!isStarted) return false;
-         if(monitorElementQueue.size()==queueSize) return false;
-         PVStructure::shared_pointer pvs = 
-              getPVDataCreate()->createPVStructure(pvStructure);
-         MonitorElementPtr monitorElement(new MonitorElement(pvs));
-         *(monitorElement->changedBitSet) = *(activeElement->changedBitSet);
-         *(monitorElement->overrunBitSet) = *(activeElement->overrunBitSet);
-         monitorElementQueue.push(monitorElement);
-         return true;
-     }
-     MonitorElementPtr poll()
-     {
-          Lock guard(mutex);
-          if(!isStarted) return MonitorElementPtr();
-          if(monitorElementQueue.empty()) return MonitorElementPtr();
-          MonitorElementPtr retval = monitorElementQueue.front();
-          return retval;
-     }
-     void release(MonitorElementPtr const & monitorElement)
-     {
-         Lock guard(mutex);
-         if(!isStarted) return;
-         if(monitorElementQueue.empty()) {
-              string mess("CAChannelMonitor::release client error calling release ");
-              throw  std::runtime_error(mess);
-         }
-         monitorElementQueue.pop();
-     }
-};
-
 CAChannelMonitorPtr CAChannelMonitor::create(
     CAChannel::shared_pointer const & channel,
     MonitorRequester::shared_pointer const & monitorRequester,
@@ -832,7 +758,7 @@ CAChannelMonitor::CAChannelMonitor(
     monitorRequester(monitorRequester),
     pvRequest(pvRequest),
     isStarted(false),
-    monitorEventThread(MonitorEventThread::get()),
+    callbackPool(channel->getCallbackPool()),
     pevid(NULL),
     eventMask(DBE_VALUE | DBE_ALARM)
 {}
@@ -858,7 +784,6 @@ void CAChannelMonitor::activate()
     dbdToPv = DbdToPv::create(channel,pvRequest,monitorIO);
     dbdToPv->getChoices(channel);
     pvStructure = dbdToPv->createPVStructure();
-    activeElement = MonitorElementPtr(new MonitorElement(pvStructure));
     int32 queueSize = 2;
     PVStructurePtr pvOptions = pvRequest->getSubField<PVStructure>("record._options");
     if (pvOptions) {
@@ -880,9 +805,8 @@ void CAChannelMonitor::activate()
             if(value.find("PROPERTY")!=std::string::npos) eventMask|=DBE_PROPERTY;
         }
     }
-    notifyMonitorRequester = NotifyMonitorRequesterPtr(new NotifyMonitorRequester());
-    notifyMonitorRequester->setChannelMonitor(shared_from_this());
-    monitorQueue = CACMonitorQueuePtr(new CACMonitorQueue(queueSize));
+    monitorCallback = CACallback::shared_pointer(new CACallback(shared_from_this(), channel.get()));
+    monitorQueue = CACMonitorQueuePtr(new CACMonitorQueue(queueSize, pvStructure));
     EXCEPTION_GUARD(requester->monitorConnect(Status::Ok, shared_from_this(),
                     pvStructure->getStructure()));
 }
@@ -901,18 +825,11 @@ void CAChannelMonitor::subscriptionEvent(struct event_handler_args &args)
     }
     MonitorRequester::shared_pointer requester(monitorRequester.lock());
     if(!requester) return;
-    Status status = dbdToPv->getFromDBD(pvStructure,activeElement->changedBitSet,args);
-    if(status.isOK())
-    {
-        if(monitorQueue->event(pvStructure,activeElement)) {
-             activeElement->changedBitSet->clear();
-             activeElement->overrunBitSet->clear();
-        } else {
-            *(activeElement->overrunBitSet) |= *(activeElement->changedBitSet);
-        }
-        monitorEventThread->event(notifyMonitorRequester);
+    Status status;
+    if(monitorQueue->event(*dbdToPv, args, status)) {
+        callbackPool->notify(monitorCallback);
     }
-    else
+    if(!status.isOK())
     {
         string mess("CAChannelMonitor::subscriptionEvent ");
         mess += channel->getChannelName();
@@ -1002,7 +919,9 @@ void CAChannelMonitor::release(MonitorElementPtr const & monitorElement)
     if(DEBUG_LEVEL>1) {
         std::cout << "CAChannelMonitor::release " << channel->getChannelName() << endl;
     }
-    monitorQueue->release(monitorElement);
+    if(monitorQueue->release(monitorElement)) {
+        callbackPool->notify(monitorCallback);
+    }
 }
 
 /* --------------- ChannelRequest --------------- */
@@ -22,6 +22,7 @@
 #include <cadef.h>
 
 #include "caProviderPvt.h"
+#include "caCallbackPool.h"
 #include "dbdToPv.h"
 
 namespace epics {
@@ -31,29 +32,6 @@ namespace ca {
 class CAChannel;
 typedef std::tr1::shared_ptr<CAChannel> CAChannelPtr;
 typedef std::tr1::weak_ptr<CAChannel> CAChannelWPtr;
-class ChannelConnectThread;
-typedef std::tr1::shared_ptr<ChannelConnectThread> ChannelConnectThreadPtr;
-
-class NotifyChannelRequester;
-typedef std::tr1::shared_ptr<NotifyChannelRequester> NotifyChannelRequesterPtr;
-
-class NotifyMonitorRequester;
-typedef std::tr1::shared_ptr<NotifyMonitorRequester> NotifyMonitorRequesterPtr;
-class MonitorEventThread;
-typedef std::tr1::shared_ptr<MonitorEventThread> MonitorEventThreadPtr;
-
-class NotifyGetRequester;
-typedef std::tr1::shared_ptr<NotifyGetRequester> NotifyGetRequesterPtr;
-typedef std::tr1::weak_ptr<NotifyGetRequester> NotifyGetRequesterWPtr;
-class GetDoneThread;
-typedef std::tr1::shared_ptr<GetDoneThread> GetDoneThreadPtr;
-
-class NotifyPutRequester;
-typedef std::tr1::shared_ptr<NotifyPutRequester> NotifyPutRequesterPtr;
-typedef std::tr1::weak_ptr<NotifyPutRequester> NotifyPutRequesterWPtr;
-class PutDoneThread;
-typedef std::tr1::shared_ptr<PutDoneThread> PutDoneThreadPtr;
-
 class CAChannelGetField;
 typedef std::tr1::shared_ptr<CAChannelGetField> CAChannelGetFieldPtr;
 typedef std::tr1::weak_ptr<CAChannelGetField> CAChannelGetFieldWPtr;
@@ -87,6 +65,7 @@ private:
 
 class CAChannel :
     public Channel,
+    public CACallbackClient,
     public std::tr1::enable_shared_from_this<CAChannel>
 {
 public:
@@ -118,6 +97,7 @@ public:
     virtual void printInfo(std::ostream& out);
 
     void attachContext();
+    CACallbackPoolPtr const & getCallbackPool() const { return callbackPool; }
     void disconnectChannel();
     void connect(bool isConnected);
     void notifyClient();
@@ -135,8 +115,8 @@ private:
     chid channelID;
     bool channelCreated;
     bool channelConnected;
-    ChannelConnectThreadPtr channelConnectThread;
-    NotifyChannelRequesterPtr notifyChannelRequester;
+    CACallbackPoolPtr callbackPool;
+    CACallback::shared_pointer connectCallback;
 
     epics::pvData::Mutex requestsMutex;
     std::queue<CAChannelGetFieldPtr> getFieldQueue;
@@ -149,6 +129,7 @@ private:
 
 class CAChannelGet :
     public ChannelGet,
+    public CACallbackClient,
     public std::tr1::enable_shared_from_this<CAChannelGet>
 {
 public:
@@ -176,8 +157,8 @@ private:
     ChannelGetRequester::weak_pointer channelGetRequester;
     const epics::pvData::PVStructure::shared_pointer pvRequest;
     epics::pvData::Status getStatus;
-    GetDoneThreadPtr getDoneThread;
-    NotifyGetRequesterPtr notifyGetRequester;
+    CACallbackPoolPtr callbackPool;
+    CACallback::shared_pointer getCallback;
     DbdToPvPtr dbdToPv;
     epics::pvData::Mutex mutex;
     epics::pvData::PVStructure::shared_pointer pvStructure;
@@ -186,6 +167,7 @@ private:
 
 class CAChannelPut :
     public ChannelPut,
+    public CACallbackClient,
     public std::tr1::enable_shared_from_this<CAChannelPut>
 {
 
@@ -221,8 +203,8 @@ private:
     bool isPut;
     epics::pvData::Status getStatus;
     epics::pvData::Status putStatus;
-    PutDoneThreadPtr putDoneThread;
-    NotifyPutRequesterPtr notifyPutRequester;
+    CACallbackPoolPtr callbackPool;
+    CACallback::shared_pointer putCallback;
     DbdToPvPtr dbdToPv;
     epics::pvData::Mutex mutex;
     epics::pvData::PVStructure::shared_pointer pvStructure;
@@ -234,6 +216,7 @@ typedef std::tr1::shared_ptr<CACMonitorQueue> CACMonitorQueuePtr;
 
 class CAChannelMonitor :
     public Monitor,
+    public CACallbackClient,
     public std::tr1::enable_shared_from_this<CAChannelMonitor>
 {
 
@@ -262,16 +245,15 @@ private:
     MonitorRequester::weak_pointer monitorRequester;
     const epics::pvData::PVStructure::shared_pointer pvRequest;
     bool isStarted;
-    MonitorEventThreadPtr monitorEventThread;
+    CACallbackPoolPtr callbackPool;
     evid pevid;
     unsigned long eventMask;
-    NotifyMonitorRequesterPtr notifyMonitorRequester;
+    CACallback::shared_pointer monitorCallback;
 
     DbdToPvPtr dbdToPv;
     epics::pvData::Mutex mutex;
     epics::pvData::PVStructure::shared_pointer pvStructure;
-    epics::pvData::MonitorElementPtr activeElement;
-    
+
     CACMonitorQueuePtr monitorQueue;
 };
 
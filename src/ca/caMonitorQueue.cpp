@@ -0,0 +1,141 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <stdexcept>
+
+#define epicsExportSharedSymbols
+#include "caMonitorQueue.h"
+
+using namespace epics::pvData;
+
+namespace epics {
+namespace pvAccess {
+namespace ca {
+
+CACMonitorQueue::CACMonitorQueue(size_t queueSize, PVStructurePtr const & pvStructure)
+    :queueSize(queueSize ? queueSize : 1u)
+    ,isStarted(false)
+    ,pvStructure(pvStructure)
+    ,changed(new BitSet(pvStructure->getNumberFields()))
+    ,pendingChanged(pvStructure->getNumberFields())
+    ,pendingOverrun(pvStructure->getNumberFields())
+    ,scratch(pvStructure->getNumberFields())
+    ,queued(this->queueSize)
+    ,head(0u)
+    ,count(0u)
+{
+    elements.reserve(this->queueSize);
+    freeElements.reserve(this->queueSize);
+    for(size_t i=0; i<this->queueSize; i++) {
+        MonitorElementPtr element(new MonitorElement(
+            getPVDataCreate()->createPVStructure(pvStructure->getStructure())));
+        elements.push_back(element);
+        freeElements.push_back(element);
+    }
+}
+
+CACMonitorQueue::~CACMonitorQueue() {}
+
+void CACMonitorQueue::reset()
+{
+    for(; count; count--) {
+        freeElements.push_back(queued[head]);
+        queued[head].reset();
+        head = (head+1u)%queueSize;
+    }
+    head = 0u;
+    pendingChanged.clear();
+    pendingOverrun.clear();
+}
+
+void CACMonitorQueue::start()
+{
+    Lock guard(mutex);
+    reset();
+    isStarted = true;
+}
+
+void CACMonitorQueue::stop()
+{
+    Lock guard(mutex);
+    reset();
+    isStarted = false;
+}
+
+void CACMonitorQueue::pushChanged()
+{
+    scratch = pendingChanged;
+    scratch &= *changed;
+    pendingOverrun |= scratch;
+    pendingChanged |= *changed;
+}
+
+bool CACMonitorQueue::flush()
+{
+    if(pendingChanged.isEmpty())
+        return false;
+
+    if(!freeElements.empty()) {
+        MonitorElementPtr element;
+        element.swap(freeElements.back());
+        freeElements.pop_back();
+
+        element->pvStructurePtr->copyUnchecked(*pvStructure);
+        *element->changedBitSet = pendingChanged;
+        *element->overrunBitSet = pendingOverrun;
+
+        queued[(head+count)%queueSize].swap(element);
+        count++;
+
+        pendingChanged.clear();
+        pendingOverrun.clear();
+        // notify when the queue was empty
+        return count==1u;
+
+    } else if(count) {
+        // merge into the newest
+        MonitorElement& last = *queued[(head+count-1u)%queueSize];
+
+        last.pvStructurePtr->copyUnchecked(*pvStructure, pendingChanged);
+        scratch = *last.changedBitSet;
+        scratch &= pendingChanged;
+        *last.overrunBitSet |= scratch;
+        *last.overrunBitSet |= pendingOverrun;
+        *last.changedBitSet |= pendingChanged;
+
+        pendingChanged.clear();
+        pendingOverrun.clear();
+        // already notified of the element merged into
+        return false;
+
+    } else {
+        // client holds all elements.  keep until release()
+        return false;
+    }
+}
+
+MonitorElementPtr CACMonitorQueue::poll()
+{
+    Lock guard(mutex);
+    MonitorElementPtr ret;
+    if(!isStarted || !count) return ret;
+    ret.swap(queued[head]);
+    head = (head+1u)%queueSize;
+    count--;
+    return ret;
+}
+
+bool CACMonitorQueue::release(MonitorElementPtr const & monitorElement)
+{
+    Lock guard(mutex);
+    if(freeElements.size()+count >= queueSize) {
+        throw std::runtime_error("CAChannelMonitor::release client error calling release ");
+    }
+    freeElements.push_back(monitorElement);
+    return isStarted && flush();
+}
+
+}}}
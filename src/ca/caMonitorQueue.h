@@ -0,0 +1,94 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef CaMonitorQueue_H
+#define CaMonitorQueue_H
+#include <vector>
+#include <cadef.h>
+#include <shareLib.h>
+#include <pv/lock.h>
+#include <pv/bitSet.h>
+#include <pv/pvData.h>
+#include <pv/status.h>
+#include <pv/monitor.h>
+
+namespace epics {
+namespace pvAccess {
+namespace ca {
+
+/** Queue of one CA subscription.
+ *
+ * All MonitorElements are allocated up front.  Each CA event is converted in place
+ * into the latest values, which are then copied into a free element.
+ * When no element is free, the event is merged into the newest element
+ * not yet poll()'d, or if the client holds all elements, into the next element released.
+ * Fields changed more than once before being poll()'d are marked in the overrunBitSet.
+ */
+class epicsShareClass CACMonitorQueue
+{
+public:
+    POINTER_DEFINITIONS(CACMonitorQueue);
+
+    /** @param queueSize number of elements, at least 1.
+     *  @param pvStructure the latest values, which event() updates.
+     */
+    CACMonitorQueue(size_t queueSize, epics::pvData::PVStructurePtr const & pvStructure);
+    ~CACMonitorQueue();
+
+    void start();
+    void stop();
+
+    /** Convert a CA event with conv.getFromDBD() (cf. DbdToPv) and queue.
+     *
+     * @returns true when a new element was queued to an empty queue, and the client should be notified.
+     *          false when merged into an element already queued.
+     */
+    template<typename Conv>
+    bool event(Conv& conv, struct event_handler_args &args, epics::pvData::Status& status)
+    {
+        epics::pvData::Lock guard(mutex);
+        if(!isStarted) return false;
+        changed->clear();
+        status = conv.getFromDBD(pvStructure, changed, args);
+        if(!status.isOK()) return false;
+        pushChanged();
+        return flush();
+    }
+
+    epics::pvData::MonitorElementPtr poll();
+    /** Return an element from poll().
+     *
+     * @returns true when a pending event was queued, and the client should be notified.
+     */
+    bool release(epics::pvData::MonitorElementPtr const & monitorElement);
+
+private:
+    // called with mutex held
+    void pushChanged();
+    bool flush();
+    void reset();
+
+    const size_t queueSize;
+    bool isStarted;
+    epics::pvData::Mutex mutex;
+
+    const epics::pvData::PVStructurePtr pvStructure;
+    // changed by the current event
+    const epics::pvData::BitSet::shared_pointer changed;
+    // changes not yet in an element
+    epics::pvData::BitSet pendingChanged, pendingOverrun;
+    epics::pvData::BitSet scratch;
+
+    std::vector<epics::pvData::MonitorElementPtr> elements;
+    // not queued nor held by the client
+    std::vector<epics::pvData::MonitorElementPtr> freeElements;
+    // ring of queueSize, oldest at 'head'
+    std::vector<epics::pvData::MonitorElementPtr> queued;
+    size_t head, count;
+};
+
+}}}
+
+#endif  /* CaMonitorQueue_H */
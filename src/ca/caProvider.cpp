@@ -10,15 +10,12 @@
 #include <epicsExit.h>
 #include <pv/logger.h>
 #include <pv/pvAccess.h>
-
-#include "channelConnectThread.h"
-#include "monitorEventThread.h"
-#include "getDoneThread.h"
-#include "putDoneThread.h"
+#include <pv/configuration.h>
 
 #define epicsExportSharedSymbols
 #include <pv/caProvider.h>
 #include "caProviderPvt.h"
+#include "caCallbackPool.h"
 #include "caChannel.h"
 
 
@@ -35,20 +32,21 @@ using namespace epics::pvData;
 CAChannelProvider::CAChannelProvider() 
     : current_context(0)
 {
-    initialize();
+    initialize(CACallbackPool::defaultWorkers());
 }
 
-CAChannelProvider::CAChannelProvider(const std::tr1::shared_ptr<Configuration>&)
-    :  current_context(0),
-       channelConnectThread(ChannelConnectThread::get()),
-       monitorEventThread(MonitorEventThread::get()),
-       getDoneThread(GetDoneThread::get()),
-       putDoneThread(PutDoneThread::get())
+CAChannelProvider::CAChannelProvider(const std::tr1::shared_ptr<Configuration>& conf)
+    :  current_context(0)
 {
     if(DEBUG_LEVEL>0) {
           std::cout<< "CAChannelProvider::CAChannelProvider\n";
     }
-    initialize();
+    size_t nworkers = CACallbackPool::defaultWorkers();
+    if(conf) {
+        epics::pvData::int32 n = conf->getPropertyAsInteger("EPICS_CA_PROVIDER_WORKERS", epics::pvData::int32(nworkers));
+        if(n > 0) nworkers = size_t(n);
+    }
+    initialize(nworkers);
 }
 
 CAChannelProvider::~CAChannelProvider()
@@ -77,10 +75,7 @@ CAChannelProvider::~CAChannelProvider()
        channelQ.front()->disconnectChannel();
        channelQ.pop();
     }
-    putDoneThread->stop();
-    getDoneThread->stop();
-    monitorEventThread->stop();
-    channelConnectThread->stop();
+    callbackPool->stop();
     if(DEBUG_LEVEL>0) {
         std::cout << "CAChannelProvider::~CAChannelProvider() calling ca_context_destroy\n";
     }
@@ -186,9 +181,11 @@ void CAChannelProvider::attachContext()
     }
 }
 
-void CAChannelProvider::initialize()
+void CAChannelProvider::initialize(size_t nworkers)
 {
     if(DEBUG_LEVEL>0) std::cout << "CAChannelProvider::initialize()\n";
+    callbackPool.reset(new CACallbackPool(nworkers));
+    callbackPool->start();
     int result = ca_context_create(ca_enable_preemptive_callback);
     if (result != ECA_NORMAL) {
         std::string mess("CAChannelProvider::initialize error calling ca_context_create ");
@@ -24,17 +24,8 @@ namespace ca {
 
 #define DEBUG_LEVEL 0
 
-class ChannelConnectThread;
-typedef std::tr1::shared_ptr<ChannelConnectThread> ChannelConnectThreadPtr;
-
-class MonitorEventThread;
-typedef std::tr1::shared_ptr<MonitorEventThread> MonitorEventThreadPtr;
-
-class GetDoneThread;
-typedef std::tr1::shared_ptr<GetDoneThread> GetDoneThreadPtr;
-
-class PutDoneThread;
-typedef std::tr1::shared_ptr<PutDoneThread> PutDoneThreadPtr;
+class CACallbackPool;
+typedef std::tr1::shared_ptr<CACallbackPool> CACallbackPoolPtr;
 
 class CAChannel;
 typedef std::tr1::shared_ptr<CAChannel> CAChannelPtr;
@@ -82,17 +73,15 @@ public:
 
     void attachContext();
     void addChannel(const CAChannelPtr & channel);
+    CACallbackPoolPtr const & getCallbackPool() const { return callbackPool; }
 private:
     
     virtual void destroy() EPICS_DEPRECATED {}
-    void initialize();
+    void initialize(size_t nworkers);
     ca_client_context* current_context;
     epics::pvData::Mutex channelListMutex;
     std::vector<CAChannelWPtr> caChannelList;
-    ChannelConnectThreadPtr channelConnectThread;
-    MonitorEventThreadPtr monitorEventThread;
-    GetDoneThreadPtr getDoneThread;
-    PutDoneThreadPtr putDoneThread;
+    CACallbackPoolPtr callbackPool;
 };
 
 }}}
@@ -18,6 +18,7 @@
 #include <pv/convert.h>
 #include <pv/timeStamp.h>
 #include "caChannel.h"
+#include "dbrConvert.h"
 #define epicsExportSharedSymbols
 #include "dbdToPv.h"
 
@@ -390,12 +391,8 @@ template<typename dbrT, typename pvT>
 void copy_DBRScalarArray(const void * dbr, unsigned count, PVScalarArray::shared_pointer const & pvArray)
 {
     std::tr1::shared_ptr<pvT> value = std::tr1::static_pointer_cast<pvT>(pvArray);
-    typename pvT::svector temp(value->reuse());
-    temp.resize(count);
-    std::copy(
-        static_cast<const dbrT*>(dbr),
-        static_cast<const dbrT*>(dbr) + count,
-        temp.begin());
+    typename pvT::svector temp(reuseDbrArray(*value, count));
+    convertDbrArray(static_cast<const dbrT*>(dbr), count, temp.data());
     value->replace(freeze(temp));
 }
 
@@ -448,8 +445,7 @@ Status DbdToPv::getFromDBD(
            {
                 const dbr_string_t *dbrval = static_cast<const dbr_string_t *>(value);
                 PVStringArrayPtr pvValue = pvStructure->getSubField<PVStringArray>("value");
-                PVStringArray::svector arr(pvValue->reuse());
-                arr.resize(count);
+                PVStringArray::svector arr(reuseDbrArray(*pvValue, count));
                 std::copy(dbrval, dbrval + count, arr.begin());
                 pvValue->replace(freeze(arr));
                 break;
@@ -892,22 +888,20 @@ Status DbdToPv::putToDBD(
                {
                    PVLongArrayPtr pvValue(pvStructure->getSubField<PVLongArray>("value"));
                    PVLongArray::const_svector sv(pvValue->view());
-                   pvDoubleArray = PVDoubleArrayPtr(getPVDataCreate()->createPVScalarArray<PVDoubleArray>());
-                   pvDoubleArray->putFrom(sv);
-                   const double * pdouble = pvDoubleArray->view().data();
-                   count = pvValue->getLength();
-                   pValue = pdouble;
+                   putBuffer.resize(sv.size());
+                   convertDbrArray(sv.data(), sv.size(), putBuffer.data());
+                   count = sv.size();
+                   pValue = putBuffer.data();
                    break;
                }
                if(dbfIsUINT64)
                {
                    PVULongArrayPtr pvValue(pvStructure->getSubField<PVULongArray>("value"));
                    PVULongArray::const_svector sv(pvValue->view());
-                   pvDoubleArray = PVDoubleArrayPtr(getPVDataCreate()->createPVScalarArray<PVDoubleArray>());
-                   pvDoubleArray->putFrom(sv);
-                   const double * pdouble = pvDoubleArray->view().data();
-                   count = pvValue->getLength();
-                   pValue = pdouble;
+                   putBuffer.resize(sv.size());
+                   convertDbrArray(sv.data(), sv.size(), putBuffer.data());
+                   count = sv.size();
+                   pValue = putBuffer.data();
                    break;
                }
                pValue = put_DBRScalarArray<dbr_double_t,PVDoubleArray>(&count,pvValue);
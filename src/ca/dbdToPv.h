@@ -138,7 +138,8 @@ private:
     CaValueAlarm caValueAlarm;
     epics::pvData::Structure::const_shared_pointer structure;
     std::vector<std::string> choices;
-    epics::pvData::PVDoubleArrayPtr pvDoubleArray; //for dbfIsINT64 and dbfIsUINT64
+    // re-used for put of dbfIsINT64 and dbfIsUINT64 arrays
+    epics::pvData::shared_vector<double> putBuffer;
 };
 
 }
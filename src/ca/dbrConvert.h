@@ -0,0 +1,66 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef DbrConvert_H
+#define DbrConvert_H
+#include <limits>
+#include <string.h>
+#include <pv/pvData.h>
+
+namespace epics {
+namespace pvAccess {
+namespace ca {
+
+/** True when a From can be converted to a To by copying its bits.
+ *  eg. dbr_short_t to epicsUInt16, or dbr_float_t to float.
+ */
+template<typename From, typename To>
+struct DbrBitwiseCopy {
+    enum { value = sizeof(From)==sizeof(To) &&
+                   std::numeric_limits<From>::is_integer==std::numeric_limits<To>::is_integer };
+};
+
+/** Convert an array of CA values to/from pvData values.
+ *
+ * A single memcpy() when only the signedness differs.
+ * Otherwise a loop simple enough for the compiler to vectorize.
+ */
+template<typename From, typename To>
+void convertDbrArray(const From *src, size_t count, To *dst)
+{
+    if(DbrBitwiseCopy<From, To>::value) {
+        if(count)
+            memcpy(dst, src, count*sizeof(To));
+    } else {
+        for(size_t i=0; i<count; i++)
+            dst[i] = static_cast<To>(src[i]);
+    }
+}
+
+/** Take the storage of a pvData array, and resize it to 'count' for overwriting.
+ *
+ * Re-uses the current storage if not shared, and large enough.
+ * Otherwise allocates, without first copying the current values
+ * as PVValueArray::reuse() does.
+ */
+template<typename pvT>
+typename pvT::svector reuseDbrArray(pvT& value, size_t count)
+{
+    typename pvT::const_svector current;
+    value.swap(current);
+    typename pvT::svector ret;
+    if(current.unique() && current.capacity() >= count) {
+        ret = thaw(current);
+        ret.resize(count);
+    } else {
+        current.clear();
+        typename pvT::svector(count).swap(ret);
+    }
+    return ret;
+}
+
+}}}
+
+#endif  /* DbrConvert_H */
@@ -4,6 +4,7 @@
  */
 
 #include <typeinfo>
+#include <sstream>
 
 #include <epicsMutex.h>
 #include <epicsGuard.h>
@@ -20,6 +21,8 @@
 #include "clientpvt.h"
 #include "pv/pvAccess.h"
 #include "pv/configuration.h"
+#include "pv/pvaConstants.h"
+#include "pv/clientContextImpl.h"
 
 namespace pvd = epics::pvData;
 namespace pva = epics::pvAccess;
@@ -28,11 +31,70 @@ typedef epicsGuard<epicsMutex> Guard;
 typedef epicsGuardRelease<epicsMutex> UnGuard;
 
 namespace pvac {
+using detail::CallbackGuard;
+using detail::CallbackUse;
 
 Timeout::Timeout()
     :std::runtime_error("Timeout")
 {}
 
+// Aggregate notification for ClientProvider::connect() of many names
+struct ConnectAll : public pvac::detail::CallbackStorage,
+                    public pvac::Operation::Impl,
+                    public pvac::detail::wrapped_shared_from_this<ConnectAll>
+{
+    ClientProvider::ConnectAllCallback *cb;
+    size_t total;
+    // channels not yet connected, plus one until setup is complete
+    size_t remaining;
+
+    static size_t num_instances;
+
+    ConnectAll() :cb(0), total(0u), remaining(1u) {REFTRACE_INCREMENT(num_instances);}
+    virtual ~ConnectAll() {
+        CallbackGuard G(*this);
+        cb = 0;
+        G.wait(); // paranoia
+        REFTRACE_DECREMENT(num_instances);
+    }
+
+    void channelConnected()
+    {
+        CallbackGuard G(*this);
+        if(remaining==0u || --remaining!=0u)
+            return;
+        ClientProvider::ConnectAllCallback *C(cb);
+        cb = 0;
+        if(C) {
+            CallbackUse U(G);
+            C->connectAllDone();
+        }
+    }
+
+    virtual std::string name() const OVERRIDE FINAL
+    {
+        std::ostringstream strm;
+        strm<<total<<" channels";
+        return strm.str();
+    }
+
+    virtual void cancel() OVERRIDE FINAL
+    {
+        CallbackGuard G(*this);
+        cb = 0;
+        G.wait();
+    }
+
+    virtual void show(std::ostream& strm) const OVERRIDE FINAL
+    {
+        strm << "Operation(ConnectAll "
+                "\"" << name() <<"\""
+             ")";
+    }
+};
+
+size_t ConnectAll::num_instances;
+
 struct ClientChannel::Impl : public pva::ChannelRequester,
                              public pvac::detail::wrapped_shared_from_this<ClientChannel::Impl>
 {
@@ -43,6 +105,9 @@ struct ClientChannel::Impl : public pva::ChannelRequester,
     listeners_t listeners;
     bool listeners_inprogress;
     epicsEvent listeners_done;
+    // ClientProvider::connect() of many names waiting for the first connection
+    typedef std::vector<std::tr1::weak_ptr<ConnectAll> > waiters_t;
+    waiters_t waiters;
 
     static size_t num_instances;
 
@@ -69,10 +134,19 @@ struct ClientChannel::Impl : public pva::ChannelRequester,
     virtual void channelStateChange(pva::Channel::shared_pointer const & channel, pva::Channel::ConnectionState connectionState) OVERRIDE FINAL
     {
         listeners_t notify;
+        waiters_t connected;
         {
             Guard G(mutex);
             notify = listeners; // copy vector
             listeners_inprogress = true;
+            if(connectionState==pva::Channel::CONNECTED)
+                connected.swap(waiters);
+        }
+        for(waiters_t::const_iterator it=connected.begin(), end=connected.end(); it!=end; ++it)
+        {
+            std::tr1::shared_ptr<ConnectAll> waiter(it->lock());
+            if(waiter)
+                waiter->channelConnected();
         }
         try {
             ConnectEvent evt;
@@ -313,6 +387,136 @@ ClientProvider::connect(const std::string& name,
     return ret;
 }
 
+Operation
+ClientProvider::connect(const std::vector<std::string>& names,
+                        std::vector<ClientChannel>& channels,
+                        ConnectAllCallback* cb,
+                        const ClientChannel::Options& conf)
+{
+    if(!impl) throw std::logic_error("Dead Provider");
+    for(size_t i=0; i<names.size(); i++) {
+        if(names[i].empty())
+            THROW_EXCEPTION2(std::logic_error, "empty channel name not allowed");
+    }
+
+    // filled in completely, or not at all
+    std::vector<ClientChannel> result(names.size());
+
+    {
+        Guard G(impl->mutex);
+
+        // names not in cache, and the index of their first appearance
+        std::vector<std::string> missNames;
+        std::vector<size_t> missIndex;
+        std::map<std::string, size_t> misses;
+
+        for(size_t i=0; i<names.size(); i++) {
+            std::map<std::string, size_t>::const_iterator dup(misses.find(names[i]));
+            if(dup!=misses.end())
+                continue; // filled in below
+
+            Impl::channels_t::iterator it(impl->channels.find(std::make_pair(names[i], conf)));
+            if(it!=impl->channels.end()) {
+                std::tr1::shared_ptr<ClientChannel::Impl> chan(it->second.lock());
+                if(chan) {
+                    result[i] = ClientChannel(chan);
+                    continue;
+                }
+                impl->channels.erase(it); // remove stale
+            }
+            misses[names[i]] = i;
+            missNames.push_back(names[i]);
+            missIndex.push_back(i);
+        }
+
+        std::tr1::shared_ptr<pva::ClientContextImpl> context(std::tr1::dynamic_pointer_cast<pva::ClientContextImpl>(impl->provider));
+        if(context && !missNames.empty()) {
+            // batched CID allocation, and search
+            pva::InetAddrVector addresses;
+            pva::getSocketAddressList(addresses, conf.address, pva::PVA_SERVER_PORT);
+
+            std::vector<std::tr1::shared_ptr<ClientChannel::Impl> > impls(missNames.size());
+            std::vector<pva::ChannelRequester::shared_pointer> requesters(missNames.size());
+            for(size_t i=0; i<missNames.size(); i++) {
+                impls[i] = ClientChannel::Impl::build();
+                requesters[i] = impls[i]->internal_shared_from_this();
+            }
+
+            std::vector<pva::ClientChannelImpl::shared_pointer> created;
+            context->createChannelsInternal(missNames, requesters, conf.priority, addresses, created);
+
+            for(size_t i=0; i<missNames.size(); i++) {
+                if(created[i])
+                    continue;
+                // undo the whole batch
+                for(size_t j=0; j<created.size(); j++) {
+                    if(created[j])
+                        created[j]->destroy();
+                }
+                throw std::runtime_error("ChannelProvider failed to create Channel");
+            }
+
+            for(size_t i=0; i<missNames.size(); i++) {
+                impls[i]->channel = created[i];
+                requesters[i]->channelCreated(pvd::Status::Ok, created[i]);
+                result[missIndex[i]] = ClientChannel(impls[i]);
+            }
+
+        } else {
+            size_t i=0;
+            try {
+                for(; i<missNames.size(); i++)
+                    result[missIndex[i]] = ClientChannel(impl->provider, missNames[i], conf);
+            }catch(...){
+                // undo the channels created for this batch
+                for(size_t j=0; j<i; j++)
+                    result[missIndex[j]].impl->channel->destroy();
+                throw;
+            }
+        }
+
+        for(size_t i=0; i<missNames.size(); i++)
+            impl->channels[std::make_pair(missNames[i], conf)] = result[missIndex[i]].impl;
+
+        for(size_t i=0; i<names.size(); i++) {
+            if(!result[i].impl)
+                result[i] = result[misses[names[i]]];
+        }
+    }
+
+    channels.swap(result);
+
+    if(!cb)
+        return Operation();
+
+    std::tr1::shared_ptr<ConnectAll> ret(ConnectAll::build());
+    std::tr1::shared_ptr<ConnectAll> internal(ret->internal_shared_from_this());
+    {
+        CallbackGuard G2(*ret);
+        ret->cb = cb;
+        ret->total = channels.size();
+        ret->remaining += channels.size();
+    }
+
+    for(size_t i=0; i<channels.size(); i++) {
+        ClientChannel::Impl& chan = *channels[i].impl;
+        bool connected;
+        {
+            Guard G3(chan.mutex);
+            connected = chan.channel->isConnected();
+            if(!connected)
+                chan.waiters.push_back(internal);
+        }
+        if(connected)
+            ret->channelConnected();
+    }
+
+    // setup complete
+    ret->channelConnected();
+
+    return Operation(ret);
+}
+
 bool ClientProvider::disconnect(const std::string& name,
                                     const ClientChannel::Options& conf)
 {
@@ -376,6 +580,7 @@ void registerRefTrack()
 {
     epics::registerRefCounter("pvac::ClientChannel::Impl", &ClientChannel::Impl::num_instances);
     epics::registerRefCounter("pvac::ClientProvider::Impl", &ClientProvider::Impl::num_instances);
+    epics::registerRefCounter("pvac::ConnectAll", &ConnectAll::num_instances);
 }
 
 }
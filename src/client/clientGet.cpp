@@ -3,6 +3,8 @@
  * found in the file LICENSE that is included with the distribution
  */
 
+#include <sstream>
+
 #include <epicsMutex.h>
 #include <epicsGuard.h>
 #include <epicsEvent.h>
@@ -143,6 +145,197 @@ struct Getter : public pvac::detail::CallbackStorage,
 
 size_t Getter::num_instances;
 
+// get from many channels, with a limited number in progress
+struct MultiGetter : public pvac::detail::CallbackStorage,
+                     public pvac::Operation::Impl,
+                     public pvac::detail::wrapped_shared_from_this<MultiGetter>
+{
+    // one get in progress
+    struct Slot : public pva::ChannelGetRequester
+    {
+        const std::tr1::weak_ptr<MultiGetter> parent;
+        const size_t index;
+        // guarded by parent mutex
+        operation_type::shared_pointer op;
+
+        Slot(const std::tr1::shared_ptr<MultiGetter>& parent, size_t index) :parent(parent), index(index) {}
+        virtual ~Slot() {}
+
+        void done(pvac::GetEvent::event_t evt, const pvd::Status& status,
+                  pvd::PVStructure::shared_pointer const & pvStructure = pvd::PVStructure::shared_pointer(),
+                  pvd::BitSet::shared_pointer const & bitSet = pvd::BitSet::shared_pointer())
+        {
+            std::tr1::shared_ptr<MultiGetter> P(parent.lock());
+            if(!P) return;
+            pvac::GetEvent event;
+            event.event = evt;
+            if(!status.isOK())
+                event.message = status.getMessage();
+            event.value = pvStructure;
+            event.valid = bitSet;
+            P->complete(index, event);
+        }
+
+        virtual std::string getRequesterName() OVERRIDE FINAL
+        {
+            return "MultiGetter";
+        }
+
+        virtual void channelGetConnect(
+            const epics::pvData::Status& status,
+            pva::ChannelGet::shared_pointer const & channelGet,
+            epics::pvData::Structure::const_shared_pointer const & structure) OVERRIDE FINAL
+        {
+            if(!status.isSuccess()) {
+                done(pvac::GetEvent::Fail, status);
+            } else {
+                // server destroys the operation after this get.  No CMD_DESTROY_REQUEST
+                channelGet->lastRequest();
+                channelGet->get();
+            }
+        }
+
+        virtual void channelDisconnect(bool destroy) OVERRIDE FINAL
+        {
+            done(pvac::GetEvent::Fail, pvd::Status(pvd::Status::STATUSTYPE_ERROR, "Disconnect"));
+        }
+
+        virtual void getDone(
+            const epics::pvData::Status& status,
+            pva::ChannelGet::shared_pointer const & channelGet,
+            epics::pvData::PVStructure::shared_pointer const & pvStructure,
+            epics::pvData::BitSet::shared_pointer const & bitSet) OVERRIDE FINAL
+        {
+            done(status.isSuccess() ? pvac::GetEvent::Success : pvac::GetEvent::Fail,
+                 status, pvStructure, bitSet);
+        }
+    };
+
+    const std::vector<pva::Channel::shared_pointer> channels;
+    const pvd::PVStructure::shared_pointer pvRequest;
+    const size_t window;
+
+    pvac::ClientProvider::MultiGetCallback *cb;
+    // in progress, by channel index.  NULL when not started, or complete
+    std::vector<std::tr1::shared_ptr<Slot> > slots;
+    size_t next, inprogress, remaining;
+    bool launching;
+
+    static size_t num_instances;
+
+    MultiGetter(const std::vector<pva::Channel::shared_pointer>& channels,
+                const pvd::PVStructure::shared_pointer& pvRequest,
+                size_t window)
+        :channels(channels)
+        ,pvRequest(pvRequest)
+        ,window(window ? window : channels.size())
+        ,cb(0)
+        ,slots(channels.size())
+        ,next(0u)
+        ,inprogress(0u)
+        ,remaining(channels.size())
+        ,launching(false)
+    {REFTRACE_INCREMENT(num_instances);}
+    virtual ~MultiGetter() {
+        CallbackGuard G(*this);
+        cb = 0;
+        G.wait(); // paranoia
+        REFTRACE_DECREMENT(num_instances);
+    }
+
+    // begin gets, up to the window
+    void launch()
+    {
+        Guard G(mutex);
+        if(launching)
+            return; // the launching thread will see the space made
+        launching = true;
+        while(cb && inprogress<window && next<channels.size()) {
+            std::tr1::shared_ptr<Slot> slot(new Slot(internal_shared_from_this(), next));
+            slots[next++] = slot;
+            inprogress++;
+
+            operation_type::shared_pointer op;
+            {
+                // not locked, as a failure may be notified from createChannelGet()
+                UnGuard U(G);
+                op = channels[slot->index]->createChannelGet(slot, pvRequest);
+            }
+            if(slots[slot->index]==slot)
+                slot->op = op;
+        }
+        launching = false;
+    }
+
+    void complete(size_t index, const pvac::GetEvent& evt)
+    {
+        std::tr1::shared_ptr<MultiGetter> keepalive(internal_shared_from_this());
+        {
+            CallbackGuard G(*this);
+            if(!slots[index])
+                return; // already complete, or cancelled
+            slots[index].reset();
+            inprogress--;
+        }
+
+        // begin the next before notifying
+        launch();
+
+        CallbackGuard G(*this);
+        if(!cb) return;
+        pvac::ClientProvider::MultiGetCallback *C = cb;
+        bool last = --remaining==0u;
+        if(last)
+            cb = 0;
+        CallbackUse U(G);
+        try {
+            C->getDone(index, evt);
+            if(last)
+                C->multiGetDone();
+        } catch(std::exception& e) {
+            LOG(pva::logLevelInfo, "Lost exception during MultiGetCallback: %s", e.what());
+        }
+    }
+
+    virtual std::string name() const OVERRIDE FINAL
+    {
+        std::ostringstream strm;
+        strm<<channels.size()<<" channels";
+        return strm.str();
+    }
+
+    // called automatically via wrapped_shared_from_this
+    virtual void cancel() OVERRIDE FINAL
+    {
+        std::tr1::shared_ptr<MultiGetter> keepalive(internal_shared_from_this());
+        std::vector<std::tr1::shared_ptr<Slot> > active;
+        {
+            CallbackGuard G(*this);
+            cb = 0;
+            for(size_t i=0; i<slots.size(); i++) {
+                if(slots[i])
+                    active.push_back(slots[i]);
+                slots[i].reset();
+            }
+            inprogress = 0u;
+            G.wait();
+        }
+        for(size_t i=0; i<active.size(); i++) {
+            if(active[i]->op)
+                active[i]->op->destroy();
+        }
+    }
+
+    virtual void show(std::ostream &strm) const OVERRIDE FINAL
+    {
+        strm << "Operation(MultiGet"
+                "\"" << name() <<"\""
+             ")";
+    }
+};
+
+size_t MultiGetter::num_instances;
+
 } //namespace
 
 namespace pvac {
@@ -166,11 +359,44 @@ ClientChannel::get(ClientChannel::GetCallback* cb,
     return Operation(ret);
 }
 
+Operation
+ClientProvider::get(const std::vector<ClientChannel>& channels,
+                    MultiGetCallback* cb,
+                    epics::pvData::PVStructure::const_shared_pointer pvRequest,
+                    size_t window)
+{
+    if(!impl) throw std::logic_error("Dead Provider");
+    if(!pvRequest)
+        pvRequest = pvd::createRequest("field()");
+
+    std::vector<pva::Channel::shared_pointer> chans(channels.size());
+    for(size_t i=0; i<channels.size(); i++) {
+        if(!channels[i].impl) throw std::logic_error("Dead Channel");
+        chans[i] = const_cast<ClientChannel&>(channels[i]).getChannel();
+    }
+
+    std::tr1::shared_ptr<MultiGetter> ret(MultiGetter::build(chans, std::tr1::const_pointer_cast<pvd::PVStructure>(pvRequest), window));
+    {
+        Guard G(ret->mutex);
+        ret->cb = cb;
+    }
+
+    if(channels.empty()) {
+        if(cb)
+            cb->multiGetDone();
+    } else {
+        ret->launch();
+    }
+
+    return Operation(ret);
+}
+
 namespace detail {
 
 void registerRefTrackGet()
 {
     epics::registerRefCounter("pvac::Getter", &Getter::num_instances);
+    epics::registerRefCounter("pvac::MultiGetter", &MultiGetter::num_instances);
 }
 
 }
@@ -6,6 +6,7 @@
 #include <epicsMutex.h>
 #include <epicsGuard.h>
 #include <epicsEvent.h>
+#include <epicsTime.h>
 
 #include <pv/current_function.h>
 #include <pv/pvData.h>
@@ -87,6 +88,66 @@ pvac::ClientChannel::get(double timeout,
     }
 }
 
+namespace {
+struct MultiGetWait : public pvac::ClientProvider::MultiGetCallback,
+                      public WaitCommon
+{
+    std::vector<pvac::GetEvent>& results;
+    size_t nsuccess;
+
+    explicit MultiGetWait(std::vector<pvac::GetEvent>& results) :results(results), nsuccess(0u) {}
+    virtual ~MultiGetWait() {}
+    virtual void getDone(size_t index, const pvac::GetEvent& evt) OVERRIDE FINAL
+    {
+        Guard G(mutex);
+        results[index] = evt;
+        if(evt.event==pvac::GetEvent::Success)
+            nsuccess++;
+    }
+    virtual void multiGetDone() OVERRIDE FINAL
+    {
+        {
+            Guard G(mutex);
+            done = true;
+        }
+        event.signal();
+    }
+};
+} //namespace
+
+size_t
+ClientProvider::get(const std::vector<ClientChannel>& channels,
+                    std::vector<GetEvent>& results,
+                    double timeout,
+                    epics::pvData::PVStructure::const_shared_pointer pvRequest,
+                    size_t window)
+{
+    results.clear();
+    results.resize(channels.size());
+    for(size_t i=0; i<results.size(); i++)
+        results[i].event = GetEvent::Cancel;
+
+    MultiGetWait waiter(results);
+    {
+        Operation op(get(channels, &waiter, pvRequest, window));
+
+        epicsTimeStamp start, now;
+        epicsTimeGetCurrent(&start);
+
+        Guard G(waiter.mutex);
+        while(!waiter.done) {
+            epicsTimeGetCurrent(&now);
+            double remaining = timeout - epicsTimeDiffInSeconds(&now, &start);
+            if(remaining<=0.0)
+                break;
+            UnGuard U(G);
+            waiter.event.wait(remaining);
+        }
+        // op cancelled when leaving this scope.  No more callbacks after
+    }
+    return waiter.nsuccess;
+}
+
 pvd::PVStructure::const_shared_pointer
 pvac::ClientChannel::rpc(double timeout,
                        const epics::pvData::PVStructure::const_shared_pointer& arguments,
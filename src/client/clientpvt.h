@@ -83,6 +83,15 @@ public:
         inner->myselfptr = inner;
         return ret;
     }
+
+    template<typename A, typename B, typename C>
+    static
+    std::tr1::shared_ptr<Derived> build(A a, B b, C c) {
+        std::tr1::shared_ptr<Derived> inner(new Derived(a, b, c)),
+                                   ret(inner.get(), canceller(inner));
+        inner->myselfptr = inner;
+        return ret;
+    }
 #endif
 };
 
@@ -14,6 +14,7 @@
 #include <pv/pvAccess.h>
 #include <pv/reftrack.h>
 #include <pv/createRequest.h>
+#include <pv/elementPool.h>
 
 namespace pvd = epics::pvData;
 
@@ -32,6 +33,17 @@ MonitorFIFO::Config::Config()
 
 size_t MonitorFIFO::num_instances;
 
+namespace {
+// take a recycled element of the requested type, or construct a new one
+MonitorElementPtr newElement(const pvd::PVRequestMapper& mapper)
+{
+    MonitorElementPtr ret(detail::ElementPool::instance().get(mapper.requested()));
+    if(!ret)
+        ret.reset(new MonitorElement(mapper.buildRequested()));
+    return ret;
+}
+} // namespace
+
 MonitorFIFO::Source::~Source() {}
 
 MonitorFIFO::MonitorFIFO(const std::tr1::shared_ptr<MonitorRequester> &requester,
@@ -96,6 +108,10 @@ MonitorFIFO::MonitorFIFO(const std::tr1::shared_ptr<MonitorRequester> &requester
 
 MonitorFIFO::~MonitorFIFO() {
     REFTRACE_DECREMENT(num_instances);
+    detail::ElementPool& pool = detail::ElementPool::instance();
+    pool.put(empty.begin(), empty.end());
+    pool.put(inuse.begin(), inuse.end());
+    pool.put(returned.begin(), returned.end());
 }
 
 void MonitorFIFO::destroy()
@@ -148,7 +164,14 @@ void MonitorFIFO::open(const pvd::StructureConstPtr& type)
             throw std::logic_error("Monitor finished.  re-open() not possible");
 
         // keep the code simpler.
-        // never try to re-use elements, even on re-open w/o type change.
+        // hand all elements to the pool, and take them back if the type is unchanged.
+        // Elements still held downstream are not re-used.
+        {
+            detail::ElementPool& pool = detail::ElementPool::instance();
+            pool.put(empty.begin(), empty.end());
+            pool.put(inuse.begin(), inuse.end());
+            pool.put(returned.begin(), returned.end());
+        }
         empty.clear();
         inuse.clear();
         returned.clear();
@@ -161,8 +184,7 @@ void MonitorFIFO::open(const pvd::StructureConstPtr& type)
             message = mapper.warnings();
 
             while(empty.size() < conf.actualCount+1) {
-                MonitorElementPtr elem(new MonitorElement(mapper.buildRequested()));
-                empty.push_back(elem);
+                empty.push_back(newElement(mapper));
             }
 
             state = Opened;
@@ -228,7 +250,7 @@ bool MonitorFIFO::tryPost(const pvData::PVStructure& value,
         empty.pop_front();
     } else if(force) {
         // allocate an extra element
-        elem.reset(new MonitorElement(mapper.buildRequested()));
+        elem = newElement(mapper);
     }
 
     if(elem) {
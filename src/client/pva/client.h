@@ -8,6 +8,7 @@
 #include <ostream>
 #include <stdexcept>
 #include <list>
+#include <vector>
 
 #include <epicsMutex.h>
 
@@ -543,6 +544,80 @@ public:
     ClientChannel connect(const std::string& name,
                           const ClientChannel::Options& conf = ClientChannel::Options());
 
+    //! Aggregate connection notification for many channels
+    struct ConnectAllCallback {
+        virtual ~ConnectAllCallback() {}
+        //! Every channel has connected at least once.  Called at most once.
+        virtual void connectAllDone()=0;
+    };
+
+    /** Get many new Channels
+     *
+     * As connect() for each name, with the channel searches and creation batched
+     * when the provider supports this (eg. "pva").
+     * Names found in the internal Channel cache re-use the cached Channel.
+     * Does not block.
+     *
+     * @param names Channel names
+     * @param channels Set to one ClientChannel for each name, in the same order
+     * @param cb If not NULL, notified once when all of the channels have connected,
+     *           possibly before this call returns.  Must outlive Operation (call Operation::cancel() to force release)
+     * @returns A handle for the 'cb' notification.
+     * @throw std::logic_error if any name is an empty string
+     * @throw std::runtime_error if any Channel can not be created.  Then none of this batch
+     *        are created or cached, and 'channels' is not changed.
+     * @since 7.1.0
+     */
+    Operation connect(const std::vector<std::string>& names,
+                      std::vector<ClientChannel>& channels,
+                      ConnectAllCallback* cb = 0,
+                      const ClientChannel::Options& conf = ClientChannel::Options());
+
+    //! Completion notification for each get of a multi-get
+    struct MultiGetCallback {
+        virtual ~MultiGetCallback() {}
+        //! Get from channels[index] is complete
+        virtual void getDone(size_t index, const GetEvent& evt)=0;
+        //! All gets are complete.  Called once, after the last getDone()
+        virtual void multiGetDone() {}
+    };
+
+    /** Get from many channels
+     *
+     * Begins gets for up to 'window' channels at once, and begins another as each completes.
+     * Requests for channels of the same server are queued, and sent, together.
+     * Each get creates, and destroys, its own operation in two round trips (as ClientChannel::get() ).
+     * Results are notified in order of completion.
+     *
+     * @param channels Channels to get from.  Need not be connected.
+     * @param cb Completion notification callback.  Must outlive Operation (call Operation::cancel() to force release)
+     * @param pvRequest if NULL defaults to "field()".
+     * @param window Maximum number of gets in progress.  0 for no limit.
+     * @returns A handle for all gets.  Cancelling stops further notification.
+     * @since 7.1.0
+     */
+    Operation get(const std::vector<ClientChannel>& channels,
+                  MultiGetCallback* cb,
+                  epics::pvData::PVStructure::const_shared_pointer pvRequest = epics::pvData::PVStructure::const_shared_pointer(),
+                  size_t window = 1024u);
+
+    /** Synchronous get from many channels
+     *
+     * @param channels Channels to get from.  Need not be connected.
+     * @param results Set to one GetEvent for each channel, in the same order.
+     *                Those not complete after 'timeout' are GetEvent::Cancel
+     * @param timeout Time for all gets to complete, in seconds
+     * @param pvRequest if NULL defaults to "field()".
+     * @param window Maximum number of gets in progress.  0 for no limit.
+     * @returns The number of GetEvent::Success results
+     * @since 7.1.0
+     */
+    size_t get(const std::vector<ClientChannel>& channels,
+               std::vector<GetEvent>& results,
+               double timeout = 3.0,
+               epics::pvData::PVStructure::const_shared_pointer pvRequest = epics::pvData::PVStructure::const_shared_pointer(),
+               size_t window = 1024u);
+
     //! Remove from channel cache
     bool disconnect(const std::string& name,
                     const ClientChannel::Options& conf = ClientChannel::Options());
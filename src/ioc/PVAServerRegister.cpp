@@ -107,6 +107,25 @@ void pvasr(int lvl)
     }
 }
 
+void pvasstats(int lvl)
+{
+    try {
+        pva::ServerContext::shared_pointer serv;
+        {
+            pvd::Lock G(the_server_lock);
+            serv = the_server;
+        }
+        if(!serv) {
+            std::cout<<"PVA server not running\n";
+        } else {
+            serv->printStats(std::cout, lvl);
+        }
+        std::cout.flush();
+    }catch(std::exception& e){
+        std::cout<<"Error: "<<e.what()<<std::endl;
+    }
+}
+
 void pva_server_cleanup(void *)
 {
     stopPVAServer();
@@ -129,6 +148,7 @@ void registerStartPVAServer(void)
     epics::iocshRegister<const char*, &startPVAServer>("startPVAServer", "provider names");
     epics::iocshRegister<&stopPVAServer>("stopPVAServer");
     epics::iocshRegister<int, &pvasr>("pvasr", "detail");
+    epics::iocshRegister<int, &pvasstats>("pvasstats", "detail");
     initHookRegister(&initStartPVAServer);
 }
 
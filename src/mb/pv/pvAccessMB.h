@@ -7,30 +7,197 @@
 #ifndef _PVACCESSMB_H_
 #define _PVACCESSMB_H_
 
-/* this header is deprecated */
+/** @file pvAccessMB.h
+ *
+ * Trace points, to find where time is spent along a pipeline.
+ *
+ * A tracer, declared with MB_DECLARE(), records for each MB_POINT() the
+ * time, a stage number, and an ID (eg. of one message).  Points with the
+ * same ID are matched, in time order, to give the time taken to reach each stage
+ * from the one before.
+ *
+ * Each thread writes to a ring buffer of its own, without locking,
+ * which keeps its most recent SIZE-1 points.  Reading (MB_STATS() and friends)
+ * may be done at any time, from any thread.
+ * The ring of a thread which exits is re-used by the next thread to record a point.
+ * At most Tracer::maxRings threads are traced at once, others record nothing.
+ *
+ * The MB_* macros expand to nothing unless WITH_MICROBENCH is defined.
+ * pvAccess itself is traced when built with WITH_MICROBENCH=YES
+ * (eg. in configure/CONFIG_SITE.local), with tracers:
+ *
+ * - pvaReceive : socket read (0), header parse (1), handler dispatch (2),
+ *   handler done (3).  One ID per message received.
+ * - pvaMonitor : provider callback (0), serialize (1), socket write (2).
+ *   One ID per server monitor update.  Socket write is of the last update in
+ *   each buffer sent.
+ *
+ * If $EPICS_PVA_MB_FILE is set, all tracers are written there in CSV form at exit.
+ */
+
+#include <vector>
+#include <ostream>
+#include <istream>
+
+#ifdef epicsExportSharedSymbols
+#   define pvAccessMBEpicsExportSharedSymbols
+#   undef epicsExportSharedSymbols
+#endif
+
+#include <epicsTypes.h>
+#include <epicsMutex.h>
+#include <epicsThread.h>
+#include <compilerDependencies.h>
+
+#ifdef pvAccessMBEpicsExportSharedSymbols
+#   define epicsExportSharedSymbols
+#	undef pvAccessMBEpicsExportSharedSymbols
+#endif
+
+#include <shareLib.h>
+
+namespace epics {
+namespace pvAccess {
+namespace mb {
+
+//! One recorded trace point
+struct Point {
+    epicsUInt64 id;
+    epicsUInt64 time; //!< ns.  Relative to the first point of the same ID once normalized.
+    epicsUInt32 stage;
+};
+
+/** A named set of per-thread rings of trace points.
+ *
+ * ID 0 means "not traced", points with this ID are not recorded.
+ */
+class epicsShareClass Tracer
+{
+    EPICS_NOT_COPYABLE(Tracer)
+public:
+    enum { maxStages = 32 };
+    //! Most threads with a ring at one time
+    enum { maxRings = 64 };
+
+    /** @param name Shown in output
+     *  @param size Number of points kept for each thread.  Rounded up to a power of 2.
+     */
+    Tracer(const char *name, size_t size);
+    ~Tracer();
+
+    const char* name() const { return _name; }
+
+    //! Record a point with ID, which becomes the current ID of this thread.
+    void point(epicsUInt32 stage, const char *desc, epicsUInt64 id);
+    //! Record a point with the current ID of this thread.
+    void point(epicsUInt32 stage, const char *desc);
+    //! Use a new, unique, current ID for this thread.
+    void nextID();
+    //! Stop tracing in this thread, until the next ID.
+    void clearID();
+
+    //! Show times relative to the first point of each ID
+    void normalize();
+
+    /** Copy of all points, sorted by ID then time.
+     *
+     * @param stage Only this stage, or all if <0.
+     * @param skip Omit the first N IDs (eg. warm up)
+     */
+    void collect(std::vector<Point>& points, int stage=-1, size_t skip=0u) const;
+
+    //! Per stage count, and min/percentiles/max time taken to reach it, in microseconds.
+    void stats(std::ostream& strm, int stage=-1, size_t skip=0u) const;
+    //! As CSV lines "id,stage,time" with time in ns.
+    void csvExport(std::ostream& strm, int stage=-1, size_t skip=0u) const;
+    //! Add points from csvExport() output
+    void csvImport(std::istream& strm);
+    //! One line for each point
+    void print(std::ostream& strm, int stage=-1, size_t skip=0u) const;
+
+    //! Write all tracers to $EPICS_PVA_MB_FILE (if set) at exit.  May be called more than once.
+    static void init();
+    //! csvExport() all tracers, each preceded by a "# name" line.
+    static void exportAll(std::ostream& strm);
+
+    struct Ring;
+    //! Make the ring of an exited thread available for re-use
+    void release(Ring *R);
+private:
+    //! NULL if this thread is not traced
+    Ring* ring();
+
+    const char * const _name;
+    size_t _size; // power of 2
+    epicsThreadPrivateId _ring;
+    size_t _lastID;
+    void *_desc[maxStages];
+    bool _normalize;
+
+    mutable epicsMutex _lock;
+    // guarded by _lock
+    std::vector<Ring*> _rings;
+    // subset of _rings not in use by any thread
+    std::vector<Ring*> _free;
+    std::vector<Point> _imported;
+};
+
+}}} // namespace epics::pvAccess::mb
+
+#ifdef WITH_MICROBENCH
+
+#define MB_DECLARE(NAME, SIZE) ::epics::pvAccess::mb::Tracer NAME(#NAME, SIZE)
+#define MB_DECLARE_EXTERN(NAME) extern ::epics::pvAccess::mb::Tracer NAME
+
+#define MB_POINT_ID(NAME, STAGE, STAGE_DESC, ID) NAME.point(STAGE, STAGE_DESC, ID)
+
+#define MB_INC_AUTO_ID(NAME) NAME.nextID()
+#define MB_CLEAR_ID(NAME) NAME.clearID()
+#define MB_POINT(NAME, STAGE, STAGE_DESC) NAME.point(STAGE, STAGE_DESC)
+
+#define MB_POINT_CONDITIONAL(NAME, STAGE, STAGE_DESC, COND) do { if(COND) NAME.point(STAGE, STAGE_DESC); } while(0)
+
+#define MB_NORMALIZE(NAME) NAME.normalize()
+
+#define MB_STATS(NAME, STREAM) NAME.stats(STREAM)
+#define MB_STATS_OPT(NAME, STAGE_ONLY, SKIP_FIRST_N_SAMPLES, STREAM) NAME.stats(STREAM, STAGE_ONLY, SKIP_FIRST_N_SAMPLES)
+
+#define MB_CSV_EXPORT(NAME, STREAM) NAME.csvExport(STREAM)
+#define MB_CSV_EXPORT_OPT(NAME, STAGE_ONLY, SKIP_FIRST_N_SAMPLES, STREAM) NAME.csvExport(STREAM, STAGE_ONLY, SKIP_FIRST_N_SAMPLES)
+#define MB_CSV_IMPORT(NAME, STREAM) NAME.csvImport(STREAM)
+
+#define MB_PRINT(NAME, STREAM) NAME.print(STREAM)
+#define MB_PRINT_OPT(NAME, STAGE_ONLY, SKIP_FIRST_N_SAMPLES, STREAM) NAME.print(STREAM, STAGE_ONLY, SKIP_FIRST_N_SAMPLES)
+
+#define MB_INIT ::epics::pvAccess::mb::Tracer::init()
+
+#else // WITH_MICROBENCH
 
 #define MB_DECLARE(NAME, SIZE)
 #define MB_DECLARE_EXTERN(NAME)
 
-#define MB_POINT_ID(NAME, STAGE, STAGE_DESC, ID)
+#define MB_POINT_ID(NAME, STAGE, STAGE_DESC, ID) do {} while(0)
+
+#define MB_INC_AUTO_ID(NAME) do {} while(0)
+#define MB_CLEAR_ID(NAME) do {} while(0)
+#define MB_POINT(NAME, STAGE, STAGE_DESC) do {} while(0)
 
-#define MB_INC_AUTO_ID(NAME)
-#define MB_POINT(NAME, STAGE, STAGE_DESC)
+#define MB_POINT_CONDITIONAL(NAME, STAGE, STAGE_DESC, COND) do {} while(0)
 
-#define MB_POINT_CONDITIONAL(NAME, STAGE, STAGE_DESC, COND)
+#define MB_NORMALIZE(NAME) do {} while(0)
 
-#define MB_NORMALIZE(NAME)
+#define MB_STATS(NAME, STREAM) do {} while(0)
+#define MB_STATS_OPT(NAME, STAGE_ONLY, SKIP_FIRST_N_SAMPLES, STREAM) do {} while(0)
 
-#define MB_STATS(NAME, STREAM)
-#define MB_STATS_OPT(NAME, STAGE_ONLY, SKIP_FIRST_N_SAMPLES, STREAM)
+#define MB_CSV_EXPORT(NAME, STREAM) do {} while(0)
+#define MB_CSV_EXPORT_OPT(NAME, STAGE_ONLY, SKIP_FIRST_N_SAMPLES, STREAM) do {} while(0)
+#define MB_CSV_IMPORT(NAME, STREAM) do {} while(0)
 
-#define MB_CSV_EXPORT(NAME, STREAM)
-#define MB_CSV_EXPORT_OPT(NAME, STAGE_ONLY, SKIP_FIRST_N_SAMPLES, STREAM)
-#define MB_CSV_IMPORT(NAME, STREAM)
+#define MB_PRINT(NAME, STREAM) do {} while(0)
+#define MB_PRINT_OPT(NAME, STAGE_ONLY, SKIP_FIRST_N_SAMPLES, STREAM) do {} while(0)
 
-#define MB_PRINT(NAME, STREAM)
-#define MB_PRINT_OPT(NAME, STAGE_ONLY, SKIP_FIRST_N_SAMPLES, STREAM)
+#define MB_INIT do {} while(0)
 
-#define MB_INIT
+#endif // WITH_MICROBENCH
 
 #endif
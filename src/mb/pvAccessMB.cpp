@@ -0,0 +1,405 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <stdlib.h>
+
+#include <epicsVersion.h>
+#include <epicsAtomic.h>
+#include <epicsGuard.h>
+#include <epicsExit.h>
+
+#define epicsExportSharedSymbols
+#include <pv/pvAccessMB.h>
+#include <pv/transportStats.h>
+
+typedef epicsGuard<epicsMutex> Guard;
+
+namespace epics {
+namespace pvAccess {
+namespace mb {
+
+struct Tracer::Ring {
+    std::vector<Point> points;
+    // count of points ever recorded.  Only written by the owning thread.
+    size_t head;
+    // current ID of the owning thread
+    epicsUInt64 id;
+
+    explicit Ring(size_t size) :points(size), head(0u), id(0u) {}
+};
+
+namespace {
+
+struct Registry {
+    epicsMutex lock;
+    std::vector<Tracer*> tracers;
+};
+
+Registry* registry;
+epicsThreadOnceId registryOnce = EPICS_THREAD_ONCE_INIT;
+
+void registryInit(void *)
+{
+    // never free'd, as Tracers are usually static
+    registry = new Registry;
+}
+
+Registry& getRegistry()
+{
+    epicsThreadOnce(&registryOnce, &registryInit, 0);
+    return *registry;
+}
+
+// thread-private value of a thread which is not traced, as all rings are in use
+char untraced;
+
+#if defined(EPICS_VERSION_INT) && EPICS_VERSION_INT>=VERSION_INT(3,15,0,2)
+#  define USE_THREAD_EXIT
+
+struct RingExit {
+    Tracer *tracer;
+    Tracer::Ring *ring;
+};
+
+// hand the ring of an exiting thread back to its Tracer, if it still exists
+void ringExit(void *raw)
+{
+    RingExit *hook = static_cast<RingExit*>(raw);
+    {
+        Registry& reg = getRegistry();
+        Guard G(reg.lock);
+        if(std::find(reg.tracers.begin(), reg.tracers.end(), hook->tracer)!=reg.tracers.end())
+            hook->tracer->release(hook->ring);
+    }
+    delete hook;
+}
+#endif
+
+
+epicsThreadOnceId initOnce = EPICS_THREAD_ONCE_INIT;
+
+void writeAll(void *raw)
+{
+    const char *fname = static_cast<const char*>(raw);
+    std::ofstream strm(fname);
+    if(strm.is_open())
+        Tracer::exportAll(strm);
+}
+
+void initOnceInit(void *)
+{
+    const char *fname = getenv("EPICS_PVA_MB_FILE");
+    if(fname && fname[0])
+        epicsAtExit(&writeAll, (void*)fname);
+}
+
+struct ByIDTime {
+    bool operator()(const Point& lhs, const Point& rhs) const
+    {
+        return lhs.id < rhs.id || (lhs.id == rhs.id && lhs.time < rhs.time);
+    }
+};
+
+double percentile(const std::vector<epicsUInt64>& sorted, double p)
+{
+    return sorted[size_t(p*(sorted.size()-1u) + 0.5)]*1e-3;
+}
+
+} // namespace
+
+Tracer::Tracer(const char *name, size_t size)
+    :_name(name)
+    ,_size(1u)
+    ,_ring(epicsThreadPrivateCreate())
+    ,_lastID(0u)
+    ,_normalize(false)
+{
+    while(_size < size)
+        _size <<= 1u;
+    for(size_t i=0; i<maxStages; i++)
+        _desc[i] = 0;
+
+    Registry& reg = getRegistry();
+    Guard G(reg.lock);
+    reg.tracers.push_back(this);
+}
+
+Tracer::~Tracer()
+{
+    {
+        Registry& reg = getRegistry();
+        Guard G(reg.lock);
+        reg.tracers.erase(std::remove(reg.tracers.begin(), reg.tracers.end(), this), reg.tracers.end());
+    }
+    for(size_t i=0; i<_rings.size(); i++)
+        delete _rings[i];
+    epicsThreadPrivateDelete(_ring);
+}
+
+Tracer::Ring* Tracer::ring()
+{
+    void *raw = epicsThreadPrivateGet(_ring);
+    if(raw==&untraced)
+        return 0;
+    Ring *R = static_cast<Ring*>(raw);
+    if(!R) {
+        {
+            Guard G(_lock);
+            if(!_free.empty()) {
+                // ring of an exited thread.  Keeps its points until overwritten
+                R = _free.back();
+                _free.pop_back();
+                R->id = 0u;
+            } else if(_rings.size() < maxRings) {
+                R = new Ring(_size);
+                _rings.push_back(R);
+            }
+        }
+#ifdef USE_THREAD_EXIT
+        if(R) {
+            RingExit *hook = new RingExit;
+            hook->tracer = this;
+            hook->ring = R;
+            if(epicsAtThreadExit(&ringExit, hook)) {
+                // can't recycle this one
+                delete hook;
+            }
+        }
+#endif
+        epicsThreadPrivateSet(_ring, R ? static_cast<void*>(R) : static_cast<void*>(&untraced));
+    }
+    return R;
+}
+
+void Tracer::release(Ring *R)
+{
+    Guard G(_lock);
+    if(std::find(_rings.begin(), _rings.end(), R)!=_rings.end())
+        _free.push_back(R);
+}
+
+void Tracer::point(epicsUInt32 stage, const char *desc, epicsUInt64 id)
+{
+    if(id==0u || stage>=maxStages)
+        return;
+
+    if(!epics::atomic::get(_desc[stage]))
+        epics::atomic::compareAndSwap(_desc[stage], (EpicsAtomicPtrT)0, (EpicsAtomicPtrT)desc);
+
+    Ring *R = ring();
+    if(!R)
+        return;
+    R->id = id;
+
+    const size_t head = R->head;
+    Point& P = R->points[head & (_size-1u)];
+    P.id = id;
+    P.stage = stage;
+    P.time = detail::statsClock();
+    // publish after the point is complete
+    epics::atomic::set(R->head, head+1u);
+}
+
+void Tracer::point(epicsUInt32 stage, const char *desc)
+{
+    Ring *R = ring();
+    if(R)
+        point(stage, desc, R->id);
+}
+
+void Tracer::nextID()
+{
+    Ring *R = ring();
+    if(R)
+        R->id = epics::atomic::increment(_lastID);
+}
+
+void Tracer::clearID()
+{
+    Ring *R = ring();
+    if(R)
+        R->id = 0u;
+}
+
+void Tracer::normalize()
+{
+    Guard G(_lock);
+    _normalize = true;
+}
+
+void Tracer::collect(std::vector<Point>& points, int stage, size_t skip) const
+{
+    points.clear();
+    bool norm;
+    {
+        Guard G(_lock);
+        norm = _normalize;
+        points = _imported;
+
+        for(size_t r=0; r<_rings.size(); r++) {
+            const Ring& R = *_rings[r];
+
+            size_t end = epics::atomic::get(R.head);
+            epicsAtomicReadMemoryBarrier();
+            size_t begin = end > _size ? end-_size : 0u;
+
+            size_t first = points.size();
+            for(size_t i=begin; i<end; i++)
+                points.push_back(R.points[i & (_size-1u)]);
+
+            // the owner may have overwritten the oldest points while we copied,
+            // including the one being written now.
+            epicsAtomicReadMemoryBarrier();
+            size_t after = epics::atomic::get(R.head);
+            size_t valid = after+1u > _size ? after+1u-_size : 0u;
+            if(valid > begin)
+                points.erase(points.begin()+first,
+                             points.begin()+first+std::min(valid-begin, end-begin));
+        }
+    }
+
+    std::sort(points.begin(), points.end(), ByIDTime());
+
+    size_t out = 0u, nids = 0u;
+    for(size_t i=0; i<points.size();) {
+        // one ID
+        size_t n = i+1u;
+        while(n<points.size() && points[n].id==points[i].id)
+            n++;
+
+        if(nids++ >= skip) {
+            const epicsUInt64 t0 = points[i].time;
+            for(; i<n; i++) {
+                Point P(points[i]);
+                if(norm)
+                    P.time -= t0;
+                if(stage<0 || P.stage==epicsUInt32(stage))
+                    points[out++] = P;
+            }
+        }
+        i = n;
+    }
+    points.resize(out);
+}
+
+void Tracer::stats(std::ostream& strm, int stage, size_t skip) const
+{
+    std::vector<Point> points;
+    collect(points, -1, skip);
+
+    // time to reach each stage from the point before it, and first to last of each ID
+    std::vector<std::vector<epicsUInt64> > deltas(maxStages+1u);
+    for(size_t i=0; i<points.size();) {
+        size_t n = i+1u;
+        for(; n<points.size() && points[n].id==points[i].id; n++)
+            deltas[points[n].stage].push_back(points[n].time - points[n-1u].time);
+        if(n > i+1u)
+            deltas[maxStages].push_back(points[n-1u].time - points[i].time);
+        i = n;
+    }
+
+    std::ios_base::fmtflags flags(strm.flags());
+    std::streamsize prec(strm.precision());
+    strm.setf(std::ios_base::fixed, std::ios_base::floatfield);
+    strm.precision(3);
+
+    strm<<"# "<<_name<<"\n"
+          "# stage count min p50 p90 p99 max (us)\n";
+    for(size_t s=0; s<=maxStages; s++) {
+        std::vector<epicsUInt64>& D = deltas[s];
+        if(D.empty() || (stage>=0 && s!=size_t(stage)))
+            continue;
+        std::sort(D.begin(), D.end());
+
+        if(s<maxStages)
+            strm<<s;
+        else
+            strm<<"total";
+        strm<<' '<<D.size()
+            <<' '<<D.front()*1e-3
+            <<' '<<percentile(D, 0.5)
+            <<' '<<percentile(D, 0.9)
+            <<' '<<percentile(D, 0.99)
+            <<' '<<D.back()*1e-3;
+        if(s<maxStages) {
+            const char *desc = static_cast<const char*>(epics::atomic::get(_desc[s]));
+            if(desc)
+                strm<<' '<<desc;
+        }
+        strm<<"\n";
+    }
+
+    strm.flags(flags);
+    strm.precision(prec);
+}
+
+void Tracer::csvExport(std::ostream& strm, int stage, size_t skip) const
+{
+    std::vector<Point> points;
+    collect(points, stage, skip);
+
+    for(size_t i=0; i<points.size(); i++)
+        strm<<points[i].id<<','<<points[i].stage<<','<<points[i].time<<"\n";
+}
+
+void Tracer::csvImport(std::istream& strm)
+{
+    std::vector<Point> points;
+    std::string line;
+    while(std::getline(strm, line)) {
+        if(line.empty() || line[0]=='#')
+            continue;
+
+        std::istringstream lstrm(line);
+        Point P;
+        char sep1 = 0, sep2 = 0;
+        lstrm>>P.id>>sep1>>P.stage>>sep2>>P.time;
+        if(!lstrm.fail() && sep1==',' && sep2==',' && P.stage<maxStages)
+            points.push_back(P);
+    }
+
+    Guard G(_lock);
+    _imported.insert(_imported.end(), points.begin(), points.end());
+}
+
+void Tracer::print(std::ostream& strm, int stage, size_t skip) const
+{
+    std::vector<Point> points;
+    collect(points, stage, skip);
+
+    strm<<"# "<<_name<<"\n"
+          "# id stage time(ns) description\n";
+    for(size_t i=0; i<points.size(); i++) {
+        const Point& P = points[i];
+        strm<<P.id<<' '<<P.stage<<' '<<P.time;
+        const char *desc = static_cast<const char*>(epics::atomic::get(_desc[P.stage]));
+        if(desc)
+            strm<<' '<<desc;
+        strm<<"\n";
+    }
+}
+
+void Tracer::init()
+{
+    epicsThreadOnce(&initOnce, &initOnceInit, 0);
+}
+
+void Tracer::exportAll(std::ostream& strm)
+{
+    Registry& reg = getRegistry();
+    Guard G(reg.lock);
+    for(size_t i=0; i<reg.tracers.size(); i++) {
+        strm<<"# "<<reg.tracers[i]->name()<<"\n";
+        reg.tracers[i]->csvExport(strm);
+    }
+}
+
+}}} // namespace epics::pvAccess::mb
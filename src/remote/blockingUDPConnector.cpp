@@ -37,7 +37,8 @@ namespace pvAccess {
 
 BlockingUDPTransport::shared_pointer BlockingUDPConnector::connect(ResponseHandler::shared_pointer const & responseHandler,
                                                                    osiSockAddr& bindAddress,
-                                                                   int8 transportRevision)
+                                                                   int8 transportRevision,
+                                                                   bool shareReceive)
 {
     SOCKET socket = epicsSocketCreate(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
     if(socket==INVALID_SOCKET) {
@@ -71,6 +72,23 @@ BlockingUDPTransport::shared_pointer BlockingUDPConnector::connect(ResponseHandl
     // set SO_REUSEADDR or SO_REUSEPORT, OS dependant
     epicsSocketEnableAddressUseForDatagramFanout(socket);
 
+    if(shareReceive) {
+#if defined(SO_REUSEPORT) && !defined(_WIN32)
+        // On Linux, unicast is balanced between all sockets with SO_REUSEPORT bound to an address
+        retval = ::setsockopt(socket, SOL_SOCKET, SO_REUSEPORT, (char *)&optval, sizeof(optval));
+        if(retval<0)
+        {
+            char errStr[64];
+            epicsSocketConvertErrnoToString(errStr, sizeof(errStr));
+            LOG(logLevelError, "Error setting SO_REUSEPORT: %s.", errStr);
+            epicsSocketDestroy (socket);
+            return BlockingUDPTransport::shared_pointer();
+        }
+#else
+        LOG(logLevelWarn, "SO_REUSEPORT not supported, UDP receive sharding ignored.");
+#endif
+    }
+
     retval = ::bind(socket, (sockaddr*)&(bindAddress.sa), sizeof(sockaddr));
     if(retval<0) {
         char ip[20];
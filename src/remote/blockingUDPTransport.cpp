@@ -10,17 +10,28 @@
 #endif
 
 #include <sstream>
+#include <vector>
 
 #include <sys/types.h>
 #include <cstdio>
+#include <stdlib.h>
+#include <string.h>
 
 #include <epicsThread.h>
+#include <epicsTypes.h>
 #include <osiSock.h>
 
 #include <pv/lock.h>
 #include <pv/byteBuffer.h>
 #include <pv/reftrack.h>
 
+#if defined(__linux__)
+// recvmmsg() and sendmmsg()
+#  define PVA_HAVE_MMSG
+#  include <sys/socket.h>
+#  include <sys/uio.h>
+#endif
+
 #define epicsExportSharedSymbols
 #include <pv/blockingUDP.h>
 #include <pv/pvaConstants.h>
@@ -46,6 +57,47 @@ inline int sendto(int s, const char *buf, size_t len, int flags, const struct so
 // reserve some space for CMD_ORIGIN_TAG message
 #define RECEIVE_BUFFER_PRE_RESERVE (PVA_MESSAGE_HEADER_SIZE + 16)
 
+#ifdef PVA_HAVE_MMSG
+// max. datagrams received with one recvmmsg() call
+#define RECEIVE_BATCH 16u
+// max. datagrams sent with one sendmmsg() call
+#define SEND_BATCH 64u
+#endif
+
+namespace {
+#ifdef PVA_HAVE_MMSG
+// receive buffers for a batch, not initialized so that pages are only
+// populated as datagrams arrive.
+struct BatchStorage {
+    char * const buf;
+    explicit BatchStorage(size_t size) :buf((char*)malloc(size)) {}
+    ~BatchStorage() { free(buf); }
+private:
+    BatchStorage(const BatchStorage&);
+    BatchStorage& operator=(const BatchStorage&);
+};
+#endif
+
+// is a send address of this type excluded by target
+inline bool skipTarget(InetAddressType target, bool unicast)
+{
+    return (target == inetAddressType_unicast && !unicast) ||
+            (target == inetAddressType_broadcast_multicast && unicast);
+}
+
+// FNV-1a, used to choose which of several sockets handles a datagram.
+// Identical datagrams (retries through several paths) always go to the same socket.
+size_t datagramHash(const char* buf, size_t len)
+{
+    epicsUInt32 hash = 2166136261u;
+    for(size_t i=0; i<len; i++) {
+        hash ^= epicsUInt8(buf[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+} // namespace
+
 size_t BlockingUDPTransport::num_instances;
 
 BlockingUDPTransport::BlockingUDPTransport(bool serverFlag,
@@ -65,7 +117,9 @@ BlockingUDPTransport::BlockingUDPTransport(bool serverFlag,
     _sendBuffer(MAX_UDP_RECV),
     _lastMessageStartPosition(0),
     _clientServerWithEndianFlag(
-        (serverFlag ? 0x40 : 0x00) | ((EPICS_BYTE_ORDER == EPICS_ENDIAN_BIG) ? 0x80 : 0x00))
+        (serverFlag ? 0x40 : 0x00) | ((EPICS_BYTE_ORDER == EPICS_ENDIAN_BIG) ? 0x80 : 0x00)),
+    _shardIndex(0u),
+    _shardCount(1u)
 {
     assert(_responseHandler.get());
 
@@ -231,85 +285,92 @@ void BlockingUDPTransport::run() {
 
         char* recvfrom_buffer_start = (char*)(_receiveBuffer.getBuffer()+RECEIVE_BUFFER_PRE_RESERVE);
         size_t recvfrom_buffer_len =_receiveBuffer.getSize()-RECEIVE_BUFFER_PRE_RESERVE;
+
+#ifdef PVA_HAVE_MMSG
+        /* Receive several datagrams with each recvmmsg() call.
+         * Each is copied to _receiveBuffer before processing as handlers
+         * expect to find it there, and may prefix it (see RECEIVE_BUFFER_PRE_RESERVE).
+         */
+        BatchStorage batchBuffer(RECEIVE_BATCH*recvfrom_buffer_len);
+        std::vector<osiSockAddr> batchFrom(RECEIVE_BATCH);
+        std::vector<iovec> batchIov(RECEIVE_BATCH);
+        std::vector<mmsghdr> batchMsg(RECEIVE_BATCH);
+        bool batch = !!batchBuffer.buf;
+#endif
+
         while(!_closed.get())
         {
-            int bytesRead = recvfrom(_channel,
-                                     recvfrom_buffer_start, recvfrom_buffer_len,
-                                     0, (sockaddr*)&fromAddress,
-                                     &addrStructSize);
-
-            if(likely(bytesRead>=0)) {
-                // successfully got datagram
-                bool ignore = false;
-                for(size_t i = 0; i <_ignoredAddresses.size(); i++)
-                {
-                    if(_ignoredAddresses[i].ia.sin_addr.s_addr==fromAddress.ia.sin_addr.s_addr)
-                    {
-                        ignore = true;
-                        if(pvAccessIsLoggable(logLevelDebug)) {
-                            char strBuffer[64];
-                            sockAddrToDottedIP(&fromAddress.sa, strBuffer, sizeof(strBuffer));
-                            LOG(logLevelDebug, "UDP Ignore (%d) %s x- %s", bytesRead, _remoteName.c_str(), strBuffer);
-                        }
-                        break;
-                    }
+#ifdef PVA_HAVE_MMSG
+            if(likely(batch)) {
+                for(size_t i=0; i<RECEIVE_BATCH; i++) {
+                    batchIov[i].iov_base = batchBuffer.buf + i*recvfrom_buffer_len;
+                    batchIov[i].iov_len = recvfrom_buffer_len;
+                    memset(&batchMsg[i], 0, sizeof(batchMsg[i]));
+                    batchMsg[i].msg_hdr.msg_iov = &batchIov[i];
+                    batchMsg[i].msg_hdr.msg_iovlen = 1;
+                    batchMsg[i].msg_hdr.msg_name = &batchFrom[i].sa;
+                    batchMsg[i].msg_hdr.msg_namelen = sizeof(batchFrom[i]);
                 }
 
-                if(likely(!ignore)) {
-                    if(pvAccessIsLoggable(logLevelDebug)) {
-                        char strBuffer[64];
-                        sockAddrToDottedIP(&fromAddress.sa, strBuffer, sizeof(strBuffer));
-                        LOG(logLevelDebug, "UDP Rx (%d) %s <- %s", bytesRead, _remoteName.c_str(), strBuffer);
-                    }
-
-                    _receiveBuffer.setPosition(RECEIVE_BUFFER_PRE_RESERVE);
-                    _receiveBuffer.setLimit(RECEIVE_BUFFER_PRE_RESERVE+bytesRead);
-
-                    try {
-                        processBuffer(thisTransport, fromAddress, &_receiveBuffer);
-                    } catch(std::exception& e) {
-                        if(IS_LOGGABLE(logLevelError)) {
-                            char strBuffer[64];
-                            sockAddrToDottedIP(&fromAddress.sa, strBuffer, sizeof(strBuffer));
-                            size_t epos = _receiveBuffer.getPosition();
-
-                            // of course _receiveBuffer _may_ have been modified during processing...
-                            _receiveBuffer.setPosition(RECEIVE_BUFFER_PRE_RESERVE);
-                            _receiveBuffer.setLimit(RECEIVE_BUFFER_PRE_RESERVE+bytesRead);
+                // block for the first datagram, then take any others already queued
+                int count = recvmmsg(_channel, &batchMsg[0], RECEIVE_BATCH, MSG_WAITFORONE, 0);
 
-                            std::cerr<<"Error on UDP RX "<<strBuffer<<" -> "<<_remoteName<<" at "<<epos<<" : "<<e.what()<<"\n"
-                                      <<HexDump(_receiveBuffer).limit(256u);
-                        }
+                if(likely(count>0)) {
+                    for(int i=0; i<count; i++) {
+                        size_t bytesRead = batchMsg[i].msg_len;
+                        memcpy(recvfrom_buffer_start, batchBuffer.buf + i*recvfrom_buffer_len, bytesRead);
+                        processDatagram(thisTransport, batchFrom[i], bytesRead);
                     }
-                }
-            } else {
-
-                int socketError = SOCKERRNO;
-
-                // interrupted or timeout
-                if (socketError == SOCK_EINTR ||
-                        socketError == EAGAIN ||        // no alias in libCom
-                        // windows times out with this
-                        socketError == SOCK_ETIMEDOUT ||
-                        socketError == SOCK_EWOULDBLOCK)
                     continue;
 
-                if (socketError == SOCK_ECONNREFUSED || // avoid spurious ECONNREFUSED in Linux
-                        socketError == SOCK_ECONNRESET)     // or ECONNRESET in Windows
+                } else if(count==0) {
                     continue;
 
-                // log a 'recvfrom' error
-                if(!_closed.get())
-                {
-                    char errStr[64];
-                    epicsSocketConvertErrnoToString(errStr, sizeof(errStr));
-                    LOG(logLevelError, "Socket recvfrom error: %s.", errStr);
+                } else if(SOCKERRNO==ENOSYS) {
+                    // not implemented by this kernel
+                    batch = false;
+                    continue;
+                }
+                // fall through to error handling
+            } else
+#endif
+            {
+                int bytesRead = recvfrom(_channel,
+                                         recvfrom_buffer_start, recvfrom_buffer_len,
+                                         0, (sockaddr*)&fromAddress,
+                                         &addrStructSize);
+
+                if(likely(bytesRead>=0)) {
+                    // successfully got datagram
+                    processDatagram(thisTransport, fromAddress, bytesRead);
+                    continue;
                 }
+            }
 
-                close(false);
-                break;
+            int socketError = SOCKERRNO;
+
+            // interrupted or timeout
+            if (socketError == SOCK_EINTR ||
+                    socketError == EAGAIN ||        // no alias in libCom
+                    // windows times out with this
+                    socketError == SOCK_ETIMEDOUT ||
+                    socketError == SOCK_EWOULDBLOCK)
+                continue;
+
+            if (socketError == SOCK_ECONNREFUSED || // avoid spurious ECONNREFUSED in Linux
+                    socketError == SOCK_ECONNRESET)     // or ECONNRESET in Windows
+                continue;
+
+            // log a 'recvfrom' error
+            if(!_closed.get())
+            {
+                char errStr[64];
+                epicsSocketConvertErrnoToString(errStr, sizeof(errStr));
+                LOG(logLevelError, "Socket recvfrom error: %s.", errStr);
             }
 
+            close(false);
+            break;
         }
     } catch(...) {
         // TODO: catch all exceptions, and act accordingly
@@ -323,6 +384,59 @@ void BlockingUDPTransport::run() {
     }
 }
 
+void BlockingUDPTransport::processDatagram(Transport::shared_pointer const & transport,
+                                           osiSockAddr& fromAddress, size_t bytesRead)
+{
+    const char* recvfrom_buffer_start = _receiveBuffer.getBuffer()+RECEIVE_BUFFER_PRE_RESERVE;
+
+    bool ignore = false;
+    for(size_t i = 0; i <_ignoredAddresses.size(); i++)
+    {
+        if(_ignoredAddresses[i].ia.sin_addr.s_addr==fromAddress.ia.sin_addr.s_addr)
+        {
+            ignore = true;
+            if(pvAccessIsLoggable(logLevelDebug)) {
+                char strBuffer[64];
+                sockAddrToDottedIP(&fromAddress.sa, strBuffer, sizeof(strBuffer));
+                LOG(logLevelDebug, "UDP Ignore (%zu) %s x- %s", bytesRead, _remoteName.c_str(), strBuffer);
+            }
+            break;
+        }
+    }
+
+    // another socket handles this datagram
+    if(_shardCount>1u && datagramHash(recvfrom_buffer_start, bytesRead)%_shardCount!=_shardIndex)
+        ignore = true;
+
+    if(likely(!ignore)) {
+        if(pvAccessIsLoggable(logLevelDebug)) {
+            char strBuffer[64];
+            sockAddrToDottedIP(&fromAddress.sa, strBuffer, sizeof(strBuffer));
+            LOG(logLevelDebug, "UDP Rx (%zu) %s <- %s", bytesRead, _remoteName.c_str(), strBuffer);
+        }
+
+        _receiveBuffer.setPosition(RECEIVE_BUFFER_PRE_RESERVE);
+        _receiveBuffer.setLimit(RECEIVE_BUFFER_PRE_RESERVE+bytesRead);
+
+        try {
+            processBuffer(transport, fromAddress, &_receiveBuffer);
+        } catch(std::exception& e) {
+            if(IS_LOGGABLE(logLevelError)) {
+                char strBuffer[64];
+                sockAddrToDottedIP(&fromAddress.sa, strBuffer, sizeof(strBuffer));
+                size_t epos = _receiveBuffer.getPosition();
+
+                // of course _receiveBuffer _may_ have been modified during processing...
+                _receiveBuffer.setPosition(RECEIVE_BUFFER_PRE_RESERVE);
+                _receiveBuffer.setLimit(RECEIVE_BUFFER_PRE_RESERVE+bytesRead);
+
+                std::cerr<<"Error on UDP RX "<<strBuffer<<" -> "<<_remoteName<<" at "<<epos<<" : "<<e.what()<<"\n"
+                          <<HexDump(_receiveBuffer).limit(256u);
+            }
+        }
+    }
+}
+
 bool BlockingUDPTransport::processBuffer(Transport::shared_pointer const & transport,
         osiSockAddr& fromAddress, ByteBuffer* receiveBuffer) {
 
@@ -483,14 +597,73 @@ bool BlockingUDPTransport::send(ByteBuffer* buffer, InetAddressType target) {
     buffer->flip();
 
     bool allOK = true;
-    for(size_t i = 0; i<_sendAddresses.size(); i++) {
+    size_t i = 0;
+
+#ifdef PVA_HAVE_MMSG
+    // send to several addresses with each sendmmsg() call
+    iovec iov;
+    iov.iov_base = const_cast<char*>(buffer->getBuffer());
+    iov.iov_len = buffer->getLimit();
+
+    mmsghdr msgs[SEND_BATCH];
+    size_t dest[SEND_BATCH];
+
+    bool batch = true;
+    while(batch && i<_sendAddresses.size()) {
+        size_t n = 0;
+        for(; n<SEND_BATCH && i<_sendAddresses.size(); i++) {
+            if(skipTarget(target, _isSendAddressUnicast[i]))
+                continue;
 
-        // filter
-        if (target != inetAddressType_all)
-            if ((target == inetAddressType_unicast && !_isSendAddressUnicast[i]) ||
-                    (target == inetAddressType_broadcast_multicast && _isSendAddressUnicast[i]))
+            if (IS_LOGGABLE(logLevelDebug))
+            {
+                LOG(logLevelDebug, "Sending %zu bytes %s -> %s.",
+                    buffer->getRemaining(), _remoteName.c_str(), inetAddressToString(_sendAddresses[i]).c_str());
+            }
+
+            memset(&msgs[n], 0, sizeof(msgs[n]));
+            msgs[n].msg_hdr.msg_name = const_cast<sockaddr*>(&_sendAddresses[i].sa);
+            msgs[n].msg_hdr.msg_namelen = sizeof(sockaddr);
+            msgs[n].msg_hdr.msg_iov = &iov;
+            msgs[n].msg_hdr.msg_iovlen = 1;
+            dest[n++] = i;
+        }
+
+        for(size_t done = 0; done < n; ) {
+            int ret = sendmmsg(_channel, &msgs[done], n-done, 0);
+            if(likely(ret>0)) {
+                done += ret;
+                continue;
+            }
+
+            int socketError = SOCKERRNO;
+            if(socketError==SOCK_EINTR)
                 continue;
 
+            if(socketError==ENOSYS) {
+                // not implemented by this kernel, continue with sendto()
+                batch = false;
+                i = dest[done];
+                break;
+            }
+
+            // error applies to the first unsent
+            char errStr[64];
+            epicsSocketConvertErrnoToString(errStr, sizeof(errStr));
+            LOG(logLevelDebug, "Socket sendto to %s error: %s.",
+                inetAddressToString(_sendAddresses[dest[done]]).c_str(), errStr);
+            allOK = false;
+            done++;
+        }
+    }
+#endif
+
+    for(; i<_sendAddresses.size(); i++) {
+
+        // filter
+        if (skipTarget(target, _isSendAddressUnicast[i]))
+            continue;
+
         if (IS_LOGGABLE(logLevelDebug))
         {
             LOG(logLevelDebug, "Sending %zu bytes %s -> %s.",
@@ -576,10 +749,25 @@ void initializeUDPTransports(bool serverFlag,
                              int32& listenPort,
                              bool autoAddressList,
                              const std::string& addressList,
-                             const std::string& ignoreAddressList)
+                             const std::string& ignoreAddressList,
+                             unsigned receiveShards)
 {
     BlockingUDPConnector connector(serverFlag);
 
+    if(receiveShards<1u)
+        receiveShards = 1u;
+
+    /* Several sockets, each with a thread, receive on each address.
+     * Unicast to sockets bound with SO_REUSEPORT is balanced by the kernel.
+     * Broadcast and multicast are delivered to every socket, and each handles a share.
+     */
+#if defined(SO_REUSEPORT) && !defined(_WIN32)
+    const unsigned unicastShards = receiveShards;
+#else
+    const unsigned unicastShards = 1u;
+#endif
+    const bool shareReceive = unicastShards>1u;
+
     const int8_t protoVer = serverFlag ? PVA_SERVER_PROTOCOL_REVISION : PVA_CLIENT_PROTOCOL_REVISION;
 
     //
@@ -732,7 +920,7 @@ void initializeUDPTransports(bool serverFlag,
             listenLocalAddress.ia.sin_addr.s_addr = node.addr.ia.sin_addr.s_addr;
 
             BlockingUDPTransport::shared_pointer transport = connector.connect(
-                        responseHandler, listenLocalAddress, protoVer);
+                        responseHandler, listenLocalAddress, protoVer, shareReceive);
             if (!transport)
                 continue;
             listenLocalAddress = transport->getRemoteAddress();
@@ -741,8 +929,23 @@ void initializeUDPTransports(bool serverFlag,
 
             tappedNIF.push_back(listenLocalAddress);
 
+            // additional receivers for the same address, each with its own thread.
+            BlockingUDPTransportVector shards;
+            for (unsigned i = 1u; i < unicastShards; i++)
+            {
+                BlockingUDPTransport::shared_pointer shard = connector.connect(
+                            responseHandler, listenLocalAddress, protoVer, true);
+                if (!shard) {
+                    LOG(logLevelWarn, "Unable to add UDP receiver %u for %s.",
+                        i, inetAddressToString(listenLocalAddress).c_str());
+                    break;
+                }
+                shard->setIgnoredAddresses(ignoreAddressVector);
+                shards.push_back(shard);
+            }
+
 
-            BlockingUDPTransport::shared_pointer transport2;
+            BlockingUDPTransportVector transport2;
 
             if(!node.validBcast || node.bcast.sa.sa_family != AF_INET ||
                     node.bcast.ia.sin_addr.s_addr == listenLocalAddress.ia.sin_addr.s_addr) {
@@ -766,9 +969,12 @@ void initializeUDPTransports(bool serverFlag,
                 bcastAddress.ia.sin_port = htons(listenPort);
                 bcastAddress.ia.sin_addr.s_addr = node.bcast.ia.sin_addr.s_addr;
 
-                transport2 = connector.connect(responseHandler, bcastAddress, protoVer);
-                if (transport2)
+                for (unsigned i = 0u; i < receiveShards; i++)
                 {
+                    BlockingUDPTransport::shared_pointer bcastTransport = connector.connect(responseHandler, bcastAddress, protoVer);
+                    if (!bcastTransport)
+                        break;
+
                     /* The other wrinkle is that nothing should be sent from this second
                      * socket. So replies are made through the unicast socket.
                      *
@@ -776,10 +982,15 @@ void initializeUDPTransports(bool serverFlag,
                     */
                     // NOTE: search responses all always send from sendTransport
 
-                    transport2->setIgnoredAddresses(ignoreAddressVector);
+                    bcastTransport->setIgnoredAddresses(ignoreAddressVector);
+                    transport2.push_back(bcastTransport);
+                }
+
+                for (size_t i = 0; i < transport2.size(); i++)
+                    transport2[i]->setReceiveShard(i, transport2.size());
 
+                if (!transport2.empty())
                     tappedNIF.push_back(bcastAddress);
-                }
             }
 #endif
 
@@ -789,10 +1000,20 @@ void initializeUDPTransports(bool serverFlag,
             transport->start();
             udpTransports.push_back(transport);
 
-            if (transport2)
+            for (size_t i = 0; i < shards.size(); i++)
             {
-                transport2->start();
-                udpTransports.push_back(transport2);
+                // also re-broadcast unicast searches locally
+                shards[i]->setMutlicastNIF(loAddr, true);
+                shards[i]->setLocalMulticastAddress(group);
+
+                shards[i]->start();
+                udpTransports.push_back(shards[i]);
+            }
+
+            for (size_t i = 0; i < transport2.size(); i++)
+            {
+                transport2[i]->start();
+                udpTransports.push_back(transport2[i]);
             }
         }
         catch (std::exception& e)
@@ -815,25 +1036,37 @@ void initializeUDPTransports(bool serverFlag,
     anyAddress.ia.sin_port = htons(listenPort);
 #endif
 
-    BlockingUDPTransport::shared_pointer localMulticastTransport;
+    BlockingUDPTransportVector localMulticastTransports;
     try
     {
-        // NOTE: multicast receiver socket must be "bound" to INADDR_ANY or multicast address
-        localMulticastTransport = connector.connect(
-                                      responseHandler,
+        for (unsigned i = 0u; i < receiveShards; i++)
+        {
+            // NOTE: multicast receiver socket must be "bound" to INADDR_ANY or multicast address
+            BlockingUDPTransport::shared_pointer localMulticastTransport = connector.connect(
+                                          responseHandler,
 #if !defined(_WIN32)
-                                      group,
+                                          group,
 #else
-                                      anyAddress,
+                                          anyAddress,
 #endif
-                                      protoVer);
-        if (!localMulticastTransport)
-            throw std::runtime_error("Failed to bind UDP socket.");
-
-        localMulticastTransport->setTappedNIF(tappedNIF);
-        localMulticastTransport->join(group, loAddr);
-        localMulticastTransport->start();
-        udpTransports.push_back(localMulticastTransport);
+                                          protoVer);
+            if (!localMulticastTransport) {
+                if (i == 0u)
+                    throw std::runtime_error("Failed to bind UDP socket.");
+                break;
+            }
+
+            localMulticastTransport->setTappedNIF(tappedNIF);
+            localMulticastTransport->join(group, loAddr);
+            localMulticastTransports.push_back(localMulticastTransport);
+        }
+
+        for (size_t i = 0; i < localMulticastTransports.size(); i++)
+        {
+            localMulticastTransports[i]->setReceiveShard(i, localMulticastTransports.size());
+            localMulticastTransports[i]->start();
+            udpTransports.push_back(localMulticastTransports[i]);
+        }
 
         LOG(logLevelDebug, "Local multicast enabled on %s/%s.",
             inetAddressToString(loAddr, false).c_str(),
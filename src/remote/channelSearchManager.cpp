@@ -7,6 +7,7 @@
 #include <stdlib.h>
 #include <time.h>
 #include <vector>
+#include <algorithm>
 
 #include <epicsMutex.h>
 
@@ -69,8 +70,13 @@ static const int BOOST_VALUE = 1;
 static const int MAX_COUNT_VALUE = 1 << 8;
 static const int MAX_FALLBACK_COUNT_VALUE = (1 << 7) + 1;
 
-static const int MAX_FRAMES_AT_ONCE = 10;
+// frames sent at once before pausing.  Starts at MAX_FRAMES_AT_ONCE,
+// grows while servers keep up, and is halved on apparent loss.
+static const size_t MAX_FRAMES_AT_ONCE = 10;
+static const size_t MAX_BURST_FRAMES = 500;
 static const int DELAY_BETWEEN_FRAMES_MS = 50;
+// weight of the latest burst in the smoothed response ratio
+static const double RESPONSE_RATIO_GAIN = 0.125;
 
 
 ChannelSearchManager::ChannelSearchManager(Context::shared_pointer const & context) :
@@ -80,6 +86,15 @@ ChannelSearchManager::ChannelSearchManager(Context::shared_pointer const & conte
     m_sequenceNumber(0),
     m_sendBuffer(MAX_UDP_UNFRAGMENTED_SEND),
     m_channels(),
+    m_found(0u),
+    m_totalSearchTime(0.0),
+    m_maxSearchTime(0.0),
+    m_burstFrames(MAX_FRAMES_AT_ONCE),
+    m_burstNames(0u),
+    m_burstResponses(0u),
+    m_responseRatio(-1.0), // no data
+    m_namesSent(0u),
+    m_framesSent(0u),
     m_lastTimeSent(),
     m_channelMutex(),
     m_userValueMutex(),
@@ -141,7 +156,9 @@ void ChannelSearchManager::registerSearchInstance(SearchInstance::shared_pointer
         Lock guard(m_channelMutex);
 
         // overrides if already registered
-        m_channels[channel->getSearchInstanceID()] = channel;
+        Pending& pending = m_channels[channel->getSearchInstanceID()];
+        pending.instance = channel;
+        epicsTimeGetCurrent(&pending.registered);
         immediateTrigger = (m_channels.size() == 1);
 
         Lock guard2(m_userValueMutex);
@@ -153,6 +170,31 @@ void ChannelSearchManager::registerSearchInstance(SearchInstance::shared_pointer
         callback();
 }
 
+void ChannelSearchManager::registerSearchInstances(const std::vector<SearchInstance::shared_pointer>& channels)
+{
+    if (m_canceled.get() || channels.empty())
+        return;
+
+    {
+        Lock guard(m_channelMutex);
+        Lock guard2(m_userValueMutex);
+
+        epicsTimeStamp now;
+        epicsTimeGetCurrent(&now);
+
+        for(size_t i=0; i<channels.size(); i++)
+        {
+            Pending& pending = m_channels[channels[i]->getSearchInstanceID()];
+            pending.instance = channels[i];
+            pending.registered = now;
+
+            channels[i]->getUserValue() = DEFAULT_USER_VALUE;
+        }
+    }
+    // not triggered immediately, as sending many bursts blocks.
+    // searched on the next period, from the timer thread.
+}
+
 void ChannelSearchManager::unregisterSearchInstance(SearchInstance::shared_pointer const & channel)
 {
     Lock guard(m_channelMutex);
@@ -178,13 +220,26 @@ void ChannelSearchManager::searchResponse(const ServerGUID & guid, pvAccessID ci
     }
     else
     {
-        SearchInstance::shared_pointer si(channelsIter->second.lock());
+        SearchInstance::shared_pointer si(channelsIter->second.instance.lock());
+
+        epicsTimeStamp now;
+        epicsTimeGetCurrent(&now);
+        double searchTime = epicsTimeDiffInSeconds(&now, &channelsIter->second.registered);
+        m_found++;
+        m_totalSearchTime += searchTime;
+        if (searchTime > m_maxSearchTime)
+            m_maxSearchTime = searchTime;
 
         // remove from search list
-        m_channels.erase(cid);
+        m_channels.erase(channelsIter);
 
         guard.unlock();
 
+        {
+            Lock guard2(m_mutex);
+            m_burstResponses++;
+        }
+
         // then notify SearchInstance
         if(si)
             si->searchResponse(guid, minorRevision, serverAddress);
@@ -197,6 +252,25 @@ void ChannelSearchManager::newServerDetected()
     callback();
 }
 
+ChannelSearchManager::Stats ChannelSearchManager::getStats()
+{
+    Stats ret;
+    {
+        Lock guard(m_channelMutex);
+        ret.pending = m_channels.size();
+        ret.found = m_found;
+        ret.meanSearchTime = m_found ? m_totalSearchTime/m_found : 0.0;
+        ret.maxSearchTime = m_maxSearchTime;
+    }
+    {
+        Lock guard(m_mutex);
+        ret.namesSent = m_namesSent;
+        ret.framesSent = m_framesSent;
+        ret.burstFrames = m_burstFrames;
+    }
+    return ret;
+}
+
 void ChannelSearchManager::initializeSendBuffer()
 {
     // for now OK, since it is only set here
@@ -246,6 +320,8 @@ void ChannelSearchManager::flushSendBuffer()
     m_sendBuffer.putByte(CAST_POSITION, (int8_t)0x00);  // b/m-cast, no reply required
     ut->send(&m_sendBuffer, inetAddressType_broadcast_multicast);
 
+    m_framesSent++;
+
     initializeSendBuffer();
 }
 
@@ -287,13 +363,19 @@ bool ChannelSearchManager::generateSearchRequestMessage(SearchInstance::shared_p
     if(!success)
     {
         flushSendBuffer();
-        if(allowNewFrame)
-            generateSearchRequestMessage(channel, &m_sendBuffer, &control);
+        if(allowNewFrame && generateSearchRequestMessage(channel, &m_sendBuffer, &control))
+        {
+            m_burstNames++;
+            m_namesSent++;
+        }
         if (flush)
             flushSendBuffer();
         return true;
     }
 
+    m_burstNames++;
+    m_namesSent++;
+
     if (flush)
         flushSendBuffer();
 
@@ -307,7 +389,7 @@ void ChannelSearchManager::boost()
     m_channels_t::iterator channelsIter = m_channels.begin();
     for(; channelsIter != m_channels.end(); channelsIter++)
     {
-        SearchInstance::shared_pointer inst(channelsIter->second.lock());
+        SearchInstance::shared_pointer inst(channelsIter->second.instance.lock());
         if(!inst) continue;
         int32_t& userValue = inst->getUserValue();
         userValue = BOOST_VALUE;
@@ -331,7 +413,7 @@ void ChannelSearchManager::callback()
 
 
     int count = 0;
-    int frameSent = 0;
+    size_t frameSent = 0;
 
     vector<SearchInstance::shared_pointer> toSend;
     {
@@ -341,12 +423,19 @@ void ChannelSearchManager::callback()
         for(m_channels_t::iterator channelsIter = m_channels.begin();
             channelsIter != m_channels.end(); channelsIter++)
         {
-            SearchInstance::shared_pointer inst(channelsIter->second.lock());
+            SearchInstance::shared_pointer inst(channelsIter->second.instance.lock());
             if(!inst) continue;
             toSend.push_back(inst);
         }
     }
 
+    size_t burstFrames;
+    {
+        Lock guard(m_mutex);
+        burstFrames = m_burstFrames;
+        m_burstNames = m_burstResponses = 0u;
+    }
+
     vector<SearchInstance::shared_pointer>::iterator siter = toSend.begin();
     for (; siter != toSend.end(); siter++)
     {
@@ -370,10 +459,11 @@ void ChannelSearchManager::callback()
 
         if (generateSearchRequestMessage(*siter, true, false))
             frameSent++;
-        if (frameSent == MAX_FRAMES_AT_ONCE)
+        if (frameSent >= burstFrames)
         {
             epicsThreadSleep(DELAY_BETWEEN_FRAMES_MS/(double)1000.0);
             frameSent = 0;
+            burstFrames = adaptBurst();
         }
     }
 
@@ -381,6 +471,40 @@ void ChannelSearchManager::callback()
         flushSendBuffer();
 }
 
+size_t ChannelSearchManager::adaptBurst()
+{
+    Lock guard(m_mutex);
+
+    if (m_burstNames > 0u)
+    {
+        double ratio = double(m_burstResponses)/m_burstNames;
+
+        if (m_responseRatio < 0.0)
+        {
+            m_responseRatio = ratio;
+        }
+        else
+        {
+            if (m_burstResponses == 0u || ratio < m_responseRatio/2)
+            {
+                // far fewer responses than usual for the names sent,
+                // or none, as for names which no server has.
+                // assume requests or responses are being dropped.
+                m_burstFrames = std::max(MAX_FRAMES_AT_ONCE, m_burstFrames/2u);
+            }
+            else
+            {
+                // servers keep up
+                m_burstFrames = std::min(MAX_BURST_FRAMES, m_burstFrames + m_burstFrames/4u);
+            }
+            m_responseRatio += RESPONSE_RATIO_GAIN*(ratio - m_responseRatio);
+        }
+    }
+
+    m_burstNames = m_burstResponses = 0u;
+    return m_burstFrames;
+}
+
 bool ChannelSearchManager::isPowerOfTwo(int32_t x)
 {
     return ((x > 0) && (x & (x - 1)) == 0);
@@ -10,6 +10,7 @@
 #include <limits>
 #include <stdexcept>
 #include <sstream>
+#include <string.h>
 #include <sys/types.h>
 
 #include <osiSock.h>
@@ -36,6 +37,18 @@
 #include <pv/serializationHelper.h>
 #include <pv/serverChannelImpl.h>
 #include <pv/clientContextImpl.h>
+#include <pv/tcpReactor.h>
+#include <pv/lzBlock.h>
+#include <pv/pvAccessMB.h>
+
+#if !defined(_WIN32) && !defined(vxWorks)
+#  include <sys/uio.h>
+#  define PVA_HAVE_SENDMSG
+#endif
+
+#ifdef PVA_HAVE_EPOLL
+#  include <poll.h>
+#endif
 
 using namespace std;
 using namespace epics::pvData;
@@ -47,16 +60,58 @@ namespace {
 struct BreakTransport : TransportSender
 {
     virtual ~BreakTransport() {}
+    virtual SendClass getSendClass() const OVERRIDE FINAL { return SEND_CONTROL; }
     virtual void send(epics::pvData::ByteBuffer* buffer, TransportSendControl* control) OVERRIDE FINAL
     {
         throw epics::pvAccess::detail::connection_closed_exception("Break");
     }
 };
+
+// how often a thread waiting on a shared memory ring checks that the peer is still connected
+const double shmWaitSlice = 0.5;
+
+// how often the stream thread of a reactor transport checks for close, and receive timeout
+const double streamWaitSlice = 1.0;
+
+struct ControlMessageSender : TransportSender
+{
+    const std::tr1::weak_ptr<epics::pvAccess::detail::BlockingTCPTransportCodec> codec;
+    const epics::pvData::int8 command;
+    const epics::pvData::int32 data;
+
+    ControlMessageSender(const std::tr1::shared_ptr<epics::pvAccess::detail::BlockingTCPTransportCodec>& codec,
+                         epics::pvData::int8 command, epics::pvData::int32 data)
+        :codec(codec), command(command), data(data)
+    {}
+    virtual ~ControlMessageSender() {}
+    virtual SendClass getSendClass() const OVERRIDE FINAL { return SEND_CONTROL; }
+    virtual void send(epics::pvData::ByteBuffer* buffer, TransportSendControl* control) OVERRIDE FINAL
+    {
+        std::tr1::shared_ptr<epics::pvAccess::detail::BlockingTCPTransportCodec> C(codec.lock());
+        if(C)
+            C->sendControl(command, data);
+    }
+};
+
+// compressed frames
+const size_t frameHeaderSize = 8u;
+// uncompressed size, matches the window of lzCompress()
+const size_t maxFrameSize = 64u*1024u;
+
+size_t compressThreshold(const Context::shared_pointer& context)
+{
+    epics::pvData::int32 threshold = context->getConfiguration()->getPropertyAsInteger("EPICS_PVA_COMPRESS_THRESHOLD", 0);
+    return threshold > 0 ? size_t(threshold) : 0u;
+}
 } // namespace
 
 namespace epics {
 namespace pvAccess {
 
+// trace points, cf. pvAccessMB.h
+MB_DECLARE(pvaReceive, 4096);
+MB_DECLARE(pvaMonitor, 4096);
+
 size_t Transport::num_instances;
 
 Transport::Transport()
@@ -71,6 +126,74 @@ Transport::~Transport()
 
 namespace detail {
 
+SendQueue::SendQueue()
+{
+    for(size_t i=0; i<TransportSender::SEND_CLASSES; i++)
+        passed[i] = 0u;
+}
+
+void SendQueue::push_back(const TransportSender::shared_pointer& sender)
+{
+    queues[sender->getSendClass()].push_back(sender);
+    wakeup.signal();
+}
+
+bool SendQueue::pop_front_try(TransportSender::shared_pointer& sender)
+{
+    // first, a lower class which has waited too long
+    for(size_t i=TransportSender::SEND_CLASSES-1u; i>0u; i--) {
+        if(passed[i] < maxPassed)
+            continue;
+        passed[i] = 0u;
+        if(queues[i].pop_front_try(sender))
+            return true;
+        // was empty
+    }
+
+    for(size_t i=0; i<TransportSender::SEND_CLASSES; i++) {
+        if(queues[i].pop_front_try(sender)) {
+            passed[i] = 0u;
+            // only those waiting are passed over
+            for(size_t j=i+1u; j<TransportSender::SEND_CLASSES; j++) {
+                if(!queues[j].empty())
+                    passed[j]++;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void SendQueue::pop_front(TransportSender::shared_pointer& sender)
+{
+    while(!pop_front_try(sender))
+        wakeup.wait();
+}
+
+bool SendQueue::empty() const
+{
+    for(size_t i=0; i<TransportSender::SEND_CLASSES; i++) {
+        if(!queues[i].empty())
+            return false;
+    }
+    return true;
+}
+
+size_t SendQueue::size() const
+{
+    size_t ret = 0u;
+    for(size_t i=0; i<TransportSender::SEND_CLASSES; i++)
+        ret += queues[i].size();
+    return ret;
+}
+
+void SendQueue::clear()
+{
+    for(size_t i=0; i<TransportSender::SEND_CLASSES; i++)
+        queues[i].clear();
+}
+
+
 const std::size_t AbstractCodec::MAX_MESSAGE_PROCESS = 100;
 const std::size_t AbstractCodec::MAX_MESSAGE_SEND = 100;
 const std::size_t AbstractCodec::MAX_ENSURE_SIZE = 1024;
@@ -98,6 +221,7 @@ AbstractCodec::AbstractCodec(
     _writeOpReady(false),
     _socketBuffer(bufSizeSelect(receiveBufferSize)),
     _sendBuffer(bufSizeSelect(sendBufferSize)),
+    _blockingProcessQueue(blockingProcessQueue),
     //PRIVATE
     _storedPayloadSize(0), _storedPosition(0), _startPosition(0),
     _maxSendPayloadSize(_sendBuffer.getSize() - 2*PVA_MESSAGE_HEADER_SIZE),    // start msg + control
@@ -186,12 +310,15 @@ void AbstractCodec::processReadNormal()  {
         {
             // read as much as available, but at least for a header
             // readFromSocket checks if reading from socket is really necessary
+            MB_INC_AUTO_ID(pvaReceive);
             if (!readToBuffer(PVA_MESSAGE_HEADER_SIZE, false)) {
                 return;
             }
 
             // read header fields
             processHeader();
+            _stats.messageReceived();
+            MB_POINT(pvaReceive, 1, "header parse");
             bool isControl = ((_flags & 0x01) == 0x01);
             if (isControl) {
                 processControlMessage();
@@ -225,6 +352,7 @@ void AbstractCodec::processReadNormal()  {
                 {
                     // handle response
                     processApplicationMessage();
+                    MB_POINT(pvaReceive, 3, "handler done");
 
                     if (!isOpen())
                         return;
@@ -316,6 +444,7 @@ void AbstractCodec::processReadSegmented() {
 
         // read header fields
         processHeader();
+        _stats.messageReceived();
 
         bool isControl = ((_flags & 0x01) == 0x01);
         if (isControl)
@@ -405,6 +534,8 @@ bool AbstractCodec::readToBuffer(
                 return false;
             }
         }
+        _stats.received(bytesRead);
+        MB_POINT_CONDITIONAL(pvaReceive, 0, "socket read", bytesRead > 0);
     }
 
     // set pointers (aka flip)
@@ -601,6 +732,7 @@ void AbstractCodec::startMessage(
         (_lastSegmentedMessageType | _byteOrderFlag | _clientServerFlag));	// data message
     _sendBuffer.putByte(command);	// command
     _sendBuffer.putInt(payloadSize);
+    _stats.messageSent();
 
     // apply offset
     if (_nextMessagePayloadOffset > 0)
@@ -621,6 +753,7 @@ void AbstractCodec::putControlMessage(
     _sendBuffer.putByte((0x01 | _byteOrderFlag | _clientServerFlag));	// control message
     _sendBuffer.putByte(command);	// command
     _sendBuffer.putInt(data);		// data
+    _stats.messageSent();
 }
 
 
@@ -809,6 +942,7 @@ void AbstractCodec::send(ByteBuffer *buffer)
         }
 
         _totalBytesSent += bytesSent;
+        _stats.sent(bytesSent);
 
         // readjust limit
         if (bytesToSend == maxBytesToSend)
@@ -822,6 +956,47 @@ void AbstractCodec::send(ByteBuffer *buffer)
         }
         tries = 0;
     }
+
+    MB_POINT(pvaMonitor, 2, "socket write");
+    MB_CLEAR_ID(pvaMonitor);
+}
+
+
+void AbstractCodec::send(ByteBuffer *head, ByteBuffer *tail)
+{
+    int tries = 0;
+    while (head->getRemaining() > 0 || tail->getRemaining() > 0)
+    {
+        int bytesSent = writeGather(head, tail);
+
+        if (bytesSent < 0)
+        {
+            // connection lost
+            close();
+            throw connection_closed_exception("bytesSent < 0");
+        }
+        else if (bytesSent == 0)
+        {
+            sendBufferFull(tries++);
+            continue;
+        }
+
+        _totalBytesSent += bytesSent;
+        _stats.sent(bytesSent);
+        tries = 0;
+    }
+
+    MB_POINT(pvaMonitor, 2, "socket write");
+    MB_CLEAR_ID(pvaMonitor);
+}
+
+
+int AbstractCodec::writeGather(ByteBuffer *head, ByteBuffer *tail)
+{
+    // no vectored I/O, one after the other
+    if (head->getRemaining() > 0)
+        return write(head);
+    return write(tail);
 }
 
 
@@ -830,7 +1005,7 @@ void AbstractCodec::processSendQueue()
 
     {
         std::size_t senderProcessed = 0;
-        while (senderProcessed++ < MAX_MESSAGE_SEND)
+        while (senderProcessed++ < MAX_MESSAGE_SEND && !sendBlocked())
         {
             TransportSender::shared_pointer sender;
             _sendQueue.pop_front_try(sender);
@@ -842,7 +1017,7 @@ void AbstractCodec::processSendQueue()
 
                 sendCompleted();	// do not schedule sending
 
-                if (terminated())			// termination
+                if (terminated() || !_blockingProcessQueue)	// termination, or nothing more to do
                     break;
                 // termination (we want to process even if shutdown)
                 _sendQueue.pop_front(sender);
@@ -970,16 +1145,31 @@ bool AbstractCodec::directSerialize(ByteBuffer* /*existingBuffer*/, const char*
     // TODO size_t to int32
     startMessage(_lastSegmentedMessageCommand, 0, static_cast<int32>(count));
 
-    // flush
-    flushSendBuffer();
-
     // TODO think if alignment is preserved after...
 
     //
-    // send toSerialize buffer
+    // send pending messages and the new header, followed by toSerialize
+    // which is referenced in place instead of being copied into _sendBuffer.
+    // toSerialize is owned by the caller, which holds it until we return.
     //
+    _sendBuffer.flip();
+
     ByteBuffer wrappedBuffer(const_cast<char*>(toSerialize), count);
-    send(&wrappedBuffer);
+    try {
+        send(&_sendBuffer, &wrappedBuffer);
+    } catch (io_exception &) {
+        try {
+            if (isOpen())
+                close();
+        } catch (io_exception &) {
+            // noop, best-effort close
+        }
+        throw connection_closed_exception("Failed to send buffer.");
+    }
+
+    _sendBuffer.clear();
+
+    _lastMessageStartPosition = std::numeric_limits<size_t>::max();
 
     //
     // continue where we left before calling directSerialize
@@ -992,7 +1182,86 @@ bool AbstractCodec::directSerialize(ByteBuffer* /*existingBuffer*/, const char*
 bool AbstractCodec::directDeserialize(ByteBuffer *existingBuffer, char* deserializeTo,
                                       std::size_t elementCount, std::size_t elementSize)
 {
-    return false;
+    std::size_t count = elementCount * elementSize;
+
+    // TODO find smart limit
+    // check if direct mode actually pays off
+    if (count < 64*1024 || existingBuffer != &_socketBuffer)
+        return false;
+
+    // called with byte order matching, caller swaps otherwise
+
+    try
+    {
+        while (count > 0)
+        {
+            // first take what has already been read into _socketBuffer,
+            // whose limit is bounded to the current message (segment)
+            std::size_t nbuffered = std::min(count, _socketBuffer.getRemaining());
+            if (nbuffered > 0)
+            {
+                std::size_t pos = _socketBuffer.getPosition();
+                memcpy(deserializeTo, &_socketBuffer.getBuffer()[pos], nbuffered);
+                _socketBuffer.setPosition(pos + nbuffered);
+                deserializeTo += nbuffered;
+                count -= nbuffered;
+                continue;
+            }
+
+            // payload of current message (segment) not yet read from the socket
+            std::size_t pos = _socketBuffer.getPosition();
+            std::size_t payloadLeft = _storedPayloadSize - (pos - _storedPosition);
+
+            if (payloadLeft == 0)
+            {
+                // end of segment, let ensureData() process the next header(s),
+                // and (partially) fill _socketBuffer
+                ensureData(1);
+                continue;
+            }
+
+            // SPLIT case, all buffered bytes are consumed.
+            // read the rest of the payload straight into the destination
+            std::size_t n = std::min(count, payloadLeft);
+
+            ByteBuffer wrappedBuffer(deserializeTo, n);
+            while (wrappedBuffer.getRemaining() > 0)
+            {
+                int bytesRead = read(&wrappedBuffer);
+
+                if (bytesRead < 0)
+                {
+                    close();
+                    throw connection_closed_exception("bytesRead < 0");
+                }
+                // non-blocking IO support
+                else if (bytesRead == 0)
+                {
+                    readPollOne();
+                }
+                _stats.received(bytesRead);
+            }
+
+            deserializeTo += n;
+            count -= n;
+
+            // as if the bytes had passed through _socketBuffer
+            _storedPayloadSize = payloadLeft - n;
+            _storedPosition = pos;
+            _storedLimit = pos;
+        }
+    }
+    catch (io_exception &) {
+        try {
+            close();
+        } catch (io_exception & ) {
+            // noop, best-effort close
+        }
+        throw connection_closed_exception(
+            "Failed to read directly from socket.");
+    }
+
+    return true;
 }
 
 //
@@ -1010,106 +1279,610 @@ BlockingTCPTransportCodec::~BlockingTCPTransportCodec()
 }
 
 void BlockingTCPTransportCodec::readPollOne() {
-    throw std::logic_error("should not be called for blocking IO");
+    if (!_reactor)
+        throw std::logic_error("should not be called for blocking IO");
+
+    if (_rxStream)
+    {
+        // on the stream thread
+        streamWait();
+        _rxWouldBlock = false;
+        return;
+    }
+
+    // only complete messages are parsed, so the handler has read past the end
+    LOG(logLevelError,
+        "Read past end of message from %s, disconnecting...",
+        _socketName.c_str());
+    invalidDataStreamHandler();
+    throw invalid_data_stream_exception("read past end of message");
 }
 
 
 void BlockingTCPTransportCodec::writePollOne() {
-    throw std::logic_error("should not be called for blocking IO");
+    // write() does not wait with the reactor
+    throw std::logic_error("should not be called");
 }
 
 
-void BlockingTCPTransportCodec::close() {
+void BlockingTCPTransportCodec::scheduleSend() {
+    if (!_reactor)
+        return; // our send thread waits on the queue
 
-    if (_isOpen.getAndSet(false))
     {
-        // always close in the same thread, same way, etc.
-        // wakeup processSendQueue
+        Guard G(_mutex);
+        if (_sendScheduled || _reactorId==0u) // start() will schedule
+            return;
+        _sendScheduled = true;
+    }
 
-        // clean resources (close socket)
-        internalClose();
+    if (!_reactor->scheduleSend(_reactorId))
+    {
+        // no longer serviced, so release queued senders
+        _sendQueue.clear();
+        Guard G(_mutex);
+        _sendScheduled = false;
+    }
+}
 
-        // Break sender from queue wait
-        BreakTransport::shared_pointer B(new BreakTransport);
-        enqueueSendRequest(B);
+
+bool BlockingTCPTransportCodec::reactorRead()
+{
+    {
+        Guard G(_mutex);
+        epicsTimeGetCurrent(&_lastRx);
+    }
+
+    try {
+        return reactorParse() && startStream();
+    } catch (std::exception &e) {
+        PRINT_EXCEPTION(e);
+        LOG(logLevelError,
+            "an exception caught while in reactorRead at %s:%d: %s",
+            __FILE__, __LINE__, e.what());
+    } catch (...) {
+        LOG(logLevelError,
+            "unknown exception caught while in reactorRead at %s:%d.",
+            __FILE__, __LINE__);
     }
+    // exception
+    close();
+    return false;
 }
 
-void BlockingTCPTransportCodec::waitJoin()
+
+// Read and parse until the socket would block.
+// Returns true if a message does not fit in _rxFifo, and must be streamed.
+bool BlockingTCPTransportCodec::reactorParse()
 {
-    assert(!_isOpen.get());
-    _sendThread.exitWait();
-    _readThread.exitWait();
+    bool wouldBlock;
+    do {
+        wouldBlock = reactorFill();
+        if (_rxStream)
+            return true;
+
+        // parse all complete messages.
+        // read() returns 0 at the start of a partial message, which remains in _rxFifo.
+        do {
+            _rxWouldBlock = false;
+            this->processRead();
+        } while (this->isOpen() && !_rxWouldBlock);
+
+    } while (this->isOpen() && !wouldBlock);
+    return false;
 }
 
-void BlockingTCPTransportCodec::internalClose()
+
+// Read what is available into _rxFifo.  Returns true if the socket would block.
+// Sets _rxStream if _rxFifo is filled by the start of one message.
+bool BlockingTCPTransportCodec::reactorFill()
 {
-    {
+    // no larger than the receive buffer
+    if (_rxFifo.size() < _socketBuffer.getSize())
+        _rxFifo.resize(_socketBuffer.getSize());
+    const size_t limit = _rxFifo.size();
 
-        epicsSocketSystemCallInterruptMechanismQueryInfo info  =
-            epicsSocketSystemCallInterruptMechanismQuery ();
-        switch ( info )
+    while (true)
+    {
+        if (_rxHead == _rxEnd)
         {
-        case esscimqi_socketCloseRequired:
-            epicsSocketDestroy ( _channel );
-            break;
-        case esscimqi_socketBothShutdownRequired:
+            // all parsed
+            _rxHead = _rxDeliver = _rxScan = _rxEnd = 0u;
+        }
+        else if (_rxEnd == limit)
         {
-            /*int status =*/ ::shutdown ( _channel, SHUT_RDWR );
-            /*
-            if ( status ) {
-                char sockErrBuf[64];
-                epicsSocketConvertErrnoToString (
-                    sockErrBuf, sizeof ( sockErrBuf ) );
-            LOG(logLevelDebug,
-                "TCP socket to %s failed to shutdown: %s.",
-                inetAddressToString(_socketAddress).c_str(), sockErrBuf);
+            if (_rxHead == 0u)
+            {
+                // parse before reading more.  Or nothing is complete,
+                // and the rest is passed on as it arrives.
+                _rxStream = _rxDeliver == 0u;
+                return false;
             }
-            */
-            epicsSocketDestroy ( _channel );
+
+            // discard parsed bytes
+            size_t n = _rxEnd - _rxHead;
+            if (n)
+                memmove(&_rxFifo[0], &_rxFifo[_rxHead], n);
+            _rxDeliver -= _rxHead;
+            _rxScan -= _rxHead;
+            _rxEnd = n;
+            _rxHead = 0u;
         }
-        break;
-        case esscimqi_socketSigAlarmRequired:
-        // not supported anymore anyway
-        default:
-            epicsSocketDestroy(_channel);
+
+        ByteBuffer wrapped(&_rxFifo[_rxEnd], limit - _rxEnd);
+        int bytesRead = streamRead(&wrapped);
+
+        if (bytesRead < 0)
+        {
+            close();
+            throw connection_closed_exception("bytesRead < 0");
+        }
+        else if (bytesRead == 0)
+        {
+            return true;
         }
+
+        _rxEnd += bytesRead;
+        reactorScan();
     }
+}
 
-    Transport::shared_pointer thisSharedPtr = this->shared_from_this();
-    _context->getTransportRegistry()->remove(thisSharedPtr);
 
-    if (IS_LOGGABLE(logLevelDebug))
+// Follow message headers through newly received bytes, and advance _rxDeliver
+// past each complete message, or sequence of segments.
+void BlockingTCPTransportCodec::reactorScan()
+{
+    if (_rxUnframed)
     {
-        LOG(logLevelDebug,
-            "TCP socket to %s is to be closed.",
-            _socketName.c_str());
+        _rxScan = _rxDeliver = _rxEnd;
+        return;
     }
-}
 
-bool BlockingTCPTransportCodec::terminated() {
-    return !isOpen();
-}
+    while (true)
+    {
+        if (_rxScanNeed > 0u)
+        {
+            // payload
+            size_t n = std::min(_rxScanNeed, _rxEnd - _rxScan);
+            _rxScan += n;
+            _rxScanNeed -= n;
+            if (_rxScanNeed > 0u)
+                break;
+            if (!_rxInSegment)
+                _rxDeliver = _rxScan;
+            continue;
+        }
 
+        if (_rxEnd - _rxScan < size_t(PVA_MESSAGE_HEADER_SIZE))
+            break;
 
-bool BlockingTCPTransportCodec::isOpen() {
-    return _isOpen.get();
-}
+        const unsigned char *head = reinterpret_cast<const unsigned char*>(&_rxFifo[_rxScan]);
+        if (int8(head[0]) != PVA_MAGIC)
+        {
+            // let processHeader() complain
+            _rxUnframed = true;
+            _rxScan = _rxDeliver = _rxEnd;
+            break;
+        }
 
+        epicsUInt8 flags = head[2];
+        epicsUInt32 size;
+        if (flags & 0x80)
+            size = (epicsUInt32(head[4])<<24) | (epicsUInt32(head[5])<<16) | (epicsUInt32(head[6])<<8) | head[7];
+        else
+            size = (epicsUInt32(head[7])<<24) | (epicsUInt32(head[6])<<16) | (epicsUInt32(head[5])<<8) | head[4];
 
-// NOTE: must not be called from constructor (e.g. needs shared_from_this())
-void BlockingTCPTransportCodec::start() {
+        _rxScan += PVA_MESSAGE_HEADER_SIZE;
+
+        if (flags & 0x01)
+        {
+            // control message, no payload
+            if (!_rxInSegment)
+                _rxDeliver = _rxScan;
+            continue;
+        }
 
-    _readThread.start();
+        // first or middle segment, the message continues
+        epicsUInt8 segment = flags & 0x30;
+        _rxInSegment = segment==0x10 || segment==0x30;
+        _rxScanNeed = size;
+        if (_rxScanNeed == 0u && !_rxInSegment)
+            _rxDeliver = _rxScan;
+    }
+}
 
-    _sendThread.start();
 
+int BlockingTCPTransportCodec::fifoRead(epics::pvData::ByteBuffer* dst)
+{
+    size_t n = std::min(dst->getRemaining(), (_rxStream ? _rxEnd : _rxDeliver) - _rxHead);
+    if (n == 0u)
+    {
+        if (_rxStream)
+            return streamRead(dst); // sets _rxWouldBlock
+        _rxWouldBlock = true;
+        return 0;
+    }
+    dst->put(&_rxFifo[0], _rxHead, n);
+    _rxHead += n;
+    return int(n);
 }
 
 
-void BlockingTCPTransportCodec::receiveThread()
+// Hand a message which does not fit in _rxFifo to the stream thread, started on first use.
+// Returns false if closed.
+bool BlockingTCPTransportCodec::startStream()
 {
-    /* This innocuous ref. is an important hack.
+    if (!_readThread.get())
+    {
+        _readThread.reset(new epics::pvData::Thread(epics::pvData::Thread::Config(this, &BlockingTCPTransportCodec::streamThread)
+                          .prio(epicsThreadPriorityCAServerLow)
+                          .name("TCP-rx")
+                          .stack(epicsThreadStackBig)
+                          .autostart(true)));
+    }
+    {
+        // the stream thread exits once closed
+        Guard G(_mutex);
+        if (!this->isOpen())
+            return false;
+        _rxStreamPending = true;
+    }
+    _rxStreamWake.signal();
+    return true;
+}
+
+
+// Wait for the rest of a streamed message.  Only on the stream thread.
+void BlockingTCPTransportCodec::streamWait()
+{
+#ifdef PVA_HAVE_EPOLL
+    double timeout;
+    {
+        Guard G(_mutex);
+        timeout = _rxTimeout;
+    }
+
+    double waited = 0.0;
+    while (this->isOpen())
+    {
+        pollfd pfd;
+        pfd.fd = _channel;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        int ret = ::poll(&pfd, 1, int(streamWaitSlice*1000));
+        if (ret > 0 || (ret < 0 && errno != EINTR))
+        {
+            // readable, or an error which the following read reports
+            Guard G(_mutex);
+            epicsTimeGetCurrent(&_lastRx);
+            return;
+        }
+        else if (ret == 0)
+        {
+            waited += streamWaitSlice;
+            if (timeout > 0.0 && waited >= timeout)
+            {
+                LOG(logLevelDebug,
+                    "TCP socket to %s receive timeout.",
+                    _socketName.c_str());
+                close();
+            }
+        }
+    }
+    throw connection_closed_exception("closed while streaming");
+#else
+    throw std::logic_error("should not be called");
+#endif
+}
+
+
+// Back at the start of a message.  Return unparsed bytes to _rxFifo.
+void BlockingTCPTransportCodec::streamDone()
+{
+    size_t carry = _socketBuffer.getRemaining();
+    size_t queued = _rxEnd - _rxHead;
+
+    std::vector<char> rest(std::max(carry + queued, _socketBuffer.getSize()));
+    _socketBuffer.get(&rest[0], 0u, carry);
+    if (queued)
+        memcpy(&rest[carry], &_rxFifo[_rxHead], queued);
+
+    _rxFifo.swap(rest);
+    _rxHead = _rxDeliver = _rxScan = _rxScanNeed = 0u;
+    _rxEnd = carry + queued;
+    _rxInSegment = false;
+    _rxStream = false;
+    reactorScan();
+}
+
+
+// Returns number of bytes sent, 0 if the socket would block, or -1 on error.
+int BlockingTCPTransportCodec::reactorSendSome(const char* data, size_t count)
+{
+    // keep within range of our int return value
+    count = std::min<size_t>(count, 1u<<30);
+    while (true)
+    {
+        int bytesSent = ::send(_channel, data, count, 0);
+        if (bytesSent >= 0)
+            return bytesSent;
+
+        int socketError = SOCKERRNO;
+        if (socketError==SOCK_EINTR)
+            continue;
+        else if (socketError==SOCK_ENOBUFS || socketError==SOCK_EWOULDBLOCK || socketError==EAGAIN)
+            return 0;
+        return -1;
+    }
+}
+
+
+// Send what the socket will accept, and keep the rest in _txPending.
+int BlockingTCPTransportCodec::reactorWrite(epics::pvData::ByteBuffer* src)
+{
+    size_t count = src->getRemaining();
+    if (count == 0u)
+        return 0;
+
+    const char *data = &src->getBuffer()[src->getPosition()];
+    size_t sent = 0u;
+    if (_txHead == _txPending.size())
+    {
+        int bytesSent = reactorSendSome(data, count);
+        if (bytesSent < 0)
+            return -1;
+        sent = size_t(bytesSent);
+    }
+    // preserve order behind earlier output
+    _txPending.insert(_txPending.end(), data + sent, data + count);
+
+    src->setPosition(src->getPosition() + count);
+    return int(count);
+}
+
+
+// Send from _txPending until empty, or the socket would block.
+void BlockingTCPTransportCodec::reactorFlush()
+{
+    while (_txHead < _txPending.size())
+    {
+        int bytesSent = reactorSendSome(&_txPending[_txHead], _txPending.size() - _txHead);
+        if (bytesSent < 0)
+        {
+            close();
+            throw connection_closed_exception("bytesSent < 0");
+        }
+        else if (bytesSent == 0)
+        {
+            return;
+        }
+        _txHead += bytesSent;
+    }
+
+    if (_txPending.capacity() > 1024u*1024u)
+        std::vector<char>().swap(_txPending);
+    else
+        _txPending.clear();
+    _txHead = 0u;
+}
+
+
+bool BlockingTCPTransportCodec::sendBlocked()
+{
+    // above the high water mark, take no more from the send queue until writable
+    return _reactor && _txPending.size() - _txHead > _sendBuffer.getSize();
+}
+
+
+BlockingTCPTransportCodec::ReactorSend BlockingTCPTransportCodec::reactorSend()
+{
+    if (this->isOpen())
+    {
+        try {
+            // earlier output first
+            reactorFlush();
+
+            // returns when empty, after MAX_MESSAGE_SEND, or once above the high water mark
+            if (!sendBlocked())
+                this->processWrite();
+
+            if (_txHead < _txPending.size())
+                return SendBlocked; // remain scheduled until writable
+
+            Guard G(_mutex);
+            if (!_sendQueue.empty())
+                return SendMore; // remain scheduled
+            _sendScheduled = false;
+            return SendDone;
+
+        } catch (connection_closed_exception &cce) {
+            // noop
+        } catch (std::exception &e) {
+            PRINT_EXCEPTION(e);
+            LOG(logLevelWarn,
+                "an exception caught while in reactorSend at %s:%d: %s",
+                __FILE__, __LINE__, e.what());
+        } catch (...) {
+            LOG(logLevelWarn,
+                "unknown exception caught while in reactorSend at %s:%d.",
+                __FILE__, __LINE__);
+        }
+        // exception
+        close();
+    }
+    _sendQueue.clear();
+
+    Guard G(_mutex);
+    _sendScheduled = false;
+    return SendDone;
+}
+
+
+void BlockingTCPTransportCodec::reactorCheckTimeout(const epicsTimeStamp& now)
+{
+    double timeout;
+    epicsTimeStamp lastRx;
+    {
+        Guard G(_mutex);
+        timeout = _rxTimeout;
+        lastRx = _lastRx;
+    }
+
+    if (timeout > 0.0 && epicsTimeDiffInSeconds(&now, &lastRx) > timeout)
+    {
+        LOG(logLevelDebug,
+            "TCP socket to %s receive timeout.",
+            _socketName.c_str());
+        close();
+    }
+}
+
+
+void BlockingTCPTransportCodec::close() {
+
+    if (_isOpen.getAndSet(false))
+    {
+        // always close in the same thread, same way, etc.
+        // wakeup processSendQueue
+
+        // clean resources (close socket)
+        internalClose();
+
+        // wake the stream thread, if any
+        if (_reactor)
+            _rxStreamWake.signal();
+
+        // Break sender from queue wait
+        BreakTransport::shared_pointer B(new BreakTransport);
+        enqueueSendRequest(B);
+    }
+}
+
+void BlockingTCPTransportCodec::waitJoin()
+{
+    assert(!_isOpen.get());
+    if (_reactor)
+        _reactor->waitIdle(_reactorId);
+    if (_sendThread.get())
+        _sendThread->exitWait();
+    if (_readThread.get())
+        _readThread->exitWait();
+}
+
+void BlockingTCPTransportCodec::internalClose()
+{
+    if (_reactor)
+        _reactor->remove(_reactorId); // before the socket is closed
+
+    {
+        // wake our threads, and the peer, if waiting on the ring
+        Guard G(_mutex);
+        if (_shm)
+            _shm->close();
+    }
+
+    {
+
+        epicsSocketSystemCallInterruptMechanismQueryInfo info  =
+            epicsSocketSystemCallInterruptMechanismQuery ();
+        switch ( info )
+        {
+        case esscimqi_socketCloseRequired:
+            epicsSocketDestroy ( _channel );
+            break;
+        case esscimqi_socketBothShutdownRequired:
+        {
+            /*int status =*/ ::shutdown ( _channel, SHUT_RDWR );
+            /*
+            if ( status ) {
+                char sockErrBuf[64];
+                epicsSocketConvertErrnoToString (
+                    sockErrBuf, sizeof ( sockErrBuf ) );
+            LOG(logLevelDebug,
+                "TCP socket to %s failed to shutdown: %s.",
+                inetAddressToString(_socketAddress).c_str(), sockErrBuf);
+            }
+            */
+            epicsSocketDestroy ( _channel );
+        }
+        break;
+        case esscimqi_socketSigAlarmRequired:
+        // not supported anymore anyway
+        default:
+            epicsSocketDestroy(_channel);
+        }
+    }
+
+    Transport::shared_pointer thisSharedPtr = this->shared_from_this();
+    _context->getTransportRegistry()->remove(thisSharedPtr);
+
+    if (IS_LOGGABLE(logLevelDebug))
+    {
+        LOG(logLevelDebug,
+            "TCP socket to %s is to be closed.",
+            _socketName.c_str());
+    }
+}
+
+bool BlockingTCPTransportCodec::terminated() {
+    return !isOpen();
+}
+
+
+bool BlockingTCPTransportCodec::isOpen() {
+    return _isOpen.get();
+}
+
+
+// NOTE: must not be called from constructor (e.g. needs shared_from_this())
+void BlockingTCPTransportCodec::start() {
+
+    if (_reactor)
+    {
+        osiSockIoctl_t nonBlocking = 1;
+        if (socket_ioctl(_channel, FIONBIO, &nonBlocking))
+            throw std::runtime_error("Unable to make TCP socket non-blocking");
+
+        // as in receiveThread()
+        setRxTimeout(true);
+        {
+            Guard G(_mutex);
+            epicsTimeGetCurrent(&_lastRx);
+        }
+
+        epicsUInt64 id = _reactor->add(shared_from_this(), _channel);
+        {
+            Guard G(_mutex);
+            _reactorId = id;
+        }
+
+        // anything queued before now
+        scheduleSend();
+        return;
+    }
+
+    _readThread.reset(new epics::pvData::Thread(epics::pvData::Thread::Config(this, &BlockingTCPTransportCodec::receiveThread)
+                      .prio(epicsThreadPriorityCAServerLow)
+                      .name("TCP-rx")
+                      .stack(epicsThreadStackBig)
+                      .autostart(false)));
+    _sendThread.reset(new epics::pvData::Thread(epics::pvData::Thread::Config(this, &BlockingTCPTransportCodec::sendThread)
+                      .prio(epicsThreadPriorityCAServerLow)
+                      .name("TCP-tx")
+                      .stack(epicsThreadStackBig)
+                      .autostart(false)));
+
+    _readThread->start();
+
+    _sendThread->start();
+
+}
+
+
+void BlockingTCPTransportCodec::receiveThread()
+{
+    /* This innocuous ref. is an important hack.
      * The code behind Transport::close() will cause
      * channels and operations to drop references
      * to this transport.  This ref. keeps it from
@@ -1145,6 +1918,65 @@ void BlockingTCPTransportCodec::receiveThread()
 }
 
 
+// With the reactor, reads the rest of each message which does not fit in _rxFifo,
+// so that reactor threads never wait.
+void BlockingTCPTransportCodec::streamThread()
+{
+    // cf. the comment in receiveThread()
+    Transport::shared_pointer ptr(this->shared_from_this());
+
+    while (true)
+    {
+        bool pending;
+        {
+            Guard G(_mutex);
+            pending = _rxStreamPending;
+            _rxStreamPending = false;
+            // cf. startStream()
+            if (!pending && !this->isOpen())
+                break;
+        }
+        if (!pending)
+        {
+            _rxStreamWake.wait();
+            continue;
+        }
+
+        try {
+            bool more;
+            do {
+                // passed on as it arrives, with direct receive of large arrays
+                do {
+                    _rxWouldBlock = false;
+                    this->processRead();
+                } while (this->isOpen() && !_rxWouldBlock);
+
+                streamDone();
+
+                // as the reactor would, until the socket would block, or another large message
+                more = this->isOpen() && reactorParse();
+            } while (more);
+
+        } catch (std::exception &e) {
+            PRINT_EXCEPTION(e);
+            LOG(logLevelError,
+                "an exception caught while in streamThread at %s:%d: %s",
+                __FILE__, __LINE__, e.what());
+            close();
+        } catch (...) {
+            LOG(logLevelError,
+                "unknown exception caught while in streamThread at %s:%d.",
+                __FILE__, __LINE__);
+            close();
+        }
+        _rxStream = false;
+
+        // watch the socket again
+        _reactor->resumeRead(_reactorId);
+    }
+}
+
+
 void BlockingTCPTransportCodec::sendThread()
 {
     // cf. the comment in receiveThread()
@@ -1178,6 +2010,18 @@ void BlockingTCPTransportCodec::sendThread()
 void BlockingTCPTransportCodec::setRxTimeout(bool ena)
 {
     double timeout = !ena ? 0.0 : std::max(0.0, _context->getConfiguration()->getPropertyAsDouble("EPICS_PVA_CONN_TMO", 30.0));
+
+    {
+        // also used by shmRead()
+        Guard G(_mutex);
+        _rxTimeout = timeout;
+    }
+
+    if (_reactor)
+    {
+        // socket is non-blocking, timeout checked by reactor
+        return;
+    }
 #ifdef _WIN32
     DWORD timo = DWORD(timeout*1000); // in milliseconds
 #else
@@ -1198,6 +2042,11 @@ void BlockingTCPTransportCodec::setRxTimeout(bool ena)
 }
 
 void BlockingTCPTransportCodec::sendBufferFull(int tries) {
+    if (_reactor)
+    {
+        writePollOne();
+        return;
+    }
     // TODO constants
     epicsThreadSleep(std::max<double>(tries * 0.1, 1));
 }
@@ -1221,18 +2070,26 @@ BlockingTCPTransportCodec::BlockingTCPTransportCodec(bool serverFlag, const Cont
          sendBufferSize,
          receiveBufferSize,
          sendBufferSize,
-         true)
-    ,_readThread(epics::pvData::Thread::Config(this, &BlockingTCPTransportCodec::receiveThread)
-                 .prio(epicsThreadPriorityCAServerLow)
-                 .name("TCP-rx")
-                 .stack(epicsThreadStackBig)
-                 .autostart(false))
-    ,_sendThread(epics::pvData::Thread::Config(this, &BlockingTCPTransportCodec::sendThread)
-                 .prio(epicsThreadPriorityCAServerLow)
-                 .name("TCP-tx")
-                 .stack(epicsThreadStackBig)
-                 .autostart(false))
+         !TCPReactor::select(context))
+    ,_reactor(TCPReactor::select(context))
     ,_channel(channel)
+    ,_reactorId(0u)
+    ,_sendScheduled(false)
+    ,_rxWouldBlock(false)
+    ,_rxHead(0u), _rxDeliver(0u), _rxScan(0u), _rxEnd(0u), _rxScanNeed(0u)
+    ,_rxInSegment(false)
+    ,_rxUnframed(false)
+    ,_rxStream(false)
+    ,_rxStreamPending(false)
+    ,_txHead(0u)
+    ,_rxTimeout(0.0)
+    ,_shmTx(false)
+    ,_shmRx(false)
+    ,_compressThreshold(compressThreshold(context))
+    ,_zAccepted(false)
+    ,_zTx(false)
+    ,_zRx(false)
+    ,_zInPos(0u), _zInLen(0u), _zOutPos(0u), _zOutLen(0u)
     ,_context(context), _responseHandler(responseHandler)
     ,_remoteTransportReceiveBufferSize(MAX_TCP_RECV)
     ,_priority(priority)
@@ -1268,6 +2125,20 @@ void BlockingTCPTransportCodec::invalidDataStreamHandler() {
 int BlockingTCPTransportCodec::write(
     epics::pvData::ByteBuffer *src) {
 
+    if (_zTx)
+        return deflateWrite(src);
+    return rawWrite(src);
+}
+
+
+int BlockingTCPTransportCodec::rawWrite(
+    epics::pvData::ByteBuffer *src) {
+
+    if (_shmTx)
+        return shmWrite(src);
+    if (_reactor)
+        return reactorWrite(src);
+
     std::size_t remaining;
     while((remaining=src->getRemaining()) > 0) {
 
@@ -1288,6 +2159,8 @@ int BlockingTCPTransportCodec::write(
                 continue;
             else if (socketError==SOCK_ENOBUFS)
                 return 0;
+            else if (_reactor && (socketError==SOCK_EWOULDBLOCK || socketError==EAGAIN))
+                return 0; // non-blocking
         }
 
         if (bytesSent > 0) {
@@ -1302,8 +2175,110 @@ int BlockingTCPTransportCodec::write(
 }
 
 
+int BlockingTCPTransportCodec::writeGather(
+    epics::pvData::ByteBuffer *head,
+    epics::pvData::ByteBuffer *tail) {
+
+    if (_shmTx || _zTx)
+        return AbstractCodec::writeGather(head, tail);
+
+    if (_reactor && _txHead < _txPending.size())
+    {
+        // behind earlier output
+        int nhead = reactorWrite(head);
+        int ntail = reactorWrite(tail);
+        return nhead + ntail;
+    }
+
+#ifdef PVA_HAVE_SENDMSG
+    while(true) {
+        iovec iov[2];
+        size_t niov = 0u;
+
+        if(head->getRemaining() > 0) {
+            iov[niov].iov_base = const_cast<char*>(&head->getBuffer()[head->getPosition()]);
+            iov[niov].iov_len = head->getRemaining();
+            niov++;
+        }
+        if(tail->getRemaining() > 0) {
+            iov[niov].iov_base = const_cast<char*>(&tail->getBuffer()[tail->getPosition()]);
+            // keep total within range of our int return value
+            iov[niov].iov_len = std::min<size_t>(tail->getRemaining(), 1u<<30);
+            niov++;
+        }
+        if(niov==0u)
+            return 0;
+
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = niov;
+
+        ssize_t bytesSent = ::sendmsg(_channel, &msg, 0);
+
+        // NOTE: do not log here, you might override SOCKERRNO relevant to recv() operation above
+
+        if(unlikely(bytesSent<0)) {
+
+            int socketError = SOCKERRNO;
+
+            // spurious EINTR check
+            if (socketError==SOCK_EINTR)
+                continue;
+            else if (socketError==SOCK_ENOBUFS)
+                return 0;
+            else if (_reactor && (socketError==SOCK_EWOULDBLOCK || socketError==EAGAIN))
+            {
+                // non-blocking, keep all
+                int nhead = reactorWrite(head);
+                int ntail = reactorWrite(tail);
+                return nhead + ntail;
+            }
+
+            return -1;
+        }
+
+        size_t nhead = std::min<size_t>(bytesSent, head->getRemaining());
+        head->setPosition(head->getPosition() + nhead);
+        tail->setPosition(tail->getPosition() + (bytesSent - nhead));
+
+        if (_reactor)
+        {
+            // keep what the socket did not accept
+            int nrest = reactorWrite(head);
+            nrest += reactorWrite(tail);
+            return int(bytesSent) + nrest;
+        }
+
+        return int(bytesSent);
+    }
+#else
+    return AbstractCodec::writeGather(head, tail);
+#endif
+}
+
+
 int BlockingTCPTransportCodec::read(epics::pvData::ByteBuffer* dst) {
 
+    if (_reactor)
+        return fifoRead(dst);
+    return streamRead(dst);
+}
+
+
+int BlockingTCPTransportCodec::streamRead(epics::pvData::ByteBuffer* dst) {
+
+    if (_zRx)
+        return inflateRead(dst);
+    return rawRead(dst);
+}
+
+
+int BlockingTCPTransportCodec::rawRead(epics::pvData::ByteBuffer* dst) {
+
+    if (_shmRx)
+        return shmRead(dst);
+
     std::size_t remaining;
     while((remaining=dst->getRemaining()) > 0) {
 
@@ -1325,6 +2300,11 @@ int BlockingTCPTransportCodec::read(epics::pvData::ByteBuffer* dst) {
                 // interrupted by signal.  Retry
                 continue;
 
+            } else if(_reactor && (err==SOCK_EWOULDBLOCK || err==EAGAIN)) {
+                // non-blocking, nothing more to read for now
+                _rxWouldBlock = true;
+                return 0;
+
             } else if(err==SOCK_EWOULDBLOCK || err==EAGAIN || err==SOCK_EINPROGRESS
                       || err==SOCK_ETIMEDOUT
                       || err==SOCK_ECONNABORTED || err==SOCK_ECONNRESET
@@ -1374,6 +2354,380 @@ void BlockingTCPTransportCodec::verified(epics::pvData::Status const & status) {
     _verifiedEvent.signal();
 }
 
+size_t BlockingTCPTransportCodec::shmSize()
+{
+    // the reactor only waits on sockets
+    if (_reactor || !ShmRing::supported())
+        return 0u;
+
+    epics::pvData::int32 size = _context->getConfiguration()->getPropertyAsInteger("EPICS_PVA_SHM_SIZE", 0);
+    if (size <= 0)
+        return 0u;
+
+    // same host if the peer is loopback, or has our own address
+    osiSockAddr local;
+    osiSocklen_t slen = sizeof(local);
+    if (getsockname(_channel, &local.sa, &slen)!=0 || local.sa.sa_family!=AF_INET)
+        return 0u;
+
+    if ((ntohl(_socketAddress.ia.sin_addr.s_addr)>>24u)!=127u
+            && _socketAddress.ia.sin_addr.s_addr!=local.ia.sin_addr.s_addr)
+        return 0u;
+
+    return size_t(size);
+}
+
+void BlockingTCPTransportCodec::shmOffer()
+{
+    size_t size = shmSize();
+    if (!size)
+        return;
+
+    osiSockAddr local;
+    osiSocklen_t slen = sizeof(local);
+    if (getsockname(_channel, &local.sa, &slen)!=0)
+        return;
+
+    ShmRing::shared_pointer ring;
+    try {
+        ring = ShmRing::create(size, ntohs(local.ia.sin_port));
+    } catch(std::exception& e) {
+        LOG(logLevelDebug, "Not using shared memory with %s : %s", _socketName.c_str(), e.what());
+        return;
+    }
+
+    {
+        Guard G(_mutex);
+        if (_shm || !isOpen())
+            return;
+        _shm = ring;
+    }
+
+    // a server which does not understand will ignore, and we continue with TCP
+    TransportSender::shared_pointer sender(new ControlMessageSender(shared_from_this(), CMD_SHM_OFFER,
+                                                                    static_cast<int32>(ring->token())));
+    enqueueSendRequest(sender);
+}
+
+bool BlockingTCPTransportCodec::shmNegotiated()
+{
+    Guard G(_mutex);
+    return !!_shm;
+}
+
+void BlockingTCPTransportCodec::shmControlMessage()
+{
+    // control message data
+    const int32 data = _payloadSize;
+    const bool server = _clientServerFlag!=0;
+
+    ShmRing::shared_pointer ring;
+    bool verified;
+    {
+        Guard G(_mutex);
+        ring = _shm;
+        verified = _verified;
+    }
+
+    if (server && _command==CMD_SHM_OFFER)
+    {
+        bool accept = false;
+        if (!ring && verified && shmSize())
+        {
+            try {
+                // also removes the name
+                ring = ShmRing::open(ntohs(_socketAddress.ia.sin_port), static_cast<epicsUInt32>(data));
+
+                Guard G(_mutex);
+                _shm = ring;
+                accept = true;
+            } catch(std::exception& e) {
+                LOG(logLevelDebug, "Declining shared memory from %s : %s", _socketName.c_str(), e.what());
+            }
+        }
+
+        TransportSender::shared_pointer sender(new ControlMessageSender(shared_from_this(), CMD_SHM_ACCEPT, accept ? 1 : 0));
+        enqueueSendRequest(sender);
+    }
+    else if (server && _command==CMD_SHM_SWITCH && ring && !_shmRx)
+    {
+        // client sends nothing more through the socket
+        _shmRx = true;
+    }
+    else if (!server && _command==CMD_SHM_ACCEPT && ring && !_shmRx)
+    {
+        ring->unlink();
+
+        if (data==1)
+        {
+            // server sends nothing more through the socket
+            _shmRx = true;
+
+            TransportSender::shared_pointer sender(new ControlMessageSender(shared_from_this(), CMD_SHM_SWITCH, 0));
+            enqueueSendRequest(sender);
+        }
+        else
+        {
+            Guard G(_mutex);
+            _shm.reset();
+        }
+    }
+}
+
+void BlockingTCPTransportCodec::sendControl(epics::pvData::int8 command, epics::pvData::int32 data)
+{
+    putControlMessage(command, data);
+    // send now, the peer reads what follows differently
+    flush(true);
+
+    switch (command)
+    {
+    case CMD_SHM_ACCEPT:
+        if (data!=1)
+            break;
+        // fall through
+    case CMD_SHM_SWITCH:
+        _shmTx = true;
+        LOG(logLevelDebug, "Sending to %s through shared memory '%s'.", _socketName.c_str(), _shm->name().c_str());
+        break;
+    case CMD_COMPRESSION:
+        _zFrame.resize(frameHeaderSize + maxFrameSize);
+        _zTx = true;
+        LOG(logLevelDebug, "Compressing messages to %s.", _socketName.c_str());
+        break;
+    }
+}
+
+int BlockingTCPTransportCodec::shmWrite(epics::pvData::ByteBuffer* src)
+{
+    while (src->getRemaining() > 0)
+    {
+        int bytesSent = _shm->send(&src->getBuffer()[src->getPosition()], src->getRemaining(), shmWaitSlice);
+
+        if (bytesSent > 0) {
+            src->setPosition(src->getPosition() + bytesSent);
+            return bytesSent;
+
+        } else if (bytesSent < 0 || !isOpen() || !peerAlive()) {
+            return -1;
+        }
+        // ring full, wait again
+    }
+    return 0;
+}
+
+int BlockingTCPTransportCodec::shmRead(epics::pvData::ByteBuffer* dst)
+{
+    double timeout;
+    {
+        Guard G(_mutex);
+        timeout = _rxTimeout;
+    }
+
+    double waited = 0.0;
+    while (dst->getRemaining() > 0)
+    {
+        int bytesRead = _shm->recv((char*)(dst->getBuffer()+dst->getPosition()), dst->getRemaining(), shmWaitSlice);
+
+        if (bytesRead > 0) {
+            dst->setPosition(dst->getPosition() + bytesRead);
+            return bytesRead;
+
+        } else if (bytesRead < 0 || !isOpen() || !peerAlive()) {
+            return -1;
+        }
+
+        // as with SO_RCVTIMEO in read()
+        waited += shmWaitSlice;
+        if (timeout > 0.0 && waited >= timeout)
+            return -1;
+    }
+    return 0;
+}
+
+bool BlockingTCPTransportCodec::peerAlive()
+{
+#ifdef PVA_HAVE_SHM
+    // once switched, nothing arrives through the socket, except the end of stream
+    char dummy;
+    int ret = ::recv(_channel, &dummy, 1, MSG_PEEK|MSG_DONTWAIT);
+    if (ret==0) {
+        return false;
+    } else if (ret<0) {
+        int err = SOCKERRNO;
+        return err==SOCK_EWOULDBLOCK || err==EAGAIN || err==SOCK_EINTR;
+    }
+#endif
+    return true;
+}
+
+void BlockingTCPTransportCodec::connectionQoS(epics::pvData::int16 qos)
+{
+    if (!(qos & CONNECTION_QOS_COMPRESSION) || !compressionEnabled() || _zAccepted)
+        return;
+
+    // client can uncompress, so we compress from now on
+    _zAccepted = true;
+    TransportSender::shared_pointer sender(new ControlMessageSender(shared_from_this(), CMD_COMPRESSION, 1));
+    enqueueSendRequest(sender);
+}
+
+void BlockingTCPTransportCodec::compressionControlMessage()
+{
+    // only lzCompress() is known
+    if (_zRx || _payloadSize!=1)
+        return;
+
+    if (_clientServerFlag)
+    {
+        // client reply
+        if (!_zAccepted)
+            return;
+    }
+    else
+    {
+        // server accepted our request, reply
+        if (!compressionEnabled())
+            return;
+
+        TransportSender::shared_pointer sender(new ControlMessageSender(shared_from_this(), CMD_COMPRESSION, 1));
+        enqueueSendRequest(sender);
+    }
+
+    startInflate();
+}
+
+void BlockingTCPTransportCodec::startInflate()
+{
+    // anything already read after this control message is the start of the first frame
+    size_t carry = _socketBuffer.getRemaining();
+    size_t queued = _rxEnd - _rxHead;
+
+    _zIn.resize(std::max(frameHeaderSize + maxFrameSize, carry + queued));
+    _zOut.resize(maxFrameSize);
+    _socketBuffer.get(&_zIn[0], 0u, carry);
+
+    if (queued)
+    {
+        // read by reactorFill(), and wrongly scanned as uncompressed
+        memcpy(&_zIn[carry], &_rxFifo[_rxHead], queued);
+        carry += queued;
+    }
+    _rxHead = _rxDeliver = _rxScan = _rxEnd = _rxScanNeed = 0u;
+    _rxInSegment = _rxUnframed = false;
+    _zInPos = 0u;
+    _zInLen = carry;
+    _zOutPos = _zOutLen = 0u;
+
+    _socketBuffer.setLimit(_socketBuffer.getPosition());
+    _zRx = true;
+}
+
+int BlockingTCPTransportCodec::deflateWrite(epics::pvData::ByteBuffer* src)
+{
+    size_t count = std::min(src->getRemaining(), maxFrameSize);
+    if (count==0u)
+        return 0;
+
+    const char *raw = &src->getBuffer()[src->getPosition()];
+    char *frame = &_zFrame[0];
+
+    size_t stored = 0u;
+    if (count >= _compressThreshold)
+    {
+        // only worthwhile if at least 1/32 smaller
+        stored = lzCompress(raw, count, frame + frameHeaderSize, count - count/32u);
+    }
+    if (stored==0u)
+    {
+        stored = count;
+        memcpy(frame + frameHeaderSize, raw, count);
+    }
+
+    for (unsigned i=0; i<4u; i++)
+    {
+        frame[i] = char(stored>>(24u-8u*i));
+        frame[4u+i] = char(count>>(24u-8u*i));
+    }
+
+    // a whole frame is sent before returning
+    ByteBuffer wrapped(frame, frameHeaderSize + stored);
+    int tries = 0;
+    while (wrapped.getRemaining() > 0)
+    {
+        int bytesSent = rawWrite(&wrapped);
+        if (bytesSent < 0)
+            return -1;
+        else if (bytesSent == 0)
+            sendBufferFull(tries++);
+    }
+
+    src->setPosition(src->getPosition() + count);
+    return int(count);
+}
+
+int BlockingTCPTransportCodec::inflateRead(epics::pvData::ByteBuffer* dst)
+{
+    while (_zOutPos==_zOutLen)
+    {
+        size_t avail = _zInLen - _zInPos, need = frameHeaderSize;
+        size_t stored = 0u, count = 0u;
+
+        if (avail >= frameHeaderSize)
+        {
+            const unsigned char *head = reinterpret_cast<const unsigned char*>(&_zIn[_zInPos]);
+            for (unsigned i=0; i<4u; i++)
+            {
+                stored = (stored<<8u) | head[i];
+                count = (count<<8u) | head[4u+i];
+            }
+            if (count==0u || count > maxFrameSize || stored > count)
+            {
+                LOG(logLevelError, "Invalid compressed frame from %s, disconnecting...", _socketName.c_str());
+                return -1;
+            }
+            need += stored;
+        }
+
+        if (avail < need)
+        {
+            // move partial frame to start, and read more
+            if (_zInPos)
+            {
+                memmove(&_zIn[0], &_zIn[_zInPos], avail);
+                _zInPos = 0u;
+                _zInLen = avail;
+            }
+
+            ByteBuffer wrapped(&_zIn[_zInLen], _zIn.size() - _zInLen);
+            int bytesRead = rawRead(&wrapped);
+            if (bytesRead <= 0)
+                return bytesRead;
+            _zInLen += bytesRead;
+            continue;
+        }
+
+        const char *payload = &_zIn[_zInPos + frameHeaderSize];
+        if (stored==count)
+        {
+            memcpy(&_zOut[0], payload, count);
+        }
+        else if (!lzDecompress(payload, stored, &_zOut[0], count))
+        {
+            LOG(logLevelError, "Corrupt compressed frame from %s, disconnecting...", _socketName.c_str());
+            return -1;
+        }
+        _zInPos += need;
+        _zOutPos = 0u;
+        _zOutLen = count;
+    }
+
+    size_t n = std::min(dst->getRemaining(), _zOutLen - _zOutPos);
+    dst->put(&_zOut[0], _zOutPos, n);
+    _zOutPos += n;
+    return int(n);
+}
+
 void BlockingTCPTransportCodec::authNZMessage(epics::pvData::PVStructure::shared_pointer const & data) {
     AuthenticationSession::shared_pointer sess;
     {
@@ -1400,6 +2754,7 @@ public:
     {
     }
 
+    virtual SendClass getSendClass() const OVERRIDE FINAL { return SEND_CONTROL; }
     void send(ByteBuffer* buffer, TransportSendControl* control) {
         control->startMessage(CMD_AUTHNZ, 0);
         SerializationHelper::serializeFull(buffer, control, _data);
@@ -1844,7 +3199,7 @@ void BlockingClientTCPTransportCodec::send(ByteBuffer* buffer,
         buffer->putShort(0x7FFF);
 
         // QoS (aka connection priority)
-        buffer->putShort(getPriority());
+        buffer->putShort(getPriority() | (compressionEnabled() ? CONNECTION_QOS_COMPRESSION : 0));
 
         std::string pluginName;
         AuthenticationSession::shared_pointer session;
@@ -1946,6 +3301,9 @@ void BlockingClientTCPTransportCodec::verified(epics::pvData::Status const & sta
     if(sess)
         sess->authenticationComplete(status);
     this->BlockingTCPTransportCodec::verified(status);
+
+    if(status.isSuccess())
+        shmOffer();
 }
 
 }
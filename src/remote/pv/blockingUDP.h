@@ -236,6 +236,18 @@ public:
         return _tappedNIF;
     }
 
+    /**
+     * Handle only a share of received datagrams.
+     * For use when several sockets each receive all datagrams (broadcast or multicast),
+     * each handling those datagrams whose content hashes to its index.
+     * @param index of this socket in [0, count)
+     * @param count number of sockets sharing.
+     */
+    void setReceiveShard(size_t index, size_t count) {
+        _shardIndex = index;
+        _shardCount = count;
+    }
+
     bool send(const char* buffer, size_t length, const osiSockAddr& address);
 
     bool send(epics::pvData::ByteBuffer* buffer, const osiSockAddr& address);
@@ -287,6 +299,9 @@ protected:
     virtual void run() OVERRIDE FINAL;
 
 private:
+    // handle datagram of bytesRead bytes, in _receiveBuffer after space reserved for a prefix.
+    void processDatagram(Transport::shared_pointer const & transport, osiSockAddr& fromAddress, size_t bytesRead);
+
     bool processBuffer(Transport::shared_pointer const & transport, osiSockAddr& fromAddress, epics::pvData::ByteBuffer* receiveBuffer);
 
     void close(bool waitForThreadToComplete);
@@ -374,6 +389,11 @@ private:
 
     epics::pvData::int8 _clientServerWithEndianFlag;
 
+    /**
+     * Receive share, see setReceiveShard()
+     */
+    size_t _shardIndex, _shardCount;
+
 };
 
 class BlockingUDPConnector{
@@ -384,11 +404,14 @@ public:
 
     /**
      * NOTE: transport client is ignored for broadcast (UDP).
+     * @param shareReceive If true, set SO_REUSEPORT so that several sockets bound to the same address
+     *                     share (load balance) received unicast datagrams.  Where supported.
      */
     BlockingUDPTransport::shared_pointer connect(
             ResponseHandler::shared_pointer const & responseHandler,
             osiSockAddr& bindAddress,
-            epics::pvData::int8 transportRevision);
+            epics::pvData::int8 transportRevision,
+            bool shareReceive = false);
 
 private:
 
@@ -411,7 +434,8 @@ void initializeUDPTransports(
     epics::pvData::int32& listenPort,
     bool autoAddressList,
     const std::string& addressList,
-    const std::string& ignoreAddressList);
+    const std::string& ignoreAddressList,
+    unsigned receiveShards = 1u);
 
 
 }
@@ -12,7 +12,10 @@
 #   undef epicsExportSharedSymbols
 #endif
 
+#include <vector>
+
 #include <osiSock.h>
+#include <epicsTime.h>
 
 #ifdef channelSearchManagerEpicsExportSharedSymbols
 #   define epicsExportSharedSymbols
@@ -58,6 +61,24 @@ class ChannelSearchManager :
 public:
     POINTER_DEFINITIONS(ChannelSearchManager);
 
+    /**
+     * Search statistics.
+     */
+    struct Stats {
+        //! Channels being searched for
+        size_t pending;
+        //! Search responses received for pending channels
+        size_t found;
+        //! Names included in search requests
+        size_t namesSent;
+        //! Search request messages sent (each to all addresses of the address list)
+        size_t framesSent;
+        //! Current limit on messages sent before pausing
+        size_t burstFrames;
+        //! Mean and maximum time in seconds from registration until found
+        double meanSearchTime, maxSearchTime;
+    };
+
     virtual ~ChannelSearchManager();
     /**
      * Cancel.
@@ -73,6 +94,12 @@ public:
      * @param channel to register.
      */
     void registerSearchInstance(SearchInstance::shared_pointer const & channel, bool penalize = false);
+    /**
+     * Register many channels at once.
+     * Searched for on the next period, rather than immediately.
+     * @param channels to register.
+     */
+    void registerSearchInstances(const std::vector<SearchInstance::shared_pointer>& channels);
     /**
      * Unregister channel.
      * @param channel to unregister.
@@ -92,6 +119,10 @@ public:
      * Boost searching of all channels.
      */
     void newServerDetected();
+    /**
+     * Get search statistics.
+     */
+    Stats getStats();
 
     /// Timer callback.
     virtual void callback() OVERRIDE FINAL;
@@ -115,6 +146,8 @@ private:
 
     void boost();
 
+    size_t adaptBurst();
+
     void initializeSendBuffer();
     void flushSendBuffer();
 
@@ -145,12 +178,35 @@ private:
      */
     epics::pvData::ByteBuffer m_sendBuffer;
 
+    struct Pending {
+        SearchInstance::weak_pointer instance;
+        epicsTimeStamp registered;
+    };
+
     /**
      * Set of registered channels.
      */
-    typedef std::map<pvAccessID,SearchInstance::weak_pointer> m_channels_t;
+    typedef std::map<pvAccessID,Pending> m_channels_t;
     m_channels_t m_channels;
 
+    /**
+     * Search response statistics, guarded by m_channelMutex.
+     */
+    size_t m_found;
+    double m_totalSearchTime, m_maxSearchTime;
+
+    /**
+     * Burst size control, and send statistics, guarded by m_mutex.
+     * Frames sent before pausing, and the names sent and responses received since the last pause.
+     */
+    size_t m_burstFrames;
+    size_t m_burstNames, m_burstResponses;
+    /**
+     * Smoothed ratio of responses to names sent.
+     */
+    double m_responseRatio;
+    size_t m_namesSent, m_framesSent;
+
     /**
      * Time of last frame send.
      */
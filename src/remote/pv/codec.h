@@ -10,6 +10,7 @@
 #include <set>
 #include <map>
 #include <deque>
+#include <vector>
 
 #include <shareLib.h>
 #include <osiSock.h>
@@ -37,6 +38,8 @@
 #include <pv/transportRegistry.h>
 #include <pv/introspectionRegistry.h>
 #include <pv/inetAddressUtil.h>
+#include <pv/shmRing.h>
+#include <pv/transportStats.h>
 
 /* C++11 keywords
  @code
@@ -71,6 +74,8 @@ class ServerChannel;
 
 namespace detail {
 
+class TCPReactor;
+
 #ifdef PVA_CODEC_USE_ATOMIC
 #undef PVA_CODEC_USE_ATOMIC
 template<typename T>
@@ -157,6 +162,42 @@ public:
 };
 
 
+/**
+ * Send queue with one fair_queue for each TransportSender::SendClass .
+ *
+ * pop_front() returns a sender from the first non-empty class,
+ * so that small replies do not wait behind every queued bulk reply.
+ * A class passed over maxPassed times while non-empty is served next.
+ *
+ * As with fair_queue, only one thread should pop.
+ */
+class epicsShareClass SendQueue
+{
+public:
+    enum { maxPassed = 8 };
+
+    SendQueue();
+
+    void push_back(const TransportSender::shared_pointer& sender);
+    //! @returns false if all classes are empty
+    bool pop_front_try(TransportSender::shared_pointer& sender);
+    //! wait until a sender is available
+    void pop_front(TransportSender::shared_pointer& sender);
+    bool empty() const;
+    //! Number of senders queued
+    size_t size() const;
+    void clear();
+
+private:
+    fair_queue<TransportSender> queues[TransportSender::SEND_CLASSES];
+    // # of pops from higher classes since this class was last served (only used by popping thread)
+    unsigned passed[TransportSender::SEND_CLASSES];
+    epicsEvent wakeup;
+
+    EPICS_NOT_COPYABLE(SendQueue)
+};
+
+
 enum ReadMode { NORMAL, SPLIT, SEGMENTED };
 
 enum WriteMode { PROCESS_SEND_QUEUE, WAIT_FOR_READY_SIGNAL };
@@ -192,6 +233,13 @@ public:
     virtual void sendCompleted() = 0;
     virtual bool terminated() = 0;
     virtual int write(epics::pvData::ByteBuffer* src) = 0;
+    /**
+     * Write the remaining bytes of 'head' followed by those of 'tail',
+     * in a single (gathering) operation where supported.
+     * Positions of both buffers are advanced.
+     * @return number of bytes written, 0 if would block, <0 on error (cf. write())
+     */
+    virtual int writeGather(epics::pvData::ByteBuffer* head, epics::pvData::ByteBuffer* tail);
     virtual int read(epics::pvData::ByteBuffer* dst) = 0;
     virtual bool isOpen() = 0;
 
@@ -240,6 +288,14 @@ public:
         return _sendQueue.empty();
     }
 
+    size_t sendQueueSize() const {
+        return _sendQueue.size();
+    }
+
+    const TransportStats& getStats() const {
+        return _stats;
+    }
+
     epics::pvData::int8 getRevision() const {
         epicsGuard<epicsMutex> G(_mutex);
         int8_t myver = _clientServerFlag ? PVA_SERVER_PROTOCOL_REVISION : PVA_CLIENT_PROTOCOL_REVISION;
@@ -249,7 +305,10 @@ public:
 protected:
 
     virtual void sendBufferFull(int tries) = 0;
+    //! True if earlier output is still waiting to be sent.  processSendQueue() stops early.
+    virtual bool sendBlocked() { return false; }
     void send(epics::pvData::ByteBuffer *buffer);
+    void send(epics::pvData::ByteBuffer *head, epics::pvData::ByteBuffer *tail);
     void flushSendBuffer();
 
     virtual void setRxTimeout(bool ena) {}
@@ -270,7 +329,12 @@ protected:
     epics::pvData::ByteBuffer _socketBuffer;
     epics::pvData::ByteBuffer _sendBuffer;
 
-    fair_queue<TransportSender> _sendQueue;
+    SendQueue _sendQueue;
+
+    TransportStats _stats;
+
+    // when false, processSendQueue() returns when the queue is empty
+    const bool _blockingProcessQueue;
 
 private:
 
@@ -328,7 +392,7 @@ public:
 
     virtual void readPollOne() OVERRIDE FINAL;
     virtual void writePollOne() OVERRIDE FINAL;
-    virtual void scheduleSend() OVERRIDE FINAL {}
+    virtual void scheduleSend() OVERRIDE FINAL;
     virtual void sendCompleted() OVERRIDE FINAL {}
     virtual void close() OVERRIDE FINAL;
     virtual void waitJoin() OVERRIDE FINAL;
@@ -338,6 +402,7 @@ public:
 
     virtual int read(epics::pvData::ByteBuffer* dst) OVERRIDE FINAL;
     virtual int write(epics::pvData::ByteBuffer* src) OVERRIDE FINAL;
+    virtual int writeGather(epics::pvData::ByteBuffer* head, epics::pvData::ByteBuffer* tail) OVERRIDE FINAL;
     virtual const osiSockAddr* getLastReadBufferSocketAddress() OVERRIDE FINAL  {
         return &_socketAddress;
     }
@@ -353,6 +418,14 @@ public:
             // check 7-th bit
             setByteOrder(_flags < 0 ? EPICS_ENDIAN_BIG : EPICS_ENDIAN_LITTLE);
         }
+        else if (_command == CMD_COMPRESSION)
+        {
+            compressionControlMessage();
+        }
+        else if (_command >= CMD_SHM_OFFER && _command <= CMD_SHM_SWITCH)
+        {
+            shmControlMessage();
+        }
     }
 
 
@@ -431,14 +504,78 @@ public:
 
     virtual void sendSecurityPluginMessage(epics::pvData::PVStructure::const_shared_pointer const & data) OVERRIDE FINAL;
 
+    //! Send a shared memory, or compression, negotiation message.  Called from the send queue.
+    //! Later sends go through the ring, or are compressed, as the message says.
+    void sendControl(epics::pvData::int8 command, epics::pvData::int32 data);
+
+    //! Server side.  Connection QoS requested by the client.
+    void connectionQoS(epics::pvData::int16 qos);
+
+    //! Server side, true once shared memory is accepted.  Client side, once offered and until declined.
+    bool shmNegotiated();
+
+    // called by TCPReactor.
+    // Returns true if left to the stream thread, which calls TCPReactor::resumeRead() when done.
+    bool reactorRead();
+    enum ReactorSend {
+        SendDone,    // send queue empty
+        SendMore,    // more remains queued
+        SendBlocked  // output waits for the socket to become writable
+    };
+    ReactorSend reactorSend();
+    void reactorCheckTimeout(const epicsTimeStamp& now);
+
 private:
     void receiveThread();
     void sendThread();
+    void streamThread();
+
+    // socket, or shared memory ring
+    int rawRead(epics::pvData::ByteBuffer* dst);
+    int rawWrite(epics::pvData::ByteBuffer* src);
+    // rawRead(), or inflateRead()
+    int streamRead(epics::pvData::ByteBuffer* dst);
+
+    // with _reactor, read() and write() never wait on the socket, except while streaming
+    bool reactorParse();
+    bool reactorFill();
+    void reactorScan();
+    int fifoRead(epics::pvData::ByteBuffer* dst);
+    bool startStream();
+    void streamWait();
+    void streamDone();
+    int reactorSendSome(const char* data, size_t count);
+    int reactorWrite(epics::pvData::ByteBuffer* src);
+    void reactorFlush();
+
+    void shmControlMessage();
+    int shmWrite(epics::pvData::ByteBuffer* src);
+    int shmRead(epics::pvData::ByteBuffer* dst);
+    bool peerAlive();
+
+    void compressionControlMessage();
+    void startInflate();
+    int deflateWrite(epics::pvData::ByteBuffer* src);
+    int inflateRead(epics::pvData::ByteBuffer* dst);
 
 protected:
     virtual void setRxTimeout(bool ena) OVERRIDE FINAL;
 
+    /** Ring size in bytes if a shared memory transport may be used with this peer,
+     *  which must be on the same host.  Otherwise 0.
+     *  Enabled by setting $EPICS_PVA_SHM_SIZE at both ends.
+     */
+    size_t shmSize();
+    //! Client side.  Offer a shared memory transport, if possible.
+    void shmOffer();
+
+    /** True if compression may be used.  Enabled by setting $EPICS_PVA_COMPRESS_THRESHOLD
+     *  at both ends to the minimum number of bytes worth compressing.
+     */
+    bool compressionEnabled() const { return _compressThreshold!=0u; }
+
     virtual void sendBufferFull(int tries) OVERRIDE FINAL;
+    virtual bool sendBlocked() OVERRIDE FINAL;
 
     /**
      * Called from close(). after start of shutdown (isOpen()==false)
@@ -448,8 +585,49 @@ protected:
 
 private:
     AtomicValue<bool> _isOpen;
-    epics::pvData::Thread _readThread, _sendThread;
+    // NULL when using our own threads
+    TCPReactor * const _reactor;
+    epics::auto_ptr<epics::pvData::Thread> _readThread, _sendThread;
     const SOCKET _channel;
+    // when using _reactor
+    epicsUInt64 _reactorId;
+    bool _sendScheduled; // guarded by _mutex
+    bool _rxWouldBlock;
+    /* Bytes received, but not yet parsed.  Only used by reactorRead(), or the stream thread.
+     * No larger than _socketBuffer.
+     * [_rxHead, _rxDeliver) is the remainder of complete messages, which read() returns.
+     * [_rxDeliver, _rxEnd) waits for the rest of a message, or of a segmented message.
+     * Headers before _rxScan have been looked at, _rxScanNeed payload bytes of the last remain.
+     */
+    std::vector<char> _rxFifo;
+    size_t _rxHead, _rxDeliver, _rxScan, _rxEnd, _rxScanNeed;
+    bool _rxInSegment, _rxUnframed;
+    /* A message which does not fit in _rxFifo is passed on as it arrives by _readThread,
+     * which may wait on the socket.  read() returns all of _rxFifo, then reads the socket.
+     */
+    bool _rxStream;
+    bool _rxStreamPending; // guarded by _mutex
+    epicsEvent _rxStreamWake;
+    // Bytes written, but not yet accepted by the socket.  Only used by reactorSend()
+    std::vector<char> _txPending;
+    size_t _txHead;
+    double _rxTimeout; // guarded by _mutex
+    epicsTimeStamp _lastRx; // guarded by _mutex
+    // set before negotiation starts, guarded by _mutex until then
+    ShmRing::shared_pointer _shm;
+    bool _shmTx; // only used by send thread
+    bool _shmRx; // only used by receive thread
+    /* Once compression is negotiated, the byte stream in each direction is a sequence of frames.
+     * Each has an 8 byte header, stored size and uncompressed size (both uint32 big endian),
+     * followed by the stored bytes.  The two sizes are equal if not compressed.
+     */
+    const size_t _compressThreshold;
+    bool _zAccepted; // server, only used by receive thread
+    bool _zTx; // only used by send thread
+    std::vector<char> _zFrame; // only used by send thread
+    bool _zRx; // only used by receive thread, as the following
+    std::vector<char> _zIn, _zOut; // received, and uncompressed, frames
+    size_t _zInPos, _zInLen, _zOutPos, _zOutLen;
 protected:
     osiSockAddr _socketAddress;
     std::string _socketName;
@@ -561,6 +739,7 @@ public:
     virtual void authenticationCompleted(epics::pvData::Status const & status,
                                          const std::tr1::shared_ptr<PeerInfo>& peer) OVERRIDE FINAL;
 
+    virtual SendClass getSendClass() const OVERRIDE FINAL { return SEND_CONTROL; }
     virtual void send(epics::pvData::ByteBuffer* buffer,
                       TransportSendControl* control) OVERRIDE FINAL;
 
@@ -653,6 +832,7 @@ public:
 
     virtual void release(pvAccessID clientId) OVERRIDE FINAL;
 
+    virtual SendClass getSendClass() const OVERRIDE FINAL { return SEND_CONTROL; }
     virtual void send(epics::pvData::ByteBuffer* buffer,
                       TransportSendControl* control) OVERRIDE FINAL;
 
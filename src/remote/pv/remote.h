@@ -82,6 +82,20 @@ enum QoS {
     QOS_GET_PUT = 0x80
 };
 
+/**
+ * Connection QoS, sent by a client in CMD_CONNECTION_VALIDATION
+ */
+enum ConnectionQoS {
+    /**
+     * Priority, cf. ChannelProvider::PRIORITY_MIN and PRIORITY_MAX
+     */
+    CONNECTION_QOS_PRIORITY_MASK = 0x7F,
+    /**
+     * Client can receive compressed frames (cf. CMD_COMPRESSION).
+     */
+    CONNECTION_QOS_COMPRESSION = 0x400
+};
+
 enum ApplicationCommands {
     CMD_BEACON = 0,
     CMD_CONNECTION_VALIDATION = 1,
@@ -111,7 +125,13 @@ enum ApplicationCommands {
 enum ControlCommands {
     CMD_SET_MARKER = 0,
     CMD_ACK_MARKER = 1,
-    CMD_SET_ENDIANESS = 2
+    CMD_SET_ENDIANESS = 2,
+    // same host shared memory negotiation, ignored by peers which do not support it
+    CMD_SHM_OFFER = 0x40,  // client, data is segment token
+    CMD_SHM_ACCEPT = 0x41, // server, data is 1 if accepted
+    CMD_SHM_SWITCH = 0x42, // client
+    // server if CONNECTION_QOS_COMPRESSION was requested, then client.  data is algorithm, 1 for lzCompress()
+    CMD_COMPRESSION = 0x43
 };
 
 /**
@@ -140,6 +160,22 @@ public:
 
     virtual ~TransportSender() {}
 
+    /**
+     * Send queue classes.  A transport sends from the first non-empty class,
+     * except that a class passed over for too long is served next.
+     */
+    enum SendClass {
+        SEND_CONTROL, //!< control messages and small replies (eg. echo, put/process completion)
+        SEND_MONITOR, //!< monitor updates
+        SEND_BULK,    //!< others, which may carry large arrays (eg. get, RPC)
+        SEND_CLASSES
+    };
+
+    /**
+     * Called by transport when queued.  Must not change while queued.
+     */
+    virtual SendClass getSendClass() const { return SEND_BULK; }
+
     /**
      * Called by transport.
      * By this call transport gives callee ownership over the buffer.
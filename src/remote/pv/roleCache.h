@@ -0,0 +1,112 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#ifndef ROLECACHE_H
+#define ROLECACHE_H
+
+#include <map>
+#include <deque>
+#include <string>
+
+#ifdef epicsExportSharedSymbols
+#   define roleCacheEpicsExportSharedSymbols
+#   undef epicsExportSharedSymbols
+#endif
+
+#include <epicsTime.h>
+#include <epicsMutex.h>
+#include <epicsEvent.h>
+#include <pv/noDefaultMethods.h>
+#include <pv/sharedPtr.h>
+#include <pv/thread.h>
+
+#ifdef roleCacheEpicsExportSharedSymbols
+#   define epicsExportSharedSymbols
+#	undef roleCacheEpicsExportSharedSymbols
+#endif
+
+#include <pv/security.h>
+
+#include <shareLib.h>
+
+namespace epics {
+namespace pvAccess {
+namespace detail {
+
+/** Process wide cache of osdGetRoles() results, by account name.
+ *
+ * Looking up the groups of an account may involve a directory service (eg. LDAP),
+ * and take long enough to delay the validation of many new connections.
+ *
+ * An entry younger than ttl() is used as is.  An entry older than ttl() is still used,
+ * while being looked up again by a background thread.  An entry older than twice ttl()
+ * is looked up again before use.  Concurrent lookups of the same account are combined.
+ *
+ * The initial ttl() is taken from $EPICS_PVAS_ROLE_CACHE_TTL (seconds), default 10.
+ * 0 disables caching.
+ */
+class epicsShareClass RoleCache {
+    EPICS_NOT_COPYABLE(RoleCache)
+public:
+    typedef void (*lookup_t)(const std::string& account, PeerInfo::roles_t& roles);
+
+    //! Shared by all server contexts.  Uses osdGetRoles()
+    static RoleCache& instance();
+
+    RoleCache(double ttl, lookup_t lookup);
+    ~RoleCache();
+
+    //! Add the roles of account, as osdGetRoles() would
+    void getRoles(const std::string& account, PeerInfo::roles_t& roles);
+
+    double ttl() const;
+    //! Change the time to live (seconds).  0 disables caching.
+    void setTTL(double ttl);
+    //! Forget all entries
+    void clear();
+
+    struct Stats {
+        size_t entries;   //!< # of accounts currently held
+        size_t hits;      //!< # of getRoles() with a current entry
+        size_t stale;     //!< # of getRoles() with an entry being refreshed
+        size_t misses;    //!< # of getRoles() which waited for a lookup
+        size_t refreshes; //!< # of background lookups
+    };
+    void getStats(Stats& s) const;
+
+private:
+    void run();
+    void sweepLocked(const epicsTimeStamp& now);
+
+    struct Entry {
+        PeerInfo::roles_t roles;
+        epicsTimeStamp updated;
+        bool valid;     // roles holds a completed lookup
+        bool busy;      // lookup in progress, or queued for refresh
+        size_t waiters; // # of getRoles() waiting for this lookup
+        std::tr1::shared_ptr<epicsEvent> done;
+        Entry() :valid(false), busy(false), waiters(0u) {}
+    };
+    typedef std::map<std::string, Entry> entries_t;
+
+    const lookup_t lookup;
+
+    mutable epicsMutex mutex;
+    entries_t entries;
+    double _ttl;
+    size_t sweepAt;
+    size_t _hits, _stale, _misses, _refreshes;
+
+    // background refresh
+    std::deque<std::string> refreshQueue;
+    epicsEvent wakeup;
+    bool stopping;
+    std::tr1::shared_ptr<epics::pvData::Thread> worker;
+};
+
+}}} // namespace epics::pvAccess::detail
+
+#endif // ROLECACHE_H
@@ -0,0 +1,106 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#ifndef SHMRING_H
+#define SHMRING_H
+
+#include <string>
+
+#include <epicsTypes.h>
+
+#include <pv/noDefaultMethods.h>
+#include <pv/sharedPtr.h>
+
+#if defined(__linux__)
+#  define PVA_HAVE_SHM
+#endif
+
+namespace epics {
+namespace pvAccess {
+namespace detail {
+
+/** A pair of single producer, single consumer, byte rings in a shared memory segment.
+ *
+ *  Carries the PVA byte stream of a TCP connection between two processes on the same host,
+ *  in place of the socket, once both ends agree (cf. BlockingTCPTransportCodec).
+ *  The client creates the segment, and the server opens it by name.
+ *  The client writes to the first ring and reads from the second, the server the opposite.
+ *
+ *  Waiting is with a futex in the segment, so no system call is made unless one side sleeps.
+ *  Only available on Linux.
+ */
+class ShmRing
+{
+public:
+    POINTER_DEFINITIONS(ShmRing);
+
+    //! True if this target can create or open segments
+    static bool supported();
+
+    /** Create and map a new segment.
+     *
+     * @param ringSize Bytes in each direction.  Rounded up to a power of two.
+     * @param port Local TCP port of the connection, to make the name unique.
+     * @throws std::runtime_error on failure
+     */
+    static shared_pointer create(size_t ringSize, unsigned short port);
+
+    /** Open and map a segment created by the peer.
+     *
+     * Once valid, and so mapped by both, the name is removed.
+     * A segment which is not valid is left for the creator to remove.
+     *
+     * @param port TCP port of the peer, as given to create().
+     * @param token As returned by token() of the creator.
+     * @throws std::runtime_error on failure, or if the segment is not valid.
+     */
+    static shared_pointer open(unsigned short port, epicsUInt32 token);
+
+    ~ShmRing();
+
+    //! Identifies this segment to the peer.  Random for each segment.
+    epicsUInt32 token() const { return _token; }
+    const std::string& name() const { return _name; }
+    size_t ringSize() const { return _ringSize; }
+
+    //! Remove the name, if created by this process.  Already mapped segments remain valid.
+    void unlink();
+
+    /** Copy up to 'count' bytes into the outgoing ring.
+     *  Waits up to 'timeout' seconds for space.
+     * @returns number of bytes copied, 0 on timeout, or <0 if closed.
+     */
+    int send(const char* src, size_t count, double timeout);
+
+    /** Copy up to 'count' bytes out of the incoming ring.
+     *  Waits up to 'timeout' seconds for data.
+     * @returns number of bytes copied, 0 on timeout, or <0 if closed (or corrupt).
+     */
+    int recv(char* dst, size_t count, double timeout);
+
+    //! Mark both directions closed, and wake any waiter in either process.
+    void close();
+
+    struct Control;
+private:
+    ShmRing();
+
+    std::string _name;
+    epicsUInt32 _token;
+    bool _creator;
+    bool _linked;
+    size_t _ringSize;
+    size_t _mapSize;
+    void *_base;
+    Control *_tx, *_rx;
+    char *_txData, *_rxData;
+
+    EPICS_NOT_COPYABLE(ShmRing)
+};
+
+}}} // namespace epics::pvAccess::detail
+
+#endif // SHMRING_H
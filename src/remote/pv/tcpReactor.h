@@ -0,0 +1,120 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#ifndef TCPREACTOR_H
+#define TCPREACTOR_H
+
+#include <map>
+#include <deque>
+#include <vector>
+
+#include <osiSock.h>
+#include <epicsTypes.h>
+#include <epicsTime.h>
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+#include <epicsEvent.h>
+
+#include <pv/noDefaultMethods.h>
+#include <pv/sharedPtr.h>
+#include <pv/thread.h>
+
+#include <pv/remote.h>
+
+#if defined(__linux__)
+#  define PVA_HAVE_EPOLL
+#endif
+
+namespace epics {
+namespace pvAccess {
+namespace detail {
+
+class BlockingTCPTransportCodec;
+
+/** Services the sockets of many TCP transports with a small, process wide, pool of threads
+ *  instead of a receive and a send thread for each transport.
+ *
+ *  Enabled by setting $EPICS_PVA_TCP_REACTOR_THREADS to the (non-zero) number of threads.
+ *  Only available where epoll() is, elsewhere transports always use their own threads.
+ *
+ *  Sockets are made non-blocking, and pool threads never wait on one.
+ *  When a socket becomes readable, a pool thread reads what is available, and runs
+ *  AbstractCodec::processRead() for each message which has arrived completely.
+ *  A partial message is kept by the transport until the rest arrives, up to the size of its
+ *  receive buffer.  The rest of a larger message is passed on as it arrives by a thread of
+ *  the transport, started when first needed, which waits on the socket so that pool threads do not.
+ *  The socket is not watched for EPOLLIN meanwhile.
+ *  Queued sends are run on a pool thread through AbstractCodec::processSendQueue().
+ *  What the socket will not yet accept is kept by the transport, which is then
+ *  watched for EPOLLOUT, and not sent to again until the socket becomes writable.
+ */
+class TCPReactor
+{
+public:
+    //! Get the reactor if enabled by configuration, otherwise NULL.
+    //! The reactor is created, and its threads started, on first use.
+    static TCPReactor* select(const Context::shared_pointer& context);
+
+    //! Begin servicing the socket of a newly started transport.
+    //! @returns an ID used with the other methods.
+    epicsUInt64 add(const std::tr1::shared_ptr<BlockingTCPTransportCodec>& codec, SOCKET sock);
+    //! Stop servicing.  Must be called before the socket is closed.
+    void remove(epicsUInt64 id);
+    //! Arrange for the send queue of the transport to be processed.
+    //! @returns false if no longer serviced (after remove() ).
+    bool scheduleSend(epicsUInt64 id);
+    //! Wait until all activity for this transport has completed after remove()
+    void waitIdle(epicsUInt64 id);
+    //! Watch for EPOLLIN again after BlockingTCPTransportCodec::reactorRead() returned true.
+    void resumeRead(epicsUInt64 id);
+
+private:
+    explicit TCPReactor(size_t nthreads);
+    ~TCPReactor(); // never called, lives as long as the process
+
+    static void onceInit(void *arg);
+
+    struct Entry {
+        std::tr1::shared_ptr<BlockingTCPTransportCodec> codec;
+        SOCKET sock;
+        // number of pending or in-progress send or read work items
+        size_t busy;
+        // still registered with epoll
+        bool registered;
+        // reactorRead(), or streaming, in progress, so not waiting for EPOLLIN
+        bool reading;
+        // unsent output, waiting for EPOLLOUT
+        bool wantWrite;
+        // signaled when erased, if waitIdle()
+        std::tr1::shared_ptr<epicsEvent> idle;
+        Entry() :sock(INVALID_SOCKET), busy(0u), registered(false), reading(false), wantWrite(false) {}
+    };
+    typedef std::map<epicsUInt64, Entry> entries_t;
+
+    void run();
+    void runEvent(epicsUInt64 id, epicsUInt32 events);
+    void runSend();
+    void checkTimeouts();
+    void wakeup();
+    void rearmLocked(epicsUInt64 id, Entry& ent);
+    void eraseLocked(entries_t::iterator it, std::tr1::shared_ptr<BlockingTCPTransportCodec>& done);
+
+    epicsMutex mutex;
+    entries_t entries;
+    // transports with queued sends, in order of scheduling
+    std::deque<epicsUInt64> sendQueue;
+    epicsUInt64 nextId;
+    epicsTimeStamp lastTimeoutCheck;
+
+    int epfd, evfd;
+    std::vector<epics::pvData::Thread*> workers;
+
+    EPICS_NOT_COPYABLE(TCPReactor)
+};
+
+}}} // namespace epics::pvAccess::detail
+
+#endif // TCPREACTOR_H
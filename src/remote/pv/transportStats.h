@@ -0,0 +1,127 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#ifndef TRANSPORTSTATS_H
+#define TRANSPORTSTATS_H
+
+#include <vector>
+#include <ostream>
+
+#ifdef epicsExportSharedSymbols
+#   define transportStatsEpicsExportSharedSymbols
+#   undef epicsExportSharedSymbols
+#endif
+
+#include <epicsTypes.h>
+#include <epicsAtomic.h>
+#include <compilerDependencies.h>
+
+#ifdef transportStatsEpicsExportSharedSymbols
+#   define epicsExportSharedSymbols
+#	undef transportStatsEpicsExportSharedSymbols
+#endif
+
+#include <shareLib.h>
+
+namespace epics {
+namespace pvAccess {
+namespace detail {
+
+//! Monotonic time in nanoseconds, for measuring intervals.
+epicsShareFunc epicsUInt64 statsClock();
+
+/** Histogram of durations, in the manner of HdrHistogram.
+ *
+ * Buckets are powers of two of nanoseconds, each divided into 4 linear sub-buckets,
+ * so a duration is recorded with at most 25% error from 1ns to 4.3 seconds.
+ * Longer durations are counted in the last bucket.
+ *
+ * record() is lock free, and may be called from any thread.
+ * Reading is not synchronized with record(), so a snapshot taken while
+ * recording may be off by the few durations being recorded.
+ */
+class epicsShareClass LatencyHistogram
+{
+    EPICS_NOT_COPYABLE(LatencyHistogram)
+public:
+    enum {
+        subBits = 2u,
+        nBuckets = ((32u-subBits+1u)<<subBits) + 1u // last is overflow
+    };
+
+    LatencyHistogram();
+
+    void record(epicsUInt64 ns)
+    {
+        epics::atomic::increment(_counts[bucketOf(ns)]);
+    }
+
+    //! Bucket holding duration 'ns'
+    static size_t bucketOf(epicsUInt64 ns);
+    //! Shortest duration of bucket 'i' in ns
+    static epicsUInt64 bucketStart(size_t i);
+
+    //! Copy of the counts
+    void snapshot(std::vector<size_t>& counts) const;
+
+    //! Total count of a snapshot
+    static size_t total(const std::vector<size_t>& counts);
+    /** Duration (ns) at or below which lie the fraction 'p' of a snapshot.
+     *  Upper bound of the bucket where 'p' falls.  0 if empty.
+     */
+    static epicsUInt64 percentile(const std::vector<size_t>& counts, double p);
+
+private:
+    size_t _counts[nBuckets];
+};
+
+/** Counters of one connection.
+ *
+ * Each counter is only incremented by one thread, the receive or send thread,
+ * but may be read by any.
+ */
+struct epicsShareClass TransportStats
+{
+    size_t bytesRx, bytesTx;
+    size_t messagesRx, messagesTx;
+
+    TransportStats() :bytesRx(0u), bytesTx(0u), messagesRx(0u), messagesTx(0u) {}
+
+    void received(size_t bytes) { epics::atomic::add(bytesRx, bytes); }
+    void sent(size_t bytes) { epics::atomic::add(bytesTx, bytes); }
+    void messageReceived() { epics::atomic::increment(messagesRx); }
+    void messageSent() { epics::atomic::increment(messagesTx); }
+};
+
+//! Counters of one (application) command, by all connections of a server.
+struct epicsShareClass CommandStats
+{
+    size_t messages, bytes;
+    //! Time spent in handler
+    LatencyHistogram latency;
+
+    CommandStats() :messages(0u), bytes(0u) {}
+};
+
+//! Records the time from construction to destruction, unless given NULL
+struct LatencyTimer
+{
+    LatencyHistogram * const hist;
+    const epicsUInt64 start;
+
+    explicit LatencyTimer(LatencyHistogram *hist) :hist(hist), start(hist ? statsClock() : 0u) {}
+    ~LatencyTimer() {
+        if(hist)
+            hist->record(statsClock()-start);
+    }
+};
+
+//! Name of application command, or NULL
+epicsShareFunc const char* commandName(int cmd);
+
+}}} // namespace epics::pvAccess::detail
+
+#endif // TRANSPORTSTATS_H
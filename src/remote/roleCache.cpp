@@ -0,0 +1,249 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <algorithm>
+
+#include <epicsThread.h>
+#include <epicsGuard.h>
+
+#define epicsExportSharedSymbols
+#include <pv/roleCache.h>
+#include <pv/configuration.h>
+#include <pv/logger.h>
+
+namespace pvd = epics::pvData;
+
+typedef epicsGuard<epicsMutex> Guard;
+typedef epicsGuardRelease<epicsMutex> UnGuard;
+
+namespace epics {
+namespace pvAccess {
+namespace detail {
+
+namespace {
+RoleCache* cache;
+epicsThreadOnceId cacheOnce = EPICS_THREAD_ONCE_INIT;
+
+void cacheInit(void *)
+{
+    Configuration::const_shared_pointer env(ConfigurationBuilder().push_env().build());
+    double ttl = env->getPropertyAsDouble("EPICS_PVAS_ROLE_CACHE_TTL", 10.0);
+    // never free'd, as connections may be validated during process exit
+    cache = new RoleCache(ttl, &osdGetRoles);
+}
+} // namespace
+
+RoleCache& RoleCache::instance()
+{
+    epicsThreadOnce(&cacheOnce, &cacheInit, 0);
+    return *cache;
+}
+
+RoleCache::RoleCache(double ttl, lookup_t lookup)
+    :lookup(lookup)
+    ,_ttl(ttl > 0.0 ? ttl : 0.0)
+    ,sweepAt(64u)
+    ,_hits(0u)
+    ,_stale(0u)
+    ,_misses(0u)
+    ,_refreshes(0u)
+    ,stopping(false)
+{}
+
+RoleCache::~RoleCache()
+{
+    {
+        Guard G(mutex);
+        stopping = true;
+    }
+    wakeup.signal();
+    if(worker)
+        worker->exitWait();
+}
+
+double RoleCache::ttl() const
+{
+    Guard G(mutex);
+    return _ttl;
+}
+
+void RoleCache::setTTL(double ttl)
+{
+    Guard G(mutex);
+    _ttl = ttl > 0.0 ? ttl : 0.0;
+}
+
+void RoleCache::clear()
+{
+    Guard G(mutex);
+    for(entries_t::iterator it(entries.begin()), end(entries.end()); it!=end;) {
+        entries_t::iterator cur(it++);
+        if(cur->second.busy || cur->second.waiters)
+            cur->second.valid = false; // in use, forget once complete
+        else
+            entries.erase(cur);
+    }
+}
+
+void RoleCache::getStats(Stats& s) const
+{
+    Guard G(mutex);
+    s.entries = entries.size();
+    s.hits = _hits;
+    s.stale = _stale;
+    s.misses = _misses;
+    s.refreshes = _refreshes;
+}
+
+void RoleCache::sweepLocked(const epicsTimeStamp& now)
+{
+    for(entries_t::iterator it(entries.begin()), end(entries.end()); it!=end;) {
+        entries_t::iterator cur(it++);
+        const Entry& ent = cur->second;
+        if(!ent.busy && !ent.waiters
+                && (!ent.valid || epicsTimeDiffInSeconds(&now, &ent.updated) >= 2.0*_ttl))
+            entries.erase(cur);
+    }
+    sweepAt = std::max(size_t(64u), 2u*entries.size());
+}
+
+void RoleCache::getRoles(const std::string& account, PeerInfo::roles_t& roles)
+{
+    Guard G(mutex);
+
+    if(_ttl<=0.0) {
+        _misses++;
+        UnGuard U(G);
+        (*lookup)(account, roles);
+        return;
+    }
+
+    epicsTimeStamp now;
+    epicsTimeGetCurrent(&now);
+
+    entries_t::iterator it(entries.find(account));
+    if(it==entries.end()) {
+        if(entries.size() >= sweepAt)
+            sweepLocked(now);
+        it = entries.insert(std::make_pair(account, Entry())).first;
+    }
+    Entry& ent = it->second;
+
+    while(true) {
+        if(ent.valid) {
+            double age = epicsTimeDiffInSeconds(&now, &ent.updated);
+
+            if(age < _ttl) {
+                _hits++;
+                roles.insert(ent.roles.begin(), ent.roles.end());
+                return;
+
+            } else if(age < 2.0*_ttl) {
+                _stale++;
+                roles.insert(ent.roles.begin(), ent.roles.end());
+                if(!ent.busy) {
+                    ent.busy = true;
+                    bool wake = refreshQueue.empty();
+                    refreshQueue.push_back(account);
+                    if(!worker) {
+                        worker.reset(new pvd::Thread(pvd::Thread::Config(this, &RoleCache::run)
+                                                     .name("PVARoleCache")
+                                                     .prio(epicsThreadPriorityLow)
+                                                     .autostart(true)));
+                    } else if(wake) {
+                        wakeup.signal();
+                    }
+                }
+                return;
+            }
+        }
+
+        if(!ent.busy)
+            break;
+
+        // wait for a lookup in progress
+        if(!ent.done)
+            ent.done.reset(new epicsEvent);
+        std::tr1::shared_ptr<epicsEvent> done(ent.done);
+        ent.waiters++;
+        {
+            UnGuard U(G);
+            done->wait();
+        }
+        ent.waiters--;
+        if(ent.waiters && !ent.busy)
+            done->signal(); // pass on to the next waiter
+        epicsTimeGetCurrent(&now);
+    }
+
+    _misses++;
+    ent.busy = true;
+
+    PeerInfo::roles_t temp;
+    try {
+        UnGuard U(G);
+        (*lookup)(account, temp);
+    } catch(...) {
+        ent.busy = false;
+        if(ent.waiters)
+            ent.done->signal();
+        throw;
+    }
+
+    ent.roles.swap(temp);
+    epicsTimeGetCurrent(&ent.updated);
+    ent.valid = true;
+    ent.busy = false;
+    if(ent.waiters)
+        ent.done->signal();
+
+    roles.insert(ent.roles.begin(), ent.roles.end());
+}
+
+void RoleCache::run()
+{
+    Guard G(mutex);
+
+    while(!stopping) {
+        if(refreshQueue.empty()) {
+            UnGuard U(G);
+            wakeup.wait();
+            continue;
+        }
+
+        std::string account;
+        account.swap(refreshQueue.front());
+        refreshQueue.pop_front();
+
+        // busy entries are not erased
+        entries_t::iterator it(entries.find(account));
+        if(it==entries.end())
+            continue;
+        Entry& ent = it->second;
+
+        _refreshes++;
+        bool ok = true;
+        PeerInfo::roles_t temp;
+        try {
+            UnGuard U(G);
+            (*lookup)(account, temp);
+        } catch(std::exception& e) {
+            LOG(logLevelError, "Error refreshing roles of \"%s\" : %s", account.c_str(), e.what());
+            ok = false;
+        }
+
+        if(ok) {
+            ent.roles.swap(temp);
+            epicsTimeGetCurrent(&ent.updated);
+            ent.valid = true;
+        }
+        ent.busy = false;
+        if(ent.waiters)
+            ent.done->signal();
+    }
+}
+
+}}} // namespace epics::pvAccess::detail
@@ -13,6 +13,7 @@
 
 #define epicsExportSharedSymbols
 #include <pv/securityImpl.h>
+#include <pv/roleCache.h>
 
 typedef epicsGuard<epicsMutex> Guard;
 
@@ -119,7 +120,7 @@ struct GroupsPlugin : public pva::AuthorizationPlugin
         if(!peer->identified)
             return; // no groups for anonymous
 
-        pva::osdGetRoles(peer->account, peer->roles);
+        pva::detail::RoleCache::instance().getRoles(peer->account, peer->roles);
     }
 };
 
@@ -0,0 +1,365 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <stdexcept>
+#include <sstream>
+#include <algorithm>
+
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <limits.h>
+
+
+#define epicsExportSharedSymbols
+#include <pv/shmRing.h>
+
+#ifdef PVA_HAVE_SHM
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <sys/syscall.h>
+#  include <linux/futex.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+namespace epics {
+namespace pvAccess {
+namespace detail {
+
+// segment layout:
+//   Header
+//   Control of client -> server ring
+//   Control of server -> client ring
+//   padding to dataOffset
+//   client -> server data
+//   server -> client data
+
+struct ShmRing::Control {
+    epicsUInt64 head; // bytes ever written, only changed by producer
+    char pad0[64-sizeof(epicsUInt64)];
+    epicsUInt64 tail; // bytes ever read, only changed by consumer
+    char pad1[64-sizeof(epicsUInt64)];
+    // futex words
+    epicsUInt32 dataSeq;  // incremented after head moves
+    epicsUInt32 spaceSeq; // incremented after tail moves
+    epicsUInt32 readerWaiting;
+    epicsUInt32 writerWaiting;
+    epicsUInt32 closed;
+};
+
+namespace {
+
+struct Header {
+    epicsUInt32 magic;
+    epicsUInt32 version;
+    epicsUInt32 ringSize;
+    epicsUInt32 reserved;
+};
+
+const epicsUInt32 shmMagic = 0x50564153; // "PVAS"
+const epicsUInt32 shmVersion = 1;
+
+const size_t controlOffset = 64;
+const size_t dataOffset = 4096;
+
+const size_t minRingSize = 64u*1024u;
+const size_t maxRingSize = 1024u*1024u*1024u;
+
+#ifdef PVA_HAVE_SHM
+
+std::string segmentName(unsigned short port, epicsUInt32 token)
+{
+    char buf[40];
+    sprintf(buf, "/epics-pva-%u-%08x", unsigned(port), unsigned(token));
+    return buf;
+}
+
+std::string errnoMsg(const char *what, const std::string& name)
+{
+    int err = errno;
+    std::ostringstream strm;
+    strm<<what<<" '"<<name<<"' : "<<strerror(err);
+    return strm.str();
+}
+
+// not to be guessed by another process
+epicsUInt32 newToken()
+{
+    epicsUInt32 ret = 0u;
+    int fd = ::open("/dev/urandom", O_RDONLY|O_CLOEXEC);
+    if(fd==-1)
+        throw std::runtime_error(errnoMsg("Unable to open", "/dev/urandom"));
+    ssize_t n;
+    do {
+        n = ::read(fd, &ret, sizeof(ret));
+    } while(n==-1 && errno==EINTR);
+    ::close(fd);
+    if(n!=ssize_t(sizeof(ret)))
+        throw std::runtime_error("Unable to read /dev/urandom");
+    return ret;
+}
+
+void futexWait(epicsUInt32 *addr, epicsUInt32 val, double timeout)
+{
+    timespec ts;
+    ts.tv_sec = time_t(timeout);
+    ts.tv_nsec = long((timeout-ts.tv_sec)*1e9);
+    // not FUTEX_PRIVATE_FLAG as shared with another process
+    (void)syscall(SYS_futex, addr, FUTEX_WAIT, val, &ts, NULL, 0);
+}
+
+void futexWake(epicsUInt32 *addr)
+{
+    (void)syscall(SYS_futex, addr, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+#endif // PVA_HAVE_SHM
+
+} // namespace
+
+ShmRing::ShmRing()
+    :_token(0u)
+    ,_creator(false)
+    ,_linked(false)
+    ,_ringSize(0u)
+    ,_mapSize(0u)
+    ,_base(0)
+    ,_tx(0), _rx(0)
+    ,_txData(0), _rxData(0)
+{}
+
+#ifdef PVA_HAVE_SHM
+
+bool ShmRing::supported() { return true; }
+
+ShmRing::shared_pointer ShmRing::create(size_t ringSize, unsigned short port)
+{
+    size_t size = minRingSize;
+    while(size < ringSize && size < maxRingSize)
+        size <<= 1u;
+
+    shared_pointer ret(new ShmRing);
+    ret->_creator = true;
+    ret->_ringSize = size;
+    ret->_mapSize = dataOffset + 2u*size;
+
+    int fd = -1;
+    for(unsigned attempt=0; fd==-1 && attempt<4; attempt++) {
+        ret->_token = newToken();
+        ret->_name = segmentName(port, ret->_token);
+        // only processes of this user may open
+        fd = shm_open(ret->_name.c_str(), O_RDWR|O_CREAT|O_EXCL, 0600);
+        if(fd==-1 && errno!=EEXIST)
+            break;
+    }
+    if(fd==-1)
+        throw std::runtime_error(errnoMsg("Unable to create shared memory", ret->_name));
+    ret->_linked = true;
+
+    if(ftruncate(fd, ret->_mapSize)!=0) {
+        std::string msg(errnoMsg("Unable to size shared memory", ret->_name));
+        ::close(fd);
+        throw std::runtime_error(msg);
+    }
+
+    void *base = mmap(NULL, ret->_mapSize, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(base==MAP_FAILED)
+        throw std::runtime_error(errnoMsg("Unable to map shared memory", ret->_name));
+    ret->_base = base;
+
+    // new segment is zero filled
+    char *cbase = static_cast<char*>(base);
+    ret->_tx = reinterpret_cast<Control*>(cbase + controlOffset);
+    ret->_rx = ret->_tx + 1;
+    ret->_txData = cbase + dataOffset;
+    ret->_rxData = cbase + dataOffset + size;
+
+    Header *head = static_cast<Header*>(base);
+    head->version = shmVersion;
+    head->ringSize = size;
+    __atomic_store_n(&head->magic, shmMagic, __ATOMIC_RELEASE);
+
+    return ret;
+}
+
+ShmRing::shared_pointer ShmRing::open(unsigned short port, epicsUInt32 token)
+{
+    shared_pointer ret(new ShmRing);
+    ret->_token = token;
+    ret->_name = segmentName(port, token);
+
+    // not ours to unlink unless valid
+    int fd = shm_open(ret->_name.c_str(), O_RDWR, 0);
+    if(fd==-1)
+        throw std::runtime_error(errnoMsg("Unable to open shared memory", ret->_name));
+
+    struct stat info;
+    if(fstat(fd, &info)!=0) {
+        std::string msg(errnoMsg("Unable to stat shared memory", ret->_name));
+        ::close(fd);
+        throw std::runtime_error(msg);
+    }
+    if(info.st_uid!=geteuid() || size_t(info.st_size) < dataOffset + 2u*minRingSize) {
+        ::close(fd);
+        throw std::runtime_error("Shared memory '"+ret->_name+"' not valid");
+    }
+
+    ret->_mapSize = info.st_size;
+    void *base = mmap(NULL, ret->_mapSize, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(base==MAP_FAILED)
+        throw std::runtime_error(errnoMsg("Unable to map shared memory", ret->_name));
+    ret->_base = base;
+
+    Header *head = static_cast<Header*>(base);
+    size_t size = head->ringSize;
+    if(__atomic_load_n(&head->magic, __ATOMIC_ACQUIRE)!=shmMagic
+            || head->version!=shmVersion
+            || size < minRingSize || size > maxRingSize || (size&(size-1u))!=0u
+            || dataOffset + 2u*size != ret->_mapSize)
+        throw std::runtime_error("Shared memory '"+ret->_name+"' not valid");
+
+    // the opposite of the creator
+    char *cbase = static_cast<char*>(base);
+    ret->_rx = reinterpret_cast<Control*>(cbase + controlOffset);
+    ret->_tx = ret->_rx + 1;
+    ret->_rxData = cbase + dataOffset;
+    ret->_txData = cbase + dataOffset + size;
+    ret->_ringSize = size;
+
+    // mapped by both, so the name is no longer needed.
+    // removed now in case the creator exits before it would.
+    (void)shm_unlink(ret->_name.c_str());
+
+    return ret;
+}
+
+ShmRing::~ShmRing()
+{
+    unlink();
+    if(_base)
+        munmap(_base, _mapSize);
+}
+
+void ShmRing::unlink()
+{
+    if(_linked) {
+        _linked = false;
+        (void)shm_unlink(_name.c_str());
+    }
+}
+
+int ShmRing::send(const char* src, size_t count, double timeout)
+{
+    const epicsUInt64 head = _tx->head; // only we change
+
+    epicsUInt64 used = head - __atomic_load_n(&_tx->tail, __ATOMIC_ACQUIRE);
+
+    if(used==_ringSize && timeout>0.0 && !__atomic_load_n(&_tx->closed, __ATOMIC_ACQUIRE)) {
+        // full, wait for reader
+        epicsUInt32 seq = __atomic_load_n(&_tx->spaceSeq, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&_tx->writerWaiting, 1u, __ATOMIC_SEQ_CST);
+        used = head - __atomic_load_n(&_tx->tail, __ATOMIC_SEQ_CST);
+        if(used==_ringSize)
+            futexWait(&_tx->spaceSeq, seq, timeout);
+        __atomic_store_n(&_tx->writerWaiting, 0u, __ATOMIC_RELAXED);
+        used = head - __atomic_load_n(&_tx->tail, __ATOMIC_ACQUIRE);
+    }
+
+    if(__atomic_load_n(&_tx->closed, __ATOMIC_ACQUIRE) || used>_ringSize)
+        return -1;
+    else if(used==_ringSize)
+        return 0;
+
+    // keep within range of our int return value
+    size_t n = std::min<size_t>(std::min<size_t>(count, _ringSize - used), 1u<<30);
+    size_t offset = head & (_ringSize-1u);
+    size_t first = std::min(n, _ringSize - offset);
+    memcpy(_txData + offset, src, first);
+    memcpy(_txData, src + first, n - first);
+
+    __atomic_store_n(&_tx->head, head + n, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&_tx->dataSeq, 1u, __ATOMIC_SEQ_CST);
+    if(__atomic_load_n(&_tx->readerWaiting, __ATOMIC_SEQ_CST))
+        futexWake(&_tx->dataSeq);
+
+    return int(n);
+}
+
+int ShmRing::recv(char* dst, size_t count, double timeout)
+{
+    const epicsUInt64 tail = _rx->tail; // only we change
+
+    epicsUInt64 used = __atomic_load_n(&_rx->head, __ATOMIC_ACQUIRE) - tail;
+
+    if(used==0u && timeout>0.0 && !__atomic_load_n(&_rx->closed, __ATOMIC_ACQUIRE)) {
+        // empty, wait for writer
+        epicsUInt32 seq = __atomic_load_n(&_rx->dataSeq, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&_rx->readerWaiting, 1u, __ATOMIC_SEQ_CST);
+        used = __atomic_load_n(&_rx->head, __ATOMIC_SEQ_CST) - tail;
+        if(used==0u)
+            futexWait(&_rx->dataSeq, seq, timeout);
+        __atomic_store_n(&_rx->readerWaiting, 0u, __ATOMIC_RELAXED);
+        used = __atomic_load_n(&_rx->head, __ATOMIC_ACQUIRE) - tail;
+    }
+
+    // data written before close() is still delivered
+    if(used>_ringSize)
+        return -1; // corrupt
+    else if(used==0u)
+        return __atomic_load_n(&_rx->closed, __ATOMIC_ACQUIRE) ? -1 : 0;
+
+    size_t n = std::min<size_t>(std::min<size_t>(count, used), 1u<<30);
+    size_t offset = tail & (_ringSize-1u);
+    size_t first = std::min(n, _ringSize - offset);
+    memcpy(dst, _rxData + offset, first);
+    memcpy(dst + first, _rxData, n - first);
+
+    __atomic_store_n(&_rx->tail, tail + n, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&_rx->spaceSeq, 1u, __ATOMIC_SEQ_CST);
+    if(__atomic_load_n(&_rx->writerWaiting, __ATOMIC_SEQ_CST))
+        futexWake(&_rx->spaceSeq);
+
+    return int(n);
+}
+
+void ShmRing::close()
+{
+    Control* ctrl[2] = {_tx, _rx};
+    for(unsigned i=0; i<2u; i++) {
+        __atomic_store_n(&ctrl[i]->closed, 1u, __ATOMIC_SEQ_CST);
+        __atomic_fetch_add(&ctrl[i]->dataSeq, 1u, __ATOMIC_SEQ_CST);
+        __atomic_fetch_add(&ctrl[i]->spaceSeq, 1u, __ATOMIC_SEQ_CST);
+        futexWake(&ctrl[i]->dataSeq);
+        futexWake(&ctrl[i]->spaceSeq);
+    }
+}
+
+#else // PVA_HAVE_SHM
+
+bool ShmRing::supported() { return false; }
+
+ShmRing::shared_pointer ShmRing::create(size_t, unsigned short)
+{
+    throw std::runtime_error("Shared memory transport not supported on this target");
+}
+
+ShmRing::shared_pointer ShmRing::open(unsigned short, epicsUInt32)
+{
+    throw std::runtime_error("Shared memory transport not supported on this target");
+}
+
+ShmRing::~ShmRing() {}
+void ShmRing::unlink() {}
+int ShmRing::send(const char*, size_t, double) { return -1; }
+int ShmRing::recv(char*, size_t, double) { return -1; }
+void ShmRing::close() {}
+
+#endif // PVA_HAVE_SHM
+
+}}} // namespace epics::pvAccess::detail
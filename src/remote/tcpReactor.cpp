@@ -0,0 +1,399 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <stdexcept>
+
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <osiSock.h>
+#include <epicsAssert.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <errlog.h>
+
+#define epicsExportSharedSymbols
+#include <pv/logger.h>
+#include <pv/codec.h>
+#include <pv/tcpReactor.h>
+
+#ifdef PVA_HAVE_EPOLL
+#  include <sys/epoll.h>
+#  include <sys/eventfd.h>
+#  include <unistd.h>
+#endif
+
+typedef epicsGuard<epicsMutex> Guard;
+
+namespace epics {
+namespace pvAccess {
+namespace detail {
+
+namespace {
+TCPReactor* reactor;
+size_t reactorThreads;
+epicsThreadOnceId reactorOnce = EPICS_THREAD_ONCE_INIT;
+
+// how often idle connections are checked for receive timeout
+const double timeoutCheckPeriod = 1.0;
+} // namespace
+
+void TCPReactor::onceInit(void *arg)
+{
+    try {
+        reactor = new TCPReactor(*static_cast<size_t*>(arg));
+    } catch(std::exception& e) {
+        errlogPrintf("Unable to start TCP reactor, using threads : %s\n", e.what());
+    }
+}
+
+TCPReactor* TCPReactor::select(const Context::shared_pointer& context)
+{
+#ifdef PVA_HAVE_EPOLL
+    epics::pvData::int32 nthreads = context->getConfiguration()->getPropertyAsInteger("EPICS_PVA_TCP_REACTOR_THREADS", 0);
+    if(nthreads <= 0)
+        return 0;
+
+    // the first user decides the pool size
+    reactorThreads = size_t(nthreads);
+    epicsThreadOnce(&reactorOnce, &TCPReactor::onceInit, &reactorThreads);
+    return reactor;
+#else
+    (void)context;
+    return 0;
+#endif
+}
+
+#ifdef PVA_HAVE_EPOLL
+
+TCPReactor::TCPReactor(size_t nthreads)
+    :nextId(1u) // 0 is the wakeup eventfd
+    ,epfd(-1)
+    ,evfd(-1)
+{
+    epicsTimeGetCurrent(&lastTimeoutCheck);
+
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if(epfd < 0)
+        throw std::runtime_error("epoll_create1() fails");
+
+    // semaphore mode, each read() consumes one wakeup
+    evfd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK | EFD_SEMAPHORE);
+    if(evfd < 0) {
+        ::close(epfd);
+        throw std::runtime_error("eventfd() fails");
+    }
+
+    epoll_event evt;
+    memset(&evt, 0, sizeof(evt));
+    evt.events = EPOLLIN;
+    evt.data.u64 = 0u;
+    if(epoll_ctl(epfd, EPOLL_CTL_ADD, evfd, &evt)) {
+        ::close(evfd);
+        ::close(epfd);
+        throw std::runtime_error("epoll_ctl() fails for eventfd");
+    }
+
+    workers.reserve(nthreads);
+    for(size_t i=0; i<nthreads; i++) {
+        epics::pvData::Thread* worker = new epics::pvData::Thread(
+                                            epics::pvData::Thread::Config(this, &TCPReactor::run)
+                                            .prio(epicsThreadPriorityCAServerLow)
+                                            .name("TCP-reactor")
+                                            .stack(epicsThreadStackBig)
+                                            .autostart(true));
+        workers.push_back(worker);
+    }
+
+    LOG(logLevelDebug, "TCP reactor started with %zu thread(s)", nthreads);
+}
+
+TCPReactor::~TCPReactor() {}
+
+epicsUInt64 TCPReactor::add(const std::tr1::shared_ptr<BlockingTCPTransportCodec>& codec, SOCKET sock)
+{
+    Guard G(mutex);
+
+    epicsUInt64 id = nextId++;
+
+    epoll_event evt;
+    memset(&evt, 0, sizeof(evt));
+    evt.events = EPOLLIN | EPOLLONESHOT;
+    evt.data.u64 = id;
+    if(epoll_ctl(epfd, EPOLL_CTL_ADD, sock, &evt))
+        throw std::runtime_error("epoll_ctl() fails to add socket");
+
+    Entry& ent = entries[id];
+    ent.codec = codec;
+    ent.sock = sock;
+    ent.registered = true;
+
+    return id;
+}
+
+void TCPReactor::remove(epicsUInt64 id)
+{
+    std::tr1::shared_ptr<BlockingTCPTransportCodec> codec; // release outside of our lock
+    Guard G(mutex);
+
+    entries_t::iterator it(entries.find(id));
+    if(it==entries.end() || !it->second.registered)
+        return;
+
+    epoll_ctl(epfd, EPOLL_CTL_DEL, it->second.sock, 0);
+    it->second.registered = false;
+    it->second.wantWrite = false;
+
+    if(it->second.busy==0u)
+        eraseLocked(it, codec);
+}
+
+bool TCPReactor::scheduleSend(epicsUInt64 id)
+{
+    {
+        Guard G(mutex);
+
+        entries_t::iterator it(entries.find(id));
+        if(it==entries.end())
+            return false;
+
+        it->second.busy++;
+        sendQueue.push_back(id);
+    }
+    wakeup();
+    return true;
+}
+
+void TCPReactor::waitIdle(epicsUInt64 id)
+{
+    // called during a callback from this transport would never complete
+    for(size_t i=0, N=workers.size(); i<N; i++) {
+        if(workers[i]->isCurrentThread())
+            return;
+    }
+
+    std::tr1::shared_ptr<epicsEvent> idle;
+    {
+        Guard G(mutex);
+        entries_t::iterator it(entries.find(id));
+        if(it==entries.end())
+            return;
+        if(!it->second.idle)
+            it->second.idle.reset(new epicsEvent);
+        idle = it->second.idle;
+    }
+    idle->wait();
+}
+
+void TCPReactor::eraseLocked(entries_t::iterator it, std::tr1::shared_ptr<BlockingTCPTransportCodec>& done)
+{
+    done.swap(it->second.codec);
+    if(it->second.idle)
+        it->second.idle->signal();
+    entries.erase(it);
+}
+
+void TCPReactor::rearmLocked(epicsUInt64 id, Entry& ent)
+{
+    epoll_event evt;
+    memset(&evt, 0, sizeof(evt));
+    // while reading, only wait for writable
+    evt.events = EPOLLONESHOT | (ent.reading ? 0u : EPOLLIN) | (ent.wantWrite ? EPOLLOUT : 0u);
+    evt.data.u64 = id;
+    if(evt.events != EPOLLONESHOT)
+        epoll_ctl(epfd, EPOLL_CTL_MOD, ent.sock, &evt);
+}
+
+void TCPReactor::wakeup()
+{
+    uint64_t one = 1u;
+    ssize_t ret;
+    do {
+        ret = ::write(evfd, &one, sizeof(one));
+    } while(ret < 0 && errno == EINTR);
+}
+
+void TCPReactor::run()
+{
+    while(true) {
+        epoll_event evt;
+        int ret = epoll_wait(epfd, &evt, 1, int(timeoutCheckPeriod*1000));
+
+        // also when busy, as idle timeouts are not socket events
+        checkTimeouts();
+
+        if(ret < 0) {
+            if(errno == EINTR)
+                continue;
+            errlogPrintf("TCP reactor: epoll_wait() error %d\n", errno);
+            epicsThreadSleep(1.0);
+
+        } else if(ret == 0) {
+            // timeout
+
+        } else if(evt.data.u64 == 0u) {
+            uint64_t cnt;
+            // some other worker may have taken this wakeup
+            if(::read(evfd, &cnt, sizeof(cnt)) == ssize_t(sizeof(cnt)))
+                runSend();
+
+        } else {
+            runEvent(evt.data.u64, evt.events);
+        }
+    }
+}
+
+void TCPReactor::runEvent(epicsUInt64 id, epicsUInt32 events)
+{
+    std::tr1::shared_ptr<BlockingTCPTransportCodec> codec;
+    bool send = false;
+    {
+        Guard G(mutex);
+
+        entries_t::iterator it(entries.find(id));
+        if(it==entries.end() || !it->second.registered)
+            return; // removed since event was queued
+        Entry& ent = it->second;
+
+        // errors are reported to both directions
+        if(ent.wantWrite && (events & (EPOLLOUT|EPOLLERR|EPOLLHUP))) {
+            ent.wantWrite = false;
+            ent.busy++;
+            sendQueue.push_back(id);
+            send = true;
+        }
+
+        if(!ent.reading && (events & (EPOLLIN|EPOLLERR|EPOLLHUP))) {
+            ent.reading = true;
+            ent.busy++;
+            codec = ent.codec;
+        } else {
+            rearmLocked(id, ent);
+        }
+    }
+
+    if(send)
+        wakeup();
+
+    if(!codec)
+        return;
+
+    // returns once the socket would block, or a large message is left to the stream thread
+    if(!codec->reactorRead())
+        resumeRead(id);
+}
+
+void TCPReactor::resumeRead(epicsUInt64 id)
+{
+    std::tr1::shared_ptr<BlockingTCPTransportCodec> done; // release outside of our lock
+    Guard G(mutex);
+
+    entries_t::iterator it(entries.find(id));
+    assert(it!=entries.end()); // busy>0 prevents removal
+    it->second.busy--;
+    it->second.reading = false;
+
+    if(it->second.registered) {
+        rearmLocked(id, it->second);
+
+    } else if(it->second.busy==0u) {
+        eraseLocked(it, done);
+    }
+}
+
+void TCPReactor::runSend()
+{
+    epicsUInt64 id;
+    std::tr1::shared_ptr<BlockingTCPTransportCodec> codec;
+    {
+        Guard G(mutex);
+
+        if(sendQueue.empty())
+            return;
+        id = sendQueue.front();
+        sendQueue.pop_front();
+
+        entries_t::iterator it(entries.find(id));
+        assert(it!=entries.end()); // busy>0 prevents removal
+        codec = it->second.codec;
+    }
+
+    BlockingTCPTransportCodec::ReactorSend result = codec->reactorSend();
+
+    std::tr1::shared_ptr<BlockingTCPTransportCodec> done; // release outside of our lock
+    {
+        Guard G(mutex);
+
+        entries_t::iterator it(entries.find(id));
+        assert(it!=entries.end());
+
+        if(result==BlockingTCPTransportCodec::SendMore) {
+            // yield to other transports, and continue later
+            sendQueue.push_back(id);
+
+        } else {
+            it->second.busy--;
+
+            if(it->second.registered) {
+                if(result==BlockingTCPTransportCodec::SendBlocked) {
+                    // continue when writable
+                    it->second.wantWrite = true;
+                    rearmLocked(id, it->second);
+                }
+
+            } else if(it->second.busy==0u) {
+                eraseLocked(it, done);
+            }
+        }
+    }
+    codec.reset();
+
+    if(result==BlockingTCPTransportCodec::SendMore)
+        wakeup();
+}
+
+void TCPReactor::checkTimeouts()
+{
+    epicsTimeStamp now;
+    epicsTimeGetCurrent(&now);
+
+    std::vector<std::tr1::shared_ptr<BlockingTCPTransportCodec> > codecs;
+    {
+        Guard G(mutex);
+
+        // only one worker need check each period
+        if(epicsTimeDiffInSeconds(&now, &lastTimeoutCheck) < timeoutCheckPeriod)
+            return;
+        lastTimeoutCheck = now;
+
+        codecs.reserve(entries.size());
+        for(entries_t::const_iterator it(entries.begin()), end(entries.end()); it!=end; ++it) {
+            if(it->second.registered)
+                codecs.push_back(it->second.codec);
+        }
+    }
+
+    for(size_t i=0, N=codecs.size(); i<N; i++)
+        codecs[i]->reactorCheckTimeout(now);
+}
+
+#else // PVA_HAVE_EPOLL
+
+TCPReactor::TCPReactor(size_t nthreads) :nextId(1u), epfd(-1), evfd(-1)
+{
+    throw std::logic_error("TCPReactor not supported");
+}
+TCPReactor::~TCPReactor() {}
+epicsUInt64 TCPReactor::add(const std::tr1::shared_ptr<BlockingTCPTransportCodec>&, SOCKET) { return 0u; }
+void TCPReactor::remove(epicsUInt64) {}
+bool TCPReactor::scheduleSend(epicsUInt64) { return false; }
+void TCPReactor::waitIdle(epicsUInt64) {}
+void TCPReactor::resumeRead(epicsUInt64) {}
+
+#endif // PVA_HAVE_EPOLL
+
+}}} // namespace epics::pvAccess::detail
@@ -0,0 +1,140 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <epicsTime.h>
+#include <epicsVersion.h>
+
+#define epicsExportSharedSymbols
+#include <pv/transportStats.h>
+#include <pv/remote.h>
+
+#ifdef EPICS_VERSION_INT
+#if EPICS_VERSION_INT>=VERSION_INT(3,16,1,0)
+#  define PVA_HAVE_MONOTONIC
+#endif
+#endif
+
+namespace epics {
+namespace pvAccess {
+namespace detail {
+
+epicsUInt64 statsClock()
+{
+#ifdef PVA_HAVE_MONOTONIC
+    return epicsMonotonicGet();
+#else
+    epicsTimeStamp now;
+    epicsTimeGetCurrent(&now);
+    return epicsUInt64(now.secPastEpoch)*1000000000u + now.nsec;
+#endif
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+    for(size_t i=0; i<nBuckets; i++)
+        _counts[i] = 0u;
+}
+
+size_t LatencyHistogram::bucketOf(epicsUInt64 ns)
+{
+    if(ns < (1u<<subBits))
+        return size_t(ns);
+    if(ns >> 32u)
+        return nBuckets-1u;
+
+    // position of most significant bit
+    epicsUInt32 v = epicsUInt32(ns);
+    unsigned msb = 0u;
+    for(unsigned step=16u; step; step>>=1u) {
+        if(v >> (msb+step))
+            msb += step;
+    }
+
+    return ((msb-subBits+1u)<<subBits) | ((v>>(msb-subBits)) & ((1u<<subBits)-1u));
+}
+
+epicsUInt64 LatencyHistogram::bucketStart(size_t i)
+{
+    if(i < (1u<<subBits))
+        return i;
+    if(i >= nBuckets-1u)
+        return epicsUInt64(1u)<<32u;
+
+    unsigned msb = unsigned(i>>subBits) + subBits - 1u;
+    epicsUInt64 sub = i & ((1u<<subBits)-1u);
+    return ((epicsUInt64(1u)<<subBits) | sub) << (msb-subBits);
+}
+
+void LatencyHistogram::snapshot(std::vector<size_t>& counts) const
+{
+    counts.resize(nBuckets);
+    for(size_t i=0; i<nBuckets; i++)
+        counts[i] = epics::atomic::get(_counts[i]);
+}
+
+size_t LatencyHistogram::total(const std::vector<size_t>& counts)
+{
+    size_t ret = 0u;
+    for(size_t i=0; i<counts.size(); i++)
+        ret += counts[i];
+    return ret;
+}
+
+epicsUInt64 LatencyHistogram::percentile(const std::vector<size_t>& counts, double p)
+{
+    size_t N = total(counts);
+    if(N==0u)
+        return 0u;
+
+    // rank of the entry, from 1
+    size_t rank = size_t(p*N + 0.5);
+    if(rank < 1u)
+        rank = 1u;
+    else if(rank > N)
+        rank = N;
+
+    size_t seen = 0u;
+    for(size_t i=0; i<counts.size(); i++) {
+        seen += counts[i];
+        if(seen >= rank)
+            return i+1u < nBuckets ? bucketStart(i+1u)-1u : bucketStart(i);
+    }
+    return bucketStart(nBuckets-1u); // not reached
+}
+
+const char* commandName(int cmd)
+{
+    switch(cmd) {
+#define CASE(NAME) case CMD_ ## NAME: return #NAME
+    CASE(BEACON);
+    CASE(CONNECTION_VALIDATION);
+    CASE(ECHO);
+    CASE(SEARCH);
+    CASE(SEARCH_RESPONSE);
+    CASE(AUTHNZ);
+    CASE(ACL_CHANGE);
+    CASE(CREATE_CHANNEL);
+    CASE(DESTROY_CHANNEL);
+    CASE(CONNECTION_VALIDATED);
+    CASE(GET);
+    CASE(PUT);
+    CASE(PUT_GET);
+    CASE(MONITOR);
+    CASE(ARRAY);
+    CASE(DESTROY_REQUEST);
+    CASE(PROCESS);
+    CASE(GET_FIELD);
+    CASE(MESSAGE);
+    CASE(MULTIPLE_DATA);
+    CASE(RPC);
+    CASE(CANCEL_REQUEST);
+    CASE(ORIGIN_TAG);
+#undef CASE
+    default: return 0;
+    }
+}
+
+}}} // namespace epics::pvAccess::detail
@@ -34,6 +34,8 @@
 #include <pv/channelSearchManager.h>
 #include <pv/clientContextImpl.h>
 #include <pv/configuration.h>
+#include <pv/elementPool.h>
+#include <pv/slotTable.h>
 #include <pv/beaconHandler.h>
 #include <pv/logger.h>
 #include <pv/securityImpl.h>
@@ -51,6 +53,8 @@ using namespace epics::pvData;
 namespace epics {
 namespace pvAccess {
 
+MB_DECLARE_EXTERN(pvaReceive);
+
 Status ClientChannelImpl::channelDestroyed(
     Status::STATUSTYPE_WARNING, "channel destroyed");
 Status ClientChannelImpl::channelDisconnected(
@@ -1815,6 +1819,7 @@ public:
 
 typedef vector<MonitorElement::shared_pointer> FreeElementQueue;
 typedef queue<MonitorElement::shared_pointer> MonitorElementQueue;
+typedef epics::pvAccess::detail::ElementPool ElementPool;
 
 
 class MonitorStrategyQueue :
@@ -1879,7 +1884,10 @@ public:
         //m_monitorQueue.reserve(m_queueSize);
     }
 
-    virtual ~MonitorStrategyQueue() {}
+    virtual ~MonitorStrategyQueue()
+    {
+        recycle();
+    }
 
     virtual void init(StructureConstPtr const & structure) OVERRIDE FINAL {
         Lock guard(m_mutex);
@@ -1888,17 +1896,20 @@ public:
         m_reportQueueStateInProgress = false;
 
         {
-            while (!m_monitorQueue.empty())
-                m_monitorQueue.pop();
-
-            m_freeQueue.clear();
+            // elements are taken back below if the type is unchanged
+            recycle();
 
             m_up2datePVStructure.reset();
 
+            ElementPool& pool = ElementPool::instance();
             for (int32 i = 0; i < m_queueSize; i++)
             {
-                PVStructure::shared_pointer pvStructure = getPVDataCreate()->createPVStructure(structure);
-                MonitorElement::shared_pointer monitorElement(new MonitorElement(pvStructure));
+                MonitorElement::shared_pointer monitorElement(pool.get(structure));
+                if (!monitorElement)
+                {
+                    PVStructure::shared_pointer pvStructure = getPVDataCreate()->createPVStructure(structure);
+                    monitorElement.reset(new MonitorElement(pvStructure));
+                }
                 m_freeQueue.push_back(monitorElement);
             }
 
@@ -2065,6 +2076,7 @@ public:
         }
     }
 
+    virtual SendClass getSendClass() const OVERRIDE FINAL { return SEND_CONTROL; }
     virtual void send(ByteBuffer* buffer, TransportSendControl* control) OVERRIDE FINAL {
         control->startMessage((int8)CMD_MONITOR, 9);
         buffer->putInt(m_channel->getServerChannelID());
@@ -2105,6 +2117,21 @@ public:
     void destroy() OVERRIDE FINAL {
     }
 
+private:
+    // hand free and queued elements to the pool.  m_mutex held, or from dtor
+    void recycle()
+    {
+        ElementPool& pool = ElementPool::instance();
+
+        pool.put(m_freeQueue.begin(), m_freeQueue.end());
+        m_freeQueue.clear();
+
+        while (!m_monitorQueue.empty())
+        {
+            pool.put(m_monitorQueue.front());
+            m_monitorQueue.pop();
+        }
+    }
 };
 
 
@@ -3004,6 +3031,7 @@ public:
             }
             return;
         }
+        MB_POINT(pvaReceive, 2, "handler dispatch");
         // delegate
         m_handlerTable[command]->handleResponse(responseFrom, transport, version, command, payloadSize, payloadBuffer);
     }
@@ -3276,14 +3304,52 @@ private:
                 ChannelRequester::shared_pointer requester,
                 short priority,
                 const InetAddrVector& addresses)
+        {
+            ClientChannelImpl::shared_pointer external;
+            build(context, channelID, name, requester, priority, addresses, external)->activate();
+            return external;
+        }
+
+        /**
+         * Construct without activating.  For createChannelsInternal(),
+         * which registers, and then calls activate(searches).
+         * @return internal reference.
+         */
+        static std::tr1::shared_ptr<InternalChannelImpl> build(InternalClientContextImpl::shared_pointer context,
+                pvAccessID channelID,
+                string const & name,
+                ChannelRequester::shared_pointer requester,
+                short priority,
+                const InetAddrVector& addresses,
+                ClientChannelImpl::shared_pointer& external)
         {
             std::tr1::shared_ptr<InternalChannelImpl> internal(
                 new InternalChannelImpl(context, channelID, name, requester, priority, addresses)),
-                    external(internal.get(), epics::pvAccess::Destroyable::cleaner(internal));
+                    ext(internal.get(), epics::pvAccess::Destroyable::cleaner(internal));
             const_cast<weak_pointer&>(internal->m_internal_this) = internal;
-            const_cast<weak_pointer&>(internal->m_external_this) = external;
-            internal->activate();
-            return external;
+            const_cast<weak_pointer&>(internal->m_external_this) = ext;
+            external = ext;
+            return internal;
+        }
+
+        /**
+         * Activate an already registered channel.
+         * Appends to 'searches' instead of registering with the ChannelSearchManager.
+         */
+        void activate(std::vector<SearchInstance::shared_pointer>& searches)
+        {
+            if (m_addresses.empty())
+            {
+                Lock guard(m_channelMutex);
+                m_allowCreation = true;
+                searches.push_back(internal_from_this());
+            }
+            else
+            {
+                connect();
+            }
+
+            REFTRACE_INCREMENT(num_active);
         }
 
         virtual ~InternalChannelImpl()
@@ -3781,6 +3847,7 @@ public:
         }
 
 
+        virtual SendClass getSendClass() const OVERRIDE FINAL { return SEND_CONTROL; }
         virtual void send(ByteBuffer* buffer, TransportSendControl* control) OVERRIDE FINAL {
             m_channelMutex.lock();
             bool issueCreateMessage = m_issueCreateMessage;
@@ -3795,9 +3862,9 @@ public:
                 // array of CIDs and names
                 buffer->putInt(m_channelID);
                 SerializeHelper::serializeString(m_name, buffer, control);
-                // send immediately
-                // TODO
-                control->flush(true);
+                // not flushed, so that the creation of many channels
+                // queued together is sent together.
+                // the send queue is flushed when empty.
             }
             else
             {
@@ -3956,7 +4023,6 @@ public:
     InternalClientContextImpl(const Configuration::shared_pointer& conf) :
         m_addressList(""), m_autoAddressList(true), m_connectionTimeout(30.0f), m_beaconPeriod(15.0f),
         m_broadcastPort(PVA_BROADCAST_PORT), m_receiveBufferSize(MAX_TCP_RECV),
-        m_lastCID(0), m_lastIOID(0),
         m_version("pvAccess Client", "cpp",
                   EPICS_PVA_MAJOR_VERSION,
                   EPICS_PVA_MINOR_VERSION,
@@ -4003,6 +4069,8 @@ public:
         else if (m_contextState == CONTEXT_INITIALIZED)
             throw std::runtime_error("Context already initialized.");
 
+        MB_INIT;
+
         internalInitialize();
 
         m_contextState = CONTEXT_INITIALIZED;
@@ -4034,6 +4102,16 @@ public:
         default:
             out << "UNKNOWN" << std::endl;
         }
+
+        if (m_channelSearchManager)
+        {
+            ChannelSearchManager::Stats stats(m_channelSearchManager->getStats());
+            out << "SEARCH_PENDING     : " << stats.pending << std::endl;
+            out << "SEARCH_FOUND       : " << stats.found << std::endl;
+            out << "SEARCH_TIME        : mean " << stats.meanSearchTime << "s, max " << stats.maxSearchTime << 's' << std::endl;
+            out << "SEARCH_SENT        : " << stats.namesSent << " names in " << stats.framesSent << " messages" << std::endl;
+            out << "SEARCH_BURST       : " << stats.burstFrames << " messages" << std::endl;
+        }
     }
 
     virtual void destroy() OVERRIDE FINAL
@@ -4158,22 +4236,11 @@ private:
     }
 
     void destroyAllChannels() {
-        Lock guard(m_cidMapMutex);
-
-        int count = 0;
-        std::vector<ClientChannelImpl::weak_pointer> channels(m_channelsByCID.size());
-        for (CIDChannelMap::iterator iter = m_channelsByCID.begin();
-                iter != m_channelsByCID.end();
-                iter++)
-        {
-            channels[count++] = iter->second;
-        }
-
-        guard.unlock();
-
+        std::vector<ClientChannelImpl::weak_pointer> channels;
+        m_channelsByCID.values(channels);
 
         ClientChannelImpl::shared_pointer ptr;
-        for (int i = 0; i < count; i++)
+        for (size_t i = 0; i < channels.size(); i++)
         {
             ptr = channels[i].lock();
             if (ptr)
@@ -4211,8 +4278,7 @@ private:
      */
     void registerChannel(ClientChannelImpl::shared_pointer const & channel) OVERRIDE FINAL
     {
-        Lock guard(m_cidMapMutex);
-        m_channelsByCID[channel->getChannelID()] = ClientChannelImpl::weak_pointer(channel);
+        m_channelsByCID.assign(channel->getChannelID(), ClientChannelImpl::weak_pointer(channel));
     }
 
     /**
@@ -4221,7 +4287,6 @@ private:
      */
     void unregisterChannel(ClientChannelImpl::shared_pointer const & channel) OVERRIDE FINAL
     {
-        Lock guard(m_cidMapMutex);
         m_channelsByCID.erase(channel->getChannelID());
     }
 
@@ -4232,9 +4297,7 @@ private:
      */
     Channel::shared_pointer getChannel(pvAccessID channelID) OVERRIDE FINAL
     {
-        Lock guard(m_cidMapMutex);
-        CIDChannelMap::iterator it = m_channelsByCID.find(channelID);
-        return (it == m_channelsByCID.end() ? Channel::shared_pointer() : static_pointer_cast<Channel>(it->second.lock()));
+        return static_pointer_cast<Channel>(m_channelsByCID.find(channelID).lock());
     }
 
     /**
@@ -4243,13 +4306,8 @@ private:
      */
     pvAccessID generateCID()
     {
-        Lock guard(m_cidMapMutex);
-
-        // search first free (theoretically possible loop of death)
-        while (m_channelsByCID.find(++m_lastCID) != m_channelsByCID.end()) ;
         // reserve CID
-        m_channelsByCID[m_lastCID].reset();
-        return m_lastCID;
+        return m_channelsByCID.insert(ClientChannelImpl::weak_pointer());
     }
 
     /**
@@ -4257,7 +4315,6 @@ private:
      */
     void freeCID(int cid)
     {
-        Lock guard(m_cidMapMutex);
         m_channelsByCID.erase(cid);
     }
 
@@ -4269,10 +4326,7 @@ private:
      */
     ResponseRequest::shared_pointer getResponseRequest(pvAccessID ioid) OVERRIDE FINAL
     {
-        Lock guard(m_ioidMapMutex);
-        IOIDResponseRequestMap::iterator it = m_pendingResponseRequests.find(ioid);
-        if (it == m_pendingResponseRequests.end()) return ResponseRequest::shared_pointer();
-        return it->second.lock();
+        return m_pendingResponseRequests.find(ioid).lock();
     }
 
     /**
@@ -4282,10 +4336,7 @@ private:
      */
     pvAccessID registerResponseRequest(ResponseRequest::shared_pointer const & request) OVERRIDE FINAL
     {
-        Lock guard(m_ioidMapMutex);
-        pvAccessID ioid = generateIOID();
-        m_pendingResponseRequests[ioid] = ResponseRequest::weak_pointer(request);
-        return ioid;
+        return m_pendingResponseRequests.insert(ResponseRequest::weak_pointer(request));
     }
 
     /**
@@ -4297,32 +4348,7 @@ private:
     {
         if (ioid == INVALID_IOID) return ResponseRequest::shared_pointer();
 
-        Lock guard(m_ioidMapMutex);
-        IOIDResponseRequestMap::iterator it = m_pendingResponseRequests.find(ioid);
-        if (it == m_pendingResponseRequests.end())
-            return ResponseRequest::shared_pointer();
-
-        ResponseRequest::shared_pointer retVal = it->second.lock();
-        m_pendingResponseRequests.erase(it);
-        return retVal;
-    }
-
-    /**
-     * Generate IOID.
-     * @return IOID.
-     */
-    pvAccessID generateIOID()
-    {
-        Lock guard(m_ioidMapMutex);
-
-        // search first free (theoretically possible loop of death)
-        do {
-            while (m_pendingResponseRequests.find(++m_lastIOID) != m_pendingResponseRequests.end()) ;
-        } while (m_lastIOID == INVALID_IOID);
-
-        // reserve IOID
-        m_pendingResponseRequests[m_lastIOID].reset();
-        return m_lastIOID;
+        return m_pendingResponseRequests.erase(ioid).lock();
     }
 
     /**
@@ -4407,6 +4433,57 @@ private:
         }
     }
 
+    void createChannelsInternal(const std::vector<std::string>& names,
+                                const std::vector<ChannelRequester::shared_pointer>& requesters,
+                                short priority,
+                                const InetAddrVector& addresses,
+                                std::vector<ClientChannelImpl::shared_pointer>& channels) OVERRIDE FINAL
+    {
+        checkState();
+
+        if (names.size() != requesters.size())
+            throw std::logic_error("one requester per channel name required");
+
+        if (priority < ChannelProvider::PRIORITY_MIN || priority > ChannelProvider::PRIORITY_MAX)
+            throw std::range_error("priority out of bounds");
+
+        channels.clear();
+        channels.resize(names.size());
+
+        std::vector<std::tr1::shared_ptr<InternalChannelImpl> > created;
+        created.reserve(names.size());
+
+        InternalClientContextImpl::shared_pointer self(internal_from_this());
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            pvAccessID cid = INVALID_IOID;
+            try {
+                checkChannelName(names[i]);
+                if (!requesters[i])
+                    throw std::runtime_error("0 requester");
+
+                cid = generateCID();
+
+                std::tr1::shared_ptr<InternalChannelImpl> chan(InternalChannelImpl::build(self, cid, names[i], requesters[i],
+                                                                                           priority, addresses, channels[i]));
+                m_channelsByCID.assign(cid, ClientChannelImpl::weak_pointer(chan));
+                created.push_back(chan);
+            } catch(std::exception& e) {
+                LOG(logLevelError, "createChannelsInternal() exception for '%s': %s\n", names[i].c_str(), e.what());
+                if (cid != INVALID_IOID)
+                    freeCID(cid);
+                channels[i].reset();
+            }
+        }
+
+        std::vector<SearchInstance::shared_pointer> searches;
+        searches.reserve(created.size());
+        for (size_t i = 0; i < created.size(); i++)
+            created[i]->activate(searches);
+
+        m_channelSearchManager->registerSearchInstances(searches);
+    }
+
     /**
      * Get channel search manager.
      * @return channel search manager.
@@ -4481,36 +4558,16 @@ private:
     ClientResponseHandler::shared_pointer m_responseHandler;
 
     /**
-     * Map of channels (keys are CIDs).
-     */
-    // TODO consider std::unordered_map
-    typedef std::map<pvAccessID, ClientChannelImpl::weak_pointer> CIDChannelMap;
-    CIDChannelMap m_channelsByCID;
-
-    /**
-     *  CIDChannelMap mutex.
-     */
-    Mutex m_cidMapMutex;
-
-    /**
-     * Last CID cache.
-     */
-    pvAccessID m_lastCID;
-
-    /**
-     * Map of pending response requests (keys are IOID).
-     */
-    IOIDResponseRequestMap m_pendingResponseRequests;
-
-    /**
-     *  IOIDResponseRequestMap mutex.
+     * Table of channels (keys are CIDs).
+     * Locks internally.
      */
-    Mutex m_ioidMapMutex;
+    epics::pvAccess::detail::ShardedSlotTable<ClientChannelImpl::weak_pointer> m_channelsByCID;
 
     /**
-     * Last IOID cache.
+     * Table of pending response requests (keys are IOID).
+     * Locks internally.
      */
-    pvAccessID m_lastIOID;
+    epics::pvAccess::detail::ShardedSlotTable<ResponseRequest::weak_pointer> m_pendingResponseRequests;
 
     /**
      * Channel search manager.
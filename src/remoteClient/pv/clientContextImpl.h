@@ -99,6 +99,21 @@ public:
                                                               short priority,
                                                               const InetAddrVector& addresses) = 0;
 
+    /**
+     * Create many channels at once.
+     * As createChannelInternal() for each name, with one CID allocation, and one search registration.
+     * @param names channel names.
+     * @param requesters one for each name.
+     * @param priority channel priority.
+     * @param addresses server addresses, bypass search if not empty.
+     * @param channels set to one channel for each name.  NULL on error.
+     */
+    virtual void createChannelsInternal(const std::vector<std::string>& names,
+                                        const std::vector<ChannelRequester::shared_pointer>& requesters,
+                                        short priority,
+                                        const InetAddrVector& addresses,
+                                        std::vector<ClientChannelImpl::shared_pointer>& channels) = 0;
+
     virtual ResponseRequest::shared_pointer getResponseRequest(pvAccessID ioid) = 0;
     virtual pvAccessID registerResponseRequest(ResponseRequest::shared_pointer const & request) = 0;
     virtual ResponseRequest::shared_pointer unregisterResponseRequest(pvAccessID ioid) = 0;
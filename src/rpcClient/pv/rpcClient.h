@@ -25,6 +25,7 @@
 #include <shareLib.h>
 
 #define RPCCLIENT_DEFAULT_TIMEOUT 5.0
+#define RPCCLIENT_DEFAULT_MAX_IN_FLIGHT 16
 
 namespace epics
 {
@@ -41,6 +42,52 @@ class epicsShareClass RPCClient
 public:
     POINTER_DEFINITIONS(RPCClient);
 
+    /**
+     * Handle of a request issued with issueAsync().
+     */
+    class epicsShareClass AsyncRequest
+    {
+    public:
+        POINTER_DEFINITIONS(AsyncRequest);
+
+        virtual ~AsyncRequest() {}
+
+        /**
+         * @returns true once a response, or an error, has been received.
+         */
+        virtual bool isDone() const = 0;
+
+        /**
+         * Wait for the request to complete.
+         * May be called more than once, and from any thread.
+         * @param timeout      the time in seconds to wait for the response, 0 means forever.
+         * @return             request response.
+         * @throws RPCRequestException exception thrown on error or timeout.
+         */
+        virtual epics::pvData::PVStructure::shared_pointer wait(double timeout = RPCCLIENT_DEFAULT_TIMEOUT) = 0;
+    };
+
+    /**
+     * Notified once when a request issued with issueAsync() completes.
+     */
+    class epicsShareClass AsyncCallback
+    {
+    public:
+        POINTER_DEFINITIONS(AsyncCallback);
+
+        virtual ~AsyncCallback() {}
+
+        /**
+         * Called from a client worker thread, which must not be blocked.
+         * @param status    Success, or the reason the request failed.
+         * @param response  The response.  NULL unless status is success.
+         */
+        virtual void requestDone(
+            epics::pvData::Status const & status,
+            epics::pvData::PVStructure::shared_pointer const & response
+        ) = 0;
+    };
+
     /**
      * Create a RPCClient.
      *
@@ -123,6 +170,39 @@ public:
      */
     epics::pvData::PVStructure::shared_pointer waitResponse(double timeout = RPCCLIENT_DEFAULT_TIMEOUT);
 
+    /**
+     * Issue a request and return immediately, without waiting for connection
+     * or for earlier requests to complete.
+     *
+     * Up to maxInFlight() requests are in progress at once, each through its own
+     * ChannelRPC of this client's channel.  Further requests are queued, and sent in order
+     * as earlier ones complete.  Responses may arrive in any order.
+     * Requests are failed when the connection is lost, or this client destroyed.
+     * Queued requests wait for the connection to be re-established.
+     *
+     * May be used concurrently with request(), which has its own ChannelRPC.
+     *
+     * @param pvArgument The argument to pass to the server.
+     * @param callback   If not NULL, notified when the request completes.
+     * @return           Handle to wait for the response.
+     * @throws std::logic_error if this client has been destroyed.
+     */
+    AsyncRequest::shared_pointer issueAsync(
+        epics::pvData::PVStructure::shared_pointer const & pvArgument,
+        AsyncCallback::shared_pointer const & callback = AsyncCallback::shared_pointer());
+
+    /**
+     * @returns the limit of requests issued by issueAsync() which are in progress at once.
+     */
+    size_t maxInFlight() const;
+
+    /**
+     * Change the limit of requests in progress at once.  Default is RPCCLIENT_DEFAULT_MAX_IN_FLIGHT.
+     * Lowering the limit does not close ChannelRPCs already created.
+     * @param count limit, at least 1.
+     */
+    void setMaxInFlight(size_t count);
+
 private:
 
     const std::string m_serviceName;
@@ -134,6 +214,9 @@ private:
     struct RPCRequester;
     std::tr1::shared_ptr<RPCRequester> m_rpc_requester;
 
+    struct Pipeline;
+    std::tr1::shared_ptr<Pipeline> m_pipeline;
+
     RPCClient(const RPCClient&);
     RPCClient& operator=(const RPCClient&);
 };
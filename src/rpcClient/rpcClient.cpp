@@ -6,6 +6,9 @@
 
 #include <iostream>
 #include <string>
+#include <deque>
+#include <vector>
+#include <algorithm>
 
 #include <epicsEvent.h>
 #include <pv/pvData.h>
@@ -114,6 +117,385 @@ struct RPCClient::RPCRequester : public pva::ChannelRPCRequester
     }
 };
 
+/* Requests issued with issueAsync() are spread over several ChannelRPC
+ * of the same channel.  The server handles each ChannelRPC separately,
+ * so requests are in progress concurrently.  ChannelRPCs are created
+ * as needed, up to the limit, and re-used.
+ */
+struct RPCClient::Pipeline : public std::tr1::enable_shared_from_this<RPCClient::Pipeline>
+{
+    POINTER_DEFINITIONS(Pipeline);
+
+    struct Request : public RPCClient::AsyncRequest
+    {
+        POINTER_DEFINITIONS(Request);
+
+        const pvd::PVStructure::shared_pointer args;
+        const AsyncCallback::shared_pointer callback;
+
+        mutable pvd::Mutex mutex;
+        epicsEvent event;
+        bool done;
+        pvd::Status status;
+        pvd::PVStructure::shared_pointer response;
+
+        Request(const pvd::PVStructure::shared_pointer& args,
+                const AsyncCallback::shared_pointer& callback)
+            :args(args)
+            ,callback(callback)
+            ,done(false)
+        {}
+        virtual ~Request() {}
+
+        void complete(const pvd::Status& sts, const pvd::PVStructure::shared_pointer& data)
+        {
+            pvd::Status result(sts);
+            pvd::PVStructure::shared_pointer copy;
+            if(result.isSuccess() && !data) {
+                result = pvd::Status::error("No reply data");
+            } else if(result.isSuccess()) {
+                // as waitResponse(), the provider may re-use data
+                copy = pvd::getPVDataCreate()->createPVStructure(data->getStructure());
+                copy->copyUnchecked(*data);
+            }
+            {
+                pvd::Lock L(mutex);
+                if(done)
+                    return;
+                done = true;
+                status = result;
+                response = copy;
+            }
+            event.signal();
+            if(callback) {
+                try {
+                    callback->requestDone(result, copy);
+                } catch(std::exception& e) {
+                    LOG(logLevelError, "Unhandled exception from RPCClient::AsyncCallback::requestDone() : %s", e.what());
+                }
+            }
+        }
+
+        virtual bool isDone() const OVERRIDE FINAL
+        {
+            pvd::Lock L(mutex);
+            return done;
+        }
+
+        virtual pvd::PVStructure::shared_pointer wait(double timeout) OVERRIDE FINAL
+        {
+            pvd::Lock L(mutex);
+            TRACE("timeout="<<timeout);
+            while(!done) {
+                L.unlock();
+                if(timeout<=0.0) {
+                    event.wait();
+                } else if(!event.wait(timeout)) {
+                    L.lock();
+                    if(done)
+                        break;
+                    TRACE("TIMEOUT");
+                    throw RPCRequestException(pvd::Status::STATUSTYPE_ERROR, "RPC timeout");
+                }
+                L.lock();
+            }
+            // in case of other waiters
+            event.signal();
+
+            if(!status.isSuccess())
+                throw RPCRequestException(pvd::Status::STATUSTYPE_ERROR, status.getMessage());
+            return response;
+        }
+    };
+
+    struct Op : public pva::ChannelRPCRequester
+    {
+        POINTER_DEFINITIONS(Op);
+
+        const std::tr1::weak_ptr<Pipeline> pipeline;
+
+        // guarded by Pipeline::mutex
+        ChannelRPC::shared_pointer rpc;
+        Request::shared_pointer current;
+        bool connecting, connected;
+
+        explicit Op(const Pipeline::shared_pointer& pipeline)
+            :pipeline(pipeline)
+            ,connecting(true)
+            ,connected(false)
+        {}
+        virtual ~Op() {}
+
+        virtual std::string getRequesterName() { return "RPCClient::Pipeline"; }
+
+        virtual void channelRPCConnect(
+            const pvd::Status& status,
+            ChannelRPC::shared_pointer const & operation)
+        {
+            Pipeline::shared_pointer P(pipeline.lock());
+            if(P)
+                P->opConnect(this, status, operation);
+        }
+
+        virtual void requestDone(
+            const pvd::Status& status,
+            ChannelRPC::shared_pointer const & operation,
+            pvd::PVStructure::shared_pointer const & pvResponse)
+        {
+            Pipeline::shared_pointer P(pipeline.lock());
+            if(P)
+                P->opDone(this, status, pvResponse);
+        }
+
+        virtual void channelDisconnect(bool destroy)
+        {
+            Pipeline::shared_pointer P(pipeline.lock());
+            if(P)
+                P->opDisconnect(this, destroy);
+        }
+    };
+
+    typedef std::vector<Op::shared_pointer> ops_t;
+    typedef std::deque<Request::shared_pointer> requests_t;
+    typedef std::vector<std::pair<ChannelRPC::shared_pointer, pvd::PVStructure::shared_pointer> > sends_t;
+
+    const Channel::shared_pointer channel;
+    const pvd::PVStructure::shared_pointer pvRequest;
+
+    mutable pvd::Mutex mutex;
+    size_t limit;
+    size_t nconnecting;
+    bool destroyed;
+    requests_t pending;
+    ops_t ops;
+    std::vector<Op*> idle;
+
+    Pipeline(const Channel::shared_pointer& channel,
+             const pvd::PVStructure::shared_pointer& pvRequest)
+        :channel(channel)
+        ,pvRequest(pvRequest)
+        ,limit(RPCCLIENT_DEFAULT_MAX_IN_FLIGHT)
+        ,nconnecting(0u)
+        ,destroyed(false)
+    {}
+
+    ops_t::iterator findLocked(Op* op)
+    {
+        for(ops_t::iterator it(ops.begin()), end(ops.end()); it!=end; ++it) {
+            if(it->get()==op)
+                return it;
+        }
+        return ops.end();
+    }
+
+    // send queued requests to idle ops, and decide whether another op is needed.
+    // call with mutex locked
+    void dispatchLocked(sends_t& sends, Op::shared_pointer& grow)
+    {
+        while(!pending.empty() && !idle.empty()) {
+            Op *op = idle.back();
+            idle.pop_back();
+            op->current.swap(pending.front());
+            pending.pop_front();
+            sends.push_back(std::make_pair(op->rpc, op->current->args));
+        }
+        if(pending.size() > nconnecting && ops.size() < limit) {
+            grow.reset(new Op(shared_from_this()));
+            ops.push_back(grow);
+            nconnecting++;
+        }
+    }
+
+    // call without mutex locked, as the provider may call back immediately
+    void flush(sends_t& sends, Op::shared_pointer& grow)
+    {
+        for(size_t i=0; i<sends.size(); i++) {
+            TRACE("request args: "<<sends[i].second);
+            sends[i].first->request(sends[i].second);
+        }
+
+        if(!grow)
+            return;
+
+        ChannelRPC::shared_pointer rpc;
+        try {
+            rpc = channel->createChannelRPC(grow, pvRequest);
+        } catch(std::exception& e) {
+            opConnect(grow.get(), pvd::Status::error(e.what()), rpc);
+            return;
+        }
+        if(!rpc) {
+            opConnect(grow.get(), pvd::Status::error("channel createChannelRPC() NULL"), rpc);
+            return;
+        }
+
+        bool dead;
+        {
+            pvd::Lock L(mutex);
+            // channelRPCConnect() may already have been called
+            if(!grow->rpc)
+                grow->rpc = rpc;
+            dead = destroyed;
+        }
+        if(dead)
+            rpc->destroy();
+    }
+
+    static void fail(requests_t& reqs, const pvd::Status& status)
+    {
+        for(size_t i=0; i<reqs.size(); i++)
+            reqs[i]->complete(status, pvd::PVStructure::shared_pointer());
+    }
+
+    Request::shared_pointer issue(const pvd::PVStructure::shared_pointer& args,
+                                  const AsyncCallback::shared_pointer& callback)
+    {
+        Request::shared_pointer req(new Request(args, callback));
+        sends_t sends;
+        Op::shared_pointer grow;
+        {
+            pvd::Lock L(mutex);
+            if(destroyed)
+                throw std::logic_error("RPCClient destroyed");
+            pending.push_back(req);
+            dispatchLocked(sends, grow);
+        }
+        flush(sends, grow);
+        return req;
+    }
+
+    void setLimit(size_t count)
+    {
+        sends_t sends;
+        Op::shared_pointer grow;
+        {
+            pvd::Lock L(mutex);
+            limit = count ? count : 1u;
+            if(destroyed)
+                return;
+            dispatchLocked(sends, grow);
+        }
+        flush(sends, grow);
+    }
+
+    void opConnect(Op* op, const pvd::Status& status, ChannelRPC::shared_pointer const & operation)
+    {
+        TRACE("status="<<status);
+        sends_t sends;
+        Op::shared_pointer grow, keep;
+        requests_t failed;
+        {
+            pvd::Lock L(mutex);
+            ops_t::iterator it(findLocked(op));
+            if(destroyed || it==ops.end())
+                return;
+            if(op->connecting) {
+                op->connecting = false;
+                nconnecting--;
+            }
+
+            if(!status.isSuccess()) {
+                // forget this op.  Fail queued requests unless another op remains to send them.
+                op->connected = false;
+                idle.erase(std::remove(idle.begin(), idle.end(), op), idle.end());
+                keep = *it;
+                ops.erase(it);
+                if(ops.empty())
+                    failed.swap(pending);
+
+            } else {
+                op->rpc = operation;
+                if(!op->connected) {
+                    op->connected = true;
+                    idle.push_back(op);
+                }
+                dispatchLocked(sends, grow);
+            }
+        }
+        fail(failed, status);
+        flush(sends, grow);
+    }
+
+    void opDone(Op* op, const pvd::Status& status, pvd::PVStructure::shared_pointer const & response)
+    {
+        TRACE("status="<<status<<" response:\n"<<response<<"\n");
+        Request::shared_pointer req;
+        sends_t sends;
+        Op::shared_pointer grow;
+        {
+            pvd::Lock L(mutex);
+            req.swap(op->current);
+            if(!req)
+                return;
+            if(!destroyed && op->connected) {
+                idle.push_back(op);
+                dispatchLocked(sends, grow);
+            }
+        }
+        // keep the pipeline full before notifying
+        flush(sends, grow);
+        req->complete(status, response);
+    }
+
+    void opDisconnect(Op* op, bool destroy)
+    {
+        TRACE("destroy="<<destroy);
+        Request::shared_pointer req;
+        Op::shared_pointer keep;
+        requests_t failed;
+        {
+            pvd::Lock L(mutex);
+            op->connected = false;
+            idle.erase(std::remove(idle.begin(), idle.end(), op), idle.end());
+            req.swap(op->current);
+
+            ops_t::iterator it(findLocked(op));
+            if(destroy && it!=ops.end()) {
+                if(op->connecting) {
+                    op->connecting = false;
+                    nconnecting--;
+                }
+                keep = *it;
+                ops.erase(it);
+                if(ops.empty())
+                    failed.swap(pending);
+            }
+        }
+        if(req)
+            failed.push_front(req);
+        fail(failed, pvd::Status::error("Connection lost"));
+    }
+
+    void destroy()
+    {
+        ops_t dead;
+        std::vector<ChannelRPC::shared_pointer> rpcs;
+        requests_t failed;
+        {
+            pvd::Lock L(mutex);
+            if(destroyed)
+                return;
+            destroyed = true;
+            dead.swap(ops);
+            idle.clear();
+            nconnecting = 0u;
+            for(size_t i=0; i<dead.size(); i++) {
+                if(dead[i]->current) {
+                    failed.push_back(Request::shared_pointer());
+                    failed.back().swap(dead[i]->current);
+                }
+                if(dead[i]->rpc)
+                    rpcs.push_back(dead[i]->rpc);
+            }
+            failed.insert(failed.end(), pending.begin(), pending.end());
+            pending.clear();
+        }
+        for(size_t i=0; i<rpcs.size(); i++)
+            rpcs[i]->destroy();
+        fail(failed, pvd::Status::error("RPCClient destroyed"));
+    }
+};
+
 
 RPCClient::RPCClient(const std::string & serviceName,
                      pvd::PVStructure::shared_pointer const & pvRequest,
@@ -140,10 +522,16 @@ RPCClient::RPCClient(const std::string & serviceName,
     m_rpc = m_channel->createChannelRPC(m_rpc_requester, m_pvRequest);
     if(!m_rpc)
         throw std::logic_error("channel createChannelRPC() NULL");
+
+    m_pipeline.reset(new Pipeline(m_channel, m_pvRequest));
 }
 
 void RPCClient::destroy()
 {
+    if (m_pipeline)
+    {
+        m_pipeline->destroy();
+    }
     if (m_channel)
     {
         m_channel->destroy();
@@ -263,6 +651,26 @@ pvd::PVStructure::shared_pointer RPCClient::waitResponse(double timeout)
     return ret;
 }
 
+RPCClient::AsyncRequest::shared_pointer RPCClient::issueAsync(
+    pvd::PVStructure::shared_pointer const & pvArgument,
+    AsyncCallback::shared_pointer const & callback)
+{
+    if(!m_pipeline)
+        throw std::logic_error("RPCClient destroyed");
+    return m_pipeline->issue(pvArgument, callback);
+}
+
+size_t RPCClient::maxInFlight() const
+{
+    pvd::Lock L(m_pipeline->mutex);
+    return m_pipeline->limit;
+}
+
+void RPCClient::setMaxInFlight(size_t count)
+{
+    m_pipeline->setLimit(count);
+}
+
 RPCClient::shared_pointer RPCClient::create(const std::string & serviceName,
         pvd::PVStructure::shared_pointer const & pvRequest)
 {
@@ -12,6 +12,7 @@
 #include <pv/rpcServer.h>
 #include <pv/serverContextImpl.h>
 #include <pv/wildcard.h>
+#include <pv/nameIndex.h>
 
 using namespace epics::pvData;
 using std::string;
@@ -276,8 +277,7 @@ public:
         bool found;
         {
             Lock guard(m_mutex);
-            found = (m_services.find(channelName) != m_services.end()) ||
-                    findWildService(channelName);
+            found = !!findService(channelName);
         }
         ChannelFind::shared_pointer thisPtr(shared_from_this());
         channelFindRequester->channelFindResult(Status::Ok, thisPtr, found);
@@ -312,18 +312,10 @@ public:
         short /*priority*/)
     {
         RPCServiceAsync::shared_pointer service;
-
-        RPCServiceMap::const_iterator iter;
         {
             Lock guard(m_mutex);
-            iter = m_services.find(channelName);
+            service = findService(channelName);
         }
-        if (iter != m_services.end())
-            service = iter->second;
-
-        // check for wild services
-        if (!service)
-            service = findWildService(channelName);
 
         if (!service)
         {
@@ -359,14 +351,21 @@ public:
         Lock guard(m_mutex);
         m_services[serviceName] = service;
 
+        m_serviceIndex.erase(serviceName);
+        m_serviceIndex.insert(serviceName, service);
+
         if (isWildcardPattern(serviceName))
             m_wildServices.push_back(std::make_pair(serviceName, service));
+
+        m_wildMatches.clear();
     }
 
     void unregisterService(std::string const & serviceName)
     {
         Lock guard(m_mutex);
         m_services.erase(serviceName);
+        m_serviceIndex.erase(serviceName);
+        m_wildMatches.clear();
 
         if (isWildcardPattern(serviceName))
         {
@@ -382,6 +381,27 @@ public:
     }
 
 private:
+    // assumes sync on services
+    RPCServiceAsync::shared_pointer findService(string const & name)
+    {
+        RPCServiceAsync::shared_pointer *service = m_serviceIndex.find(name);
+        if (service)
+            return *service;
+        else if (m_wildServices.empty())
+            return RPCServiceAsync::shared_pointer();
+
+        // remember the outcome of matching against all patterns, including no match
+        service = m_wildMatches.find(name);
+        if (service)
+            return *service;
+
+        RPCServiceAsync::shared_pointer ret(findWildService(name));
+        if (m_wildMatches.size() >= maxWildMatches)
+            m_wildMatches.clear();
+        m_wildMatches.insert(name, ret);
+        return ret;
+    }
+
     // assumes sync on services
     RPCServiceAsync::shared_pointer findWildService(string const & wildcard)
     {
@@ -407,6 +427,14 @@ private:
     typedef std::map<string, RPCServiceAsync::shared_pointer> RPCServiceMap;
     RPCServiceMap m_services;
 
+    // same content as m_services, for lookup by name
+    typedef detail::NameIndex<RPCServiceAsync::shared_pointer> RPCServiceIndex;
+    RPCServiceIndex m_serviceIndex;
+
+    // results of findWildService(), cleared when services change
+    RPCServiceIndex m_wildMatches;
+    static const size_t maxWildMatches = 65536u;
+
     typedef std::vector<std::pair<string, RPCServiceAsync::shared_pointer> > RPCWildServiceList;
     RPCWildServiceList m_wildServices;
 
@@ -59,6 +59,7 @@ class BaseChannelRequesterMessageTransportSender : public TransportSender
 {
 public:
     BaseChannelRequesterMessageTransportSender(const pvAccessID _ioid, const std::string message,const epics::pvData::MessageType messageType);
+    virtual SendClass getSendClass() const OVERRIDE FINAL { return SEND_CONTROL; }
     virtual void send(epics::pvData::ByteBuffer* buffer, TransportSendControl* control) OVERRIDE FINAL;
 private:
     const pvAccessID _ioid;
@@ -70,6 +71,7 @@ class BaseChannelRequesterFailureMessageTransportSender : public TransportSender
 {
 public:
     BaseChannelRequesterFailureMessageTransportSender(const epics::pvData::int8 command, Transport::shared_pointer const & transport, const pvAccessID ioid, const epics::pvData::int8 qos, const epics::pvData::Status& status);
+    virtual SendClass getSendClass() const OVERRIDE FINAL { return SEND_CONTROL; }
     virtual void send(epics::pvData::ByteBuffer* buffer, TransportSendControl* control) OVERRIDE FINAL;
 
 private:
@@ -8,6 +8,7 @@
 #define RESPONSEHANDLERS_H_
 
 #include <list>
+#include <vector>
 
 #include <pv/timer.h>
 
@@ -16,6 +17,7 @@
 #include <pv/serverChannelImpl.h>
 #include <pv/baseChannelRequester.h>
 #include <pv/securityImpl.h>
+#include <pv/transportStats.h>
 
 namespace epics {
 namespace pvAccess {
@@ -101,6 +103,7 @@ public:
 
     virtual ~EchoTransportSender() {}
 
+    virtual SendClass getSendClass() const OVERRIDE FINAL { return SEND_CONTROL; }
     virtual void send(epics::pvData::ByteBuffer* buffer, TransportSendControl* control) OVERRIDE FINAL {
         control->startMessage(CMD_ECHO, toEcho.size(), toEcho.size());
         control->setRecipient(_echoFrom);
@@ -131,6 +134,65 @@ public:
 };
 
 
+/**
+ * Collects the results of all names in one search request into as few
+ * CMD_SEARCH_RESPONSE datagrams as possible.
+ *
+ * Sent when every name has a result, or after a short delay for
+ * the results available if some ChannelProvider answers asynchronously.
+ * Later results are then sent as they arrive.
+ */
+class ServerSearchResponseBatch :
+    public TransportSender,
+    public epics::pvData::TimerCallback,
+    public std::tr1::enable_shared_from_this<ServerSearchResponseBatch>
+{
+public:
+    POINTER_DEFINITIONS(ServerSearchResponseBatch);
+
+    //! Max. delay in seconds of results waiting for other names in the same request.
+    static const double maxDelay;
+
+    ServerSearchResponseBatch(ServerContextImpl::shared_pointer const & context,
+                              epics::pvData::int32 searchSequenceId, osiSockAddr const & sendTo,
+                              size_t count);
+    virtual ~ServerSearchResponseBatch() {}
+
+    //! Result for one name which needs a response
+    void result(epics::pvData::int32 cid, bool found);
+    //! Result for one name which does not need a response
+    void noResult();
+    //! Call once after the requests for all names have been issued
+    void start();
+
+    virtual void send(epics::pvData::ByteBuffer* buffer, TransportSendControl* control) OVERRIDE FINAL;
+
+    virtual void callback() OVERRIDE FINAL;
+    virtual void timerStopped() OVERRIDE FINAL;
+
+private:
+    void resolved(bool added);
+    void flush();
+
+    const ServerContextImpl::shared_pointer _context;
+    const epics::pvData::int32 _searchSequenceId;
+    const osiSockAddr _sendTo;
+
+    epics::pvData::Mutex _mutex;
+    // results not yet sent
+    std::vector<epics::pvData::int32> _found, _notFound;
+    // names without a result, plus one until start()
+    size_t _remaining;
+    // after timeout or completion, send results immediately
+    bool _immediate;
+
+    // serializes flush() and send()
+    epics::pvData::Mutex _sendMutex;
+    const epics::pvData::int32 *_sendCIDs;
+    size_t _sendCount;
+    bool _sendFound;
+};
+
 class ServerChannelFindRequesterImpl:
     public ChannelFindRequester,
     public TransportSender,
@@ -145,6 +207,8 @@ public:
     void clear();
     ServerChannelFindRequesterImpl* set(std::string _name, epics::pvData::int32 searchSequenceId,
                                         epics::pvData::int32 cid, osiSockAddr const & sendTo, bool responseRequired, bool serverSearch);
+    //! Report through batch instead of sending an individual response
+    void setBatch(const ServerSearchResponseBatch::shared_pointer& batch) { _batch = batch; }
     virtual void channelFindResult(const epics::pvData::Status& status, ChannelFind::shared_pointer const & channelFind, bool wasFound) OVERRIDE FINAL;
 
     virtual std::tr1::shared_ptr<const PeerInfo> getPeerInfo() OVERRIDE FINAL;
@@ -167,6 +231,9 @@ private:
     const epics::pvData::int32 _expectedResponseCount;
     epics::pvData::int32 _responseCount;
     bool _serverSearch;
+    ServerSearchResponseBatch::shared_pointer _batch;
+    // result given to _batch
+    bool _reported;
 };
 
 /****************************************************************************************/
@@ -219,6 +286,7 @@ public:
     virtual std::tr1::shared_ptr<const PeerInfo> getPeerInfo() OVERRIDE FINAL;
     virtual std::string getRequesterName() OVERRIDE FINAL;
     virtual void message(std::string const & message, epics::pvData::MessageType messageType) OVERRIDE FINAL;
+    virtual SendClass getSendClass() const OVERRIDE FINAL { return SEND_CONTROL; }
     virtual void send(epics::pvData::ByteBuffer* buffer, TransportSendControl* control) OVERRIDE FINAL;
 private:
     ServerChannel::weak_pointer _serverChannel;
@@ -255,6 +323,7 @@ public:
     }
 
     virtual ~ServerDestroyChannelHandlerTransportSender() {}
+    virtual SendClass getSendClass() const OVERRIDE FINAL { return SEND_CONTROL; }
     virtual void send(epics::pvData::ByteBuffer* buffer, TransportSendControl* control) OVERRIDE FINAL {
         control->startMessage((epics::pvData::int8)CMD_DESTROY_CHANNEL, 2*sizeof(epics::pvData::int32)/sizeof(epics::pvData::int8));
         buffer->putInt(_sid);
@@ -373,6 +442,7 @@ public:
 
     epics::pvData::BitSet::shared_pointer getPutBitSet();
     epics::pvData::PVStructure::shared_pointer getPutPVStructure();
+    virtual SendClass getSendClass() const OVERRIDE FINAL { return _sendClass; }
     void send(epics::pvData::ByteBuffer* buffer, TransportSendControl* control) OVERRIDE FINAL;
 private:
     // Note: this forms a reference loop, which is broken in destroy()
@@ -380,6 +450,8 @@ private:
     epics::pvData::BitSet::shared_pointer _bitSet;
     epics::pvData::PVStructure::shared_pointer _pvStructure;
     epics::pvData::Status _status;
+    // set before queueing.  A get reply carries the whole structure
+    SendClass _sendClass;
 };
 
 /****************************************************************************************/
@@ -499,6 +571,7 @@ public:
     Monitor::shared_pointer getChannelMonitor();
     virtual std::tr1::shared_ptr<ChannelRequest> getOperation() OVERRIDE FINAL { return std::tr1::shared_ptr<ChannelRequest>(); }
 
+    virtual SendClass getSendClass() const OVERRIDE FINAL { return SEND_MONITOR; }
     virtual void send(epics::pvData::ByteBuffer* buffer, TransportSendControl* control) OVERRIDE FINAL;
     void ack(size_t cnt);
 private:
@@ -515,6 +588,10 @@ private:
     window_t _window_closed;
     bool _unlisten;
     bool _pipeline; // const after activate()
+    // max. number of updates sent back-to-back in one send() call (record._options.batch)
+    size_t _batch; // const after activate()
+    // count of monitorEvent() calls, to trace updates (cf. pvAccessMB.h)
+    size_t _traceSeq;
 };
 
 
@@ -671,6 +748,7 @@ public:
     ChannelProcess::shared_pointer getChannelProcess();
     virtual std::tr1::shared_ptr<ChannelRequest> getOperation() OVERRIDE FINAL { return getChannelProcess(); }
 
+    virtual SendClass getSendClass() const OVERRIDE FINAL { return SEND_CONTROL; }
     virtual void send(epics::pvData::ByteBuffer* buffer, TransportSendControl* control) OVERRIDE FINAL;
 
 private:
@@ -808,13 +886,18 @@ private:
  */
 class ServerResponseHandler : public ResponseHandler {
 public:
-    ServerResponseHandler(ServerContextImpl::shared_pointer const & context);
+    ServerResponseHandler(ServerContextImpl::shared_pointer const & context, bool timing);
 
     virtual ~ServerResponseHandler() {}
 
     virtual void handleResponse(osiSockAddr* responseFrom,
                                 Transport::shared_pointer const & transport, epics::pvData::int8 version, epics::pvData::int8 command,
                                 std::size_t payloadSize, epics::pvData::ByteBuffer* payloadBuffer) OVERRIDE FINAL;
+
+    //! Number of application commands which may be handled
+    size_t commandCount() const { return m_handlerTable.size(); }
+    //! Counters of messages received with command < commandCount()
+    const detail::CommandStats& getCommandStats(size_t command) const { return m_stats[command]; }
 private:
     ServerBadResponse handle_bad;
 
@@ -840,6 +923,9 @@ private:
      */
     std::vector<ResponseHandler*> m_handlerTable;
 
+    detail::CommandStats m_stats[CMD_CANCEL_REQUEST+1];
+    // measure time spent in handlers.  cf. $EPICS_PVAS_HANDLER_TIMING
+    const bool m_timing;
 };
 
 }
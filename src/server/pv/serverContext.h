@@ -68,6 +68,15 @@ public:
      */
     virtual void printInfo(std::ostream& str, int lvl=0) = 0;
 
+    /**
+     * Prints counters of bytes and messages for each connection,
+     * and of messages and handling time for each command.
+     * @param str stream to which to print
+     * @param lvl detail level.  0 commands only, 1 also connections.
+     * @since 7.1.0
+     */
+    virtual void printStats(std::ostream& str, int lvl=0) = 0;
+
     virtual epicsTimeStamp& getStartTime() = 0;
 
     /**
@@ -16,6 +16,7 @@
 #include <pv/blockingUDP.h>
 #include <pv/blockingTCP.h>
 #include <pv/beaconEmitter.h>
+#include <pv/nameIndex.h>
 
 #include "serverContext.h"
 
@@ -44,6 +45,7 @@ public:
     void run(epics::pvData::uint32 seconds) OVERRIDE FINAL;
     void shutdown() OVERRIDE FINAL;
     void printInfo(std::ostream& str, int lvl) OVERRIDE FINAL;
+    void printStats(std::ostream& str, int lvl) OVERRIDE FINAL;
     void setBeaconServerStatusProvider(BeaconServerStatusProvider::shared_pointer const & beaconServerStatusProvider) OVERRIDE FINAL;
     //**************** derived from Context ****************//
     epics::pvData::Timer::shared_pointer getTimer() OVERRIDE FINAL;
@@ -139,6 +141,23 @@ public:
     // used by ServerChannelFindRequesterImpl
     typedef std::map<std::string, std::tr1::weak_ptr<ChannelProvider> > s_channelNameToProvider_t;
     s_channelNameToProvider_t s_channelNameToProvider;
+
+    // used by ServerSearchHandler and ServerChannelFindRequesterImpl
+    /**
+     * Was name recently searched for, and not found by any provider?
+     * Always false unless $EPICS_PVAS_SEARCH_NEGATIVE_TTL is set.
+     */
+    bool isUnclaimedName(const std::string& name);
+    /**
+     * Record that no provider found name.
+     */
+    void unclaimedName(const std::string& name);
+
+    // used by the "server" RPC service
+    /**
+     * Connection and command statistics, as printed by printStats().
+     */
+    epics::pvData::PVStructure::shared_pointer getStats();
 private:
 
     /**
@@ -190,6 +209,28 @@ private:
      */
     epics::pvData::int32 _receiveBufferSize;
 
+    /**
+     * Number of sockets, each with a thread, sharing unicast name searches received on each interface.
+     */
+    epics::pvData::int32 _udpReceiveThreads;
+
+    /**
+     * Time in seconds for which a name not found by any provider is not searched for again.
+     * Zero to always search.
+     */
+    double _searchNegativeTTL;
+
+    /**
+     * Expiry times of names not found by any provider.
+     */
+    detail::NameIndex<epicsTimeStamp> _unclaimedNames;
+    epics::pvData::Mutex _unclaimedNamesMutex;
+
+    /**
+     * Measure time spent handling each command.
+     */
+    bool _handlerTiming;
+
     epics::pvData::Timer::shared_pointer _timer;
 
     /**
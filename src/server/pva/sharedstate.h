@@ -7,6 +7,7 @@
 
 #include <string>
 #include <list>
+#include <vector>
 
 #include <shareLib.h>
 #include <pv/sharedPtr.h>
@@ -28,6 +29,7 @@ class Channel;
 class ChannelRequester;
 struct ChannelBaseRequester;
 class GetFieldRequester;
+class MonitorFIFO;
 void providerRegInit(void*);
 }} // epics::pvAccess
 
@@ -188,6 +190,11 @@ private:
 
     mutable epicsMutex mutex;
 
+    // Serializes post(), and excludes open() and close() while updates
+    // are queued to subscribers without holding mutex.
+    // Not held while subscribers are notified.  Lock before mutex.
+    epicsMutex postMutex;
+
     std::tr1::shared_ptr<SharedPV::Handler> handler;
 
     typedef std::list<detail::SharedPut*> puts_t;
@@ -204,6 +211,13 @@ private:
     getfields_t getfields;
     channels_t channels;
 
+    // copy of monitors used by post(), refreshed when monitorsChanged.
+    // guarded by postMutex
+    typedef std::vector<std::tr1::weak_ptr<epics::pvAccess::MonitorFIFO> > fanout_t;
+    fanout_t fanout;
+    // guarded by mutex
+    bool monitorsChanged;
+
     std::tr1::shared_ptr<epics::pvData::PVStructure> current;
     //! mask of fields which are considered to have non-default values.
     //! Used for initial Monitor update and Get operations.
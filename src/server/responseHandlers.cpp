@@ -5,6 +5,7 @@
  */
 
 #include <sstream>
+#include <algorithm>
 #include <time.h>
 #include <stdlib.h>
 
@@ -51,6 +52,17 @@ using namespace epics::pvData;
 namespace epics {
 namespace pvAccess {
 
+MB_DECLARE_EXTERN(pvaReceive);
+MB_DECLARE_EXTERN(pvaMonitor);
+
+#ifdef WITH_MICROBENCH
+// trace ID of the latest update of a monitor
+static epicsUInt64 monitorTraceID(pvAccessID ioid, size_t seq)
+{
+    return (epicsUInt64(ioid)<<32u) | epicsUInt32(seq);
+}
+#endif
+
 // TODO this is a copy from clientContextImpl.cpp
 static PVDataCreatePtr pvDataCreate = getPVDataCreate();
 
@@ -100,7 +112,7 @@ void ServerBadResponse::handleResponse(osiSockAddr* responseFrom,
 
 }
 
-ServerResponseHandler::ServerResponseHandler(ServerContextImpl::shared_pointer const & context)
+ServerResponseHandler::ServerResponseHandler(ServerContextImpl::shared_pointer const & context, bool timing)
     :ResponseHandler(context.get(), "ServerResponseHandler")
     ,handle_bad(context)
     ,handle_beacon(context, "Beacon")
@@ -121,6 +133,7 @@ ServerResponseHandler::ServerResponseHandler(ServerContextImpl::shared_pointer c
     ,handle_rpc(context)
     ,handle_cancel(context)
     ,m_handlerTable(CMD_CANCEL_REQUEST+1, &handle_bad)
+    ,m_timing(timing)
 {
 
     m_handlerTable[CMD_BEACON] = &handle_beacon; /*  0 */
@@ -165,6 +178,14 @@ void ServerResponseHandler::handleResponse(osiSockAddr* responseFrom,
         return;
     }
 
+    detail::CommandStats& stats = m_stats[command];
+    epics::atomic::increment(stats.messages);
+    epics::atomic::add(stats.bytes, payloadSize);
+
+    detail::LatencyTimer timer(m_timing ? &stats.latency : 0);
+
+    MB_POINT(pvaReceive, 2, "handler dispatch");
+
     // delegate
     m_handlerTable[command]->handleResponse(responseFrom, transport,
                                             version, command, payloadSize, payloadBuffer);
@@ -182,8 +203,7 @@ void ServerConnectionValidationHandler::handleResponse(
     transport->setRemoteTransportReceiveBufferSize(payloadBuffer->getInt());
     // TODO clientIntrospectionRegistryMaxSize
     /* int clientIntrospectionRegistryMaxSize = */ payloadBuffer->getShort();
-    // TODO connectionQoS
-    /* int16 connectionQoS = */ payloadBuffer->getShort();
+    int16 connectionQoS = payloadBuffer->getShort();
 
     // authNZ
     std::string securityPluginName = SerializeHelper::deserializeString(payloadBuffer, transport.get());
@@ -203,6 +223,8 @@ void ServerConnectionValidationHandler::handleResponse(
     //TODO: simplify byzantine class heirarchy...
     assert(casTransport);
 
+    casTransport->connectionQoS(connectionQoS);
+
     try {
         casTransport->authNZInitialize(securityPluginName, data);
     }catch(std::exception& e){
@@ -340,26 +362,50 @@ void ServerSearchHandler::handleResponse(osiSockAddr* responseFrom,
 
     if (count > 0)
     {
-        // regular name search
-        for (int32 i = 0; i < count; i++)
-        {
-            transport->ensureData(4);
-            const int32 cid = payloadBuffer->getInt();
-            const string name = SerializeHelper::deserializeString(payloadBuffer, transport.get());
-            // no name check here...
+        // results for all names are sent together
+        ServerSearchResponseBatch::shared_pointer batch;
+        if (allowed)
+            batch.reset(new ServerSearchResponseBatch(_context, searchSequenceId, responseAddress, count));
 
-            if (allowed)
+        try {
+            // regular name search
+            for (int32 i = 0; i < count; i++)
             {
-                const std::vector<ChannelProvider::shared_pointer>& _providers = _context->getChannelProviders();
+                transport->ensureData(4);
+                const int32 cid = payloadBuffer->getInt();
+                const string name = SerializeHelper::deserializeString(payloadBuffer, transport.get());
+                // no name check here...
+
+                if (allowed && _context->isUnclaimedName(name))
+                {
+                    // recently not found by any provider, don't ask again
+                    if (responseRequired)
+                        batch->result(cid, false);
+                    else
+                        batch->noResult();
+                }
+                else if (allowed)
+                {
+                    const std::vector<ChannelProvider::shared_pointer>& _providers = _context->getChannelProviders();
 
-                int providerCount = _providers.size();
-                std::tr1::shared_ptr<ServerChannelFindRequesterImpl> tp(new ServerChannelFindRequesterImpl(_context, info, providerCount));
-                tp->set(name, searchSequenceId, cid, responseAddress, responseRequired, false);
+                    int providerCount = _providers.size();
+                    std::tr1::shared_ptr<ServerChannelFindRequesterImpl> tp(new ServerChannelFindRequesterImpl(_context, info, providerCount));
+                    tp->set(name, searchSequenceId, cid, responseAddress, responseRequired, false);
+                    tp->setBatch(batch);
 
-                for (int i = 0; i < providerCount; i++)
-                    _providers[i]->channelFind(name, tp);
+                    for (int i = 0; i < providerCount; i++)
+                        _providers[i]->channelFind(name, tp);
+                }
             }
+        } catch(...) {
+            // send results for names before a truncated request
+            if (batch)
+                batch->start();
+            throw;
         }
+
+        if (batch)
+            batch->start();
     }
     else
     {
@@ -380,6 +426,154 @@ void ServerSearchHandler::handleResponse(osiSockAddr* responseFrom,
     }
 }
 
+const double ServerSearchResponseBatch::maxDelay = 0.01;
+
+namespace {
+// max. CIDs in one unfragmented CMD_SEARCH_RESPONSE
+const size_t maxSearchResponseCIDs = (MAX_UDP_UNFRAGMENTED_SEND - PVA_MESSAGE_HEADER_SIZE
+                                      - (12+4+16+2) // GUID, sequence, address, port
+                                      - (1+3)       // "tcp"
+                                      - 1 - 2)/4;   // found, count
+}
+
+ServerSearchResponseBatch::ServerSearchResponseBatch(ServerContextImpl::shared_pointer const & context,
+        int32 searchSequenceId, osiSockAddr const & sendTo, size_t count) :
+    _context(context),
+    _searchSequenceId(searchSequenceId),
+    _sendTo(sendTo),
+    _remaining(count+1u),
+    _immediate(false),
+    _sendCIDs(0),
+    _sendCount(0u),
+    _sendFound(false)
+{}
+
+void ServerSearchResponseBatch::result(int32 cid, bool found)
+{
+    {
+        Lock guard(_mutex);
+        (found ? _found : _notFound).push_back(cid);
+    }
+    resolved(true);
+}
+
+void ServerSearchResponseBatch::noResult()
+{
+    resolved(false);
+}
+
+void ServerSearchResponseBatch::start()
+{
+    resolved(false);
+
+    bool wait;
+    {
+        Lock guard(_mutex);
+        wait = !_immediate;
+    }
+
+    // some provider(s) answer asynchronously
+    if (wait)
+        _context->getTimer()->scheduleAfterDelay(shared_from_this(), maxDelay);
+}
+
+void ServerSearchResponseBatch::resolved(bool added)
+{
+    bool flushNow;
+    {
+        Lock guard(_mutex);
+
+        if (_remaining > 0u && --_remaining == 0u)
+        {
+            flushNow = !_immediate;
+            _immediate = true;
+        }
+        else
+        {
+            flushNow = added && _immediate;
+        }
+    }
+
+    if (flushNow)
+        flush();
+}
+
+void ServerSearchResponseBatch::callback()
+{
+    {
+        Lock guard(_mutex);
+        if (_immediate)
+            return;
+        _immediate = true;
+    }
+    flush();
+}
+
+void ServerSearchResponseBatch::timerStopped()
+{
+    // noop
+}
+
+void ServerSearchResponseBatch::flush()
+{
+    Lock sguard(_sendMutex);
+
+    std::vector<int32> found, notFound;
+    {
+        Lock guard(_mutex);
+        found.swap(_found);
+        notFound.swap(_notFound);
+    }
+
+    BlockingUDPTransport::shared_pointer bt = _context->getBroadcastTransport();
+    if (!bt)
+        return;
+
+    TransportSender::shared_pointer thisSender = shared_from_this();
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        const std::vector<int32>& cids = pass==0 ? found : notFound;
+        _sendFound = pass==0;
+
+        for (size_t i = 0; i < cids.size(); i += maxSearchResponseCIDs)
+        {
+            _sendCIDs = &cids[i];
+            _sendCount = std::min(cids.size()-i, maxSearchResponseCIDs);
+            // sends immediately through our send()
+            bt->enqueueSendRequest(thisSender);
+        }
+    }
+
+    _sendCIDs = 0;
+    _sendCount = 0u;
+}
+
+void ServerSearchResponseBatch::send(ByteBuffer* buffer, TransportSendControl* control)
+{
+    // called from flush() with _sendMutex held
+    control->startMessage(CMD_SEARCH_RESPONSE, 12+4+16+2);
+
+    const ServerGUID& guid = _context->getGUID();
+    buffer->put(guid.value, 0, sizeof(guid.value));
+    buffer->putInt(_searchSequenceId);
+
+    // NOTE: is it possible (very likely) that address is any local address ::ffff:0.0.0.0
+    encodeAsIPv6Address(buffer, _context->getServerInetAddress());
+    buffer->putShort((int16)_context->getServerPort());
+
+    SerializeHelper::serializeString(ServerSearchHandler::SUPPORTED_PROTOCOL, buffer, control);
+
+    control->ensureBuffer(1+2+4*_sendCount);
+    buffer->putByte(_sendFound ? (int8)1 : (int8)0);
+
+    buffer->putShort((int16)_sendCount);
+    for (size_t i = 0; i < _sendCount; i++)
+        buffer->putInt(_sendCIDs[i]);
+
+    control->setRecipient(_sendTo);
+}
+
 ServerChannelFindRequesterImpl::ServerChannelFindRequesterImpl(ServerContextImpl::shared_pointer const & context, const PeerInfo::const_shared_pointer &peer,
         int32 expectedResponseCount) :
     _guid(context->getGUID()),
@@ -389,7 +583,8 @@ ServerChannelFindRequesterImpl::ServerChannelFindRequesterImpl(ServerContextImpl
     _peer(peer),
     _expectedResponseCount(expectedResponseCount),
     _responseCount(0),
-    _serverSearch(false)
+    _serverSearch(false),
+    _reported(false)
 {}
 
 void ServerChannelFindRequesterImpl::clear()
@@ -398,6 +593,7 @@ void ServerChannelFindRequesterImpl::clear()
     _wasFound = false;
     _responseCount = 0;
     _serverSearch = false;
+    _reported = false;
 }
 
 void ServerChannelFindRequesterImpl::callback()
@@ -425,41 +621,72 @@ ServerChannelFindRequesterImpl* ServerChannelFindRequesterImpl::set(std::string
 
 void ServerChannelFindRequesterImpl::channelFindResult(const Status& /*status*/, ChannelFind::shared_pointer const & channelFind, bool wasFound)
 {
-    // TODO status
-    Lock guard(_mutex);
-
-    _responseCount++;
-    if (_responseCount > _expectedResponseCount)
+    ServerSearchResponseBatch::shared_pointer batch;
+    int32 cid = 0;
+    bool respond;
     {
-        if ((_responseCount+1) == _expectedResponseCount)
+        // TODO status
+        Lock guard(_mutex);
+
+        _responseCount++;
+        if (_responseCount > _expectedResponseCount)
+        {
+            if ((_responseCount+1) == _expectedResponseCount)
+            {
+                LOG(logLevelDebug,"[ServerChannelFindRequesterImpl::channelFindResult] More responses received than expected fpr channel '%s'!", _name.c_str());
+            }
+            return;
+        }
+
+        if (wasFound && _wasFound)
         {
-            LOG(logLevelDebug,"[ServerChannelFindRequesterImpl::channelFindResult] More responses received than expected fpr channel '%s'!", _name.c_str());
+            LOG(logLevelDebug,"[ServerChannelFindRequesterImpl::channelFindResult] Channel '%s' is hosted by different channel providers!", _name.c_str());
+            return;
         }
-        return;
-    }
 
-    if (wasFound && _wasFound)
-    {
-        LOG(logLevelDebug,"[ServerChannelFindRequesterImpl::channelFindResult] Channel '%s' is hosted by different channel providers!", _name.c_str());
-        return;
-    }
+        respond = wasFound || (_responseRequired && (_responseCount == _expectedResponseCount));
+
+        if (!wasFound && !_wasFound && !_serverSearch && _responseCount == _expectedResponseCount)
+            _context->unclaimedName(_name);
+
+        if (_batch)
+        {
+            // exactly one result, when found or after all providers answer
+            if (_reported || (!wasFound && _responseCount < _expectedResponseCount))
+                return;
+            _reported = true;
+        }
+        else if (!respond)
+        {
+            return;
+        }
 
-    if (wasFound || (_responseRequired && (_responseCount == _expectedResponseCount)))
-    {
         if (wasFound && _expectedResponseCount > 1)
         {
             Lock L(_context->_mutex);
             _context->s_channelNameToProvider[_name] = channelFind->getChannelProvider();
         }
         _wasFound = wasFound;
-        
-        BlockingUDPTransport::shared_pointer bt = _context->getBroadcastTransport();
-        if (bt)
+
+        if (!_batch)
         {
-            TransportSender::shared_pointer thisSender = shared_from_this();
-            bt->enqueueSendRequest(thisSender);
+            BlockingUDPTransport::shared_pointer bt = _context->getBroadcastTransport();
+            if (bt)
+            {
+                TransportSender::shared_pointer thisSender = shared_from_this();
+                bt->enqueueSendRequest(thisSender);
+            }
+            return;
         }
+
+        batch = _batch;
+        cid = _cid;
     }
+
+    if (respond)
+        batch->result(cid, wasFound);
+    else
+        batch->noResult();
 }
 
 std::tr1::shared_ptr<const PeerInfo> ServerChannelFindRequesterImpl::getPeerInfo()
@@ -673,6 +900,10 @@ public:
 
             return result;
         }
+        else if (op == "stats")
+        {
+            return m_serverContext->getStats();
+        }
         else
             throw RPCRequestException(Status::STATUSTYPE_ERROR, "unsupported operation '" + op + "'.");
     }
@@ -712,6 +943,7 @@ const std::string ServerRPCService::helpString =
     "\toperations:\n"
     "\t\tinfo\t\treturns some information about the server\n"
     "\t\tchannels\treturns a list of 'static' channels the server can provide\n"
+    "\t\tstats\t\treturns message counters and handling times of each command, and counters of each connection\n"
 //        "\t\t\t (no arguments)\n"
     "\n";
 
@@ -1325,6 +1557,7 @@ void ServerPutHandler::handleResponse(osiSockAddr* responseFrom,
 ServerChannelPutRequesterImpl::ServerChannelPutRequesterImpl(ServerContextImpl::shared_pointer const & context, ServerChannel::shared_pointer const & channel,
         const pvAccessID ioid, Transport::shared_pointer const & transport):
     BaseChannelRequester(context, channel, ioid, transport)
+    ,_sendClass(SEND_CONTROL)
 {
 }
 
@@ -1352,6 +1585,7 @@ void ServerChannelPutRequesterImpl::channelPutConnect(const Status& status, Chan
         Lock guard(_mutex);
         _status = status;
         _channelPut = channelPut;
+        _sendClass = SEND_CONTROL;
         if (_status.isSuccess())
         {
             _pvStructure = std::tr1::static_pointer_cast<PVStructure>(reuseOrCreatePVField(structure, _pvStructure));
@@ -1374,6 +1608,7 @@ void ServerChannelPutRequesterImpl::putDone(const Status& status, ChannelPut::sh
     {
         Lock guard(_mutex);
         _status = status;
+        _sendClass = SEND_CONTROL;
     }
     TransportSender::shared_pointer thisSender = shared_from_this();
     _transport->enqueueSendRequest(thisSender);
@@ -1384,6 +1619,7 @@ void ServerChannelPutRequesterImpl::getDone(const Status& status, ChannelPut::sh
     {
         Lock guard(_mutex);
         _status = status;
+        _sendClass = SEND_BULK;
         if (_status.isSuccess())
         {
             *_bitSet = *bitSet;
@@ -1861,6 +2097,8 @@ ServerMonitorRequesterImpl::ServerMonitorRequesterImpl(
     ,_window_open(0u)
     ,_unlisten(false)
     ,_pipeline(false)
+    ,_batch(1u)
+    ,_traceSeq(0u)
 {}
 
 ServerMonitorRequesterImpl::shared_pointer ServerMonitorRequesterImpl::create(
@@ -1884,6 +2122,16 @@ void ServerMonitorRequesterImpl::activate(PVStructure::shared_pointer const & pv
             message(strm.str(), epics::pvData::errorMessage);
         }
     }
+    O = pvRequest->getSubField<epics::pvData::PVScalar>("record._options.batch");
+    if(O) {
+        try{
+            _batch = std::max(1u, O->getAs<epics::pvData::uint32>());
+        }catch(std::exception& e){
+            std::ostringstream strm;
+            strm<<"Ignoring invalid batch= : "<<e.what();
+            message(strm.str(), epics::pvData::errorMessage);
+        }
+    }
     startRequest(QOS_INIT);
     shared_pointer thisPointer(shared_from_this());
     _channel->registerRequest(_ioid, thisPointer);
@@ -1920,6 +2168,9 @@ void ServerMonitorRequesterImpl::unlisten(Monitor::shared_pointer const & /*moni
 
 void ServerMonitorRequesterImpl::monitorEvent(Monitor::shared_pointer const & /*monitor*/)
 {
+    MB_POINT_ID(pvaMonitor, 0, "provider callback",
+                monitorTraceID(_ioid, epics::atomic::increment(_traceSeq)));
+
     TransportSender::shared_pointer thisSender = shared_from_this();
     _transport->enqueueSendRequest(thisSender);
 }
@@ -1986,19 +2237,29 @@ void ServerMonitorRequesterImpl::send(ByteBuffer* buffer, TransportSendControl*
 
         // TODO asCheck ?
 
-        bool busy = false;
-        if(_pipeline) {
-            Lock guard(_mutex);
-            busy = _window_open==0;
-        }
+        // updates left in this send pass, and byte budget to preserve fairness
+        // between senders sharing this connection
+        size_t nbatch = _batch;
+        const size_t maxBytes = buffer->getSize()/2u;
+        size_t nbytes = 0u, pos = buffer->getPosition();
+        bool sent = false;
 
-        MonitorElement::Ref element;
-        if(!busy) {
-            MonitorElement::Ref E(monitor);
-            E.swap(element);
-        }
-        if (element)
+        while(true)
         {
+            bool busy = false;
+            if(_pipeline) {
+                Lock guard(_mutex);
+                busy = _window_open==0;
+            }
+
+            MonitorElement::Ref element;
+            if(!busy) {
+                MonitorElement::Ref E(monitor);
+                E.swap(element);
+            }
+            if (!element)
+                break;
+
             control->startMessage((int8)CMD_MONITOR, sizeof(int32)/sizeof(int8) + 1);
             buffer->putInt(_ioid);
             buffer->putByte((int8)request);
@@ -2014,6 +2275,10 @@ void ServerMonitorRequesterImpl::send(ByteBuffer* buffer, TransportSendControl*
                 element->overrunBitSet->serialize(buffer, control);
             }
 
+            // set payload size so that the next update can start a new message
+            control->endMessage();
+            sent = true;
+
             {
                 Lock guard(_mutex);
                 if(!_pipeline) {
@@ -2031,8 +2296,23 @@ void ServerMonitorRequesterImpl::send(ByteBuffer* buffer, TransportSendControl*
 
             element.reset(); // calls Monitor::release() if not swap()'d
 
-            // TODO if we try to proces several monitors at once, then fairness suffers
-            // TODO compbine several monitors into one message (reduces payload)
+            // stop batching when the send buffer was flushed mid-update (it is full),
+            // or when our share of the buffer is used up.
+            const size_t npos = buffer->getPosition();
+            if(npos < pos)
+                break;
+            nbytes += npos - pos;
+            pos = npos;
+            if(--nbatch==0u || nbytes >= maxBytes)
+                break;
+        }
+
+        if (sent)
+        {
+            MB_POINT_ID(pvaMonitor, 1, "serialize",
+                        monitorTraceID(_ioid, epics::atomic::get(_traceSeq)));
+
+            // come back for any remaining updates after other senders have had a turn
             TransportSender::shared_pointer thisSender = shared_from_this();
             _transport->enqueueSendRequest(thisSender);
         }
@@ -19,6 +19,7 @@
 #include "pv/pvAccess.h"
 #include "pv/security.h"
 #include "pv/reftrack.h"
+#include "pv/nameIndex.h"
 
 namespace pvd = epics::pvData;
 namespace pva = epics::pvAccess;
@@ -42,6 +43,9 @@ struct StaticProvider::Impl : public pva::ChannelProvider
 
     typedef StaticProvider::builders_t builders_t;
     builders_t builders;
+    // lookup by name into builders, which remains the ordered list
+    typedef pva::detail::NameIndex<builders_t::iterator> index_t;
+    index_t index;
 
     Impl(const std::string& name)
         :name(name)
@@ -63,7 +67,7 @@ struct StaticProvider::Impl : public pva::ChannelProvider
         {
             Guard G(mutex);
 
-            found =  builders.find(name)!=builders.end();
+            found = !!index.find(name);
         }
         requester->channelFindResult(pvd::Status(), finder, found);
         return finder;
@@ -91,11 +95,9 @@ struct StaticProvider::Impl : public pva::ChannelProvider
         builders_t::mapped_type builder;
         {
             Guard G(mutex);
-            builders_t::const_iterator it(builders.find(name));
-            if(it!=builders.end()) {
-                UnGuard U(G);
-                builder = it->second;
-            }
+            builders_t::iterator *it = index.find(name);
+            if(it)
+                builder = (*it)->second;
         }
         if(builder)
             ret = builder->connect(Impl::shared_pointer(internal_self), name, requester);
@@ -133,6 +135,7 @@ void StaticProvider::close(bool destroy)
         Guard G(impl->mutex);
         if(destroy) {
             pvs.swap(impl->builders); // consume
+            impl->index.clear();
         } else {
             pvs = impl->builders; // just copy, close() is a relatively rare action
         }
@@ -151,9 +154,10 @@ void StaticProvider::add(const std::string& name,
          const std::tr1::shared_ptr<ChannelBuilder>& builder)
 {
     Guard G(impl->mutex);
-    if(impl->builders.find(name)!=impl->builders.end())
+    std::pair<Impl::builders_t::iterator, bool> ins(impl->builders.insert(std::make_pair(name, builder)));
+    if(!ins.second)
         throw std::logic_error("Duplicate PV name");
-    impl->builders[name] = builder;
+    impl->index.insert(name, ins.first);
 }
 
 std::tr1::shared_ptr<StaticProvider::ChannelBuilder> StaticProvider::remove(const std::string& name)
@@ -161,10 +165,11 @@ std::tr1::shared_ptr<StaticProvider::ChannelBuilder> StaticProvider::remove(cons
     std::tr1::shared_ptr<StaticProvider::ChannelBuilder> ret;
     {
         Guard G(impl->mutex);
-        Impl::builders_t::iterator it(impl->builders.find(name));
-        if(it!=impl->builders.end()) {
-            ret = it->second;
-            impl->builders.erase(it);
+        Impl::builders_t::iterator *it = impl->index.find(name);
+        if(it) {
+            ret = (*it)->second;
+            impl->builders.erase(*it);
+            impl->index.erase(name);
         }
     }
     if(ret)
@@ -4,12 +4,16 @@
  * in file LICENSE that is included with this distribution.
  */
 
+#include <iomanip>
+
 #include <epicsSignal.h>
+#include <epicsAtomic.h>
 
 #include <pv/lock.h>
 #include <pv/timer.h>
 #include <pv/thread.h>
 #include <pv/reftrack.h>
+#include <pv/pvData.h>
 
 #define epicsExportSharedSymbols
 #include <pv/responseHandlers.h>
@@ -17,6 +21,7 @@
 #include <pv/serverContextImpl.h>
 #include <pv/codec.h>
 #include <pv/security.h>
+#include <pv/pvAccessMB.h>
 
 using namespace std;
 using namespace epics::pvData;
@@ -39,6 +44,9 @@ ServerContextImpl::ServerContextImpl():
     _broadcastPort(PVA_BROADCAST_PORT),
     _serverPort(PVA_SERVER_PORT),
     _receiveBufferSize(MAX_TCP_RECV),
+    _udpReceiveThreads(1),
+    _searchNegativeTTL(0.0),
+    _handlerTiming(true),
     _timer(new Timer("PVAS timers", lowerPriority)),
     _beaconEmitter(),
     _acceptor(),
@@ -145,6 +153,16 @@ void ServerContextImpl::loadConfiguration()
     _receiveBufferSize = config->getPropertyAsInteger("EPICS_PVA_MAX_ARRAY_BYTES", _receiveBufferSize);
     _receiveBufferSize = config->getPropertyAsInteger("EPICS_PVAS_MAX_ARRAY_BYTES", _receiveBufferSize);
 
+    _udpReceiveThreads = config->getPropertyAsInteger("EPICS_PVAS_UDP_RX_THREADS", _udpReceiveThreads);
+    if(_udpReceiveThreads < 1)
+        _udpReceiveThreads = 1;
+
+    _searchNegativeTTL = config->getPropertyAsDouble("EPICS_PVAS_SEARCH_NEGATIVE_TTL", _searchNegativeTTL);
+    if(_searchNegativeTTL < 0.0)
+        _searchNegativeTTL = 0.0;
+
+    _handlerTiming = config->getPropertyAsBoolean("EPICS_PVAS_HANDLER_TIMING", _handlerTiming);
+
     if(_channelProviders.empty()) {
         std::string providers = config->getPropertyAsString("EPICS_PVAS_PROVIDER_NAMES", PVACCESS_DEFAULT_PROVIDER);
 
@@ -248,6 +266,10 @@ ServerContextImpl::getCurrentConfig()
     SET("EPICS_PVAS_MAX_ARRAY_BYTES", getReceiveBufferSize());
     SET("EPICS_PVA_MAX_ARRAY_BYTES", getReceiveBufferSize());
 
+    SET("EPICS_PVAS_UDP_RX_THREADS", _udpReceiveThreads);
+    SET("EPICS_PVAS_SEARCH_NEGATIVE_TTL", _searchNegativeTTL);
+    SET("EPICS_PVAS_HANDLER_TIMING", _handlerTiming ? "YES" : "NO");
+
     SET("EPICS_PVAS_PROVIDER_NAMES", providerName.str());
 
 #undef SET
@@ -268,16 +290,19 @@ void ServerContextImpl::initialize()
     // already called in loadConfiguration
     //osiSockAttach();
 
+    MB_INIT;
+
     ServerContextImpl::shared_pointer thisServerContext = shared_from_this();
     // we create reference cycles here which are broken by our shutdown() method,
-    _responseHandler.reset(new ServerResponseHandler(thisServerContext));
+    _responseHandler.reset(new ServerResponseHandler(thisServerContext, _handlerTiming));
 
     _acceptor.reset(new BlockingTCPAcceptor(thisServerContext, _responseHandler, _ifaceAddr, _receiveBufferSize));
     _serverPort = ntohs(_acceptor->getBindAddress()->ia.sin_port);
 
     // setup broadcast UDP transport
     initializeUDPTransports(true, _udpTransports, _ifaceList, _responseHandler, _broadcastTransport,
-                            _broadcastPort, _autoBeaconAddressList, _beaconAddressList, _ignoreAddressList);
+                            _broadcastPort, _autoBeaconAddressList, _beaconAddressList, _ignoreAddressList,
+                            _udpReceiveThreads);
 
     _beaconEmitter.reset(new BeaconEmitter("tcp", _broadcastTransport, thisServerContext));
 
@@ -459,6 +484,203 @@ void ServerContextImpl::printInfo(ostream& str, int lvl)
     }
 }
 
+namespace {
+
+struct ConnectionCounters {
+    std::string name;
+    size_t bytesRx, bytesTx, messagesRx, messagesTx, queued;
+};
+
+void collectConnections(TransportRegistry& registry, std::vector<ConnectionCounters>& out)
+{
+    TransportRegistry::transportVector_t transports;
+    registry.toArray(transports);
+
+    out.reserve(transports.size());
+    for(TransportRegistry::transportVector_t::const_iterator it(transports.begin()), end(transports.end());
+        it!=end; ++it)
+    {
+        const detail::AbstractCodec *codec = dynamic_cast<const detail::AbstractCodec*>(it->get());
+        if(!codec)
+            continue;
+        const detail::TransportStats& stats = codec->getStats();
+
+        ConnectionCounters C;
+        C.name = (*it)->getType()+"://"+(*it)->getRemoteName();
+        C.bytesRx = epics::atomic::get(stats.bytesRx);
+        C.bytesTx = epics::atomic::get(stats.bytesTx);
+        C.messagesRx = epics::atomic::get(stats.messagesRx);
+        C.messagesTx = epics::atomic::get(stats.messagesTx);
+        C.queued = codec->sendQueueSize();
+        out.push_back(C);
+    }
+}
+
+struct CommandCounters {
+    const char *name;
+    size_t messages, bytes;
+    std::vector<size_t> latency;
+};
+
+// commands received at least once
+void collectCommands(const ResponseHandler::shared_pointer& handler, std::vector<CommandCounters>& out)
+{
+    const ServerResponseHandler *H = dynamic_cast<const ServerResponseHandler*>(handler.get());
+    if(!H)
+        return;
+
+    for(size_t i=0, N=H->commandCount(); i<N; i++) {
+        const detail::CommandStats& stats = H->getCommandStats(i);
+
+        CommandCounters C;
+        C.messages = epics::atomic::get(stats.messages);
+        if(C.messages==0u)
+            continue;
+        C.name = detail::commandName(int(i));
+        C.bytes = epics::atomic::get(stats.bytes);
+        stats.latency.snapshot(C.latency);
+        out.push_back(C);
+    }
+}
+
+const StructureConstPtr statsType(getFieldCreate()->createFieldBuilder()
+                                   ->addNestedStructure("commands")
+                                       ->addArray("name", pvString)
+                                       ->addArray("messages", pvULong)
+                                       ->addArray("bytes", pvULong)
+                                       ->addArray("p50", pvDouble)
+                                       ->addArray("p99", pvDouble)
+                                       ->addArray("max", pvDouble)
+                                   ->endNested()
+                                   ->addNestedStructure("connections")
+                                       ->addArray("name", pvString)
+                                       ->addArray("messagesRx", pvULong)
+                                       ->addArray("bytesRx", pvULong)
+                                       ->addArray("messagesTx", pvULong)
+                                       ->addArray("bytesTx", pvULong)
+                                       ->addArray("queued", pvULong)
+                                   ->endNested()
+                                   ->createStructure());
+
+// microseconds
+double latencyUS(const std::vector<size_t>& counts, double p)
+{
+    return detail::LatencyHistogram::percentile(counts, p)*1e-3;
+}
+
+} // namespace
+
+void ServerContextImpl::printStats(ostream& str, int lvl)
+{
+    ResponseHandler::shared_pointer handler;
+    {
+        Lock guard(_mutex);
+        handler = _responseHandler;
+    }
+
+    std::vector<CommandCounters> commands;
+    collectCommands(handler, commands);
+
+    str<<"Commands:\n"
+       <<"  "<<std::left<<std::setw(22)<<"command"<<std::right
+       <<std::setw(12)<<"messages"<<std::setw(14)<<"bytes";
+    if(_handlerTiming)
+        str<<std::setw(10)<<"p50_us"<<std::setw(10)<<"p99_us"<<std::setw(10)<<"max_us";
+    str<<"\n";
+
+    for(size_t i=0; i<commands.size(); i++) {
+        const CommandCounters& C = commands[i];
+        str<<"  "<<std::left<<std::setw(22)<<C.name<<std::right
+           <<std::setw(12)<<C.messages<<std::setw(14)<<C.bytes;
+        if(_handlerTiming) {
+            std::ios_base::fmtflags flags(str.flags());
+            std::streamsize prec(str.precision());
+            str<<std::fixed<<std::setprecision(1)
+               <<std::setw(10)<<latencyUS(C.latency, 0.5)
+               <<std::setw(10)<<latencyUS(C.latency, 0.99)
+               <<std::setw(10)<<latencyUS(C.latency, 1.0);
+            str.flags(flags);
+            str.precision(prec);
+        }
+        str<<"\n";
+    }
+
+    if(lvl<1)
+        return;
+
+    std::vector<ConnectionCounters> conns;
+    collectConnections(_transportRegistry, conns);
+
+    str<<"Connections:\n";
+    for(size_t i=0; i<conns.size(); i++) {
+        const ConnectionCounters& C = conns[i];
+        str<<"  "<<C.name
+           <<" rx "<<C.messagesRx<<" msg "<<C.bytesRx<<" B"
+           <<" tx "<<C.messagesTx<<" msg "<<C.bytesTx<<" B"
+           <<" queued "<<C.queued<<"\n";
+    }
+}
+
+PVStructure::shared_pointer ServerContextImpl::getStats()
+{
+    ResponseHandler::shared_pointer handler;
+    {
+        Lock guard(_mutex);
+        handler = _responseHandler;
+    }
+
+    std::vector<CommandCounters> commands;
+    collectCommands(handler, commands);
+
+    std::vector<ConnectionCounters> conns;
+    collectConnections(_transportRegistry, conns);
+
+    PVStructure::shared_pointer ret(getPVDataCreate()->createPVStructure(statsType));
+
+    {
+        const size_t N = commands.size();
+        PVStringArray::svector name(N);
+        PVULongArray::svector messages(N), bytes(N);
+        PVDoubleArray::svector p50(N), p99(N), pmax(N);
+        for(size_t i=0; i<N; i++) {
+            name[i] = commands[i].name;
+            messages[i] = commands[i].messages;
+            bytes[i] = commands[i].bytes;
+            // seconds.  zero if timing disabled
+            p50[i] = latencyUS(commands[i].latency, 0.5)*1e-6;
+            p99[i] = latencyUS(commands[i].latency, 0.99)*1e-6;
+            pmax[i] = latencyUS(commands[i].latency, 1.0)*1e-6;
+        }
+        ret->getSubFieldT<PVStringArray>("commands.name")->replace(freeze(name));
+        ret->getSubFieldT<PVULongArray>("commands.messages")->replace(freeze(messages));
+        ret->getSubFieldT<PVULongArray>("commands.bytes")->replace(freeze(bytes));
+        ret->getSubFieldT<PVDoubleArray>("commands.p50")->replace(freeze(p50));
+        ret->getSubFieldT<PVDoubleArray>("commands.p99")->replace(freeze(p99));
+        ret->getSubFieldT<PVDoubleArray>("commands.max")->replace(freeze(pmax));
+    }
+    {
+        const size_t N = conns.size();
+        PVStringArray::svector name(N);
+        PVULongArray::svector messagesRx(N), bytesRx(N), messagesTx(N), bytesTx(N), queued(N);
+        for(size_t i=0; i<N; i++) {
+            name[i] = conns[i].name;
+            messagesRx[i] = conns[i].messagesRx;
+            bytesRx[i] = conns[i].bytesRx;
+            messagesTx[i] = conns[i].messagesTx;
+            bytesTx[i] = conns[i].bytesTx;
+            queued[i] = conns[i].queued;
+        }
+        ret->getSubFieldT<PVStringArray>("connections.name")->replace(freeze(name));
+        ret->getSubFieldT<PVULongArray>("connections.messagesRx")->replace(freeze(messagesRx));
+        ret->getSubFieldT<PVULongArray>("connections.bytesRx")->replace(freeze(bytesRx));
+        ret->getSubFieldT<PVULongArray>("connections.messagesTx")->replace(freeze(messagesTx));
+        ret->getSubFieldT<PVULongArray>("connections.bytesTx")->replace(freeze(bytesTx));
+        ret->getSubFieldT<PVULongArray>("connections.queued")->replace(freeze(queued));
+    }
+
+    return ret;
+}
+
 void ServerContextImpl::setBeaconServerStatusProvider(BeaconServerStatusProvider::shared_pointer const & beaconServerStatusProvider)
 {
     _beaconServerStatusProvider = beaconServerStatusProvider;
@@ -523,6 +745,46 @@ const std::vector<ChannelProvider::shared_pointer>& ServerContextImpl::getChanne
     return _channelProviders;
 }
 
+namespace {
+// bound memory used by a storm of searches for distinct names
+const size_t maxUnclaimedNames = 100000u;
+}
+
+bool ServerContextImpl::isUnclaimedName(const std::string& name)
+{
+    if(_searchNegativeTTL <= 0.0)
+        return false;
+
+    epicsTimeStamp now;
+    epicsTimeGetCurrent(&now);
+
+    Lock guard(_unclaimedNamesMutex);
+    epicsTimeStamp *expires = _unclaimedNames.find(name);
+    if(!expires)
+        return false;
+    else if(epicsTimeLessThan(expires, &now)) {
+        _unclaimedNames.erase(name);
+        return false;
+    }
+    return true;
+}
+
+void ServerContextImpl::unclaimedName(const std::string& name)
+{
+    if(_searchNegativeTTL <= 0.0)
+        return;
+
+    epicsTimeStamp expires;
+    epicsTimeGetCurrent(&expires);
+    epicsTimeAddSeconds(&expires, _searchNegativeTTL);
+
+    Lock guard(_unclaimedNamesMutex);
+    if(_unclaimedNames.size() >= maxUnclaimedNames)
+        _unclaimedNames.clear();
+    if(!_unclaimedNames.insert(name, expires))
+        *_unclaimedNames.find(name) = expires;
+}
+
 Timer::shared_pointer ServerContextImpl::getTimer()
 {
     return _timer;
@@ -226,6 +226,7 @@ pva::Monitor::shared_pointer SharedChannel::createMonitor(
 
         } else {
             owner->monitors.push_back(ret.get());
+            owner->monitorsChanged = true;
             notify = !!owner->type;
             if(notify) {
                 ret->open(owner->type);
@@ -267,6 +268,7 @@ SharedMonitorFIFO::~SharedMonitorFIFO()
 {
     Guard G(channel->owner->mutex);
     channel->owner->monitors.remove(this);
+    channel->owner->monitorsChanged = true;
 }
 
 } // namespace detail
@@ -85,6 +85,7 @@ SharedPV::shared_pointer SharedPV::buildMailbox(pvas::SharedPV::Config *conf)
 SharedPV::SharedPV(const std::tr1::shared_ptr<Handler> &handler, pvas::SharedPV::Config *conf)
     :config(conf ? *conf : Config())
     ,handler(handler)
+    ,monitorsChanged(false)
     ,notifiedConn(false)
     ,debugLvl(0)
 {
@@ -148,6 +149,7 @@ void SharedPV::open(const pvd::PVStructure &value, const epics::pvData::BitSet&
     xmonitors_t p_monitor;
     xgetfields_t p_getfield;
     {
+        Guard P(postMutex);
         Guard I(mutex);
 
         if(type)
@@ -244,6 +246,7 @@ void SharedPV::close(bool destroy)
     xchannels_t p_channel;
     Handler::shared_pointer p_handler;
     {
+        Guard P(postMutex);
         Guard I(mutex);
 
         FOR_EACH(rpcs_t::const_iterator, it, end, rpcs) {
@@ -284,6 +287,7 @@ void SharedPV::close(bool destroy)
             puts.clear();
             rpcs.clear();
             monitors.clear();
+            monitorsChanged = true;
             if(!channels.empty() && notifiedConn) {
                 p_handler = handler;
                 notifiedConn = false;
@@ -325,23 +329,45 @@ void SharedPV::post(const pvd::PVStructure& value,
     typedef std::vector<std::tr1::shared_ptr<pva::MonitorFIFO> > xmonitors_t;
     xmonitors_t p_monitor;
     {
-        Guard I(mutex);
+        // Order of updates is kept by postMutex.  The PV mutex is only held to update 'current',
+        // so Get, Put, and new subscriptions are not delayed by a post() to many subscribers.
+        Guard P(postMutex);
+        {
+            Guard I(mutex);
+
+            if(!type)
+                throw std::logic_error("Not open()");
+            else if(*type!=*value.getStructure())
+                throw std::logic_error("Type mis-match");
+
+            if(current) {
+                current->copyUnchecked(value, changed);
+                valid |= changed;
+            }
 
-        if(!type)
-            throw std::logic_error("Not open()");
-        else if(*type!=*value.getStructure())
-            throw std::logic_error("Type mis-match");
+            if(monitorsChanged) {
+                monitorsChanged = false;
+                fanout.clear();
+                fanout.reserve(monitors.size());
 
-        if(current) {
-            current->copyUnchecked(value, changed);
-            valid |= changed;
+                FOR_EACH(monitors_t::const_iterator, it, end, monitors) {
+                    try {
+                        fanout.push_back((*it)->shared_from_this());
+                    }catch(std::tr1::bad_weak_ptr&) { /* ignore, racing dtor */ }
+                }
+            }
         }
 
-        p_monitor.reserve(monitors.size()); // ick, for lack of a list with thread-safe iteration
+        p_monitor.reserve(fanout.size());
 
-        FOR_EACH(monitors_t::const_iterator, it, end, monitors) {
-            (*it)->post(value, changed);
-            p_monitor.push_back((*it)->shared_from_this());
+        // a subscription added since the snapshot was refreshed above has received
+        // an initial update which includes this one.
+        FOR_EACH(fanout_t::const_iterator, it, end, fanout) {
+            std::tr1::shared_ptr<pva::MonitorFIFO> mon(it->lock());
+            if(!mon)
+                continue;
+            mon->post(value, changed);
+            p_monitor.push_back(mon);
         }
     }
     FOR_EACH(xmonitors_t::iterator, it, end, p_monitor) {
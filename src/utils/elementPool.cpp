@@ -0,0 +1,162 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <epicsThread.h>
+
+#include <pv/pvData.h>
+
+#define epicsExportSharedSymbols
+#include <pv/elementPool.h>
+#include <pv/configuration.h>
+
+namespace pvd = epics::pvData;
+
+typedef epicsGuard<epicsMutex> Guard;
+
+namespace epics {
+namespace pvAccess {
+namespace detail {
+
+namespace {
+ElementPool* pool;
+epicsThreadOnceId poolOnce = EPICS_THREAD_ONCE_INIT;
+} // namespace
+
+void ElementPool::onceInit(void *)
+{
+    // never free'd, as MonitorFIFOs may be destroyed during process exit
+    pool = new ElementPool;
+}
+
+ElementPool& ElementPool::instance()
+{
+    epicsThreadOnce(&poolOnce, &ElementPool::onceInit, 0);
+    return *pool;
+}
+
+ElementPool::ElementPool()
+    :_limit(0u)
+    ,_size(0u)
+    ,_tick(0u)
+    ,_reused(0u)
+    ,_missed(0u)
+    ,_discarded(0u)
+{
+    Configuration::const_shared_pointer env(ConfigurationBuilder().push_env().build());
+    pvd::int32 limit = env->getPropertyAsInteger("EPICS_PVA_MONITOR_POOL_SIZE", 0);
+    if(limit > 0)
+        _limit = size_t(limit);
+}
+
+MonitorElementPtr ElementPool::get(const pvd::StructureConstPtr& type)
+{
+    MonitorElementPtr ret;
+    pvd::PVStructure::const_shared_pointer initial;
+
+    {
+        Guard G(mutex);
+
+        entries_t::iterator it(entries.find(type.get()));
+        if(it==entries.end()) {
+            _missed++;
+            return ret;
+        }
+
+        Entry& entry = it->second;
+        ret.swap(entry.elements.back());
+        entry.elements.pop_back();
+        entry.lastUsed = ++_tick;
+        _size--;
+        _reused++;
+        initial = entry.initial;
+
+        if(entry.elements.empty())
+            entries.erase(it);
+    }
+
+    // forget values of the previous user, whose subscription may be to another PV.
+    // A new subscriber may only receive some fields in its first update.
+    ret->pvStructurePtr->copyUnchecked(*initial);
+    ret->changedBitSet->clear();
+    ret->overrunBitSet->clear();
+    return ret;
+}
+
+void ElementPool::putLocked(MonitorElementPtr& elem)
+{
+    if(!elem)
+        return;
+
+    if(_limit==0u || !elem.unique()) {
+        elem.reset();
+        _discarded++;
+        return;
+    }
+
+    if(_size >= _limit)
+        trimLocked(_limit-1u);
+
+    const pvd::StructureConstPtr& type(elem->pvStructurePtr->getStructure());
+    Entry& entry = entries[type.get()];
+    if(!entry.initial)
+        entry.initial = pvd::getPVDataCreate()->createPVStructure(type);
+    entry.lastUsed = ++_tick;
+    entry.elements.push_back(MonitorElementPtr());
+    entry.elements.back().swap(elem);
+    _size++;
+}
+
+// discard elements of the least recently used type(s) until _size<=target
+void ElementPool::trimLocked(size_t target)
+{
+    while(_size > target) {
+        entries_t::iterator oldest(entries.begin());
+        for(entries_t::iterator it(entries.begin()), end(entries.end()); it!=end; ++it) {
+            if(it->second.lastUsed < oldest->second.lastUsed)
+                oldest = it;
+        }
+
+        std::vector<MonitorElementPtr>& elements = oldest->second.elements;
+        while(_size > target && !elements.empty()) {
+            elements.pop_back();
+            _size--;
+            _discarded++;
+        }
+        if(elements.empty())
+            entries.erase(oldest);
+    }
+}
+
+size_t ElementPool::limit() const
+{
+    Guard G(mutex);
+    return _limit;
+}
+
+void ElementPool::setLimit(size_t limit)
+{
+    Guard G(mutex);
+    _limit = limit;
+    trimLocked(limit);
+}
+
+void ElementPool::clear()
+{
+    Guard G(mutex);
+    trimLocked(0u);
+}
+
+void ElementPool::getStats(Stats& s) const
+{
+    Guard G(mutex);
+    s.pooled = _size;
+    s.types = entries.size();
+    s.reused = _reused;
+    s.missed = _missed;
+    s.discarded = _discarded;
+}
+
+}}} // namespace epics::pvAccess::detail
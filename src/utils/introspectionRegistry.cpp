@@ -34,13 +34,17 @@ void IntrospectionRegistry::reset()
 {
     _pointer = 1;
     _registry.clear();
+    _byInstance.clear();
+    _aliases.clear();
+    _aliasOrder.clear();
+    _byHash.clear();
 }
 
 int16 IntrospectionRegistry::registerIntrospectionInterface(FieldConstPtr const & field, bool& existing)
 {
     int16 key;
-    // TODO this is slow
-    if(registryContainsValue(field, key))
+    size_t hash;
+    if(registryContainsValue(field, key, hash))
     {
         existing = true;
     }
@@ -48,25 +52,143 @@ int16 IntrospectionRegistry::registerIntrospectionInterface(FieldConstPtr const
     {
         existing = false;
         key = _pointer++;
-        _registry[key] = field;
+
+        std::pair<registryMap_t::iterator, bool> ins(_registry.insert(std::make_pair(key, field)));
+        if(ins.second)
+        {
+            _byInstance[field.get()] = std::make_pair(field, key);
+            _byHash.insert(std::make_pair(hash, key));
+        }
+        else
+        {
+            // IDs have wrapped around, replacing an earlier registration
+            ins.first->second = field;
+            reindex();
+        }
     }
     return key;
 }
 
-// TODO slow !!!!
-bool IntrospectionRegistry::registryContainsValue(FieldConstPtr const & field, int16& key)
+bool IntrospectionRegistry::registryContainsValue(FieldConstPtr const & field, int16& key, size_t& hash)
 {
-    for(registryMap_t::reverse_iterator registryRIter = _registry.rbegin(); registryRIter != _registry.rend(); registryRIter++)
+    instanceMap_t::const_iterator inst(_byInstance.find(field.get()));
+    if(inst != _byInstance.end())
+    {
+        key = inst->second.second;
+        return true;
+    }
+
+    aliasMap_t::iterator alias(_aliases.find(field.get()));
+    if(alias != _aliases.end())
+    {
+        // an expired entry is for an earlier Field at the same address
+        if(alias->second.first.lock() == field)
+        {
+            key = alias->second.second;
+            return true;
+        }
+        _aliases.erase(alias);
+    }
+
+    hash = hashField(*field);
+
+    for(hashMap_t::const_iterator it(_byHash.lower_bound(hash)), end(_byHash.upper_bound(hash)); it != end; ++it)
     {
-        if(*(field.get()) == *(registryRIter->second))
+        registryMap_t::const_iterator registryIter(_registry.find(it->second));
+        if(registryIter != _registry.end() && *field == *registryIter->second)
         {
-            key = registryRIter->first;
+            key = it->second;
+            // another instance of an equal Field.  find it directly next time.
+            if(_aliasOrder.size() >= maxAliases)
+            {
+                _aliases.erase(_aliasOrder.front());
+                _aliasOrder.pop_front();
+            }
+            _aliases[field.get()] = std::make_pair(std::tr1::weak_ptr<const Field>(field), key);
+            _aliasOrder.push_back(field.get());
             return true;
         }
     }
     return false;
 }
 
+void IntrospectionRegistry::reindex()
+{
+    _byInstance.clear();
+    _aliases.clear();
+    _aliasOrder.clear();
+    _byHash.clear();
+
+    for(registryMap_t::const_iterator it(_registry.begin()), end(_registry.end()); it != end; ++it)
+    {
+        _byInstance[it->second.get()] = std::make_pair(it->second, it->first);
+        _byHash.insert(std::make_pair(hashField(*it->second), it->first));
+    }
+}
+
+namespace {
+// FNV-1a
+void hashBytes(size_t& hash, const std::string& str)
+{
+    for(size_t i=0, N=str.size(); i<N; i++) {
+        hash ^= (unsigned char)str[i];
+        hash *= size_t(16777619u);
+    }
+    // separate consecutive strings
+    hash ^= 0xffu;
+    hash *= size_t(16777619u);
+}
+
+void hashValue(size_t& hash, size_t value)
+{
+    for(size_t i=0; i<sizeof(value); i++, value >>= 8) {
+        hash ^= (value&0xffu);
+        hash *= size_t(16777619u);
+    }
+}
+
+void hashMembers(size_t& hash, const StringArray& names, const FieldConstPtrArray& fields, size_t (*hashField)(const Field&))
+{
+    hashValue(hash, fields.size());
+    for(size_t i=0, N=fields.size(); i<N; i++) {
+        hashBytes(hash, names[i]);
+        hashValue(hash, hashField(*fields[i]));
+    }
+}
+} // namespace
+
+size_t IntrospectionRegistry::hashField(const Field& field)
+{
+    size_t hash = size_t(2166136261u);
+    hashValue(hash, field.getType());
+    // includes scalar type, and bounds
+    hashBytes(hash, field.getID());
+
+    switch(field.getType()) {
+    case structure:
+    {
+        const Structure& S = static_cast<const Structure&>(field);
+        hashMembers(hash, S.getFieldNames(), S.getFields(), &hashField);
+        break;
+    }
+    case union_:
+    {
+        const Union& U = static_cast<const Union&>(field);
+        hashMembers(hash, U.getFieldNames(), U.getFields(), &hashField);
+        break;
+    }
+    case structureArray:
+        hashValue(hash, hashField(*static_cast<const StructureArray&>(field).getStructure()));
+        break;
+    case unionArray:
+        hashValue(hash, hashField(*static_cast<const UnionArray&>(field).getUnion()));
+        break;
+    default:
+        break;
+    }
+    return hash;
+}
+
 void IntrospectionRegistry::serialize(FieldConstPtr const & field, ByteBuffer* buffer, SerializableControl* control)
 {
     if (field.get() == NULL)
@@ -0,0 +1,193 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <algorithm>
+
+#include <string.h>
+
+#include <epicsTypes.h>
+
+#define epicsExportSharedSymbols
+#include <pv/lzBlock.h>
+
+namespace epics {
+namespace pvAccess {
+namespace detail {
+
+namespace {
+
+const unsigned hashLog = 12u;
+const size_t minMatch = 4u;
+const size_t maxOffset = 0xffffu;
+// as LZ4, the last match starts at least 12 bytes before the end, and the last 5 bytes are literals.
+const size_t matchLimit = 12u;
+const size_t lastLiterals = 5u;
+
+inline epicsUInt32 read32(const char *p)
+{
+    epicsUInt32 ret;
+    memcpy(&ret, p, 4u);
+    return ret;
+}
+
+inline unsigned hash(epicsUInt32 seq)
+{
+    return (seq*2654435761u)>>(32u-hashLog);
+}
+
+// bytes needed to encode a length with a 4 bit field
+inline size_t lengthBytes(size_t len)
+{
+    return len<15u ? 0u : 1u + (len-15u)/255u;
+}
+
+inline char* putLength(char *op, size_t len)
+{
+    for(len -= 15u; len>=255u; len -= 255u)
+        *op++ = char(255u);
+    *op++ = char(len);
+    return op;
+}
+
+} // namespace
+
+size_t lzCompress(const char *src, size_t count, char *dst, size_t capacity)
+{
+    // positions+1, 0 is empty
+    epicsUInt32 table[1u<<hashLog];
+    memset(table, 0, sizeof(table));
+
+    char *op = dst;
+    char * const oend = dst + capacity;
+
+    size_t anchor = 0u, ip = 0u;
+
+    if(count > matchLimit) {
+        const size_t limit = count - matchLimit;
+        unsigned misses = 0u;
+
+        while(ip < limit) {
+            epicsUInt32 seq = read32(src+ip);
+            unsigned h = hash(seq);
+            size_t ref = table[h];
+            table[h] = epicsUInt32(ip+1u);
+
+            if(ref==0u || ip - (ref-1u) > maxOffset || read32(src+ref-1u)!=seq) {
+                // skip faster through incompressible data
+                ip += 1u + (misses++>>6u);
+                continue;
+            }
+            ref--;
+            misses = 0u;
+
+            size_t mlen = minMatch;
+            while(ip+mlen < count-lastLiterals && src[ref+mlen]==src[ip+mlen])
+                mlen++;
+
+            size_t nlit = ip - anchor;
+            size_t need = 1u + lengthBytes(nlit) + nlit + 2u + lengthBytes(mlen-minMatch);
+            if(need > size_t(oend-op))
+                return 0u;
+
+            char *token = op++;
+            *token = char((nlit<15u ? nlit : 15u)<<4u);
+            if(nlit>=15u)
+                op = putLength(op, nlit);
+            memcpy(op, src+anchor, nlit);
+            op += nlit;
+
+            size_t offset = ip - ref;
+            *op++ = char(offset&0xff);
+            *op++ = char(offset>>8u);
+
+            *token |= char(mlen-minMatch<15u ? mlen-minMatch : 15u);
+            if(mlen-minMatch>=15u)
+                op = putLength(op, mlen-minMatch);
+
+            ip += mlen;
+            anchor = ip;
+        }
+    }
+
+    // last literals
+    size_t nlit = count - anchor;
+    if(1u + lengthBytes(nlit) + nlit > size_t(oend-op))
+        return 0u;
+
+    *op++ = char((nlit<15u ? nlit : 15u)<<4u);
+    if(nlit>=15u)
+        op = putLength(op, nlit);
+    memcpy(op, src+anchor, nlit);
+    op += nlit;
+
+    return op - dst;
+}
+
+bool lzDecompress(const char *src, size_t count, char *dst, size_t expect)
+{
+    const unsigned char *ip = reinterpret_cast<const unsigned char*>(src);
+    const unsigned char * const iend = ip + count;
+    size_t op = 0u;
+
+    while(ip < iend) {
+        unsigned token = *ip++;
+
+        size_t nlit = token>>4u;
+        if(nlit==15u) {
+            unsigned b;
+            do {
+                if(ip==iend)
+                    return false;
+                b = *ip++;
+                nlit += b;
+            } while(b==255u);
+        }
+        if(nlit > size_t(iend-ip) || nlit > expect-op)
+            return false;
+        memcpy(dst+op, ip, nlit);
+        ip += nlit;
+        op += nlit;
+
+        if(ip==iend)
+            break; // last sequence has no match
+
+        if(iend-ip < 2)
+            return false;
+        size_t offset = ip[0] | (size_t(ip[1])<<8u);
+        ip += 2;
+        if(offset==0u || offset > op)
+            return false;
+
+        size_t mlen = token&0xfu;
+        if(mlen==15u) {
+            unsigned b;
+            do {
+                if(ip==iend)
+                    return false;
+                b = *ip++;
+                mlen += b;
+            } while(b==255u);
+        }
+        mlen += minMatch;
+        if(mlen > expect-op)
+            return false;
+
+        const char *ref = dst + op - offset;
+        char *out = dst + op;
+        // when overlapping (eg. a run of one byte) copy whole repetitions,
+        // doubling each time.
+        for(size_t done=0u; done<mlen;) {
+            size_t n = std::min(offset+done, mlen-done);
+            memcpy(out+done, ref, n);
+            done += n;
+        }
+        op += mlen;
+    }
+
+    return op==expect;
+}
+
+}}} // namespace epics::pvAccess::detail
@@ -0,0 +1,120 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#ifndef ELEMENTPOOL_H
+#define ELEMENTPOOL_H
+
+#include <map>
+#include <vector>
+
+#ifdef epicsExportSharedSymbols
+#   define elementPoolEpicsExportSharedSymbols
+#   undef epicsExportSharedSymbols
+#endif
+
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+#include <pv/pvIntrospect.h>
+#include <pv/pvData.h>
+#include <pv/sharedPtr.h>
+
+#ifdef elementPoolEpicsExportSharedSymbols
+#   define epicsExportSharedSymbols
+#	undef elementPoolEpicsExportSharedSymbols
+#endif
+
+#include <pv/monitor.h>
+
+#include <shareLib.h>
+
+namespace epics {
+namespace pvAccess {
+namespace detail {
+
+/** Process wide free list of MonitorElement s, by type.
+ *
+ * Elements of a monitor queue which is closed, re-opened, or destroyed
+ * are kept for the next queue opened with the same Structure (instance),
+ * saving allocation of a PVStructure and two BitSets for each.
+ *
+ * A recycled element has cleared BitSets, and default field values,
+ * as if newly constructed.  So an element last used for one PV does
+ * not carry its values into a subscription to another PV of the same type.
+ *
+ * Holds at most limit() elements.  When full, elements of the least recently
+ * used type are discarded first.  The initial limit is taken from
+ * $EPICS_PVA_MONITOR_POOL_SIZE , default 0 which disables pooling.
+ */
+class epicsShareClass ElementPool {
+    EPICS_NOT_COPYABLE(ElementPool)
+public:
+    static ElementPool& instance();
+
+    struct Stats {
+        size_t pooled;    //!< # of elements currently held
+        size_t types;     //!< # of distinct types held
+        size_t reused;    //!< # of get() which returned an element
+        size_t missed;    //!< # of get() which returned NULL
+        size_t discarded; //!< # of elements put() but not kept
+    };
+
+    /** Take an element of the given type
+     * @returns NULL if none available, caller should construct a new element.
+     */
+    MonitorElementPtr get(const epics::pvData::StructureConstPtr& type);
+
+    /** Hand an element over for re-use.
+     * Only taken if there are no other references to elem.
+     * elem is always reset().
+     */
+    void put(MonitorElementPtr& elem)
+    {
+        epicsGuard<epicsMutex> G(mutex);
+        putLocked(elem);
+    }
+
+    //! put() each of a sequence of MonitorElementPtr
+    template<typename Iter>
+    void put(Iter begin, Iter end)
+    {
+        epicsGuard<epicsMutex> G(mutex);
+        for(; begin!=end; ++begin)
+            putLocked(*begin);
+    }
+
+    size_t limit() const;
+    //! Change the limit.  Discards elements if necessary.  0 disables pooling.
+    void setLimit(size_t limit);
+    //! Discard all elements
+    void clear();
+
+    void getStats(Stats& s) const;
+
+private:
+    ElementPool();
+    static void onceInit(void *);
+
+    void putLocked(MonitorElementPtr& elem);
+    void trimLocked(size_t target);
+
+    struct Entry {
+        // default values, copied into each element taken.  Also keeps the type alive while pooled
+        epics::pvData::PVStructure::const_shared_pointer initial;
+        std::vector<MonitorElementPtr> elements;
+        size_t lastUsed;
+        Entry() :lastUsed(0u) {}
+    };
+    typedef std::map<const epics::pvData::Structure*, Entry> entries_t;
+
+    mutable epicsMutex mutex;
+    entries_t entries;
+    size_t _limit, _size, _tick;
+    size_t _reused, _missed, _discarded;
+};
+
+}}} // namespace epics::pvAccess::detail
+
+#endif // ELEMENTPOOL_H
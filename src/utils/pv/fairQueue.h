@@ -137,6 +137,11 @@ public:
         return ellFirst(&list)==NULL;
     }
 
+    size_t size() const {
+        guard_t G(mutex);
+        return size_t(ellCount(&list));
+    }
+
     void push_back(const value_type& ent)
     {
         bool wake;
@@ -8,6 +8,7 @@
 #define INTROSPECTIONREGISTRY_H
 
 #include <map>
+#include <deque>
 #include <iostream>
 
 #ifdef epicsExportSharedSymbols
@@ -58,8 +59,6 @@ private:
      * Registers introspection interface and get it's ID. Always OUTGOING.
      * If it is already registered only preassigned ID is returned.
      *
-     * TODO !!!!!!this can get very slow in large maps. We need to change this !!!!!!
-     *
      * @param field introspection interface to register
      *
      * @return id of given introspection interface
@@ -106,12 +105,41 @@ private:
     registryMap_t _registry;
     epics::pvData::int16 _pointer;
 
+    /**
+     * Index of outgoing registrations by Field instance.
+     * Holds a reference, so an indexed address is not re-used by another Field.
+     */
+    typedef std::map<const epics::pvData::Field*, std::pair<epics::pvData::FieldConstPtr, epics::pvData::int16> > instanceMap_t;
+    instanceMap_t _byInstance;
+
+    /**
+     * Recently seen instances equal to a registered Field, but not registered themselves.
+     * Does not keep these Fields alive.  At most maxAliases entries, the oldest are dropped.
+     */
+    typedef std::map<const epics::pvData::Field*, std::pair<std::tr1::weak_ptr<const epics::pvData::Field>, epics::pvData::int16> > aliasMap_t;
+    aliasMap_t _aliases;
+    std::deque<const epics::pvData::Field*> _aliasOrder;
+    static const size_t maxAliases = 16u;
+
+    /**
+     * Index of outgoing registrations by structural hash, for equal Fields which are different instances.
+     */
+    typedef std::multimap<size_t, epics::pvData::int16> hashMap_t;
+    hashMap_t _byHash;
+
     /**
      * Field factory.
      */
     static epics::pvData::FieldCreatePtr _fieldCreate;
 
-    bool registryContainsValue(epics::pvData::FieldConstPtr const & field, epics::pvData::int16& key);
+    bool registryContainsValue(epics::pvData::FieldConstPtr const & field, epics::pvData::int16& key, size_t& hash);
+
+    void reindex();
+
+    /**
+     * Hash of what is compared by Field equality.
+     */
+    static size_t hashField(const epics::pvData::Field& field);
 };
 
 }
@@ -0,0 +1,48 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#ifndef LZBLOCK_H
+#define LZBLOCK_H
+
+#include <stddef.h>
+
+#include <shareLib.h>
+
+namespace epics {
+namespace pvAccess {
+namespace detail {
+
+/** Compress a block of bytes, in the LZ4 block format.
+ *
+ * A fast, byte oriented, LZ77 with a 64KB window.  Intended for
+ * data with long runs (eg. image background, or slowly changing values),
+ * not for best ratio.
+ *
+ * @param src Input bytes
+ * @param count Number of input bytes
+ * @param dst Output buffer
+ * @param capacity Size of 'dst'
+ * @returns Number of bytes written to 'dst', or 0 if the result would not fit in 'capacity'.
+ */
+epicsShareFunc
+size_t lzCompress(const char *src, size_t count, char *dst, size_t capacity);
+
+/** Decompress a block written by lzCompress().
+ *
+ * Never reads or writes outside of the given buffers, whatever the input.
+ *
+ * @param src Compressed bytes
+ * @param count Number of compressed bytes
+ * @param dst Output buffer
+ * @param expect Size of the decompressed block.  'dst' must have room for this many bytes.
+ * @returns true if the input was valid and decompressed to exactly 'expect' bytes.
+ */
+epicsShareFunc
+bool lzDecompress(const char *src, size_t count, char *dst, size_t expect);
+
+}}} // namespace epics::pvAccess::detail
+
+#endif // LZBLOCK_H
@@ -0,0 +1,169 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#ifndef NAMEINDEX_H
+#define NAMEINDEX_H
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+namespace epics {
+namespace pvAccess {
+namespace detail {
+
+/** Hash table keyed by (channel) name.
+ *
+ * Open addressing with linear probing in a power of two sized table.
+ * The hash of each key is stored, so most mismatches are rejected
+ * without a string compare, and growing does not re-hash keys.
+ *
+ * Not thread safe.  Pointers returned by find() are invalidated
+ * by insert() and erase().
+ */
+template<typename V>
+class NameIndex
+{
+public:
+    typedef V value_type;
+
+    NameIndex() :_used(0u), _deleted(0u) {}
+
+    //! FNV-1a
+    static size_t hash(const std::string& key)
+    {
+        size_t h = size_t(2166136261u);
+        for(size_t i=0, N=key.size(); i<N; i++) {
+            h ^= (unsigned char)key[i];
+            h *= size_t(16777619u);
+        }
+        return h;
+    }
+
+    size_t size() const { return _used; }
+    bool empty() const { return _used==0u; }
+
+    void clear()
+    {
+        std::vector<Slot> empty;
+        _slots.swap(empty);
+        _used = _deleted = 0u;
+    }
+
+    //! @returns The value for key, or NULL
+    V* find(const std::string& key)
+    {
+        size_t idx = lookup(key, hash(key));
+        return idx==npos ? 0 : &_slots[idx].value;
+    }
+
+    //! @returns false, with no change, if key is already present
+    bool insert(const std::string& key, const V& value)
+    {
+        const size_t h = hash(key);
+        if(lookup(key, h)!=npos)
+            return false;
+
+        // keep load (including tombstones) below 3/4
+        if(4u*(_used+_deleted+1u) > 3u*_slots.size())
+            rehash();
+
+        const size_t mask = _slots.size()-1u;
+        size_t idx = h&mask;
+        while(_slots[idx].state==Used)
+            idx = (idx+1u)&mask;
+
+        Slot& slot = _slots[idx];
+        if(slot.state==Deleted)
+            _deleted--;
+        slot.state = Used;
+        slot.hash = h;
+        slot.key = key;
+        slot.value = value;
+        _used++;
+        return true;
+    }
+
+    //! @returns false if key was not present
+    bool erase(const std::string& key)
+    {
+        size_t idx = lookup(key, hash(key));
+        if(idx==npos)
+            return false;
+
+        Slot& slot = _slots[idx];
+        slot.state = Deleted;
+        std::string().swap(slot.key);
+        slot.value = V();
+        _used--;
+        _deleted++;
+        return true;
+    }
+
+private:
+    enum state_t {Empty, Used, Deleted};
+
+    struct Slot {
+        size_t hash;
+        state_t state;
+        std::string key;
+        V value;
+        Slot() :hash(0u), state(Empty), key(), value() {}
+    };
+
+    static const size_t npos = size_t(-1);
+
+    size_t lookup(const std::string& key, size_t h) const
+    {
+        if(_slots.empty())
+            return npos;
+
+        const size_t mask = _slots.size()-1u;
+        for(size_t idx = h&mask; ; idx = (idx+1u)&mask) {
+            const Slot& slot = _slots[idx];
+            if(slot.state==Empty)
+                return npos;
+            else if(slot.state==Used && slot.hash==h && slot.key==key)
+                return idx;
+        }
+    }
+
+    // resize for the current number of entries, and discard tombstones
+    void rehash()
+    {
+        size_t capacity = 16u;
+        while(2u*(_used+1u) > capacity)
+            capacity *= 2u;
+
+        std::vector<Slot> old(capacity);
+        old.swap(_slots);
+        _deleted = 0u;
+
+        const size_t mask = capacity-1u;
+        for(size_t i=0, N=old.size(); i<N; i++) {
+            Slot& from = old[i];
+            if(from.state!=Used)
+                continue;
+
+            size_t idx = from.hash&mask;
+            while(_slots[idx].state==Used)
+                idx = (idx+1u)&mask;
+
+            Slot& to = _slots[idx];
+            to.state = Used;
+            to.hash = from.hash;
+            to.key.swap(from.key);
+            std::swap(to.value, from.value);
+        }
+    }
+
+    std::vector<Slot> _slots;
+    size_t _used, _deleted;
+};
+
+}}} // namespace epics::pvAccess::detail
+
+#endif // NAMEINDEX_H
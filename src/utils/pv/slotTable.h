@@ -0,0 +1,281 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#ifndef SLOTTABLE_H
+#define SLOTTABLE_H
+
+#include <vector>
+#include <stdexcept>
+
+#ifdef epicsExportSharedSymbols
+#   define slotTableEpicsExportSharedSymbols
+#   undef epicsExportSharedSymbols
+#endif
+
+#include <compilerDependencies.h>
+#include <epicsTypes.h>
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+#include <epicsAtomic.h>
+
+#ifdef slotTableEpicsExportSharedSymbols
+#   define epicsExportSharedSymbols
+#	undef slotTableEpicsExportSharedSymbols
+#endif
+
+namespace epics {
+namespace pvAccess {
+namespace detail {
+
+/** Table of values by 32 bit ID.  eg. client channel (CID) and request (IOID) IDs.
+ *
+ * Values are kept in a vector of slots, with a free list through the unused slots,
+ * so insert(), find(), and erase() take constant time.
+ * An ID holds the index of its slot, and a count of the times this slot has been used,
+ * so an ID is not repeated until its slot has been re-used 2047 times.
+ * The free list is first in, first out, and is not drawn from until 'minFree' slots are free
+ * (or the table is full), so a slot just freed is not immediately re-used.
+ *
+ * IDs are positive, and never 0.  The low 'shardBits' bits of each ID are the 'shard' number,
+ * so that the IDs of several tables do not overlap.
+ *
+ * Not thread safe.
+ */
+template<typename V>
+class SlotTable
+{
+public:
+    typedef V value_type;
+
+    enum {genBits = 11u, minFree = 256u};
+
+    explicit SlotTable(unsigned shard=0u, unsigned shardBits=0u)
+        :_shard(shard)
+        ,_shardBits(shardBits)
+        ,_indexBits(31u-genBits-shardBits)
+        ,_free(npos)
+        ,_freeTail(npos)
+        ,_nfree(0u)
+        ,_used(0u)
+    {
+        if(shardBits>8u || shard>>shardBits)
+            throw std::logic_error("SlotTable invalid shard");
+    }
+
+    size_t size() const { return _used; }
+    bool empty() const { return _used==0u; }
+    //! Maximum number of entries
+    size_t capacity() const { return size_t(1u)<<_indexBits; }
+
+    //! @returns A new ID for 'value', or 0 if full
+    epicsUInt32 insert(const V& value)
+    {
+        size_t idx;
+        if(_nfree>=minFree || (_nfree && _slots.size()>=capacity())) {
+            // oldest free slot
+            idx = _free;
+            _free = _slots[idx].next;
+            if(_free==npos)
+                _freeTail = npos;
+            _nfree--;
+        } else if(_slots.size() < capacity()) {
+            idx = _slots.size();
+            _slots.push_back(Slot());
+        } else {
+            return 0u;
+        }
+
+        Slot& slot = _slots[idx];
+        slot.used = true;
+        slot.value = value;
+        _used++;
+        return (slot.gen<<(_indexBits+_shardBits)) | (epicsUInt32(idx)<<_shardBits) | _shard;
+    }
+
+    //! @returns The value for id, or NULL
+    V* find(epicsUInt32 id)
+    {
+        size_t idx = lookup(id);
+        return idx==npos ? 0 : &_slots[idx].value;
+    }
+
+    //! @returns false if id was not present
+    bool erase(epicsUInt32 id)
+    {
+        size_t idx = lookup(id);
+        if(idx==npos)
+            return false;
+
+        Slot& slot = _slots[idx];
+        slot.used = false;
+        slot.value = V();
+        // generations 1 through 2**genBits-1
+        slot.gen = slot.gen==(1u<<genBits)-1u ? 1u : slot.gen+1u;
+        slot.next = npos;
+        if(_freeTail!=npos)
+            _slots[_freeTail].next = idx;
+        else
+            _free = idx;
+        _freeTail = idx;
+        _nfree++;
+        _used--;
+        return true;
+    }
+
+    //! Append all values to 'out'
+    void values(std::vector<V>& out) const
+    {
+        out.reserve(out.size()+_used);
+        for(size_t i=0, N=_slots.size(); i<N; i++) {
+            if(_slots[i].used)
+                out.push_back(_slots[i].value);
+        }
+    }
+
+    void clear()
+    {
+        std::vector<Slot> empty;
+        _slots.swap(empty);
+        _free = _freeTail = npos;
+        _nfree = 0u;
+        _used = 0u;
+    }
+
+private:
+    struct Slot {
+        V value;
+        epicsUInt32 gen;
+        size_t next; // when !used
+        bool used;
+        Slot() :value(), gen(1u), next(npos), used(false) {}
+    };
+
+    static const size_t npos = size_t(-1);
+
+    size_t lookup(epicsUInt32 id) const
+    {
+        if((id&((1u<<_shardBits)-1u))!=_shard)
+            return npos;
+        size_t idx = (id>>_shardBits)&((1u<<_indexBits)-1u);
+        if(idx>=_slots.size())
+            return npos;
+        const Slot& slot = _slots[idx];
+        if(!slot.used || slot.gen!=(id>>(_indexBits+_shardBits)))
+            return npos;
+        return idx;
+    }
+
+    epicsUInt32 _shard;
+    unsigned _shardBits, _indexBits;
+    std::vector<Slot> _slots;
+    // free list, oldest first
+    size_t _free, _freeTail, _nfree;
+    size_t _used;
+};
+
+/** Thread safe SlotTable.
+ *
+ * Entries are divided between 16 SlotTables, each with its own lock.
+ * A lookup locks only the table selected by the ID.
+ * New entries are spread across tables in turn.
+ */
+template<typename V>
+class ShardedSlotTable
+{
+    EPICS_NOT_COPYABLE(ShardedSlotTable)
+public:
+    typedef V value_type;
+    typedef epicsGuard<epicsMutex> Guard;
+
+    enum {shardBits = 4u, nShards = 1u<<shardBits};
+
+    ShardedSlotTable() :_next(0u)
+    {
+        for(unsigned i=0; i<nShards; i++)
+            _shards[i].table = SlotTable<V>(i, shardBits);
+    }
+
+    //! @returns A new ID for 'value'
+    //! @throws std::runtime_error if full
+    epicsUInt32 insert(const V& value)
+    {
+        size_t first = epicsAtomicIncrSizeT(&_next);
+        for(unsigned n=0; n<nShards; n++) {
+            Shard& shard = _shards[(first+n)%nShards];
+            Guard G(shard.lock);
+            epicsUInt32 id = shard.table.insert(value);
+            if(id)
+                return id;
+        }
+        throw std::runtime_error("No free IDs");
+    }
+
+    //! @returns The value for id, or V() if not present
+    V find(epicsUInt32 id)
+    {
+        Shard& shard = _shards[id%nShards];
+        Guard G(shard.lock);
+        V *val = shard.table.find(id);
+        return val ? *val : V();
+    }
+
+    //! Replace the value of an existing id
+    //! @returns false if id was not present
+    bool assign(epicsUInt32 id, const V& value)
+    {
+        Shard& shard = _shards[id%nShards];
+        Guard G(shard.lock);
+        V *val = shard.table.find(id);
+        if(val)
+            *val = value;
+        return !!val;
+    }
+
+    //! Remove id
+    //! @returns The value removed, or V() if id was not present
+    V erase(epicsUInt32 id)
+    {
+        Shard& shard = _shards[id%nShards];
+        Guard G(shard.lock);
+        V *val = shard.table.find(id);
+        if(!val)
+            return V();
+        V ret(*val);
+        shard.table.erase(id);
+        return ret;
+    }
+
+    size_t size()
+    {
+        size_t ret = 0u;
+        for(unsigned i=0; i<nShards; i++) {
+            Guard G(_shards[i].lock);
+            ret += _shards[i].table.size();
+        }
+        return ret;
+    }
+
+    //! Append all values to 'out'
+    void values(std::vector<V>& out)
+    {
+        for(unsigned i=0; i<nShards; i++) {
+            Guard G(_shards[i].lock);
+            _shards[i].table.values(out);
+        }
+    }
+
+private:
+    struct Shard {
+        epicsMutex lock;
+        SlotTable<V> table;
+    };
+    Shard _shards[nShards];
+    size_t _next;
+};
+
+}}} // namespace epics::pvAccess::detail
+
+#endif // SLOTTABLE_H
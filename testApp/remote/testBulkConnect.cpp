@@ -0,0 +1,222 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* Time to connect many channels.
+ *
+ * Starts a server in this process with one PV under many names.
+ * Then, for each of two client contexts, connects to all names.
+ * Once with ClientProvider::connect() for each name, and once with
+ * one ClientProvider::connect() of the list of names.
+ * Reports the time until all are connected.
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <epicsGetopt.h>
+#include <epicsTime.h>
+#include <epicsEvent.h>
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+
+#include <pv/configuration.h>
+#include <pv/clientFactory.h>
+#include <pv/serverContext.h>
+#include <pv/standardField.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+#include <pva/client.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+#define DEFAULT_TIMEOUT 60.0
+
+typedef epicsGuard<epicsMutex> Guard;
+
+struct Waiter : public pvac::ClientProvider::ConnectAllCallback
+{
+    epicsMutex lock;
+    epicsEvent done;
+    size_t remaining;
+
+    explicit Waiter(size_t n) :remaining(n) {}
+    virtual ~Waiter() {}
+
+    void connected()
+    {
+        bool last;
+        {
+            Guard G(lock);
+            last = --remaining==0u;
+        }
+        if(last)
+            done.signal();
+    }
+
+    virtual void connectAllDone() OVERRIDE FINAL
+    {
+        Guard G(lock);
+        remaining = 0u;
+        done.signal();
+    }
+};
+
+// counts only the first connection of each channel
+struct Listener : public pvac::ClientChannel::ConnectCallback
+{
+    Waiter *waiter;
+    bool seen;
+    Listener() :waiter(0), seen(false) {}
+    virtual ~Listener() {}
+    virtual void connectEvent(const pvac::ConnectEvent& evt) OVERRIDE FINAL
+    {
+        if(evt.connected && !seen) {
+            seen = true;
+            waiter->connected();
+        }
+    }
+};
+
+pvac::ClientProvider makeClient(const pva::ServerContext::shared_pointer& serv)
+{
+    return pvac::ClientProvider("pva", pva::ConfigurationBuilder()
+                                .push_config(serv->getCurrentConfig())
+                                .push_map()
+                                .build());
+}
+
+double single(const pva::ServerContext::shared_pointer& serv, const std::vector<std::string>& names, double timeout)
+{
+    pvac::ClientProvider client(makeClient(serv));
+    Waiter waiter(names.size());
+    std::vector<Listener> listeners(names.size());
+    std::vector<pvac::ClientChannel> channels(names.size());
+
+    epicsTimeStamp start, end;
+    epicsTimeGetCurrent(&start);
+
+    for(size_t i=0; i<names.size(); i++) {
+        channels[i] = client.connect(names[i]);
+        listeners[i].waiter = &waiter;
+        channels[i].addConnectListener(&listeners[i]);
+    }
+
+    if(!waiter.done.wait(timeout))
+        throw std::runtime_error("Timeout");
+    epicsTimeGetCurrent(&end);
+
+    for(size_t i=0; i<names.size(); i++)
+        channels[i].removeConnectListener(&listeners[i]);
+
+    return epicsTimeDiffInSeconds(&end, &start);
+}
+
+double bulk(const pva::ServerContext::shared_pointer& serv, const std::vector<std::string>& names, double timeout)
+{
+    pvac::ClientProvider client(makeClient(serv));
+    Waiter waiter(names.size());
+    std::vector<pvac::ClientChannel> channels;
+
+    epicsTimeStamp start, end;
+    epicsTimeGetCurrent(&start);
+
+    pvac::Operation op(client.connect(names, channels, &waiter));
+
+    if(!waiter.done.wait(timeout))
+        throw std::runtime_error("Timeout");
+    epicsTimeGetCurrent(&end);
+
+    return epicsTimeDiffInSeconds(&end, &start);
+}
+
+void usage()
+{
+    fprintf(stderr, "\nUsage: testBulkConnect [options]\n\n"
+            "  -h: Help: Print this message\n"
+            "options:\n"
+            "  -n <count>:        number of channels, may be repeated.  default is 10000 and 100000\n"
+            "  -w <sec>:          timeout, default is %.1f\n\n",
+            DEFAULT_TIMEOUT);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::vector<size_t> counts;
+    double timeout = DEFAULT_TIMEOUT;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "hn:w:")) != -1) {
+        switch(opt) {
+        case 'n': counts.push_back(atoi(optarg)); break;
+        case 'w': timeout = atof(optarg); break;
+        case 'h': usage(); return 0;
+        default: usage(); return 1;
+        }
+    }
+
+    if(counts.empty()) {
+        counts.push_back(10000u);
+        counts.push_back(100000u);
+    }
+
+    size_t maxCount = 0u;
+    for(size_t i=0; i<counts.size(); i++) {
+        if(counts[i]<1u) {
+            fprintf(stderr, "Invalid options\n");
+            return 1;
+        }
+        maxCount = std::max(maxCount, counts[i]);
+    }
+
+    try {
+        pvas::SharedPV::shared_pointer pv(pvas::SharedPV::buildReadOnly());
+        pv->open(pvd::getStandardField()->scalar(pvd::pvInt, ""));
+
+        std::vector<std::string> names(maxCount);
+        pvas::StaticProvider prov("bulk");
+        for(size_t i=0; i<maxCount; i++) {
+            std::ostringstream strm;
+            strm<<"bulk:"<<i;
+            names[i] = strm.str();
+            prov.add(names[i], pv);
+        }
+
+        pva::ServerContext::shared_pointer serv(pva::ServerContext::create(pva::ServerContext::Config()
+                                                                           .config(pva::ConfigurationBuilder()
+                                                                                   .add("EPICS_PVAS_INTF_ADDR_LIST", "127.0.0.1")
+                                                                                   .add("EPICS_PVA_ADDR_LIST", "127.0.0.1")
+                                                                                   .add("EPICS_PVA_AUTO_ADDR_LIST","0")
+                                                                                   .add("EPICS_PVA_SERVER_PORT", "0")
+                                                                                   .add("EPICS_PVA_BROADCAST_PORT", "0")
+                                                                                   .push_map()
+                                                                                   .build())
+                                                                           .provider(prov.provider())));
+
+        pva::ClientFactory::start();
+
+        printf("# channels single_s bulk_s single_ch/s bulk_ch/s\n");
+        for(size_t i=0; i<counts.size(); i++) {
+            std::vector<std::string> subset(names.begin(), names.begin()+counts[i]);
+            double t1 = single(serv, subset, timeout);
+            double t2 = bulk(serv, subset, timeout);
+            printf("%zu %.3f %.3f %.0f %.0f\n", counts[i], t1, t2, counts[i]/t1, counts[i]/t2);
+        }
+
+    }catch(std::exception& e){
+        std::cerr<<"Error: "<<e.what()<<"\n";
+        return 1;
+    }
+    return 0;
+}
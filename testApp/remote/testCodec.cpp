@@ -2,6 +2,9 @@
 * testCodec.cpp
 */
 
+#include <vector>
+#include <sstream>
+
 #include <epicsExit.h>
 #include <epicsUnitTest.h>
 #include <testMain.h>
@@ -102,6 +105,7 @@ public:
         _writePollOneCount(0),
         _throwExceptionOnSend(false),
         _readPayload(false),
+        _directReadPayload(false),
         _disconnected(false),
         _forcePayloadRead(-1),
         _readBuffer(new ByteBuffer(receiveBufferSize)),
@@ -227,6 +231,14 @@ public:
                 ? _forcePayloadRead : _payloadSize;
 
             caMessage._payload.reset(new ByteBuffer(toRead));
+            if (_directReadPayload &&
+                AbstractCodec::directDeserialize(&_socketBuffer,
+                                                 const_cast<char*>(caMessage._payload->getBuffer()),
+                                                 toRead, 1))
+            {
+                caMessage._payload->setPosition(toRead);
+                toRead = 0;
+            }
             while (toRead > 0)
             {
                 std::size_t partitalRead =
@@ -398,6 +410,7 @@ public:
     std::size_t _writePollOneCount;
     bool _throwExceptionOnSend;
     bool _readPayload;
+    bool _directReadPayload;
     bool _disconnected;
     int _forcePayloadRead;
 
@@ -432,7 +445,7 @@ class CodecTest {
 public:
 
     int runAllTest() {
-        testPlan(5883);
+        testPlan(5902);
         testHeaderProcess();
         testInvalidHeaderMagic();
         testInvalidHeaderSegmentedInNormal();
@@ -456,11 +469,16 @@ public:
         testEnqueueSendDirectRequest();
         testSendException();
         testSendHugeMessagePartes();
+        testDirectSerialize();
+        testDirectDeserializeSegmented();
         testRecipient();
         testInvalidArguments();
         testDefaultModes();
         testEnqueueSendRequestExceptionThrown();
         testBlockingProcessQueueTest();
+        testSendClassOrder();
+        testSendClassStarvation();
+        testSendClassPassedWhileWaiting();
         return testDone();
     }
 
@@ -2664,6 +2682,125 @@ private:
     }
 
 
+    void testDirectSerialize()
+    {
+        testDiag("BEGIN TEST %s:", CURRENT_FUNCTION);
+
+        const std::size_t directSize = 100*1024;
+        TestCodec codec(DEFAULT_BUFFER_SIZE,2*directSize);
+
+        codec._readPayload = true;
+        codec._readBuffer.reset(new ByteBuffer(2*directSize));
+
+        std::vector<char> direct(directSize);
+        for (std::size_t i = 0; i < directSize; i++)
+            direct[i] = (char)(i+3);
+
+        codec.startMessage((int8_t)0x01, 0);
+        for (int8_t i = 0; i < 3; i++)
+            codec.getSendBuffer()->put(i);
+
+        // bypass TestCodec override, which disables direct mode
+        testOk(codec.AbstractCodec::directSerialize(codec.getSendBuffer(), &direct[0], directSize, 1),
+               "%s: directSerialize() accepts large array", CURRENT_FUNCTION);
+
+        for (std::size_t i = 0; i < 2; i++)
+            codec.getSendBuffer()->put((int8_t)(directSize+3+i));
+
+        codec.endMessage();
+
+        codec.transferToReadBuffer();
+
+        const std::size_t payloadSizeSum = 3+directSize+2;
+        codec._forcePayloadRead = payloadSizeSum;
+
+        codec.processRead();
+
+        testOk(codec._invalidDataStreamCount == 0,
+               "%s: codec._invalidDataStreamCount == 0",
+               CURRENT_FUNCTION);
+        testOk(codec._closedCount == 0,
+               "%s: codec._closedCount == 0", CURRENT_FUNCTION);
+        testOk(codec._receivedAppMessages.size() == 1,
+               "%s: codec._receivedAppMessages.size() == 1",
+               CURRENT_FUNCTION);
+        if (codec._receivedAppMessages.size() != 1) {
+            testSkip(2, "no message");
+            return;
+        }
+
+        PVAMessage msg = codec._receivedAppMessages[0];
+        msg._payload->flip();
+
+        testOk(payloadSizeSum == msg._payload->getLimit(),
+               "%s: payloadSizeSum == msg._payload->getLimit()",
+               CURRENT_FUNCTION);
+
+        bool match = true;
+        for (std::size_t i = 0; i < payloadSizeSum && match; i++)
+            match = (int8_t)i == msg._payload->getByte();
+        testOk(match, "%s: payload content matches", CURRENT_FUNCTION);
+    }
+
+
+    void testDirectDeserializeSegmented()
+    {
+        testDiag("BEGIN TEST %s:", CURRENT_FUNCTION);
+
+        const std::size_t payloadSize = 100*1024+3;
+        const std::size_t segmentSize = 20000;
+        TestCodec codec(DEFAULT_BUFFER_SIZE,2*payloadSize);
+
+        codec._readPayload = true;
+        codec._directReadPayload = true;
+        codec._readBuffer.reset(new ByteBuffer(2*payloadSize));
+
+        codec.startMessage((int8_t)0x01, 0);
+        for (std::size_t i = 0; i < payloadSize; i++)
+        {
+            // several segments, each larger than the receive buffer
+            if (i > 0 && i % segmentSize == 0)
+                codec.flush(false);
+            codec.getSendBuffer()->put((int8_t)i);
+        }
+        codec.endMessage();
+
+        codec.transferToReadBuffer();
+
+        codec._forcePayloadRead = payloadSize;
+
+        codec.processRead();
+
+        testOk(codec._invalidDataStreamCount == 0,
+               "%s: codec._invalidDataStreamCount == 0",
+               CURRENT_FUNCTION);
+        testOk(codec._closedCount == 0,
+               "%s: codec._closedCount == 0", CURRENT_FUNCTION);
+        testOk(codec._receivedControlMessages.size() == 0,
+               "%s: codec._receivedControlMessages.size() == 0 ",
+               CURRENT_FUNCTION);
+        testOk(codec._receivedAppMessages.size() == 1,
+               "%s: codec._receivedAppMessages.size() == 1",
+               CURRENT_FUNCTION);
+        if (codec._receivedAppMessages.size() != 1) {
+            testSkip(2, "no message");
+            return;
+        }
+
+        PVAMessage msg = codec._receivedAppMessages[0];
+        msg._payload->flip();
+
+        testOk(payloadSize == msg._payload->getLimit(),
+               "%s: payloadSize == msg._payload->getLimit()",
+               CURRENT_FUNCTION);
+
+        bool match = true;
+        for (std::size_t i = 0; i < payloadSize && match; i++)
+            match = (int8_t)i == msg._payload->getByte();
+        testOk(match, "%s: payload content matches", CURRENT_FUNCTION);
+    }
+
+
     void testRecipient()
     {
         // nothing to test, depends on implementation
@@ -2914,6 +3051,127 @@ private:
         thr.exitWait();
     }
 
+
+    class TransportSenderForTestSendClass:
+        public TransportSender {
+    public:
+
+        TransportSenderForTestSendClass(
+            TestCodec & codec, int8_t command, SendClass sendClass):
+            _codec(codec), _command(command), _sendClass(sendClass) {}
+
+        SendClass getSendClass() const { return _sendClass; }
+
+        void send(epics::pvData::ByteBuffer* buffer,
+                  TransportSendControl* control)
+        {
+            _codec.startMessage(_command, 0x00000000);
+            _codec.endMessage();
+        }
+
+    private:
+        TestCodec &_codec;
+        const int8_t _command;
+        const SendClass _sendClass;
+    };
+
+
+    void testSendClassOrder()
+    {
+        testDiag("BEGIN TEST %s:", CURRENT_FUNCTION);
+
+        TestCodec codec(DEFAULT_BUFFER_SIZE,DEFAULT_BUFFER_SIZE);
+
+        codec.enqueueSendRequest(std::tr1::shared_ptr<TransportSender>(
+                                     new TransportSenderForTestSendClass(codec, 1, TransportSender::SEND_BULK)));
+        codec.enqueueSendRequest(std::tr1::shared_ptr<TransportSender>(
+                                     new TransportSenderForTestSendClass(codec, 1, TransportSender::SEND_BULK)));
+        codec.enqueueSendRequest(std::tr1::shared_ptr<TransportSender>(
+                                     new TransportSenderForTestSendClass(codec, 2, TransportSender::SEND_MONITOR)));
+        codec.enqueueSendRequest(std::tr1::shared_ptr<TransportSender>(
+                                     new TransportSenderForTestSendClass(codec, 3, TransportSender::SEND_CONTROL)));
+        codec.breakSender();
+        try {
+            codec.processSendQueue();
+        } catch(sender_break&) {}
+
+        codec.transferToReadBuffer();
+        codec.processRead();
+
+        std::ostringstream order;
+        for(size_t i=0; i<codec._receivedAppMessages.size(); i++)
+            order<<int(codec._receivedAppMessages[i]._command);
+
+        testOk(codec._receivedAppMessages.size() == 4,
+               "%s: codec._receivedAppMessages.size() == 4", CURRENT_FUNCTION);
+        testOk(order.str() == "3211",
+               "%s: sent in order of class \"%s\" == \"3211\"", CURRENT_FUNCTION, order.str().c_str());
+    }
+
+
+    void testSendClassStarvation()
+    {
+        testDiag("BEGIN TEST %s:", CURRENT_FUNCTION);
+
+        TestCodec codec(DEFAULT_BUFFER_SIZE,DEFAULT_BUFFER_SIZE);
+
+        codec.enqueueSendRequest(std::tr1::shared_ptr<TransportSender>(
+                                     new TransportSenderForTestSendClass(codec, 1, TransportSender::SEND_BULK)));
+        for(size_t i=0; i<16; i++)
+            codec.enqueueSendRequest(std::tr1::shared_ptr<TransportSender>(
+                                         new TransportSenderForTestSendClass(codec, 3, TransportSender::SEND_CONTROL)));
+        codec.breakSender();
+        try {
+            codec.processSendQueue();
+        } catch(sender_break&) {}
+
+        codec.transferToReadBuffer();
+        codec.processRead();
+
+        size_t bulkIndex = 0;
+        while(bulkIndex<codec._receivedAppMessages.size() && codec._receivedAppMessages[bulkIndex]._command!=1)
+            bulkIndex++;
+
+        testOk(codec._receivedAppMessages.size() == 17,
+               "%s: codec._receivedAppMessages.size() == 17", CURRENT_FUNCTION);
+        testOk(bulkIndex == SendQueue::maxPassed,
+               "%s: bulk sent after %u control (%u)", CURRENT_FUNCTION,
+               unsigned(SendQueue::maxPassed), unsigned(bulkIndex));
+    }
+
+
+    void testSendClassPassedWhileWaiting()
+    {
+        testDiag("BEGIN TEST %s:", CURRENT_FUNCTION);
+
+        TestCodec codec(DEFAULT_BUFFER_SIZE,DEFAULT_BUFFER_SIZE);
+        SendQueue queue;
+        TransportSender::shared_pointer sender;
+
+        // many control, while no bulk waits
+        size_t npopped = 0;
+        for(size_t i=0; i<2*SendQueue::maxPassed; i++) {
+            queue.push_back(TransportSender::shared_pointer(
+                                new TransportSenderForTestSendClass(codec, 3, TransportSender::SEND_CONTROL)));
+            if(queue.pop_front_try(sender))
+                npopped++;
+        }
+        testOk(npopped == 2*SendQueue::maxPassed && queue.empty(),
+               "%s: popped %u control", CURRENT_FUNCTION, unsigned(npopped));
+
+        TransportSender::shared_pointer bulk(new TransportSenderForTestSendClass(codec, 1, TransportSender::SEND_BULK)),
+                                        control(new TransportSenderForTestSendClass(codec, 3, TransportSender::SEND_CONTROL));
+        queue.push_back(bulk);
+        queue.push_back(control);
+
+        // bulk was not passed over while not queued
+        TransportSender::shared_pointer first, second;
+        queue.pop_front_try(first);
+        queue.pop_front_try(second);
+        testOk(first == control, "%s: control sent first", CURRENT_FUNCTION);
+        testOk(second == bulk, "%s: then bulk", CURRENT_FUNCTION);
+    }
+
 private:
 
     AtomicValue<bool> _processTreadExited;
@@ -0,0 +1,185 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* Throughput, and CPU cost, of compressed transfers of NTNDArray images.
+ *
+ * Starts a server in this process with an NTNDArray PV holding the
+ * test image of testNTImage.cpp, scaled up.  Then, for each of two client
+ * contexts, one without and one with $EPICS_PVA_COMPRESS_THRESHOLD ,
+ * repeatedly gets the image.  Reports image throughput, and the process CPU
+ * time (client and server) per MB, with the compression ratio of the image.
+ *
+ * Loopback is faster than compression.  For a slower link, the ratio
+ * gives the bytes sent on the wire for each image byte.
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cmath>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <epicsGetopt.h>
+#include <epicsTime.h>
+
+#include <pv/pvData.h>
+#include <pv/standardField.h>
+#include <pv/pvTimeStamp.h>
+#include <pv/configuration.h>
+#include <pv/clientFactory.h>
+#include <pv/serverContext.h>
+#include <pv/lzBlock.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+#include <pva/client.h>
+
+using namespace epics::pvData;
+using namespace std;
+
+#include "testNTImage.cpp"
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+#define DEFAULT_COLS 1024
+#define DEFAULT_ROWS 1024
+#define DEFAULT_DURATION 5.0
+#define DEFAULT_THRESHOLD 1024
+
+// compressed size, in the 64KB blocks sent by the codec
+double compressionRatio(const std::vector<int8_t>& image)
+{
+    const size_t block = 64u*1024u;
+    std::vector<char> out(block);
+    size_t total = 0u;
+    for(size_t i=0; i<image.size(); i+=block) {
+        size_t n = std::min(block, image.size()-i);
+        const char *src = reinterpret_cast<const char*>(&image[i]);
+        size_t c = pva::detail::lzCompress(src, n, &out[0], n - n/32u);
+        total += c ? c : n;
+    }
+    return double(total)/image.size();
+}
+
+void run(const pva::ServerContext::shared_pointer& serv, const char *name, int threshold,
+         size_t imageSize, double duration)
+{
+    pvac::ClientProvider client("pva", pva::ConfigurationBuilder()
+                                .push_config(serv->getCurrentConfig())
+                                .add("EPICS_PVA_COMPRESS_THRESHOLD", threshold)
+                                .push_map()
+                                .build());
+    pvac::ClientChannel chan(client.connect("compress:image"));
+
+    // connect before starting
+    chan.get(10.0);
+
+    size_t ngets = 0u;
+    clock_t cpu0 = clock();
+    epicsTimeStamp start, now;
+    epicsTimeGetCurrent(&start);
+    do {
+        chan.get(30.0);
+        ngets++;
+        epicsTimeGetCurrent(&now);
+    } while(epicsTimeDiffInSeconds(&now, &start) < duration);
+    clock_t cpu1 = clock();
+
+    double elapsed = epicsTimeDiffInSeconds(&now, &start);
+    double cpu = double(cpu1-cpu0)/CLOCKS_PER_SEC;
+    double MB = ngets*double(imageSize)/1048576.0;
+
+    printf("%s %d %zu %zu %.1f %.2f %.2f\n",
+           name, threshold, imageSize, ngets,
+           MB/elapsed, cpu, cpu*1e3/MB);
+}
+
+void usage()
+{
+    fprintf(stderr, "\nUsage: testCompression [options]\n\n"
+            "  -h: Help: Print this message\n"
+            "options:\n"
+            "  -x <cols>:         image width, default is %d\n"
+            "  -y <rows>:         image height, default is %d\n"
+            "  -t <bytes>:        compression threshold, default is %d\n"
+            "  -d <sec>:          duration, default is %.1f\n\n",
+            DEFAULT_COLS, DEFAULT_ROWS, DEFAULT_THRESHOLD, DEFAULT_DURATION);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int cols = DEFAULT_COLS, rows = DEFAULT_ROWS, threshold = DEFAULT_THRESHOLD;
+    double duration = DEFAULT_DURATION;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "hx:y:t:d:")) != -1) {
+        switch(opt) {
+        case 'x': cols = atoi(optarg); break;
+        case 'y': rows = atoi(optarg); break;
+        case 't': threshold = atoi(optarg); break;
+        case 'd': duration = atof(optarg); break;
+        case 'h': usage(); return 0;
+        default: usage(); return 1;
+        }
+    }
+
+    if(cols<1 || rows<1 || threshold<1) {
+        fprintf(stderr, "Invalid options\n");
+        return 1;
+    }
+
+    try {
+        // scale the logo up to the requested size
+        std::vector<int8_t> image(size_t(cols)*rows);
+        for(int y=0; y<rows; y++) {
+            int sy = y*epicsv4_raw_dim[1]/rows;
+            for(int x=0; x<cols; x++) {
+                int sx = x*epicsv4_raw_dim[0]/cols;
+                image[size_t(y)*cols+x] = epicsv4_raw[sy*epicsv4_raw_dim[0]+sx];
+            }
+        }
+        const int32_t dims[2] = {cols, rows};
+
+        pvd::PVStructurePtr value(pvd::getPVDataCreate()->createPVStructure(createNTNDArrayStructure()));
+        initImage(value, "", 0, 2, dims, image.size(), &image[0]);
+
+        pvas::SharedPV::shared_pointer pv(pvas::SharedPV::buildReadOnly());
+        pv->open(*value);
+
+        pvas::StaticProvider prov("compress");
+        prov.add("compress:image", pv);
+
+        // server compresses when a client asks
+        pva::ServerContext::shared_pointer serv(pva::ServerContext::create(pva::ServerContext::Config()
+                                                                           .config(pva::ConfigurationBuilder()
+                                                                                   .add("EPICS_PVAS_INTF_ADDR_LIST", "127.0.0.1")
+                                                                                   .add("EPICS_PVA_ADDR_LIST", "127.0.0.1")
+                                                                                   .add("EPICS_PVA_AUTO_ADDR_LIST","0")
+                                                                                   .add("EPICS_PVA_SERVER_PORT", "0")
+                                                                                   .add("EPICS_PVA_BROADCAST_PORT", "0")
+                                                                                   .add("EPICS_PVA_COMPRESS_THRESHOLD", threshold)
+                                                                                   .push_map()
+                                                                                   .build())
+                                                                           .provider(prov.provider())));
+
+        pva::ClientFactory::start();
+
+        printf("# image %dx%d compression ratio %.3f\n", cols, rows, compressionRatio(image));
+        printf("# mode threshold image_bytes gets MB/s cpu_s cpu_ms/MB\n");
+        run(serv, "none", 0, image.size(), duration);
+        run(serv, "lz", threshold, image.size(), duration);
+
+    }catch(std::exception& e){
+        std::cerr<<"Error: "<<e.what()<<"\n";
+        return 1;
+    }
+    return 0;
+}
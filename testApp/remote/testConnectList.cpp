@@ -0,0 +1,261 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* ClientProvider::connect() of a list of names
+ */
+
+#include <vector>
+#include <string>
+
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+#include <epicsEvent.h>
+
+#include <pv/pvUnitTest.h>
+#include <testMain.h>
+
+#include <pv/configuration.h>
+#include <pv/clientFactory.h>
+#include <pv/serverContext.h>
+#include <pv/standardField.h>
+#include <pv/current_function.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+#include <pva/client.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+typedef epicsGuard<epicsMutex> Guard;
+
+namespace {
+
+struct Waiter : public pvac::ClientProvider::ConnectAllCallback
+{
+    epicsMutex lock;
+    epicsEvent done;
+    size_t ncalls;
+
+    Waiter() :ncalls(0u) {}
+    virtual ~Waiter() {}
+
+    virtual void connectAllDone() OVERRIDE FINAL
+    {
+        {
+            Guard G(lock);
+            ncalls++;
+        }
+        done.signal();
+    }
+};
+
+struct Listener : public pvac::ClientChannel::ConnectCallback
+{
+    epicsMutex lock;
+    bool seen;
+    Listener() :seen(false) {}
+    virtual ~Listener() {}
+    virtual void connectEvent(const pvac::ConnectEvent& evt) OVERRIDE FINAL
+    {
+        Guard G(lock);
+        if(evt.connected)
+            seen = true;
+    }
+};
+
+// Passes through to another provider, counting channels created.
+// Fails to create channel "bad".
+struct CountingProvider : public pva::ChannelProvider
+{
+    const pva::ChannelProvider::shared_pointer upstream;
+    size_t ncreated;
+    std::vector<std::tr1::weak_ptr<pva::Channel> > created;
+
+    explicit CountingProvider(const pva::ChannelProvider::shared_pointer& upstream)
+        :upstream(upstream)
+        ,ncreated(0u)
+    {}
+    virtual ~CountingProvider() {}
+
+    virtual std::string getProviderName() OVERRIDE FINAL { return "counting"; }
+
+    virtual pva::ChannelFind::shared_pointer channelFind(std::string const & name,
+                                                         pva::ChannelFindRequester::shared_pointer const & requester) OVERRIDE FINAL
+    {
+        return upstream->channelFind(name, requester);
+    }
+
+    virtual pva::Channel::shared_pointer createChannel(std::string const & name,
+                                                       pva::ChannelRequester::shared_pointer const & requester,
+                                                       short priority, std::string const & address) OVERRIDE FINAL
+    {
+        if(name=="bad")
+            return pva::Channel::shared_pointer();
+        pva::Channel::shared_pointer ret(upstream->createChannel(name, requester, priority, address));
+        ncreated++;
+        created.push_back(ret);
+        return ret;
+    }
+};
+
+std::vector<std::string> makeNames(const char *a, const char *b, const char *c, const char *d, const char *e)
+{
+    std::vector<std::string> ret;
+    ret.push_back(a);
+    ret.push_back(b);
+    ret.push_back(c);
+    ret.push_back(d);
+    ret.push_back(e);
+    return ret;
+}
+
+// each channel has the requested name, and has connected
+void testConnected(const std::vector<std::string>& names, std::vector<pvac::ClientChannel>& channels)
+{
+    testOk(channels.size()==names.size(), "%zu channels for %zu names", channels.size(), names.size());
+
+    size_t badname = 0u, unconnected = 0u;
+    for(size_t i=0; i<channels.size() && i<names.size(); i++) {
+        if(channels[i].name()!=names[i])
+            badname++;
+
+        Listener listener;
+        // notifies current state immediately
+        channels[i].addConnectListener(&listener);
+        channels[i].removeConnectListener(&listener);
+        Guard G(listener.lock);
+        if(!listener.seen)
+            unconnected++;
+    }
+    testOk(badname==0u, "%zu channels with wrong name", badname);
+    testOk(unconnected==0u, "%zu channels not connected", unconnected);
+}
+
+void testLocal()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    pvas::SharedPV::shared_pointer pv(pvas::SharedPV::buildReadOnly());
+    pv->open(pvd::getStandardField()->scalar(pvd::pvInt, ""));
+
+    pvas::StaticProvider prov("local");
+    prov.add("pv:a", pv);
+    prov.add("pv:b", pv);
+    prov.add("pv:c", pv);
+
+    std::tr1::shared_ptr<CountingProvider> counter(new CountingProvider(prov.provider()));
+    pvac::ClientProvider client(counter);
+
+    // already in cache
+    pvac::ClientChannel cached(client.connect("pv:a"));
+    testOk1(counter->ncreated==1u);
+
+    const std::vector<std::string> names(makeNames("pv:a", "pv:b", "pv:a", "pv:c", "pv:b"));
+    std::vector<pvac::ClientChannel> channels;
+    Waiter waiter;
+
+    pvac::Operation op(client.connect(names, channels, &waiter));
+
+    // one new channel for each of the names not already cached
+    testOk(counter->ncreated==3u, "created %zu", counter->ncreated);
+    testOk1(waiter.done.wait(5.0));
+    testConnected(names, channels);
+
+    {
+        Guard G(waiter.lock);
+        testOk(waiter.ncalls==1u, "connectAllDone() called %zu times", waiter.ncalls);
+    }
+
+    // already cached, and a failure
+    const std::vector<std::string> badnames(makeNames("pv:a", "new:a", "bad", "new:a", "pv:c"));
+    std::vector<pvac::ClientChannel> prev(channels);
+    const size_t before = counter->ncreated;
+    testThrows(std::runtime_error, client.connect(badnames, channels));
+
+    testOk(channels.size()==prev.size() && channels[0].name()==prev[0].name(), "channels not changed");
+
+    size_t leaked = 0u;
+    for(size_t i=before; i<counter->created.size(); i++) {
+        if(!counter->created[i].expired())
+            leaked++;
+    }
+    testOk(leaked==0u, "%zu channels of failed connect() remain", leaked);
+
+    // nothing of the failed connect() was cached
+    {
+        pvac::ClientChannel again(client.connect("new:a"));
+        testOk(counter->ncreated==before+2u, "created %zu", counter->ncreated-before);
+    }
+
+    testThrows(std::logic_error, client.connect(makeNames("pv:a", "", "pv:b", "pv:b", "pv:c"), channels));
+}
+
+void testRemote()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    pvas::SharedPV::shared_pointer pv(pvas::SharedPV::buildReadOnly());
+    pv->open(pvd::getStandardField()->scalar(pvd::pvInt, ""));
+
+    pvas::StaticProvider prov("remote");
+    prov.add("pv:a", pv);
+    prov.add("pv:b", pv);
+    prov.add("pv:c", pv);
+
+    pva::ServerContext::shared_pointer serv(pva::ServerContext::create(pva::ServerContext::Config()
+                                                                       .config(pva::ConfigurationBuilder()
+                                                                               .add("EPICS_PVAS_INTF_ADDR_LIST", "127.0.0.1")
+                                                                               .add("EPICS_PVA_ADDR_LIST", "127.0.0.1")
+                                                                               .add("EPICS_PVA_AUTO_ADDR_LIST","0")
+                                                                               .add("EPICS_PVA_SERVER_PORT", "0")
+                                                                               .add("EPICS_PVA_BROADCAST_PORT", "0")
+                                                                               .push_map()
+                                                                               .build())
+                                                                       .provider(prov.provider())));
+
+    pva::ClientFactory::start();
+    pvac::ClientProvider client("pva", pva::ConfigurationBuilder()
+                                .push_config(serv->getCurrentConfig())
+                                .push_map()
+                                .build());
+
+    // already in cache, and perhaps connected
+    pvac::ClientChannel cached(client.connect("pv:a"));
+
+    const std::vector<std::string> names(makeNames("pv:a", "pv:b", "pv:a", "pv:c", "pv:b"));
+    std::vector<pvac::ClientChannel> channels;
+    Waiter waiter;
+
+    pvac::Operation op(client.connect(names, channels, &waiter));
+
+    testOk1(waiter.done.wait(5.0));
+    testConnected(names, channels);
+
+    {
+        Guard G(waiter.lock);
+        testOk(waiter.ncalls==1u, "connectAllDone() called %zu times", waiter.ncalls);
+    }
+
+    // all connected, so notified before returning
+    Waiter again;
+    pvac::Operation op2(client.connect(names, channels, &again));
+    {
+        Guard G(again.lock);
+        testOk(again.ncalls==1u, "connectAllDone() called %zu times", again.ncalls);
+    }
+}
+
+} // namespace
+
+MAIN(testConnectList)
+{
+    testPlan(18);
+    try {
+        testLocal();
+        testRemote();
+    }catch(std::exception& e){
+        testAbort("Unexpected exception: %s", e.what());
+    }
+    return testDone();
+}
@@ -0,0 +1,183 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* Time for a client to search for, and connect, many channels.
+ *
+ * Starts a server in this process with N PVs, then creates a client channel
+ * for each, and waits until all are connected.  Reports the elapsed time,
+ * and the search statistics of the client context.
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <sstream>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <epicsGetopt.h>
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+#include <epicsEvent.h>
+#include <epicsTime.h>
+
+#include <pv/configuration.h>
+#include <pv/serverContext.h>
+#include <pv/clientFactory.h>
+#include <pv/pvAccess.h>
+#include <pv/clientContextImpl.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+typedef epicsGuard<epicsMutex> Guard;
+
+namespace {
+
+#define DEFAULT_PVS 100000
+#define DEFAULT_TIMEOUT 120.0
+
+struct Connected {
+    epicsMutex mutex;
+    epicsEvent done;
+    size_t expect, count;
+    Connected() :expect(0u), count(0u) {}
+};
+
+struct CountingRequester : public pva::ChannelRequester
+{
+    Connected& connected;
+    bool seen;
+
+    explicit CountingRequester(Connected& connected) :connected(connected), seen(false) {}
+    virtual ~CountingRequester() {}
+
+    virtual std::string getRequesterName() OVERRIDE FINAL { return "testConnectTime"; }
+    virtual void channelCreated(const pvd::Status&, pva::Channel::shared_pointer const &) OVERRIDE FINAL {}
+    virtual void channelStateChange(pva::Channel::shared_pointer const &, pva::Channel::ConnectionState state) OVERRIDE FINAL
+    {
+        if(state!=pva::Channel::CONNECTED)
+            return;
+
+        Guard G(connected.mutex);
+        if(seen)
+            return;
+        seen = true;
+        if(++connected.count==connected.expect)
+            connected.done.signal();
+    }
+};
+
+void usage()
+{
+    fprintf(stderr, "\nUsage: testConnectTime [options]\n\n"
+            "  -h: Help: Print this message\n"
+            "options:\n"
+            "  -N <channels>:     number of channels, default is %d\n"
+            "  -w <sec>:          give up after, default is %.1f\n\n",
+            DEFAULT_PVS, DEFAULT_TIMEOUT);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int npvs = DEFAULT_PVS;
+    double timeout = DEFAULT_TIMEOUT;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "hN:w:")) != -1) {
+        switch(opt) {
+        case 'N': npvs = atoi(optarg); break;
+        case 'w': timeout = atof(optarg); break;
+        case 'h': usage(); return 0;
+        default: usage(); return 1;
+        }
+    }
+
+    if(npvs<1) {
+        fprintf(stderr, "Invalid options\n");
+        return 1;
+    }
+
+    try {
+        pvas::StaticProvider prov("connect");
+        std::vector<std::string> names(npvs);
+        {
+            pvas::SharedPV::shared_pointer pv(pvas::SharedPV::buildReadOnly());
+            for(int i=0; i<npvs; i++) {
+                std::ostringstream name;
+                name<<"connect:"<<i;
+                names[i] = name.str();
+                prov.add(names[i], pv);
+            }
+        }
+
+        pva::ServerContext::shared_pointer serv(pva::ServerContext::create(pva::ServerContext::Config()
+                                                                           .config(pva::ConfigurationBuilder()
+                                                                                   .add("EPICS_PVAS_INTF_ADDR_LIST", "127.0.0.1")
+                                                                                   .add("EPICS_PVA_ADDR_LIST", "127.0.0.1")
+                                                                                   .add("EPICS_PVA_AUTO_ADDR_LIST","0")
+                                                                                   .add("EPICS_PVA_SERVER_PORT", "0")
+                                                                                   .add("EPICS_PVA_BROADCAST_PORT", "0")
+                                                                                   .push_map()
+                                                                                   .build())
+                                                                           .provider(prov.provider())));
+
+        pva::ClientFactory::start();
+        pva::ChannelProvider::shared_pointer client(pva::ChannelProviderRegistry::clients()->createProvider("pva",
+                                                                                                            serv->getCurrentConfig()));
+        if(!client)
+            throw std::runtime_error("No pva provider");
+
+        Connected connected;
+        connected.expect = names.size();
+
+        std::vector<pva::Channel::shared_pointer> channels;
+        channels.reserve(names.size());
+
+        epicsTimeStamp start, end;
+        epicsTimeGetCurrent(&start);
+
+        for(size_t i=0; i<names.size(); i++) {
+            pva::ChannelRequester::shared_pointer req(new CountingRequester(connected));
+            channels.push_back(client->createChannel(names[i], req));
+        }
+
+        bool complete = connected.done.wait(timeout);
+        epicsTimeGetCurrent(&end);
+
+        size_t count;
+        {
+            Guard G(connected.mutex);
+            count = connected.count;
+        }
+
+        printf("# channels connected seconds channels/s\n");
+        printf("%zu %zu %.3f %.0f\n",
+               names.size(), count,
+               epicsTimeDiffInSeconds(&end, &start),
+               count/epicsTimeDiffInSeconds(&end, &start));
+        if(!complete)
+            fprintf(stderr, "Timeout\n");
+
+        pva::ClientContextImpl::shared_pointer context(std::tr1::dynamic_pointer_cast<pva::ClientContextImpl>(client));
+        if(context)
+            context->printInfo(std::cout);
+
+        for(size_t i=0; i<channels.size(); i++)
+            channels[i]->destroy();
+        channels.clear();
+        client.reset();
+        serv.reset();
+
+        return complete ? 0 : 1;
+    }catch(std::exception& e){
+        std::cerr<<"Error: "<<e.what()<<"\n";
+        return 1;
+    }
+}
@@ -0,0 +1,239 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* Server resource use vs. number of TCP connections.
+ *
+ * Starts a server in this process, and opens many raw TCP connections to it,
+ * each completing connection validation.  Reports threads, RSS, and CPU time
+ * for the established connections.
+ *
+ * Compare thread per connection (default) with $EPICS_PVA_TCP_REACTOR_THREADS
+ * using the -t option.  Two file descriptors are used per connection,
+ * so 'ulimit -n' may need to be raised.
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+
+#include <osiSock.h>
+#include <epicsGetopt.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <epicsEndian.h>
+
+#include <pv/byteBuffer.h>
+#include <pv/configuration.h>
+#include <pv/serverContext.h>
+#include <pv/pvaConstants.h>
+#include <pv/remote.h>
+#include <pva/sharedstate.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+// value of a field from /proc/self/status , eg. "Threads" or "VmRSS"
+long procStatus(const char *name)
+{
+    std::ifstream strm("/proc/self/status");
+    std::string line;
+    size_t nlen = strlen(name);
+    while(std::getline(strm, line)) {
+        if(line.compare(0, nlen, name)==0 && line.size()>nlen && line[nlen]==':')
+            return atol(line.c_str()+nlen+1);
+    }
+    return -1;
+}
+
+double cpuTime()
+{
+#ifndef _WIN32
+    rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage)==0)
+        return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec*1e-6
+                + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec*1e-6;
+#endif
+    return -1.0;
+}
+
+bool recvAll(SOCKET sock, char *buf, size_t len)
+{
+    while(len) {
+        int ret = recv(sock, buf, len, 0);
+        if(ret<=0)
+            return false;
+        buf += ret;
+        len -= ret;
+    }
+    return true;
+}
+
+// read messages until CMD_CONNECTION_VALIDATED
+bool waitValidated(SOCKET sock)
+{
+    std::vector<char> payload;
+    while(true) {
+        char header[pva::PVA_MESSAGE_HEADER_SIZE];
+        if(!recvAll(sock, header, sizeof(header)))
+            return false;
+
+        pvd::ByteBuffer hbuf(header, sizeof(header));
+        hbuf.setEndianess((header[2]&0x80) ? EPICS_ENDIAN_BIG : EPICS_ENDIAN_LITTLE);
+        hbuf.setPosition(4);
+        pvd::int32 size = hbuf.getInt();
+
+        if(header[2]&0x01)
+            continue; // control message, no payload
+
+        payload.resize(size);
+        if(size && !recvAll(sock, &payload[0], size))
+            return false;
+
+        if(header[3]==pva::CMD_CONNECTION_VALIDATED)
+            return true;
+    }
+}
+
+SOCKET connectValidated(const osiSockAddr& addr)
+{
+    SOCKET sock = epicsSocketCreate(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if(sock==INVALID_SOCKET)
+        return sock;
+
+    if(::connect(sock, &addr.sa, sizeof(addr.ia))) {
+        epicsSocketDestroy(sock);
+        return INVALID_SOCKET;
+    }
+
+    // connection validation reply, as a client using "anonymous" authentication
+    const std::string authnz("anonymous");
+    char buf[64];
+    pvd::ByteBuffer msg(buf, sizeof(buf));
+    msg.setEndianess(EPICS_BYTE_ORDER);
+    msg.putByte(pva::PVA_MAGIC);
+    msg.putByte(pva::PVA_CLIENT_PROTOCOL_REVISION);
+    msg.putByte(EPICS_BYTE_ORDER==EPICS_ENDIAN_BIG ? 0x80 : 0x00);
+    msg.putByte(pva::CMD_CONNECTION_VALIDATION);
+    msg.putInt(4+2+2+1+authnz.size()+1);
+    msg.putInt(pva::MAX_TCP_RECV);
+    msg.putShort(0x7fff);
+    msg.putShort(0);
+    msg.putByte(authnz.size());
+    msg.put(authnz.c_str(), 0, authnz.size());
+    msg.putByte(-1); // null field, no authnz data
+
+    if(::send(sock, buf, msg.getPosition(), 0)!=int(msg.getPosition())
+            || !waitValidated(sock)) {
+        epicsSocketDestroy(sock);
+        return INVALID_SOCKET;
+    }
+    return sock;
+}
+
+void usage()
+{
+    fprintf(stderr, "\nUsage: testConnectionScaling [options]\n\n"
+            "  -h: Help: Print this message\n"
+            "options:\n"
+            "  -n <connections>:  number of connections, default is 1000\n"
+            "  -t <threads>:      $EPICS_PVA_TCP_REACTOR_THREADS (0 means thread per connection), default is 0\n"
+            "  -w <sec>:          idle time over which CPU use is measured, default is 5\n\n");
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int nconn = 1000, nthreads = 0;
+    double idle = 5.0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "hn:t:w:")) != -1) {
+        switch(opt) {
+        case 'n': nconn = atoi(optarg); break;
+        case 't': nthreads = atoi(optarg); break;
+        case 'w': idle = atof(optarg); break;
+        case 'h': usage(); return 0;
+        default: usage(); return 1;
+        }
+    }
+
+    try {
+        std::ostringstream threads;
+        threads<<nthreads;
+
+        pva::Configuration::shared_pointer conf(pva::ConfigurationBuilder()
+                                                .add("EPICS_PVAS_INTF_ADDR_LIST", "127.0.0.1")
+                                                .add("EPICS_PVA_ADDR_LIST", "127.0.0.1")
+                                                .add("EPICS_PVA_AUTO_ADDR_LIST","0")
+                                                .add("EPICS_PVA_SERVER_PORT", "0")
+                                                .add("EPICS_PVA_BROADCAST_PORT", "0")
+                                                .add("EPICS_PVA_TCP_REACTOR_THREADS", threads.str())
+                                                .push_map()
+                                                .build());
+
+        pvas::StaticProvider prov("scaling");
+        pva::ServerContext::shared_pointer serv(pva::ServerContext::create(pva::ServerContext::Config()
+                                                                           .config(conf)
+                                                                           .provider(prov.provider())));
+
+        osiSockAddr addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.ia.sin_family = AF_INET;
+        addr.ia.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.ia.sin_port = htons(serv->getServerPort());
+
+        long threads0 = procStatus("Threads"), rss0 = procStatus("VmRSS");
+        double cpu0 = cpuTime();
+        epicsTimeStamp start, end;
+        epicsTimeGetCurrent(&start);
+
+        std::vector<SOCKET> socks;
+        socks.reserve(nconn);
+        for(int i=0; i<nconn; i++) {
+            SOCKET sock = connectValidated(addr);
+            if(sock==INVALID_SOCKET) {
+                fprintf(stderr, "Connection %d fails (ulimit -n ?)\n", i);
+                break;
+            }
+            socks.push_back(sock);
+        }
+
+        epicsTimeGetCurrent(&end);
+        double cpu1 = cpuTime();
+        long threads1 = procStatus("Threads"), rss1 = procStatus("VmRSS");
+
+        epicsThreadSleep(idle);
+        double cpu2 = cpuTime();
+
+        printf("# connections reactor_threads process_threads RSS_kB setup_sec setup_cpu_sec idle_cpu_%%\n");
+        printf("%zu %d %ld %ld %.3f %.3f %.2f\n",
+               socks.size(), nthreads,
+               threads1-threads0, rss1-rss0,
+               epicsTimeDiffInSeconds(&end, &start),
+               cpu1-cpu0, 100.0*(cpu2-cpu1)/idle);
+
+        for(size_t i=0; i<socks.size(); i++)
+            epicsSocketDestroy(socks[i]);
+
+        serv.reset();
+    }catch(std::exception& e){
+        std::cerr<<"Error: "<<e.what()<<"\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,235 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* ClientProvider::get() of a list of channels
+ */
+
+#include <vector>
+#include <string>
+#include <sstream>
+
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+#include <epicsEvent.h>
+
+#include <pv/pvUnitTest.h>
+#include <testMain.h>
+
+#include <pv/standardField.h>
+#include <pv/current_function.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+#include <pva/client.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+typedef epicsGuard<epicsMutex> Guard;
+
+namespace {
+
+struct Collector : public pvac::ClientProvider::MultiGetCallback
+{
+    epicsMutex lock;
+    epicsEvent event;
+    std::vector<pvac::GetEvent> results;
+    // indices in order of completion
+    std::vector<size_t> order;
+    size_t ndone;
+
+    explicit Collector(size_t n) :results(n), ndone(0u) {}
+    virtual ~Collector() {}
+
+    virtual void getDone(size_t index, const pvac::GetEvent& evt) OVERRIDE FINAL
+    {
+        {
+            Guard G(lock);
+            results[index] = evt;
+            order.push_back(index);
+        }
+        event.signal();
+    }
+    virtual void multiGetDone() OVERRIDE FINAL
+    {
+        {
+            Guard G(lock);
+            ndone++;
+        }
+        event.signal();
+    }
+};
+
+struct Fixture
+{
+    pvas::StaticProvider prov;
+    std::vector<pvas::SharedPV::shared_pointer> pvs;
+    pvac::ClientProvider client;
+
+    Fixture()
+        :prov("getlist")
+    {
+        // pv:1 to pv:4 have value 1 to 4
+        for(int i=1; i<=4; i++) {
+            pvas::SharedPV::shared_pointer pv(pvas::SharedPV::buildReadOnly());
+            pvd::PVStructurePtr value(pvd::getPVDataCreate()->createPVStructure(pvd::getStandardField()->scalar(pvd::pvInt, "")));
+            value->getSubFieldT<pvd::PVInt>("value")->put(i);
+            pv->open(*value);
+            pvs.push_back(pv);
+
+            std::ostringstream name;
+            name<<"pv:"<<i;
+            prov.add(name.str(), pv);
+        }
+        client = pvac::ClientProvider(prov.provider());
+    }
+
+    // a PV which is never open()'d, so a get never completes
+    pvas::SharedPV::shared_pointer addClosed(const std::string& name)
+    {
+        pvas::SharedPV::shared_pointer pv(pvas::SharedPV::buildReadOnly());
+        prov.add(name, pv);
+        return pv;
+    }
+
+    std::vector<pvac::ClientChannel> connect(const char *a, const char *b, const char *c, const char *d)
+    {
+        std::vector<pvac::ClientChannel> ret;
+        ret.push_back(client.connect(a));
+        ret.push_back(client.connect(b));
+        ret.push_back(client.connect(c));
+        ret.push_back(client.connect(d));
+        return ret;
+    }
+};
+
+int valueOf(const pvac::GetEvent& evt)
+{
+    if(evt.event!=pvac::GetEvent::Success || !evt.value)
+        return -1;
+    return evt.value->getSubFieldT<pvd::PVScalar>("value")->getAs<pvd::int32>();
+}
+
+void testOrder()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    Fixture fix;
+    std::vector<pvac::ClientChannel> channels(fix.connect("pv:3", "pv:1", "pv:4", "pv:2"));
+    const int expect[] = {3, 1, 4, 2};
+
+    std::vector<pvac::GetEvent> results;
+    // fewer in progress than channels
+    size_t nsuccess = fix.client.get(channels, results, 5.0, pvd::PVStructure::const_shared_pointer(), 2u);
+    testOk(nsuccess==4u, "%zu succeed", nsuccess);
+
+    bool ok = results.size()==4u;
+    for(size_t i=0; ok && i<results.size(); i++) {
+        testDiag("results[%zu] = %d", i, valueOf(results[i]));
+        ok &= valueOf(results[i])==expect[i];
+    }
+    testOk(ok, "results in order of channels");
+}
+
+void testOrderAsync()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    Fixture fix;
+    std::vector<pvac::ClientChannel> channels(fix.connect("pv:4", "pv:3", "pv:2", "pv:1"));
+    const int expect[] = {4, 3, 2, 1};
+
+    Collector collect(channels.size());
+    pvac::Operation op(fix.client.get(channels, &collect, pvd::PVStructure::const_shared_pointer(), 1u));
+
+    {
+        Guard G(collect.lock);
+        while(collect.ndone==0u) {
+            epicsGuardRelease<epicsMutex> U(G);
+            if(!collect.event.wait(5.0))
+                break;
+        }
+    }
+
+    Guard G(collect.lock);
+    testOk(collect.ndone==1u, "multiGetDone() called %zu times", collect.ndone);
+    testOk(collect.order.size()==channels.size(), "getDone() called %zu times", collect.order.size());
+
+    bool ok = true;
+    for(size_t i=0; i<collect.results.size(); i++)
+        ok &= valueOf(collect.results[i])==expect[i];
+    testOk(ok, "each result passed with the index of its channel");
+}
+
+void testErrors()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    Fixture fix;
+    fix.addClosed("pv:closed");
+    fix.prov.add("pv:dead", fix.pvs[0]);
+
+    std::vector<pvac::ClientChannel> channels(fix.connect("pv:1", "pv:dead", "pv:2", "pv:closed"));
+    // operations on a destroyed channel fail
+    channels[1].getChannel()->destroy();
+
+    std::vector<pvac::GetEvent> results;
+    size_t nsuccess = fix.client.get(channels, results, 0.5);
+    testOk(nsuccess==2u, "%zu succeed", nsuccess);
+
+    testOk1(results.size()==4u);
+    results.resize(4u);
+    testOk(valueOf(results[0])==1 && valueOf(results[2])==2, "others succeed");
+    testOk(results[1].event==pvac::GetEvent::Fail, "destroyed channel fails, %d '%s'",
+           results[1].event, results[1].message.c_str());
+    testOk(results[3].event==pvac::GetEvent::Cancel, "timeout is Cancel, %d", results[3].event);
+}
+
+void testCancel()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    Fixture fix;
+    pvas::SharedPV::shared_pointer closed(fix.addClosed("pv:closed"));
+
+    std::vector<pvac::ClientChannel> channels(fix.connect("pv:1", "pv:closed", "pv:2", "pv:3"));
+
+    Collector collect(channels.size());
+    pvac::Operation op(fix.client.get(channels, &collect));
+
+    {
+        Guard G(collect.lock);
+        while(collect.order.size()<3u) {
+            epicsGuardRelease<epicsMutex> U(G);
+            if(!collect.event.wait(5.0))
+                break;
+        }
+        testOk(collect.order.size()==3u, "%zu complete before cancel", collect.order.size());
+    }
+
+    op.cancel();
+
+    // would complete the last get
+    pvd::PVStructurePtr value(pvd::getPVDataCreate()->createPVStructure(pvd::getStandardField()->scalar(pvd::pvInt, "")));
+    closed->open(*value);
+
+    Guard G(collect.lock);
+    testOk(collect.order.size()==3u, "%zu complete after cancel", collect.order.size());
+    testOk(collect.ndone==0u, "multiGetDone() called %zu times", collect.ndone);
+}
+
+} // namespace
+
+MAIN(testGetList)
+{
+    testPlan(13);
+    try {
+        testOrder();
+        testOrderAsync();
+        testErrors();
+        testCancel();
+    }catch(std::exception& e){
+        testAbort("Unexpected exception: %s", e.what());
+    }
+    return testDone();
+}
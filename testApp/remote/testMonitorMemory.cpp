@@ -0,0 +1,163 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* Memory footprint of many monitor queues.
+ *
+ * Opens N MonitorFIFOs, as a server does for N subscriptions,
+ * and posts one update to each.  Reports the increase in resident size
+ * per monitor, and the time to open each.  Then closes all, and opens
+ * them again, which re-uses elements when $EPICS_PVA_MONITOR_POOL_SIZE
+ * (or -P) allows.
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <epicsGetopt.h>
+#include <epicsTime.h>
+
+#include <pv/pvData.h>
+#include <pv/createRequest.h>
+#include <pv/monitor.h>
+#include <pv/elementPool.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+#define DEFAULT_MONITORS 100000
+#define DEFAULT_QUEUE 4
+#define DEFAULT_FIELDS 8
+
+// resident set size in bytes, or 0 if not known
+double residentSize()
+{
+    double ret = 0.0;
+    FILE *fp = fopen("/proc/self/statm", "r");
+    if(fp) {
+        unsigned long size, resident;
+        if(fscanf(fp, "%lu %lu", &size, &resident)==2)
+            ret = double(resident)*4096.0;
+        fclose(fp);
+    }
+    return ret;
+}
+
+struct DummyRequester : public pva::MonitorRequester {
+    virtual ~DummyRequester() {}
+    virtual std::string getRequesterName() OVERRIDE FINAL { return "testMonitorMemory"; }
+    virtual void monitorConnect(pvd::Status const &, pva::MonitorPtr const &, pvd::StructureConstPtr const &) OVERRIDE FINAL {}
+    virtual void monitorEvent(pva::MonitorPtr const &) OVERRIDE FINAL {}
+    virtual void unlisten(pva::MonitorPtr const &) OVERRIDE FINAL {}
+};
+
+void usage()
+{
+    fprintf(stderr, "\nUsage: testMonitorMemory [options]\n\n"
+            "  -h: Help: Print this message\n"
+            "options:\n"
+            "  -N <monitors>:     number of monitors, default is %d\n"
+            "  -q <size>:         queueSize, default is %d\n"
+            "  -f <fields>:       number of double fields, default is %d\n"
+            "  -P <elements>:     element pool size, default is $EPICS_PVA_MONITOR_POOL_SIZE\n\n",
+            DEFAULT_MONITORS, DEFAULT_QUEUE, DEFAULT_FIELDS);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int nmonitors = DEFAULT_MONITORS, queueSize = DEFAULT_QUEUE, nfields = DEFAULT_FIELDS, poolSize = -1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "hN:q:f:P:")) != -1) {
+        switch(opt) {
+        case 'N': nmonitors = atoi(optarg); break;
+        case 'q': queueSize = atoi(optarg); break;
+        case 'f': nfields = atoi(optarg); break;
+        case 'P': poolSize = atoi(optarg); break;
+        case 'h': usage(); return 0;
+        default: usage(); return 1;
+        }
+    }
+
+    if(nmonitors<1 || queueSize<1 || nfields<1) {
+        fprintf(stderr, "Invalid options\n");
+        return 1;
+    }
+
+    try {
+        pva::detail::ElementPool& pool = pva::detail::ElementPool::instance();
+        if(poolSize>=0)
+            pool.setLimit(size_t(poolSize));
+
+        pvd::StructureConstPtr type;
+        {
+            pvd::FieldBuilderPtr builder(pvd::getFieldCreate()->createFieldBuilder());
+            for(int i=0; i<nfields; i++) {
+                char name[16];
+                sprintf(name, "f%d", i);
+                builder = builder->add(name, pvd::pvDouble);
+            }
+            type = builder->createStructure();
+        }
+        pvd::PVStructurePtr value(pvd::getPVDataCreate()->createPVStructure(type));
+        pvd::BitSet changed;
+        changed.set(0);
+
+        pvd::PVStructure::shared_pointer pvRequest(pvd::createRequest(""));
+        pva::MonitorRequester::shared_pointer req(new DummyRequester);
+
+        pva::MonitorFIFO::Config conf;
+        conf.maxCount = conf.defCount = queueSize;
+
+        std::vector<pva::MonitorFIFO::shared_pointer> monitors(nmonitors);
+        for(int i=0; i<nmonitors; i++)
+            monitors[i].reset(new pva::MonitorFIFO(req, pvRequest, pva::MonitorFIFO::Source::shared_pointer(), &conf));
+
+        printf("# round monitors queue pool seconds us/monitor RSS_MB bytes/monitor\n");
+
+        const double rss0 = residentSize();
+
+        for(int round=0; round<2; round++) {
+            epicsTimeStamp start, end;
+            epicsTimeGetCurrent(&start);
+
+            for(int i=0; i<nmonitors; i++) {
+                monitors[i]->open(type);
+                monitors[i]->notify();
+                monitors[i]->post(*value, changed);
+            }
+
+            epicsTimeGetCurrent(&end);
+            double elapsed = epicsTimeDiffInSeconds(&end, &start);
+            double rss = residentSize();
+
+            printf("%d %d %d %zu %.3f %.2f %.1f %.0f\n",
+                   round, nmonitors, queueSize, pool.limit(),
+                   elapsed, elapsed*1e6/nmonitors,
+                   rss/1048576.0, (rss-rss0)/nmonitors);
+
+            for(int i=0; i<nmonitors; i++) {
+                monitors[i]->close();
+                monitors[i]->notify();
+            }
+        }
+
+        pva::detail::ElementPool::Stats stats;
+        pool.getStats(stats);
+        printf("# pooled reused missed discarded\n");
+        printf("%zu %zu %zu %zu\n", stats.pooled, stats.reused, stats.missed, stats.discarded);
+
+    }catch(std::exception& e){
+        std::cerr<<"Error: "<<e.what()<<"\n";
+        return 1;
+    }
+    return 0;
+}
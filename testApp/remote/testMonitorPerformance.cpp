@@ -35,6 +35,7 @@ using namespace epics::pvAccess;
 #define DEFAULT_CHANNELS 1
 #define DEFAULT_ARRAY_SIZE 0
 #define DEFAULT_RUNS 1
+#define DEFAULT_BATCH 0
 
 bool verbose = false;
 
@@ -42,6 +43,7 @@ int iterations = DEFAULT_ITERATIONS;
 int channels = DEFAULT_CHANNELS;
 int runs = DEFAULT_RUNS;
 int arraySize = DEFAULT_ARRAY_SIZE;          // 0 means scalar
+int batch = DEFAULT_BATCH;                   // 0 means do not compare
 Mutex waitLoopPtrMutex;
 TR1::shared_ptr<Event> waitLoopEvent;
 
@@ -76,12 +78,13 @@ void usage (void)
              "  -c <channels>:     number of channels, default is '%d'\n"
              "  -s <array size>:   number of array elements (0 means scalar), default is '%d'\n"
              "  -l <runs>:         number of runs (0 means execute runs continuously), default is '%d'\n"
+             "  -b <batch>:        also run each test with record._options.batch=<batch> and compare (0 means no comparison), default is '%d'\n"
              "  -f <filename>:     read configuration file that contains list of tests to be performed\n"
              "                         each test is defined by a \"<c> <s> <i> <l>\" line\n"
              "                         output is a space separated list of get operations per second for each run, one line per test\n"
              "  -v                 enable verbose output when configuration is read from the file\n"
              "  -w <sec>:          wait time, specifies timeout, default is %f second(s)\n\n"
-             , DEFAULT_REQUEST, DEFAULT_ITERATIONS, DEFAULT_CHANNELS, DEFAULT_ARRAY_SIZE, DEFAULT_RUNS, DEFAULT_TIMEOUT);
+             , DEFAULT_REQUEST, DEFAULT_ITERATIONS, DEFAULT_CHANNELS, DEFAULT_ARRAY_SIZE, DEFAULT_RUNS, DEFAULT_BATCH, DEFAULT_TIMEOUT);
 }
 
 // TODO thread-safety
@@ -367,6 +370,50 @@ void runTest()
     waitLoopEvent->wait();
 }
 
+// insert record._options.batch=<n> into a pvRequest string
+string batchRequest(const string& req, int n)
+{
+    char buf[32];
+    sprintf(buf, "batch=%d", n);
+
+    string ret(req);
+    size_t idx = ret.find("record[");
+    if (idx == string::npos)
+        ret = string("record[") + buf + "]" + ret;
+    else
+        ret.insert(idx + 7, string(buf) + ",");
+    return ret;
+}
+
+// run the test w/o, and then w/ batched monitor updates
+void runTests()
+{
+    if (batch <= 0)
+    {
+        runTest();
+        return;
+    }
+
+    PVStructure::shared_pointer plainRequest(pvRequest);
+
+    runTest();
+    double plain = sum/runs;
+
+    pvRequest = CreateRequest::create()->createRequest(batchRequest(request, batch));
+    if (!pvRequest)
+    {
+        fprintf(stderr, "failed to parse batched request string\n");
+        exit(1);
+    }
+    runTest();
+    double batched = sum/runs;
+
+    pvRequest = plainRequest;
+
+    if (verbose)
+        printf("batch=%d: %.3f -> %.3f monitors/s (x %.2f)\n", batch, plain, batched, plain > 0 ? batched/plain : 0.0);
+}
+
 int main (int argc, char *argv[])
 {
     int opt;                    // getopt() current option
@@ -374,7 +421,7 @@ int main (int argc, char *argv[])
 
     setvbuf(stdout,NULL,_IOLBF,BUFSIZ);    // Set stdout to line buffering
 
-    while ((opt = getopt(argc, argv, ":hr:w:i:c:s:l:f:v")) != -1) {
+    while ((opt = getopt(argc, argv, ":hr:w:i:c:s:l:b:f:v")) != -1) {
         switch (opt) {
         case 'h':               // Print usage
             usage();
@@ -402,6 +449,9 @@ int main (int argc, char *argv[])
         case 'l':               // runs
             runs = atoi(optarg);
             break;
+        case 'b':               // batch
+            batch = atoi(optarg);
+            break;
         case 'f':               // testFile
             testFile = optarg;
             break;
@@ -454,7 +504,7 @@ int main (int argc, char *argv[])
                         if (sscanf(line.c_str(), "%d %d %d %d", &channels, &arraySize, &iterations, &runs) == 4)
                         {
                             //printf("%d %d %d %d\n", channels, arraySize, iterations, runs);
-                            runTest();
+                            runTests();
 
                             // wait a bit for a next test
                             epicsThreadSleep(1.0);
@@ -485,7 +535,7 @@ int main (int argc, char *argv[])
     {
         // in non-file mode, verbose is true by default
         verbose = true;
-        runTest();
+        runTests();
     }
 
     //ClientFactory::stop();
@@ -0,0 +1,203 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* Subscription setup latency.
+ *
+ * Starts a server in this process with one PV, connects one client channel,
+ * then creates N subscriptions and waits for the first update of each.
+ * All are cancelled, and this is repeated for several rounds.
+ * Reports the time for each round.
+ *
+ * Client and server monitor queues re-use elements of earlier rounds
+ * when $EPICS_PVA_MONITOR_POOL_SIZE (or -P) allows.
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <sstream>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <epicsGetopt.h>
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+#include <epicsEvent.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+
+#include <pv/createRequest.h>
+#include <pv/configuration.h>
+#include <pv/clientFactory.h>
+#include <pv/serverContext.h>
+#include <pv/standardField.h>
+#include <pv/elementPool.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+#include <pva/client.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+typedef epicsGuard<epicsMutex> Guard;
+
+namespace {
+
+#define DEFAULT_MONITORS 10000
+#define DEFAULT_ROUNDS 3
+#define DEFAULT_QUEUE 4
+#define DEFAULT_TIMEOUT 60.0
+
+struct Updated {
+    epicsMutex mutex;
+    epicsEvent done;
+    size_t expect, count;
+    Updated() :expect(0u), count(0u) {}
+};
+
+struct FirstUpdate : public pvac::ClientChannel::MonitorCallback
+{
+    Updated& updated;
+    bool seen;
+
+    explicit FirstUpdate(Updated& updated) :updated(updated), seen(false) {}
+    virtual ~FirstUpdate() {}
+
+    virtual void monitorEvent(const pvac::MonitorEvent& evt) OVERRIDE FINAL
+    {
+        if(evt.event!=pvac::MonitorEvent::Data)
+            return;
+
+        Guard G(updated.mutex);
+        if(seen)
+            return;
+        seen = true;
+        if(++updated.count==updated.expect)
+            updated.done.signal();
+    }
+};
+
+void usage()
+{
+    fprintf(stderr, "\nUsage: testMonitorSetup [options]\n\n"
+            "  -h: Help: Print this message\n"
+            "options:\n"
+            "  -N <monitors>:     number of subscriptions, default is %d\n"
+            "  -r <rounds>:       number of rounds, default is %d\n"
+            "  -q <size>:         queueSize, default is %d\n"
+            "  -P <elements>:     element pool size, default is $EPICS_PVA_MONITOR_POOL_SIZE\n"
+            "  -w <sec>:          give up after, default is %.1f\n\n",
+            DEFAULT_MONITORS, DEFAULT_ROUNDS, DEFAULT_QUEUE, DEFAULT_TIMEOUT);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int nmonitors = DEFAULT_MONITORS, nrounds = DEFAULT_ROUNDS, queueSize = DEFAULT_QUEUE, poolSize = -1;
+    double timeout = DEFAULT_TIMEOUT;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "hN:r:q:P:w:")) != -1) {
+        switch(opt) {
+        case 'N': nmonitors = atoi(optarg); break;
+        case 'r': nrounds = atoi(optarg); break;
+        case 'q': queueSize = atoi(optarg); break;
+        case 'P': poolSize = atoi(optarg); break;
+        case 'w': timeout = atof(optarg); break;
+        case 'h': usage(); return 0;
+        default: usage(); return 1;
+        }
+    }
+
+    if(nmonitors<1 || nrounds<1 || queueSize<2) {
+        fprintf(stderr, "Invalid options\n");
+        return 1;
+    }
+
+    try {
+        pva::detail::ElementPool& pool = pva::detail::ElementPool::instance();
+        if(poolSize>=0)
+            pool.setLimit(size_t(poolSize));
+
+        pvas::SharedPV::shared_pointer pv(pvas::SharedPV::buildReadOnly());
+        pv->open(*pvd::getPVDataCreate()->createPVStructure(pvd::getStandardField()->scalar(pvd::pvDouble, "alarm,timeStamp")));
+
+        pvas::StaticProvider prov("setup");
+        prov.add("setup:pv", pv);
+
+        pva::ServerContext::shared_pointer serv(pva::ServerContext::create(pva::ServerContext::Config()
+                                                                           .config(pva::ConfigurationBuilder()
+                                                                                   .add("EPICS_PVAS_INTF_ADDR_LIST", "127.0.0.1")
+                                                                                   .add("EPICS_PVA_ADDR_LIST", "127.0.0.1")
+                                                                                   .add("EPICS_PVA_AUTO_ADDR_LIST","0")
+                                                                                   .add("EPICS_PVA_SERVER_PORT", "0")
+                                                                                   .add("EPICS_PVA_BROADCAST_PORT", "0")
+                                                                                   .push_map()
+                                                                                   .build())
+                                                                           .provider(prov.provider())));
+
+        pva::ClientFactory::start();
+        pvac::ClientProvider client("pva", serv->getCurrentConfig());
+        pvac::ClientChannel chan(client.connect("setup:pv"));
+
+        pvd::PVStructure::shared_pointer pvRequest;
+        {
+            std::ostringstream req;
+            req<<"record[queueSize="<<queueSize<<"]field()";
+            pvRequest = pvd::createRequest(req.str());
+        }
+
+        printf("# round monitors queue pool seconds monitors/s reused\n");
+
+        int ret = 0;
+        for(int round=0; round<nrounds && ret==0; round++) {
+            Updated updated;
+            updated.expect = nmonitors;
+
+            std::vector<FirstUpdate*> callbacks(nmonitors);
+            std::vector<pvac::Monitor> monitors(nmonitors);
+
+            pva::detail::ElementPool::Stats before, after;
+            pool.getStats(before);
+
+            epicsTimeStamp start, end;
+            epicsTimeGetCurrent(&start);
+
+            for(int i=0; i<nmonitors; i++) {
+                callbacks[i] = new FirstUpdate(updated);
+                monitors[i] = chan.monitor(callbacks[i], pvRequest);
+            }
+
+            bool complete = updated.done.wait(timeout);
+            epicsTimeGetCurrent(&end);
+            pool.getStats(after);
+
+            double elapsed = epicsTimeDiffInSeconds(&end, &start);
+            printf("%d %d %d %zu %.3f %.0f %zu\n",
+                   round, nmonitors, queueSize, pool.limit(),
+                   elapsed, nmonitors/elapsed, after.reused-before.reused);
+
+            if(!complete) {
+                fprintf(stderr, "Timeout\n");
+                ret = 1;
+            }
+
+            for(int i=0; i<nmonitors; i++) {
+                monitors[i].cancel();
+                delete callbacks[i];
+            }
+            monitors.clear();
+
+            // allow server side subscriptions to be destroyed
+            epicsThreadSleep(0.5);
+        }
+
+        return ret;
+    }catch(std::exception& e){
+        std::cerr<<"Error: "<<e.what()<<"\n";
+        return 1;
+    }
+}
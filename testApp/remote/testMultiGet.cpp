@@ -0,0 +1,171 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* Time to read many PVs (eg. a snapshot).
+ *
+ * Starts a server in this process with one PV under many names, and connects to all.
+ * Then reads all, once with ClientChannel::get() for each name, and once
+ * with ClientProvider::get() of all channels for each batch size (gets in progress).
+ * Reports the total time of each.
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <sstream>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <epicsGetopt.h>
+#include <epicsTime.h>
+#include <epicsEvent.h>
+
+#include <pv/configuration.h>
+#include <pv/clientFactory.h>
+#include <pv/serverContext.h>
+#include <pv/standardField.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+#include <pva/client.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+#define DEFAULT_COUNT 50000
+#define DEFAULT_TIMEOUT 60.0
+
+struct Connected : public pvac::ClientProvider::ConnectAllCallback
+{
+    epicsEvent done;
+    virtual ~Connected() {}
+    virtual void connectAllDone() OVERRIDE FINAL { done.signal(); }
+};
+
+double sequential(std::vector<pvac::ClientChannel>& channels)
+{
+    epicsTimeStamp start, end;
+    epicsTimeGetCurrent(&start);
+    for(size_t i=0; i<channels.size(); i++)
+        channels[i].get();
+    epicsTimeGetCurrent(&end);
+    return epicsTimeDiffInSeconds(&end, &start);
+}
+
+double batched(pvac::ClientProvider& client, std::vector<pvac::ClientChannel>& channels,
+               size_t window, double timeout)
+{
+    std::vector<pvac::GetEvent> results;
+
+    epicsTimeStamp start, end;
+    epicsTimeGetCurrent(&start);
+    size_t nok = client.get(channels, results, timeout, pvd::PVStructure::const_shared_pointer(), window);
+    epicsTimeGetCurrent(&end);
+
+    if(nok!=channels.size()) {
+        std::ostringstream strm;
+        strm<<"Only "<<nok<<" of "<<channels.size()<<" gets succeeded";
+        throw std::runtime_error(strm.str());
+    }
+    return epicsTimeDiffInSeconds(&end, &start);
+}
+
+void usage()
+{
+    fprintf(stderr, "\nUsage: testMultiGet [options]\n\n"
+            "  -h: Help: Print this message\n"
+            "options:\n"
+            "  -n <count>:        number of PVs, default is %d\n"
+            "  -b <size>:         batch size, may be repeated.  0 is unlimited.  default is 1, 16, 256, 4096, and 0\n"
+            "  -w <sec>:          timeout, default is %.1f\n\n",
+            DEFAULT_COUNT, DEFAULT_TIMEOUT);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int count = DEFAULT_COUNT;
+    std::vector<size_t> windows;
+    double timeout = DEFAULT_TIMEOUT;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "hn:b:w:")) != -1) {
+        switch(opt) {
+        case 'n': count = atoi(optarg); break;
+        case 'b': windows.push_back(atoi(optarg)); break;
+        case 'w': timeout = atof(optarg); break;
+        case 'h': usage(); return 0;
+        default: usage(); return 1;
+        }
+    }
+
+    if(count<1) {
+        fprintf(stderr, "Invalid options\n");
+        return 1;
+    }
+
+    if(windows.empty()) {
+        windows.push_back(1u);
+        windows.push_back(16u);
+        windows.push_back(256u);
+        windows.push_back(4096u);
+        windows.push_back(0u);
+    }
+
+    try {
+        pvas::SharedPV::shared_pointer pv(pvas::SharedPV::buildReadOnly());
+        pv->open(pvd::getStandardField()->scalar(pvd::pvDouble, "alarm,timeStamp"));
+
+        std::vector<std::string> names(count);
+        pvas::StaticProvider prov("snap");
+        for(int i=0; i<count; i++) {
+            std::ostringstream strm;
+            strm<<"snap:"<<i;
+            names[i] = strm.str();
+            prov.add(names[i], pv);
+        }
+
+        pva::ServerContext::shared_pointer serv(pva::ServerContext::create(pva::ServerContext::Config()
+                                                                           .config(pva::ConfigurationBuilder()
+                                                                                   .add("EPICS_PVAS_INTF_ADDR_LIST", "127.0.0.1")
+                                                                                   .add("EPICS_PVA_ADDR_LIST", "127.0.0.1")
+                                                                                   .add("EPICS_PVA_AUTO_ADDR_LIST","0")
+                                                                                   .add("EPICS_PVA_SERVER_PORT", "0")
+                                                                                   .add("EPICS_PVA_BROADCAST_PORT", "0")
+                                                                                   .push_map()
+                                                                                   .build())
+                                                                           .provider(prov.provider())));
+
+        pva::ClientFactory::start();
+
+        pvac::ClientProvider client("pva", pva::ConfigurationBuilder()
+                                    .push_config(serv->getCurrentConfig())
+                                    .push_map()
+                                    .build());
+
+        std::vector<pvac::ClientChannel> channels;
+        Connected connected;
+        pvac::Operation op(client.connect(names, channels, &connected));
+        if(!connected.done.wait(timeout))
+            throw std::runtime_error("Timeout connecting");
+
+        printf("# mode batch pvs total_s gets/s\n");
+        {
+            double t = sequential(channels);
+            printf("sequential 1 %d %.3f %.0f\n", count, t, count/t);
+        }
+        for(size_t i=0; i<windows.size(); i++) {
+            double t = batched(client, channels, windows[i], timeout);
+            printf("batched %zu %d %.3f %.0f\n", windows[i], count, t, count/t);
+        }
+
+    }catch(std::exception& e){
+        std::cerr<<"Error: "<<e.what()<<"\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* Channel name lookup micro-benchmark.
+ *
+ * Names are looked up as ServerSearchHandler does, with channelFind()
+ * of every provider, for a number of StaticProviders sharing many PVs.
+ * Reports names resolved per second.
+ *
+ * See testSearchStorm for the complete search path, including
+ * $EPICS_PVAS_SEARCH_NEGATIVE_TTL .
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <epicsGetopt.h>
+#include <epicsTime.h>
+
+#include <pv/pvAccess.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+#define DEFAULT_PVS 200000
+#define DEFAULT_PROVIDERS 4
+#define DEFAULT_MISSING 50
+#define DEFAULT_DURATION 3.0
+
+struct CountingRequester : public pva::ChannelFindRequester
+{
+    size_t found, notFound;
+    CountingRequester() :found(0u), notFound(0u) {}
+    virtual ~CountingRequester() {}
+    virtual void channelFindResult(const pvd::Status&, const pva::ChannelFind::shared_pointer&, bool wasFound) OVERRIDE FINAL
+    {
+        if(wasFound)
+            found++;
+        else
+            notFound++;
+    }
+};
+
+void usage()
+{
+    fprintf(stderr, "\nUsage: testNameLookup [options]\n\n"
+            "  -h: Help: Print this message\n"
+            "options:\n"
+            "  -N <pvs>:          number of PVs served, default is %d\n"
+            "  -p <providers>:    number of providers, PVs divided between them, default is %d\n"
+            "  -x <percent>:      percentage of names not found, default is %d\n"
+            "  -d <sec>:          duration, default is %.1f\n\n",
+            DEFAULT_PVS, DEFAULT_PROVIDERS, DEFAULT_MISSING, DEFAULT_DURATION);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int npvs = DEFAULT_PVS, nproviders = DEFAULT_PROVIDERS, missingPercent = DEFAULT_MISSING;
+    double duration = DEFAULT_DURATION;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "hN:p:x:d:")) != -1) {
+        switch(opt) {
+        case 'N': npvs = atoi(optarg); break;
+        case 'p': nproviders = atoi(optarg); break;
+        case 'x': missingPercent = atoi(optarg); break;
+        case 'd': duration = atof(optarg); break;
+        case 'h': usage(); return 0;
+        default: usage(); return 1;
+        }
+    }
+
+    if(npvs<1 || nproviders<1 || missingPercent<0 || missingPercent>100) {
+        fprintf(stderr, "Invalid options\n");
+        return 1;
+    }
+
+    try {
+        pvas::SharedPV::shared_pointer pv(pvas::SharedPV::buildReadOnly());
+
+        std::vector<std::tr1::shared_ptr<pvas::StaticProvider> > statics(nproviders);
+        std::vector<pva::ChannelProvider::shared_pointer> providers(nproviders);
+        for(int p=0; p<nproviders; p++) {
+            std::ostringstream name;
+            name<<"lookup"<<p;
+            statics[p].reset(new pvas::StaticProvider(name.str()));
+            providers[p] = statics[p]->provider();
+        }
+
+        // names searched for, in a fixed pseudo-random order
+        std::vector<std::string> names(npvs);
+        for(int i=0; i<npvs; i++) {
+            std::ostringstream name;
+            name<<"lookup:"<<i<<":value";
+            statics[i%nproviders]->add(name.str(), pv);
+
+            if((i%100) < missingPercent)
+                name<<":missing";
+            names[i] = name.str();
+        }
+        for(size_t i=names.size()-1u; i>0u; i--)
+            std::swap(names[i], names[size_t(rand())%(i+1u)]);
+
+        std::tr1::shared_ptr<CountingRequester> req(new CountingRequester);
+
+        size_t lookups = 0u;
+        epicsTimeStamp start, now;
+        epicsTimeGetCurrent(&start);
+
+        do {
+            for(size_t i=0; i<names.size(); i++) {
+                for(size_t p=0; p<providers.size(); p++)
+                    providers[p]->channelFind(names[i], req);
+            }
+            lookups += names.size();
+            epicsTimeGetCurrent(&now);
+        } while(epicsTimeDiffInSeconds(&now, &start) < duration);
+
+        double elapsed = epicsTimeDiffInSeconds(&now, &start);
+
+        printf("# pvs providers missing_%% names names/s found not_found\n");
+        printf("%d %d %d %zu %.0f %zu %zu\n",
+               npvs, nproviders, missingPercent,
+               lookups, lookups/elapsed, req->found, req->notFound);
+
+    }catch(std::exception& e){
+        std::cerr<<"Error: "<<e.what()<<"\n";
+        return 1;
+    }
+    return 0;
+}
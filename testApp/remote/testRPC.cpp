@@ -1,4 +1,13 @@
 
+#include <vector>
+#include <deque>
+#include <string>
+#include <algorithm>
+
+#include <epicsEvent.h>
+#include <epicsThread.h>
+
+#include <pv/lock.h>
 #include <pv/epicsException.h>
 #include <pv/valueBuilder.h>
 
@@ -106,11 +115,329 @@ void testRPCFail(const pva::ChannelProvider::shared_pointer& cli_prov)
     }
 }
 
+struct CountCallback : public pva::RPCClient::AsyncCallback
+{
+    const size_t expect;
+    pvd::Mutex mutex;
+    size_t success, failure;
+    // of each failure
+    std::vector<std::string> messages;
+    epicsEvent done;
+
+    explicit CountCallback(size_t expect) :expect(expect), success(0u), failure(0u) {}
+    virtual ~CountCallback() {}
+
+    virtual void requestDone(pvd::Status const & status,
+                             pvd::PVStructure::shared_pointer const & response) OVERRIDE FINAL
+    {
+        pvd::Lock L(mutex);
+        if(status.isSuccess() && response) {
+            success++;
+        } else {
+            failure++;
+            messages.push_back(response ? std::string("unexpected response") : status.getMessage());
+        }
+        if(success+failure==expect)
+            done.signal();
+    }
+
+    size_t calls()
+    {
+        pvd::Lock L(mutex);
+        return success+failure;
+    }
+
+    bool waitCalls(size_t n)
+    {
+        for(unsigned i=0; i<500u && calls()<n; i++)
+            epicsThreadSleep(0.01);
+        return calls()==n;
+    }
+
+    bool failedWith(const std::string& msg)
+    {
+        pvd::Lock L(mutex);
+        for(size_t i=0; i<messages.size(); i++) {
+            if(messages[i]!=msg) {
+                testDiag("Failed with '%s'", messages[i].c_str());
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Replies only when release()d, so that requests remain in progress.
+struct DelayService : public pva::RPCServiceAsync
+{
+    POINTER_DEFINITIONS(DelayService);
+
+    pvd::Mutex mutex;
+    std::deque<std::pair<double, pva::RPCResponseCallback::shared_pointer> > held;
+    size_t maxHeld;
+
+    DelayService() :maxHeld(0u) {}
+    virtual ~DelayService() {}
+
+    virtual void request(
+        epics::pvData::PVStructure::shared_pointer const & args,
+        pva::RPCResponseCallback::shared_pointer const & callback
+    ) OVERRIDE FINAL
+    {
+        double value = args->getSubFieldT<pvd::PVScalar>("query.value")->getAs<double>();
+        pvd::Lock L(mutex);
+        held.push_back(std::make_pair(value, callback));
+        maxHeld = std::max(maxHeld, held.size());
+    }
+
+    size_t inProgress()
+    {
+        pvd::Lock L(mutex);
+        return held.size();
+    }
+
+    bool waitInProgress(size_t n)
+    {
+        for(unsigned i=0; i<500u && inProgress()!=n; i++)
+            epicsThreadSleep(0.01);
+        return inProgress()==n;
+    }
+
+    // reply to the oldest 'n' with their value
+    void release(size_t n)
+    {
+        std::deque<std::pair<double, pva::RPCResponseCallback::shared_pointer> > replies;
+        {
+            pvd::Lock L(mutex);
+            for(; n && !held.empty(); n--) {
+                replies.push_back(held.front());
+                held.pop_front();
+            }
+        }
+        for(size_t i=0; i<replies.size(); i++) {
+            pvd::PVStructure::shared_pointer reply(pvd::getPVDataCreate()->createPVStructure(reply_type));
+            reply->getSubFieldT<pvd::PVDouble>("value")->put(replies[i].first);
+            replies[i].second->requestDone(pvd::Status::Ok, reply);
+        }
+    }
+};
+
+pva::RPCClient::AsyncRequest::shared_pointer issueDelay(pva::RPCClient& client, size_t value,
+                                                       const pva::RPCClient::AsyncCallback::shared_pointer& callback)
+{
+    pvd::ValueBuilder args("epics:nt/NTURI:1.0");
+    args.add<pvd::pvString>("scheme", "pva")
+        .add<pvd::pvString>("path", "delay");
+    return client.issueAsync(args.addNested("query")
+                                 .add<pvd::pvDouble>("value", double(value))
+                             .endNested()
+                             .buildPVStructure(),
+                             callback);
+}
+
+// wait() of each request not yet done fails with 'msg'
+size_t countFailed(const std::vector<pva::RPCClient::AsyncRequest::shared_pointer>& requests,
+                   const std::vector<bool>& skip, const char *msg)
+{
+    size_t ret = 0u;
+    for(size_t i=0; i<requests.size(); i++) {
+        if(skip[i])
+            continue;
+        try{
+            (void)requests[i]->wait(5.0);
+        }catch(pva::RPCRequestException& e){
+            if(std::string(e.what()).find(msg)!=std::string::npos)
+                ret++;
+            else
+                testDiag("Request %u failed with '%s'", unsigned(i), e.what());
+        }
+    }
+    return ret;
+}
+
+void testAsyncSum(const pva::ChannelProvider::shared_pointer& cli_prov)
+{
+    testDiag("Async");
+
+    pva::RPCClient client("sum", pvd::createRequest("field()"), cli_prov);
+    client.setMaxInFlight(4u);
+    testOk1(client.maxInFlight()==4u);
+
+    const size_t count = 20u;
+    std::tr1::shared_ptr<CountCallback> callback(new CountCallback(count));
+
+    // issued before connecting
+    std::vector<pva::RPCClient::AsyncRequest::shared_pointer> requests;
+    for(size_t i=0; i<count; i++) {
+        pvd::ValueBuilder args("epics:nt/NTURI:1.0");
+        args.add<pvd::pvString>("scheme", "pva")
+            .add<pvd::pvString>("path", "sum");
+        requests.push_back(client.issueAsync(args.addNested("query")
+                                                 .add<pvd::pvDouble>("lhs", double(i))
+                                                 .add<pvd::pvDouble>("rhs", 1.0)
+                                             .endNested()
+                                             .buildPVStructure(),
+                                             callback));
+    }
+
+    bool ok = true;
+    for(size_t i=0; i<count; i++) {
+        pvd::PVStructurePtr reply(requests[i]->wait());
+        pvd::int32 value = reply->getSubFieldT<pvd::PVScalar>("value")->getAs<pvd::int32>();
+        if(value!=pvd::int32(i+1)) {
+            testDiag("Reply %u value = %d", unsigned(i), (int)value);
+            ok = false;
+        }
+        ok &= requests[i]->isDone();
+    }
+    testOk(ok, "%u replies", unsigned(count));
+
+    callback->done.wait(5.0);
+    pvd::Lock L(callback->mutex);
+    testOk(callback->success==count && callback->failure==0u, "callbacks success=%u failure=%u",
+           unsigned(callback->success), unsigned(callback->failure));
+}
+
+void testAsyncFail(const pva::ChannelProvider::shared_pointer& cli_prov)
+{
+    testDiag("Async Fail");
+
+    pva::RPCClient client("fail", pvd::createRequest("field()"), cli_prov);
+
+    pvd::ValueBuilder args("epics:nt/NTURI:1.0");
+    args.add<pvd::pvString>("scheme", "pva")
+        .add<pvd::pvString>("path", "fail");
+
+    std::tr1::shared_ptr<CountCallback> callback(new CountCallback(1u));
+    pva::RPCClient::AsyncRequest::shared_pointer request(client.issueAsync(args.buildPVStructure(), callback));
+    try{
+        (void)request->wait();
+        testFail("Missing expected exception");
+    }catch(pva::RPCRequestException& e){
+        testPass("caught expected rpc exception: %s", e.what());
+    }catch(std::exception& e){
+        testFail("caught un-expected exception: %s", e.what());
+    }
+    testOk1(request->isDone());
+    // called after waiters are woken
+    callback->done.wait(5.0);
+    {
+        pvd::Lock L(callback->mutex);
+        testOk(callback->success==0u && callback->failure==1u && callback->messages[0]=="oops",
+               "callback failure=%u", unsigned(callback->failure));
+    }
+
+    client.destroy();
+    try{
+        (void)client.issueAsync(args.buildPVStructure());
+        testFail("Missing expected exception");
+    }catch(std::logic_error& e){
+        testPass("caught expected exception after destroy: %s", e.what());
+    }
+}
+
+void testAsyncConcurrent(pva::RPCServer& serv, const pva::ChannelProvider::shared_pointer& cli_prov)
+{
+    testDiag("Async Concurrent");
+
+    DelayService::shared_pointer service(new DelayService);
+    serv.registerService("delay", service);
+    {
+        pva::RPCClient client("delay", pvd::createRequest("field()"), cli_prov);
+        client.setMaxInFlight(4u);
+
+        const size_t count = 10u;
+        std::tr1::shared_ptr<CountCallback> callback(new CountCallback(count));
+        std::vector<pva::RPCClient::AsyncRequest::shared_pointer> requests;
+        for(size_t i=0; i<count; i++)
+            requests.push_back(issueDelay(client, i, callback));
+
+        testOk(service->waitInProgress(4u), "%u requests in progress at once", unsigned(service->inProgress()));
+        bool ok = true;
+        for(size_t i=0; i<count; i++)
+            ok &= !requests[i]->isDone();
+        testOk(ok, "none done while held");
+
+        // two complete, and two queued requests take their place
+        service->release(2u);
+        testOk1(callback->waitCalls(2u));
+        testOk(service->waitInProgress(4u), "%u in progress after two complete", unsigned(service->inProgress()));
+        testOk(service->maxHeld==4u, "at most %u in progress", unsigned(service->maxHeld));
+
+        std::vector<bool> done(count);
+        ok = true;
+        for(size_t i=0; i<count; i++) {
+            done[i] = requests[i]->isDone();
+            if(done[i]) {
+                pvd::PVStructurePtr reply(requests[i]->wait());
+                ok &= reply->getSubFieldT<pvd::PVScalar>("value")->getAs<pvd::int32>()==pvd::int32(i);
+            }
+        }
+        testOk(ok && std::count(done.begin(), done.end(), true)==2, "2 replies");
+
+        // four in progress, and four queued
+        client.destroy();
+
+        testOk(countFailed(requests, done, "RPCClient destroyed")==8u, "8 requests failed by destroy()");
+        bool destroyed = callback->failedWith("RPCClient destroyed");
+        pvd::Lock L(callback->mutex);
+        testOk(callback->success==2u && callback->failure==8u && destroyed,
+               "callbacks success=%u failure=%u", unsigned(callback->success), unsigned(callback->failure));
+    }
+    // replies to destroyed operations are ignored
+    service->release(service->inProgress());
+    serv.unregisterService("delay");
+}
+
+void testAsyncDisconnect(const pva::Configuration::shared_pointer& conf)
+{
+    testDiag("Async Disconnect");
+
+    // a server of our own to stop
+    pva::RPCServer serv(conf);
+    DelayService::shared_pointer service(new DelayService);
+    serv.registerService("delay", service);
+
+    pva::ChannelProvider::shared_pointer cli_prov(pva::ChannelProviderRegistry::clients()->createProvider("pva",
+                                                                                                          serv.getServer()->getCurrentConfig()));
+    if(!cli_prov)
+        testAbort("No pva provider");
+
+    pva::RPCClient client("delay", pvd::createRequest("field()"), cli_prov);
+    client.setMaxInFlight(2u);
+
+    std::tr1::shared_ptr<CountCallback> callback(new CountCallback(3u));
+    std::vector<pva::RPCClient::AsyncRequest::shared_pointer> requests;
+    for(size_t i=0; i<3u; i++)
+        requests.push_back(issueDelay(client, i, callback));
+
+    testOk(service->waitInProgress(2u), "%u requests in progress", unsigned(service->inProgress()));
+
+    serv.destroy();
+
+    // in progress requests fail.  The queued request waits for a new connection.
+    testOk1(callback->waitCalls(2u));
+    std::vector<pva::RPCClient::AsyncRequest::shared_pointer> inProgress(requests.begin(), requests.begin()+2);
+    testOk(countFailed(inProgress, std::vector<bool>(2u), "Connection lost")==2u, "2 requests failed by disconnect");
+    testOk1(!requests[2]->isDone());
+
+    client.destroy();
+    testOk1(countFailed(std::vector<pva::RPCClient::AsyncRequest::shared_pointer>(1u, requests[2]),
+                        std::vector<bool>(1u), "RPCClient destroyed")==1u);
+    {
+        pvd::Lock L(callback->mutex);
+        testOk(callback->failure==3u && callback->messages.size()==3u
+               && callback->messages[0]=="Connection lost" && callback->messages[1]=="Connection lost"
+               && callback->messages[2]=="RPCClient destroyed",
+               "callbacks failure=%u", unsigned(callback->failure));
+    }
+}
+
 } // namespace
 
 MAIN(testRPC)
 {
-    testPlan(3);
+    testPlan(24);
     try {
         pva::Configuration::shared_pointer conf(pva::ConfigurationBuilder()
                                                 //.push_env()
@@ -148,6 +475,10 @@ MAIN(testRPC)
 
         testSum(cli_prov);
         testRPCFail(cli_prov);
+        testAsyncSum(cli_prov);
+        testAsyncFail(cli_prov);
+        testAsyncConcurrent(serv, cli_prov);
+        testAsyncDisconnect(conf);
 
     }catch(std::exception& e){
         PRINT_EXCEPTION(e);
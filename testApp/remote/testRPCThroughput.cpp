@@ -0,0 +1,289 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+/* RPC request throughput of one RPCClient.
+ *
+ * Starts a server in this process with an RPCServiceAsync, as rpcServiceAsyncExample,
+ * which replies after a delay from another thread (eg. a slow device or database).
+ * Makes requests with RPCClient::request() one at a time, then with RPCClient::issueAsync()
+ * keeping each number of requests in progress.  Reports requests per second of each.
+ */
+
+#include <iostream>
+#include <vector>
+#include <deque>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <epicsGetopt.h>
+#include <epicsThread.h>
+#include <epicsEvent.h>
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+#include <epicsTime.h>
+
+#include <pv/pvData.h>
+#include <pv/valueBuilder.h>
+#include <pv/configuration.h>
+#include <pv/clientFactory.h>
+#include <pv/serverContext.h>
+#include <pv/rpcServer.h>
+#include <pv/rpcClient.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+typedef epicsGuard<epicsMutex> Guard;
+typedef epicsGuardRelease<epicsMutex> UnGuard;
+
+namespace {
+
+#define DEFAULT_DURATION 1.0
+#define DEFAULT_DELAY 1000.0
+
+pvd::StructureConstPtr resultStructure(pvd::getFieldCreate()->createFieldBuilder()
+                                       ->add("c", pvd::pvDouble)
+                                       ->createStructure());
+
+class SumServiceImpl : public pva::RPCServiceAsync, public epicsThreadRunable
+{
+    struct Job {
+        epicsTimeStamp due;
+        pvd::PVStructurePtr result;
+        pva::RPCResponseCallback::shared_pointer callback;
+    };
+
+    const double delay;
+    epicsMutex mutex;
+    epicsEvent wakeup;
+    bool stopping;
+    // all have the same delay, so are due in order
+    std::deque<Job> jobs;
+    epicsThread worker;
+
+public:
+    explicit SumServiceImpl(double delay)
+        :delay(delay)
+        ,stopping(false)
+        ,worker(*this, "sumService", epicsThreadGetStackSize(epicsThreadStackSmall))
+    {
+        worker.start();
+    }
+    virtual ~SumServiceImpl()
+    {
+        {
+            Guard G(mutex);
+            stopping = true;
+        }
+        wakeup.signal();
+        worker.exitWait();
+    }
+
+    virtual void request(pvd::PVStructure::shared_pointer const & args,
+                         pva::RPCResponseCallback::shared_pointer const & callback)
+    {
+        pvd::PVScalar::shared_pointer af(args->getSubField<pvd::PVScalar>("query.a")),
+                                      bf(args->getSubField<pvd::PVScalar>("query.b"));
+        if(!af || !bf) {
+            callback->requestDone(pvd::Status::error("scalar 'a' and 'b' fields are required"),
+                                  pvd::PVStructure::shared_pointer());
+            return;
+        }
+
+        Job job;
+        job.result = pvd::getPVDataCreate()->createPVStructure(resultStructure);
+        job.result->getSubFieldT<pvd::PVDouble>("c")->put(af->getAs<double>() + bf->getAs<double>());
+
+        if(delay<=0.0) {
+            callback->requestDone(pvd::Status::Ok, job.result);
+            return;
+        }
+
+        epicsTimeGetCurrent(&job.due);
+        epicsTimeAddSeconds(&job.due, delay);
+        job.callback = callback;
+
+        bool wake;
+        {
+            Guard G(mutex);
+            wake = jobs.empty();
+            jobs.push_back(job);
+        }
+        if(wake)
+            wakeup.signal();
+    }
+
+    virtual void run()
+    {
+        Guard G(mutex);
+        while(!stopping) {
+            if(jobs.empty()) {
+                UnGuard U(G);
+                wakeup.wait();
+                continue;
+            }
+
+            epicsTimeStamp now;
+            epicsTimeGetCurrent(&now);
+            double wait = epicsTimeDiffInSeconds(&jobs.front().due, &now);
+            if(wait > 0.0) {
+                UnGuard U(G);
+                wakeup.wait(wait);
+                continue;
+            }
+
+            Job job(jobs.front());
+            jobs.pop_front();
+            UnGuard U(G);
+            job.callback->requestDone(pvd::Status::Ok, job.result);
+        }
+    }
+};
+
+pvd::PVStructurePtr buildArgs(double a, double b)
+{
+    pvd::ValueBuilder args("epics:nt/NTURI:1.0");
+    args.add<pvd::pvString>("scheme", "pva")
+        .add<pvd::pvString>("path", "sum");
+    return args.addNested("query")
+                   .add<pvd::pvDouble>("a", a)
+                   .add<pvd::pvDouble>("b", b)
+               .endNested()
+               .buildPVStructure();
+}
+
+void check(const pvd::PVStructurePtr& reply, double expect)
+{
+    if(reply->getSubFieldT<pvd::PVDouble>("c")->get()!=expect)
+        throw std::runtime_error("Wrong reply");
+}
+
+// one request at a time with request()
+double sequential(pva::RPCClient& client, double duration)
+{
+    size_t count = 0u;
+    epicsTimeStamp start, now;
+    epicsTimeGetCurrent(&start);
+    do {
+        check(client.request(buildArgs(double(count), 1.0)), double(count+1u));
+        count++;
+        epicsTimeGetCurrent(&now);
+    } while(epicsTimeDiffInSeconds(&now, &start) < duration);
+
+    return count/epicsTimeDiffInSeconds(&now, &start);
+}
+
+// keep depth requests in progress with issueAsync()
+double pipelined(pva::RPCClient& client, size_t depth, double duration)
+{
+    client.setMaxInFlight(depth);
+
+    std::deque<std::pair<pva::RPCClient::AsyncRequest::shared_pointer, double> > inprog;
+    size_t issued = 0u, count = 0u;
+    bool more = true;
+    epicsTimeStamp start, now;
+    epicsTimeGetCurrent(&start);
+    while(more || !inprog.empty()) {
+        while(more && inprog.size() < depth) {
+            inprog.push_back(std::make_pair(client.issueAsync(buildArgs(double(issued), 1.0)),
+                                            double(issued+1u)));
+            issued++;
+        }
+
+        check(inprog.front().first->wait(), inprog.front().second);
+        inprog.pop_front();
+        count++;
+
+        epicsTimeGetCurrent(&now);
+        more = epicsTimeDiffInSeconds(&now, &start) < duration;
+    }
+    epicsTimeGetCurrent(&now);
+
+    return count/epicsTimeDiffInSeconds(&now, &start);
+}
+
+void usage()
+{
+    fprintf(stderr, "\nUsage: testRPCThroughput [options]\n\n"
+            "  -h: Help: Print this message\n"
+            "options:\n"
+            "  -n <count>:        requests in progress, may be repeated.  default is 1, 4, 16, and 64\n"
+            "  -u <usec>:         delay before the service replies, default is %.1f\n"
+            "  -d <sec>:          duration of each, default is %.1f\n\n",
+            DEFAULT_DELAY, DEFAULT_DURATION);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::vector<size_t> depths;
+    double delay = DEFAULT_DELAY;
+    double duration = DEFAULT_DURATION;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "hn:u:d:")) != -1) {
+        switch(opt) {
+        case 'n': depths.push_back(atoi(optarg)); break;
+        case 'u': delay = atof(optarg); break;
+        case 'd': duration = atof(optarg); break;
+        case 'h': usage(); return 0;
+        default: usage(); return 1;
+        }
+    }
+
+    if(depths.empty()) {
+        depths.push_back(1u);
+        depths.push_back(4u);
+        depths.push_back(16u);
+        depths.push_back(64u);
+    }
+
+    if(delay<0.0 || duration<=0.0) {
+        fprintf(stderr, "Invalid options\n");
+        return 1;
+    }
+    for(size_t i=0; i<depths.size(); i++) {
+        if(depths[i]<1u) {
+            fprintf(stderr, "Invalid options\n");
+            return 1;
+        }
+    }
+
+    try {
+        pva::Configuration::shared_pointer conf(pva::ConfigurationBuilder()
+                                                .add("EPICS_PVAS_INTF_ADDR_LIST", "127.0.0.1")
+                                                .add("EPICS_PVA_ADDR_LIST", "127.0.0.1")
+                                                .add("EPICS_PVA_AUTO_ADDR_LIST","0")
+                                                .add("EPICS_PVA_SERVER_PORT", "0")
+                                                .add("EPICS_PVA_BROADCAST_PORT", "0")
+                                                .push_map()
+                                                .build());
+
+        pva::RPCServer serv(conf);
+        serv.registerService("sum", pva::RPCServiceAsync::shared_pointer(new SumServiceImpl(delay*1e-6)));
+
+        pva::ClientFactory::start();
+        pva::ChannelProvider::shared_pointer provider(pva::ChannelProviderRegistry::clients()->createProvider("pva",
+                                                                                                              serv.getServer()->getCurrentConfig()));
+        if(!provider)
+            throw std::runtime_error("No pva provider");
+
+        pva::RPCClient client("sum", pvd::createRequest("field()"), provider);
+        if(!client.connect())
+            throw std::runtime_error("Not connected");
+
+        printf("# mode in-progress usec/reply requests/s\n");
+        printf("request 1 %.1f %.0f\n", delay, sequential(client, duration));
+        for(size_t i=0; i<depths.size(); i++)
+            printf("issueAsync %zu %.1f %.0f\n", depths[i], delay, pipelined(client, depths[i], duration));
+
+    }catch(std::exception& e){
+        std::cerr<<"Error: "<<e.what()<<"\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,259 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <sstream>
+#include <vector>
+
+#include <epicsThread.h>
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+#include <epicsTime.h>
+
+#include <pv/roleCache.h>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+namespace pva = epics::pvAccess;
+
+typedef pva::detail::RoleCache RoleCache;
+typedef epicsGuard<epicsMutex> Guard;
+
+namespace {
+
+// stand-in for osdGetRoles(), as slow as a directory service
+struct Stub {
+    epicsMutex mutex;
+    size_t lookups;
+    unsigned generation;
+    double delay;
+    Stub() :lookups(0u), generation(1u), delay(0.0) {}
+} stub;
+
+void stubLookup(const std::string& account, pva::PeerInfo::roles_t& roles)
+{
+    unsigned gen;
+    double delay;
+    {
+        Guard G(stub.mutex);
+        stub.lookups++;
+        gen = stub.generation;
+        delay = stub.delay;
+    }
+    if(delay>0.0)
+        epicsThreadSleep(delay);
+
+    std::ostringstream strm;
+    strm<<"gen"<<gen;
+    roles.insert("grp_"+account);
+    roles.insert(strm.str());
+}
+
+void resetStub(double delay)
+{
+    Guard G(stub.mutex);
+    stub.lookups = 0u;
+    stub.generation = 1u;
+    stub.delay = delay;
+}
+
+size_t lookups()
+{
+    Guard G(stub.mutex);
+    return stub.lookups;
+}
+
+void nextGeneration()
+{
+    Guard G(stub.mutex);
+    stub.generation++;
+}
+
+void testDisabled()
+{
+    testDiag("testDisabled()");
+    resetStub(0.0);
+
+    RoleCache cache(0.0, &stubLookup);
+
+    for(unsigned i=0; i<3u; i++) {
+        pva::PeerInfo::roles_t roles;
+        cache.getRoles("alice", roles);
+        testOk1(roles.count("grp_alice")==1u);
+    }
+    testOk(lookups()==3u, "lookups %u", unsigned(lookups()));
+}
+
+void testHit()
+{
+    testDiag("testHit()");
+    resetStub(0.0);
+
+    RoleCache cache(10.0, &stubLookup);
+
+    pva::PeerInfo::roles_t roles;
+    roles.insert("existing");
+    cache.getRoles("alice", roles);
+    testOk1(roles.size()==3u && roles.count("existing")==1u && roles.count("grp_alice")==1u);
+
+    roles.clear();
+    cache.getRoles("alice", roles);
+    cache.getRoles("bob", roles);
+    testOk1(roles.count("grp_alice")==1u && roles.count("grp_bob")==1u);
+
+    RoleCache::Stats stats;
+    cache.getStats(stats);
+    testOk(lookups()==2u, "lookups %u", unsigned(lookups()));
+    testOk(stats.entries==2u && stats.hits==1u && stats.misses==2u,
+           "entries %u hits %u misses %u", unsigned(stats.entries), unsigned(stats.hits), unsigned(stats.misses));
+
+    cache.clear();
+    roles.clear();
+    cache.getRoles("alice", roles);
+    testOk(lookups()==3u, "lookups %u after clear()", unsigned(lookups()));
+}
+
+struct Validator : public epicsThreadRunable
+{
+    RoleCache& cache;
+    const size_t count, naccounts, offset;
+    bool ok;
+    epicsThread thread;
+
+    Validator(RoleCache& cache, size_t count, size_t naccounts, size_t offset)
+        :cache(cache), count(count), naccounts(naccounts), offset(offset)
+        ,ok(true)
+        ,thread(*this, "validator", epicsThreadGetStackSize(epicsThreadStackSmall))
+    {}
+    virtual ~Validator() {}
+
+    virtual void run()
+    {
+        for(size_t i=0; i<count; i++) {
+            std::ostringstream strm;
+            strm<<"user"<<((i+offset)%naccounts);
+
+            pva::PeerInfo::roles_t roles;
+            cache.getRoles(strm.str(), roles);
+            ok &= roles.count("grp_"+strm.str())==1u;
+        }
+    }
+};
+
+// returns validations per second
+double validate(RoleCache& cache, size_t nthreads, size_t count, size_t naccounts, bool& ok)
+{
+    std::vector<std::tr1::shared_ptr<Validator> > validators;
+    for(size_t i=0; i<nthreads; i++)
+        validators.push_back(std::tr1::shared_ptr<Validator>(new Validator(cache, count, naccounts, i)));
+
+    epicsTimeStamp start, end;
+    epicsTimeGetCurrent(&start);
+    for(size_t i=0; i<validators.size(); i++)
+        validators[i]->thread.start();
+    for(size_t i=0; i<validators.size(); i++)
+        validators[i]->thread.exitWait();
+    epicsTimeGetCurrent(&end);
+
+    ok = true;
+    for(size_t i=0; i<validators.size(); i++)
+        ok &= validators[i]->ok;
+
+    return nthreads*count/epicsTimeDiffInSeconds(&end, &start);
+}
+
+void testConcurrent()
+{
+    testDiag("testConcurrent()");
+    resetStub(0.1);
+
+    RoleCache cache(10.0, &stubLookup);
+
+    // all ask for the same account while the first lookup is in progress
+    bool ok;
+    validate(cache, 4u, 1u, 1u, ok);
+    testOk1(ok);
+    testOk(lookups()==1u, "lookups %u", unsigned(lookups()));
+}
+
+void testRefresh()
+{
+    testDiag("testRefresh()");
+    resetStub(0.0);
+
+    RoleCache cache(0.5, &stubLookup);
+
+    pva::PeerInfo::roles_t roles;
+    cache.getRoles("alice", roles);
+    testOk1(roles.count("gen1")==1u);
+
+    nextGeneration();
+    epicsThreadSleep(0.6);
+
+    // stale, used while refreshed
+    roles.clear();
+    cache.getRoles("alice", roles);
+    testOk1(roles.count("gen1")==1u);
+
+    for(unsigned i=0; i<100u && lookups()<2u; i++)
+        epicsThreadSleep(0.01);
+    epicsThreadSleep(0.05);
+
+    roles.clear();
+    cache.getRoles("alice", roles);
+    testOk1(roles.count("gen2")==1u);
+
+    RoleCache::Stats stats;
+    cache.getStats(stats);
+    testOk(stats.stale==1u && stats.refreshes==1u, "stale %u refreshes %u",
+           unsigned(stats.stale), unsigned(stats.refreshes));
+
+    nextGeneration();
+    epicsThreadSleep(1.1);
+
+    // expired, looked up again before use
+    roles.clear();
+    cache.getRoles("alice", roles);
+    testOk1(roles.count("gen3")==1u);
+    testOk(lookups()==3u, "lookups %u", unsigned(lookups()));
+}
+
+// many clients of a few accounts re-connect at once
+void testStorm()
+{
+    testDiag("testStorm()");
+
+    const size_t nthreads = 8u, count = 250u, naccounts = 20u;
+    bool ok;
+
+    resetStub(0.001);
+    RoleCache uncached(0.0, &stubLookup);
+    double before = validate(uncached, nthreads, count, naccounts, ok);
+    testOk1(ok);
+    testDiag("Without cache %.0f validations/s, %u lookups", before, unsigned(lookups()));
+
+    resetStub(0.001);
+    RoleCache cached(10.0, &stubLookup);
+    double after = validate(cached, nthreads, count, naccounts, ok);
+    testOk1(ok);
+    testDiag("With cache %.0f validations/s, %u lookups", after, unsigned(lookups()));
+
+    testOk(lookups()==naccounts, "lookups %u", unsigned(lookups()));
+    testOk(after > before, "cached %.0f > uncached %.0f", after, before);
+}
+
+} // namespace
+
+MAIN(testRoleCache)
+{
+    testPlan(21);
+    testDisabled();
+    testHit();
+    testConcurrent();
+    testRefresh();
+    testStorm();
+    return testDone();
+}
@@ -0,0 +1,270 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* Results for the names of a search request are sent together.
+ * Counts response datagrams for a search of 10000 names.
+ */
+
+#include <vector>
+#include <set>
+#include <string>
+#include <sstream>
+
+#include <string.h>
+
+#include <osiSock.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <epicsEndian.h>
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/byteBuffer.h>
+#include <pv/configuration.h>
+#include <pv/serverContext.h>
+#include <pv/pvaConstants.h>
+#include <pv/inetAddressUtil.h>
+#include <pv/remote.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+const size_t npvs = 10000u;
+
+struct Searcher {
+    SOCKET sock;
+    osiSockAddr self, server;
+    pvd::int32 seq;
+
+    explicit Searcher(const osiSockAddr& server)
+        :sock(epicsSocketCreate(AF_INET, SOCK_DGRAM, IPPROTO_UDP))
+        ,server(server)
+        ,seq(0)
+    {
+        if(sock==INVALID_SOCKET)
+            testAbort("Unable to create socket");
+
+        memset(&self, 0, sizeof(self));
+        self.ia.sin_family = AF_INET;
+        self.ia.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        osiSocklen_t slen = sizeof(self);
+        if(::bind(sock, &self.sa, sizeof(self.ia)) || ::getsockname(sock, &self.sa, &slen))
+            testAbort("Unable to bind socket");
+
+        int bsize = 4*1024*1024;
+        (void)::setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (char*)&bsize, sizeof(bsize));
+
+        struct timeval tmo;
+        tmo.tv_sec = 0;
+        tmo.tv_usec = 200000;
+        (void)::setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (char*)&tmo, sizeof(tmo));
+    }
+    ~Searcher() {
+        epicsSocketDestroy(sock);
+    }
+
+    // send searches for names packed into as few datagrams as possible.
+    // CID is the index in names.
+    // @returns number of request datagrams
+    size_t search(const std::vector<std::string>& names, bool replyRequired)
+    {
+        std::vector<char> storage(pva::MAX_UDP_UNFRAGMENTED_SEND);
+        pvd::ByteBuffer buf(&storage[0], storage.size());
+        size_t ndatagrams = 0u;
+
+        for(size_t next=0; next<names.size(); ) {
+            buf.clear();
+            buf.setEndianess(EPICS_BYTE_ORDER);
+            buf.putByte(pva::PVA_MAGIC);
+            buf.putByte(pva::PVA_CLIENT_PROTOCOL_REVISION);
+            buf.putByte(EPICS_BYTE_ORDER==EPICS_ENDIAN_BIG ? 0x80 : 0x00);
+            buf.putByte(pva::CMD_SEARCH);
+            buf.putInt(0);
+            buf.putInt(seq++);
+            buf.putByte(replyRequired ? pva::QOS_REPLY_REQUIRED : 0);
+            buf.putByte(0);
+            buf.putShort(0);
+            pva::encodeAsIPv6Address(&buf, &self);
+            buf.putShort((pvd::int16)ntohs(self.ia.sin_port));
+            buf.putByte(1);
+            buf.putByte(3);
+            buf.put("tcp", 0, 3);
+            size_t countPos = buf.getPosition();
+            buf.putShort(0);
+
+            pvd::int16 count = 0;
+            for(; next<names.size() && buf.getRemaining() >= 4u+1u+names[next].size(); next++, count++) {
+                buf.putInt(pvd::int32(next));
+                buf.putByte(pvd::int8(names[next].size()));
+                buf.put(names[next].c_str(), 0, names[next].size());
+            }
+
+            buf.putShort(countPos, count);
+            buf.putInt(4, buf.getPosition()-pva::PVA_MESSAGE_HEADER_SIZE);
+
+            if(::sendto(sock, &storage[0], buf.getPosition(), 0, &server.sa, sizeof(server.ia))!=int(buf.getPosition()))
+                testAbort("sendto fails");
+            ndatagrams++;
+
+            // don't overrun the server socket buffer
+            epicsThreadSleep(0.001);
+        }
+        return ndatagrams;
+    }
+
+    // receive responses until expect CIDs seen, or timeout.
+    // @returns number of response datagrams
+    size_t receive(size_t expect, std::set<pvd::int32>& found, std::set<pvd::int32>& notFound, size_t& duplicates)
+    {
+        std::vector<char> storage(pva::MAX_UDP_RECV);
+        size_t ndatagrams = 0u;
+        duplicates = 0u;
+
+        epicsTimeStamp start, now;
+        epicsTimeGetCurrent(&start);
+
+        while(found.size()+notFound.size() < expect) {
+            epicsTimeGetCurrent(&now);
+            if(epicsTimeDiffInSeconds(&now, &start) > 10.0)
+                break;
+
+            int ret = ::recv(sock, &storage[0], storage.size(), 0);
+            if(ret<=0)
+                continue;
+            ndatagrams++;
+
+            pvd::ByteBuffer buf(&storage[0], ret);
+            while(buf.getRemaining() >= size_t(pva::PVA_MESSAGE_HEADER_SIZE)) {
+                buf.getByte();
+                buf.getByte();
+                pvd::int8 flags = buf.getByte();
+                pvd::int8 cmd = buf.getByte();
+                buf.setEndianess((flags&0x80) ? EPICS_ENDIAN_BIG : EPICS_ENDIAN_LITTLE);
+                size_t size = buf.getInt();
+                size_t next = buf.getPosition()+size;
+                if(next>buf.getLimit())
+                    break;
+
+                if(!(flags&0x01) && cmd==pva::CMD_SEARCH_RESPONSE) {
+                    buf.setPosition(buf.getPosition()+12+4+16+2);
+                    pvd::int8 plen = buf.getByte();
+                    buf.setPosition(buf.getPosition()+plen);
+                    bool wasFound = buf.getByte()!=0;
+                    size_t count = buf.getShort()&0xffff;
+                    for(size_t i=0; i<count; i++) {
+                        pvd::int32 cid = buf.getInt();
+                        if(!(wasFound ? found : notFound).insert(cid).second)
+                            duplicates++;
+                    }
+                }
+                buf.setPosition(next);
+            }
+        }
+        return ndatagrams;
+    }
+};
+
+struct TestServer {
+    pvas::StaticProvider prov;
+    pva::ServerContext::shared_pointer serv;
+    osiSockAddr addr;
+
+    TestServer()
+        :prov("search")
+    {
+        pvas::SharedPV::shared_pointer pv(pvas::SharedPV::buildReadOnly());
+        for(size_t i=0; i<npvs; i++) {
+            std::ostringstream name;
+            name<<"search:"<<i;
+            prov.add(name.str(), pv);
+        }
+
+        serv = pva::ServerContext::create(pva::ServerContext::Config()
+                                          .config(pva::ConfigurationBuilder()
+                                                  .add("EPICS_PVAS_INTF_ADDR_LIST", "127.0.0.1")
+                                                  .add("EPICS_PVA_ADDR_LIST", "127.0.0.1")
+                                                  .add("EPICS_PVA_AUTO_ADDR_LIST","0")
+                                                  .add("EPICS_PVA_SERVER_PORT", "0")
+                                                  .add("EPICS_PVA_BROADCAST_PORT", "0")
+                                                  .push_map()
+                                                  .build())
+                                          .provider(prov.provider()));
+
+        memset(&addr, 0, sizeof(addr));
+        addr.ia.sin_family = AF_INET;
+        addr.ia.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.ia.sin_port = htons(serv->getBroadcastPort());
+    }
+};
+
+void testManyNames()
+{
+    testDiag("Search for %zu names", npvs);
+
+    TestServer server;
+    Searcher searcher(server.addr);
+
+    std::vector<std::string> names(npvs);
+    for(size_t i=0; i<npvs; i++) {
+        std::ostringstream name;
+        name<<"search:"<<i;
+        names[i] = name.str();
+    }
+
+    size_t nrequests = searcher.search(names, false);
+
+    std::set<pvd::int32> found, notFound;
+    size_t duplicates;
+    size_t nresponses = searcher.receive(npvs, found, notFound, duplicates);
+
+    testDiag("%zu request datagrams, %zu response datagrams", nrequests, nresponses);
+
+    testOk(found.size()==npvs, "found %zu of %zu", found.size(), npvs);
+    testOk1(notFound.empty());
+    testOk1(duplicates==0u);
+    testOk(nresponses<=nrequests, "%zu response datagrams <= %zu request datagrams", nresponses, nrequests);
+}
+
+void testMixed()
+{
+    testDiag("Search for found and not found names, with reply required");
+
+    TestServer server;
+    Searcher searcher(server.addr);
+
+    std::vector<std::string> names;
+    names.push_back("search:1");
+    names.push_back("nonexistent:1");
+    names.push_back("search:2");
+    names.push_back("nonexistent:2");
+
+    size_t nrequests = searcher.search(names, true);
+    testOk1(nrequests==1u);
+
+    std::set<pvd::int32> found, notFound;
+    size_t duplicates;
+    size_t nresponses = searcher.receive(names.size(), found, notFound, duplicates);
+
+    // one response for found, and one for not found
+    testOk(nresponses==2u, "%zu response datagrams", nresponses);
+    testOk1(found.size()==2u && found.count(0) && found.count(2));
+    testOk1(notFound.size()==2u && notFound.count(1) && notFound.count(3));
+    testOk1(duplicates==0u);
+}
+
+} // namespace
+
+MAIN(testSearchResponse)
+{
+    testPlan(9);
+    osiSockAttach();
+    testManyNames();
+    testMixed();
+    return testDone();
+}
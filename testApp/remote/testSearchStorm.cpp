@@ -0,0 +1,353 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* Search storm load generator.
+ *
+ * Starts a server in this process with many PVs, then sends name searches
+ * from several UDP sockets as fast as possible (or at a given rate).
+ * Reports searches sent and answered per second.
+ *
+ * Compare $EPICS_PVAS_UDP_RX_THREADS settings with the -t option.
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <sstream>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <osiSock.h>
+#include <epicsGetopt.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <epicsEndian.h>
+#include <epicsStdio.h>
+
+#include <pv/byteBuffer.h>
+#include <pv/configuration.h>
+#include <pv/serverContext.h>
+#include <pv/pvaConstants.h>
+#include <pv/inetAddressUtil.h>
+#include <pv/remote.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+#define DEFAULT_PVS 10000
+#define DEFAULT_NAMES 1
+#define DEFAULT_SENDERS 4
+#define DEFAULT_DURATION 5.0
+#define DEFAULT_MISSING 0
+
+int npvs = DEFAULT_PVS;
+int namesPerSearch = DEFAULT_NAMES;
+int missingPercent = DEFAULT_MISSING;
+double rate = 0.0; // searches per second per sender, 0 is unlimited
+
+struct Sender : public epicsThreadRunable
+{
+    const unsigned index;
+    osiSockAddr server, self;
+    SOCKET sock;
+
+    volatile bool stopTx, stopRx;
+    // only accessed by the worker threads until joined
+    size_t sent, expected, answered;
+
+    struct Receiver : public epicsThreadRunable {
+        Sender& sender;
+        explicit Receiver(Sender& sender) :sender(sender) {}
+        virtual void run() OVERRIDE FINAL { sender.receive(); }
+    } receiver;
+
+    epicsThread tx, rx;
+
+    Sender(unsigned index, const osiSockAddr& server)
+        :index(index)
+        ,server(server)
+        ,sock(epicsSocketCreate(AF_INET, SOCK_DGRAM, IPPROTO_UDP))
+        ,stopTx(false)
+        ,stopRx(false)
+        ,sent(0u)
+        ,expected(0u)
+        ,answered(0u)
+        ,receiver(*this)
+        ,tx(*this, "storm-tx", epicsThreadGetStackSize(epicsThreadStackSmall))
+        ,rx(receiver, "storm-rx", epicsThreadGetStackSize(epicsThreadStackSmall))
+    {
+        if(sock==INVALID_SOCKET)
+            throw std::runtime_error("Unable to create socket");
+
+        memset(&self, 0, sizeof(self));
+        self.ia.sin_family = AF_INET;
+        self.ia.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        osiSocklen_t slen = sizeof(self);
+        if(::bind(sock, &self.sa, sizeof(self.ia)) || ::getsockname(sock, &self.sa, &slen)) {
+            epicsSocketDestroy(sock);
+            throw std::runtime_error("Unable to bind socket");
+        }
+
+        // don't lose responses on our side
+        int bsize = 4*1024*1024;
+        (void)::setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (char*)&bsize, sizeof(bsize));
+
+        // allow receiver to notice stopRx
+        struct timeval tmo;
+        tmo.tv_sec = 0;
+        tmo.tv_usec = 100000;
+        (void)::setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (char*)&tmo, sizeof(tmo));
+    }
+    virtual ~Sender() {
+        epicsSocketDestroy(sock);
+    }
+
+    void start() {
+        rx.start();
+        tx.start();
+    }
+
+    // build one CMD_SEARCH message
+    size_t build(pvd::ByteBuffer& buf, pvd::int32 seq, size_t& nameIndex, size_t& nfound)
+    {
+        buf.clear();
+        buf.setEndianess(EPICS_BYTE_ORDER);
+        buf.putByte(pva::PVA_MAGIC);
+        buf.putByte(pva::PVA_CLIENT_PROTOCOL_REVISION);
+        buf.putByte(EPICS_BYTE_ORDER==EPICS_ENDIAN_BIG ? 0x80 : 0x00);
+        buf.putByte(pva::CMD_SEARCH);
+        buf.putInt(0); // payload size, filled in below
+        buf.putInt(seq);
+        buf.putByte(0x00); // handle without forwarding, reply only when found
+        buf.putByte(0);
+        buf.putShort(0);
+        pva::encodeAsIPv6Address(&buf, &self);
+        buf.putShort((pvd::int16)ntohs(self.ia.sin_port));
+        buf.putByte(1);
+        buf.putByte(3);
+        buf.put("tcp", 0, 3);
+        buf.putShort((pvd::int16)namesPerSearch);
+
+        nfound = 0u;
+        for(int n=0; n<namesPerSearch; n++, nameIndex++) {
+            char name[64];
+            if(missingPercent && int(nameIndex%100u) < missingPercent) {
+                epicsSnprintf(name, sizeof(name), "storm:missing:%u:%zu", index, nameIndex);
+            } else {
+                epicsSnprintf(name, sizeof(name), "storm:%zu", nameIndex%npvs);
+                nfound++;
+            }
+            size_t nlen = strlen(name);
+
+            buf.putInt(pvd::int32(nameIndex));
+            buf.putByte(pvd::int8(nlen));
+            buf.put(name, 0, nlen);
+        }
+
+        buf.putInt(4, buf.getPosition()-pva::PVA_MESSAGE_HEADER_SIZE);
+        return buf.getPosition();
+    }
+
+    virtual void run() OVERRIDE FINAL
+    {
+        std::vector<char> storage(pva::MAX_UDP_UNFRAGMENTED_SEND);
+        pvd::ByteBuffer buf(&storage[0], storage.size());
+
+        size_t nameIndex = 0u;
+        pvd::int32 seq = 0;
+
+        epicsTimeStamp start;
+        epicsTimeGetCurrent(&start);
+
+        while(!stopTx) {
+            size_t nfound;
+            size_t len = build(buf, seq++, nameIndex, nfound);
+
+            if(::sendto(sock, &storage[0], len, 0, &server.sa, sizeof(server.ia))==int(len)) {
+                sent += namesPerSearch;
+                expected += nfound;
+            }
+
+            if(rate>0.0) {
+                epicsTimeStamp now;
+                epicsTimeGetCurrent(&now);
+                double ahead = sent/rate - epicsTimeDiffInSeconds(&now, &start);
+                if(ahead>0.0)
+                    epicsThreadSleep(ahead);
+            }
+        }
+    }
+
+    void receive()
+    {
+        std::vector<char> storage(pva::MAX_UDP_RECV);
+
+        while(!stopRx) {
+            int ret = ::recv(sock, &storage[0], storage.size(), 0);
+            if(ret<=0)
+                continue;
+
+            pvd::ByteBuffer buf(&storage[0], ret);
+
+            while(buf.getRemaining() >= size_t(pva::PVA_MESSAGE_HEADER_SIZE)) {
+                pvd::int8 magic = buf.getByte();
+                buf.getByte();
+                pvd::int8 flags = buf.getByte();
+                pvd::int8 cmd = buf.getByte();
+                if(magic!=pva::PVA_MAGIC)
+                    break;
+                buf.setEndianess((flags&0x80) ? EPICS_ENDIAN_BIG : EPICS_ENDIAN_LITTLE);
+                size_t size = buf.getInt();
+                size_t next = buf.getPosition()+size;
+                if(next>buf.getLimit())
+                    break;
+
+                if(!(flags&0x01) && cmd==pva::CMD_SEARCH_RESPONSE) {
+                    // GUID, sequence, address, port
+                    buf.setPosition(buf.getPosition()+12+4+16+2);
+                    pvd::int8 plen = buf.getByte();
+                    buf.setPosition(buf.getPosition()+plen);
+                    buf.getByte(); // found
+                    answered += buf.getShort()&0xffff;
+                }
+                buf.setPosition(next);
+            }
+        }
+    }
+};
+
+void usage()
+{
+    fprintf(stderr, "\nUsage: testSearchStorm [options]\n\n"
+            "  -h: Help: Print this message\n"
+            "options:\n"
+            "  -N <pvs>:          number of PVs served, default is %d\n"
+            "  -n <names>:        names per search message, default is %d\n"
+            "  -s <senders>:      sending sockets (and threads), default is %d\n"
+            "  -r <rate>:         searches per second per sender, default is unlimited\n"
+            "  -x <percent>:      percentage of names not found, default is %d\n"
+            "  -d <sec>:          duration, default is %.1f\n"
+            "  -t <threads>:      $EPICS_PVAS_UDP_RX_THREADS, default is 1\n"
+            "  -T <sec>:          $EPICS_PVAS_SEARCH_NEGATIVE_TTL, default is 0\n\n",
+            DEFAULT_PVS, DEFAULT_NAMES, DEFAULT_SENDERS, DEFAULT_MISSING, DEFAULT_DURATION);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int nsenders = DEFAULT_SENDERS, nthreads = 1;
+    double duration = DEFAULT_DURATION, negativeTTL = 0.0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "hN:n:s:r:x:d:t:T:")) != -1) {
+        switch(opt) {
+        case 'N': npvs = atoi(optarg); break;
+        case 'n': namesPerSearch = atoi(optarg); break;
+        case 's': nsenders = atoi(optarg); break;
+        case 'r': rate = atof(optarg); break;
+        case 'x': missingPercent = atoi(optarg); break;
+        case 'd': duration = atof(optarg); break;
+        case 't': nthreads = atoi(optarg); break;
+        case 'T': negativeTTL = atof(optarg); break;
+        case 'h': usage(); return 0;
+        default: usage(); return 1;
+        }
+    }
+
+    if(npvs<1 || namesPerSearch<1 || namesPerSearch>16 || nsenders<1) {
+        fprintf(stderr, "Invalid options (1 to 16 names per search)\n");
+        return 1;
+    }
+
+    try {
+        std::ostringstream threads, ttl;
+        threads<<nthreads;
+        ttl<<negativeTTL;
+
+        pva::Configuration::shared_pointer conf(pva::ConfigurationBuilder()
+                                                .add("EPICS_PVAS_INTF_ADDR_LIST", "127.0.0.1")
+                                                .add("EPICS_PVA_ADDR_LIST", "127.0.0.1")
+                                                .add("EPICS_PVA_AUTO_ADDR_LIST","0")
+                                                .add("EPICS_PVA_SERVER_PORT", "0")
+                                                .add("EPICS_PVA_BROADCAST_PORT", "0")
+                                                .add("EPICS_PVAS_UDP_RX_THREADS", threads.str())
+                                                .add("EPICS_PVAS_SEARCH_NEGATIVE_TTL", ttl.str())
+                                                .push_map()
+                                                .build());
+
+        pvas::StaticProvider prov("storm");
+        {
+            pvas::SharedPV::shared_pointer pv(pvas::SharedPV::buildReadOnly());
+            for(int i=0; i<npvs; i++) {
+                std::ostringstream name;
+                name<<"storm:"<<i;
+                prov.add(name.str(), pv);
+            }
+        }
+
+        pva::ServerContext::shared_pointer serv(pva::ServerContext::create(pva::ServerContext::Config()
+                                                                           .config(conf)
+                                                                           .provider(prov.provider())));
+
+        osiSockAddr server;
+        memset(&server, 0, sizeof(server));
+        server.ia.sin_family = AF_INET;
+        server.ia.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        server.ia.sin_port = htons(serv->getBroadcastPort());
+
+        std::vector<Sender*> senders(nsenders);
+        for(int i=0; i<nsenders; i++)
+            senders[i] = new Sender(i, server);
+
+        epicsTimeStamp start, end;
+        epicsTimeGetCurrent(&start);
+
+        for(int i=0; i<nsenders; i++)
+            senders[i]->start();
+
+        epicsThreadSleep(duration);
+
+        for(int i=0; i<nsenders; i++)
+            senders[i]->stopTx = true;
+        for(int i=0; i<nsenders; i++)
+            senders[i]->tx.exitWait();
+
+        epicsTimeGetCurrent(&end);
+        double elapsed = epicsTimeDiffInSeconds(&end, &start);
+
+        // collect late responses
+        epicsThreadSleep(1.0);
+
+        size_t sent = 0u, expected = 0u, answered = 0u;
+        for(int i=0; i<nsenders; i++) {
+            senders[i]->stopRx = true;
+            senders[i]->rx.exitWait();
+            sent += senders[i]->sent;
+            expected += senders[i]->expected;
+            answered += senders[i]->answered;
+            delete senders[i];
+        }
+
+        printf("# rx_threads senders names/msg sent sent/s answered answered/s answered_%%\n");
+        printf("%d %d %d %zu %.0f %zu %.0f %.1f\n",
+               nthreads, nsenders, namesPerSearch,
+               sent, sent/elapsed,
+               answered, answered/elapsed,
+               expected ? 100.0*answered/expected : 0.0);
+
+        serv.reset();
+    }catch(std::exception& e){
+        std::cerr<<"Error: "<<e.what()<<"\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,191 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* Latency of small requests while a connection carries bulk transfers.
+ *
+ * Starts a server in this process with a large array PV, and a small PV.
+ * Several client threads repeatedly get the array, while another
+ * times puts to the small PV.  All share one TCP connection.
+ * Reports put round trip times, and the array throughput.
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <epicsGetopt.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+
+#include <pv/configuration.h>
+#include <pv/clientFactory.h>
+#include <pv/serverContext.h>
+#include <pv/standardField.h>
+#include <pv/thread.h>
+#include <pv/pvaDefs.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+#include <pva/client.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+#define DEFAULT_ELEMENTS (4*1024*1024)
+#define DEFAULT_GETTERS 2
+#define DEFAULT_DURATION 5.0
+
+struct Getter : public pvd::Runnable
+{
+    pvac::ClientChannel chan;
+    pva::AtomicBoolean& stop;
+    size_t count;
+    pvd::Thread thread;
+
+    Getter(const pvac::ClientChannel& chan, pva::AtomicBoolean& stop)
+        :chan(chan)
+        ,stop(stop)
+        ,count(0u)
+        ,thread(pvd::Thread::Config(this).name("getter").autostart(false))
+    {
+        thread.start();
+    }
+    virtual ~Getter() {}
+
+    virtual void run() OVERRIDE FINAL
+    {
+        try {
+            while(!stop.get()) {
+                chan.get(30.0);
+                count++;
+            }
+        } catch(std::exception& e) {
+            std::cerr<<"Getter error: "<<e.what()<<"\n";
+        }
+    }
+};
+
+void usage()
+{
+    fprintf(stderr, "\nUsage: testSendLatency [options]\n\n"
+            "  -h: Help: Print this message\n"
+            "options:\n"
+            "  -n <elements>:     number of array elements (double), default is %d\n"
+            "  -g <getters>:      number of concurrent array gets, default is %d\n"
+            "  -d <sec>:          duration, default is %.1f\n\n",
+            DEFAULT_ELEMENTS, DEFAULT_GETTERS, DEFAULT_DURATION);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int nelements = DEFAULT_ELEMENTS, ngetters = DEFAULT_GETTERS;
+    double duration = DEFAULT_DURATION;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "hn:g:d:")) != -1) {
+        switch(opt) {
+        case 'n': nelements = atoi(optarg); break;
+        case 'g': ngetters = atoi(optarg); break;
+        case 'd': duration = atof(optarg); break;
+        case 'h': usage(); return 0;
+        default: usage(); return 1;
+        }
+    }
+
+    if(nelements<1 || ngetters<0) {
+        fprintf(stderr, "Invalid options\n");
+        return 1;
+    }
+
+    try {
+        pvas::SharedPV::shared_pointer bulk(pvas::SharedPV::buildReadOnly());
+        {
+            pvd::PVStructurePtr value(pvd::getPVDataCreate()->createPVStructure(pvd::getStandardField()->scalarArray(pvd::pvDouble, "")));
+            pvd::shared_vector<double> arr(nelements, 1.0);
+            value->getSubFieldT<pvd::PVDoubleArray>("value")->replace(pvd::freeze(arr));
+            bulk->open(*value);
+        }
+
+        pvas::SharedPV::shared_pointer small(pvas::SharedPV::buildMailbox());
+        small->open(pvd::getStandardField()->scalar(pvd::pvInt, ""));
+
+        pvas::StaticProvider prov("latency");
+        prov.add("latency:bulk", bulk);
+        prov.add("latency:small", small);
+
+        pva::ServerContext::shared_pointer serv(pva::ServerContext::create(pva::ServerContext::Config()
+                                                                           .config(pva::ConfigurationBuilder()
+                                                                                   .add("EPICS_PVAS_INTF_ADDR_LIST", "127.0.0.1")
+                                                                                   .add("EPICS_PVA_ADDR_LIST", "127.0.0.1")
+                                                                                   .add("EPICS_PVA_AUTO_ADDR_LIST","0")
+                                                                                   .add("EPICS_PVA_SERVER_PORT", "0")
+                                                                                   .add("EPICS_PVA_BROADCAST_PORT", "0")
+                                                                                   .push_map()
+                                                                                   .build())
+                                                                           .provider(prov.provider())));
+
+        pva::ClientFactory::start();
+        pvac::ClientProvider client("pva", serv->getCurrentConfig());
+        pvac::ClientChannel bulkChan(client.connect("latency:bulk"));
+        pvac::ClientChannel smallChan(client.connect("latency:small"));
+
+        // connect both before starting
+        bulkChan.get(10.0);
+        smallChan.put().set("value", 0).exec(10.0);
+
+        pva::AtomicBoolean stop;
+        std::vector<std::tr1::shared_ptr<Getter> > getters(ngetters);
+        for(int i=0; i<ngetters; i++)
+            getters[i].reset(new Getter(bulkChan, stop));
+
+        std::vector<double> rtt;
+        epicsTimeStamp start, now;
+        epicsTimeGetCurrent(&start);
+
+        do {
+            epicsTimeStamp begin, end;
+            epicsTimeGetCurrent(&begin);
+            smallChan.put().set("value", pvd::int32(rtt.size())).exec(30.0);
+            epicsTimeGetCurrent(&end);
+            rtt.push_back(epicsTimeDiffInSeconds(&end, &begin));
+
+            now = end;
+        } while(epicsTimeDiffInSeconds(&now, &start) < duration);
+
+        double elapsed = epicsTimeDiffInSeconds(&now, &start);
+
+        stop.set();
+        size_t ngets = 0u;
+        for(size_t i=0; i<getters.size(); i++) {
+            getters[i]->thread.exitWait();
+            ngets += getters[i]->count;
+        }
+
+        std::sort(rtt.begin(), rtt.end());
+        double sum = 0.0;
+        for(size_t i=0; i<rtt.size(); i++)
+            sum += rtt[i];
+
+        printf("# elements getters puts put_mean_ms put_p50_ms put_p99_ms put_max_ms gets array_MB/s\n");
+        printf("%d %d %zu %.3f %.3f %.3f %.3f %zu %.1f\n",
+               nelements, ngetters, rtt.size(),
+               sum*1e3/rtt.size(),
+               rtt[rtt.size()/2]*1e3,
+               rtt[std::min(rtt.size()-1u, rtt.size()*99u/100u)]*1e3,
+               rtt.back()*1e3,
+               ngets, ngets*double(nelements)*sizeof(double)/elapsed/1048576.0);
+
+    }catch(std::exception& e){
+        std::cerr<<"Error: "<<e.what()<<"\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,354 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* ShmRing, and the negotiation of a shared memory transport by BlockingTCPTransportCodec
+ */
+
+#include <vector>
+#include <string>
+
+#include <errno.h>
+#include <string.h>
+
+#include <epicsThread.h>
+
+#include <pv/pvUnitTest.h>
+#include <testMain.h>
+
+#include <pv/standardField.h>
+#include <pv/current_function.h>
+#include <pv/configuration.h>
+#include <pv/serverContextImpl.h>
+#include <pv/codec.h>
+#include <pv/shmRing.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+#include <pva/client.h>
+
+#ifdef PVA_HAVE_SHM
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+using pva::detail::ShmRing;
+
+namespace {
+
+#ifdef PVA_HAVE_SHM
+
+// cf. segment layout in shmRing.cpp
+const size_t controlOffset = 64;
+
+// a second mapping of a segment, to corrupt it.  Must be made before ShmRing::open() removes the name.
+struct Mapping {
+    void *base;
+    size_t size;
+    explicit Mapping(const std::string& name)
+        :base(MAP_FAILED), size(0u)
+    {
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        struct stat info;
+        if(fd!=-1 && fstat(fd, &info)==0) {
+            size = info.st_size;
+            base = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        if(fd!=-1)
+            close(fd);
+        if(base==MAP_FAILED)
+            testAbort("Unable to map %s", name.c_str());
+    }
+    ~Mapping() { munmap(base, size); }
+    epicsUInt32& magic() { return *static_cast<epicsUInt32*>(base); }
+    // client -> server ring
+    epicsUInt64& head() { return *reinterpret_cast<epicsUInt64*>(static_cast<char*>(base) + controlOffset); }
+    epicsUInt64& tail() { return *reinterpret_cast<epicsUInt64*>(static_cast<char*>(base) + controlOffset + 64u); }
+};
+
+bool exists(const std::string& name)
+{
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if(fd==-1)
+        return errno!=ENOENT;
+    close(fd);
+    return true;
+}
+
+void fill(std::vector<char>& buf, unsigned seed)
+{
+    for(size_t i=0; i<buf.size(); i++)
+        buf[i] = char(i*7u + seed);
+}
+
+void testWrap()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    ShmRing::shared_pointer client(ShmRing::create(1u, 0u)),
+                            server(ShmRing::open(0u, client->token()));
+
+    testOk1(client->ringSize()==64u*1024u);
+    testOk1(server->ringSize()==client->ringSize());
+
+    // 3/4 of the ring each time, so each direction wraps around more than once
+    std::vector<char> out(client->ringSize()*3u/4u), in(out.size());
+    bool ok = true;
+    for(unsigned i=0; i<4u; i++) {
+        fill(out, i);
+        ok &= client->send(&out[0], out.size(), 1.0)==int(out.size());
+        ok &= server->recv(&in[0], in.size(), 1.0)==int(in.size());
+        ok &= in==out;
+
+        fill(out, i+100u);
+        ok &= server->send(&out[0], out.size(), 1.0)==int(out.size());
+        ok &= client->recv(&in[0], in.size(), 1.0)==int(in.size());
+        ok &= in==out;
+    }
+    testOk(ok, "send/recv across wraparound in both directions");
+
+    testOk1(server->recv(&in[0], in.size(), 0.0)==0);
+    testOk1(server->recv(&in[0], in.size(), 0.01)==0);
+
+    // fill
+    std::vector<char> big(client->ringSize()+100u);
+    fill(big, 3u);
+    testOk1(client->send(&big[0], big.size(), 0.0)==int(client->ringSize()));
+    testOk1(client->send(&big[0], big.size(), 0.0)==0);
+    testOk1(client->send(&big[0], big.size(), 0.01)==0);
+
+    // space for part only
+    testOk1(server->recv(&in[0], 1000u, 0.0)==1000);
+    testOk1(client->send(&big[0], 2000u, 0.0)==1000);
+
+    std::vector<char> all(client->ringSize());
+    testOk1(server->recv(&all[0], all.size(), 0.0)==int(all.size()));
+    ok = memcmp(&all[0], &big[1000], all.size()-1000u)==0
+            && memcmp(&all[all.size()-1000u], &big[0], 1000u)==0;
+    testOk(ok, "contents after partial send");
+}
+
+void testClose()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    ShmRing::shared_pointer client(ShmRing::create(1u, 0u)),
+                            server(ShmRing::open(0u, client->token()));
+
+    std::vector<char> out(100u), in(200u);
+    fill(out, 5u);
+    testOk1(client->send(&out[0], out.size(), 0.0)==100);
+    client->close();
+
+    // data sent before close() is still delivered, then EOF
+    testOk1(server->recv(&in[0], in.size(), 0.0)==100);
+    testOk1(memcmp(&in[0], &out[0], out.size())==0);
+    testOk1(server->recv(&in[0], in.size(), 0.0)==-1);
+    testOk1(server->recv(&in[0], in.size(), 1.0)==-1);
+    testOk1(client->recv(&in[0], in.size(), 1.0)==-1);
+
+    testOk1(client->send(&out[0], out.size(), 0.0)==-1);
+    testOk1(server->send(&out[0], out.size(), 1.0)==-1);
+}
+
+void testCorrupt()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    ShmRing::shared_pointer client(ShmRing::create(1u, 0u));
+    Mapping map(client->name());
+    ShmRing::shared_pointer server(ShmRing::open(0u, client->token()));
+
+    std::vector<char> buf(100u);
+    testOk1(client->send(&buf[0], buf.size(), 0.0)==100);
+    testOk1(server->recv(&buf[0], buf.size(), 0.0)==100);
+
+    // more used than the ring holds
+    map.head() = map.tail() + client->ringSize() + 1u;
+    testOk1(server->recv(&buf[0], buf.size(), 0.0)==-1);
+    testOk1(server->recv(&buf[0], buf.size(), 0.01)==-1);
+
+    // consumer ahead of producer
+    map.head() = 0u;
+    map.tail() = 1u;
+    testOk1(client->send(&buf[0], buf.size(), 0.0)==-1);
+    testOk1(client->send(&buf[0], buf.size(), 0.01)==-1);
+}
+
+void testLink()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    ShmRing::shared_pointer client(ShmRing::create(1u, 0u));
+    const std::string name(client->name());
+    testOk1(exists(name));
+
+    testThrows(std::runtime_error, ShmRing::open(0u, client->token()+1u));
+    testThrows(std::runtime_error, ShmRing::open(1u, client->token()));
+
+    {
+        Mapping map(name);
+        map.magic() = 0u;
+        testThrows(std::runtime_error, ShmRing::open(0u, client->token()));
+        testOk(exists(name), "name remains after failed validation");
+
+        map.magic() = 0x50564153; // "PVAS"
+    }
+
+    ShmRing::shared_pointer server(ShmRing::open(0u, client->token()));
+    testOk(!exists(name), "name removed once mapped by both");
+
+    // still usable
+    std::vector<char> buf(10u);
+    testOk1(server->send(&buf[0], buf.size(), 0.0)==10);
+    testOk1(client->recv(&buf[0], buf.size(), 0.0)==10);
+
+    // peer never opens
+    ShmRing::shared_pointer orphan(ShmRing::create(1u, 0u));
+    const std::string oname(orphan->name());
+    testOk1(exists(oname));
+    orphan.reset();
+    testOk(!exists(oname), "creator removes name when destroyed");
+
+    ShmRing::shared_pointer a(ShmRing::create(1u, 0u)), b(ShmRing::create(1u, 0u));
+    testOk1(a->token()!=b->token());
+}
+
+struct Server {
+    pvas::SharedPV::shared_pointer bulk;
+    pvas::StaticProvider prov;
+    pva::ServerContext::shared_pointer serv;
+
+    // larger than the minimum ring
+    enum { nelements = 64*1024 };
+
+    explicit Server(const char *shmSize)
+        :bulk(pvas::SharedPV::buildReadOnly())
+        ,prov("shm")
+    {
+        pvd::PVStructurePtr value(pvd::getPVDataCreate()->createPVStructure(pvd::getStandardField()->scalarArray(pvd::pvDouble, "")));
+        pvd::shared_vector<double> arr(nelements);
+        for(size_t i=0; i<arr.size(); i++)
+            arr[i] = double(i);
+        value->getSubFieldT<pvd::PVDoubleArray>("value")->replace(pvd::freeze(arr));
+        bulk->open(*value);
+        prov.add("shm:bulk", bulk);
+
+        pva::ConfigurationBuilder conf;
+        conf.add("EPICS_PVAS_INTF_ADDR_LIST", "127.0.0.1")
+            .add("EPICS_PVA_ADDR_LIST", "127.0.0.1")
+            .add("EPICS_PVA_AUTO_ADDR_LIST","0")
+            .add("EPICS_PVA_SERVER_PORT", "0")
+            .add("EPICS_PVA_BROADCAST_PORT", "0");
+        if(shmSize)
+            conf.add("EPICS_PVA_SHM_SIZE", shmSize);
+        serv = pva::ServerContext::create(pva::ServerContext::Config()
+                                          .config(conf.push_map().build())
+                                          .provider(prov.provider()));
+    }
+
+    // the server side of the only connection
+    pva::detail::BlockingTCPTransportCodec::shared_pointer transport()
+    {
+        pva::ServerContextImpl::shared_pointer impl(std::tr1::dynamic_pointer_cast<pva::ServerContextImpl>(serv));
+        pva::TransportRegistry::transportVector_t transports;
+        impl->getTransportRegistry()->toArray(transports);
+        if(transports.size()!=1u)
+            return pva::detail::BlockingTCPTransportCodec::shared_pointer();
+        return std::tr1::dynamic_pointer_cast<pva::detail::BlockingTCPTransportCodec>(transports[0]);
+    }
+
+    // wait for the offer, made once the connection is verified, to be answered
+    bool negotiated()
+    {
+        for(unsigned i=0; i<500u; i++) {
+            pva::detail::BlockingTCPTransportCodec::shared_pointer codec(transport());
+            if(codec && codec->shmNegotiated())
+                return true;
+            epicsThreadSleep(0.01);
+        }
+        return false;
+    }
+};
+
+bool checkGet(pvac::ClientChannel& chan)
+{
+    bool ok = true;
+    for(unsigned n=0; n<4u; n++) {
+        pvd::PVStructure::const_shared_pointer root(chan.get(5.0));
+        pvd::shared_vector<const double> arr(root->getSubFieldT<pvd::PVDoubleArray>("value")->view());
+        ok &= arr.size()==size_t(Server::nelements);
+        for(size_t i=0; ok && i<arr.size(); i++)
+            ok &= arr[i]==double(i);
+    }
+    return ok;
+}
+
+void testNegotiate()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    Server server("65536");
+    {
+        pvac::ClientProvider client("pva", pva::ConfigurationBuilder()
+                                    .push_config(server.serv->getCurrentConfig())
+                                    .add("EPICS_PVA_SHM_SIZE", "65536")
+                                    .push_map()
+                                    .build());
+        pvac::ClientChannel chan(client.connect("shm:bulk"));
+
+        testOk1(checkGet(chan));
+        testOk(server.negotiated(), "server accepted shared memory");
+        // after OFFER/ACCEPT/SWITCH, through the ring
+        testOk(checkGet(chan), "gets through shared memory");
+    }
+}
+
+void testDecline()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    // server without $EPICS_PVA_SHM_SIZE
+    Server server(0);
+    {
+        pvac::ClientProvider client("pva", pva::ConfigurationBuilder()
+                                    .push_config(server.serv->getCurrentConfig())
+                                    .add("EPICS_PVA_SHM_SIZE", "65536")
+                                    .push_map()
+                                    .build());
+        pvac::ClientChannel chan(client.connect("shm:bulk"));
+
+        testOk1(checkGet(chan));
+        pva::detail::BlockingTCPTransportCodec::shared_pointer codec(server.transport());
+        testOk(codec && !codec->shmNegotiated(), "server declined shared memory");
+        testOk(checkGet(chan), "gets through TCP");
+    }
+}
+
+#endif // PVA_HAVE_SHM
+
+} // namespace
+
+MAIN(testShmRing)
+{
+    testPlan(43);
+#ifdef PVA_HAVE_SHM
+    try {
+        testWrap();
+        testClose();
+        testCorrupt();
+        testLink();
+        testNegotiate();
+        testDecline();
+    }catch(std::exception& e){
+        testAbort("Unexpected exception: %s", e.what());
+    }
+#else
+    testSkip(43, "No shared memory on this target");
+#endif
+    return testDone();
+}
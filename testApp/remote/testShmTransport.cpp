@@ -0,0 +1,168 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* Same host transfers through loopback TCP, and through shared memory.
+ *
+ * Starts a server in this process with a large array PV, and a small PV.
+ * Then, for each of two client contexts, one with and one without
+ * $EPICS_PVA_SHM_SIZE, times puts to the small PV, and gets of the array.
+ * Reports put round trip times, and the array throughput.
+ *
+ * Shared memory is only used on Linux, and not with $EPICS_PVA_TCP_REACTOR_THREADS .
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <epicsGetopt.h>
+#include <epicsTime.h>
+
+#include <pv/configuration.h>
+#include <pv/clientFactory.h>
+#include <pv/serverContext.h>
+#include <pv/standardField.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+#include <pva/client.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+#define DEFAULT_ELEMENTS (1024*1024)
+#define DEFAULT_PUTS 10000
+#define DEFAULT_DURATION 5.0
+#define DEFAULT_RING (4*1024*1024)
+
+void run(const pva::ServerContext::shared_pointer& serv, const char *name, int ringSize,
+         int nelements, int nputs, double duration)
+{
+    pvac::ClientProvider client("pva", pva::ConfigurationBuilder()
+                                .push_config(serv->getCurrentConfig())
+                                .add("EPICS_PVA_SHM_SIZE", ringSize)
+                                .push_map()
+                                .build());
+    pvac::ClientChannel bulkChan(client.connect("shm:bulk"));
+    pvac::ClientChannel smallChan(client.connect("shm:small"));
+
+    // connect both, and allow negotiation to complete, before starting
+    bulkChan.get(10.0);
+    smallChan.put().set("value", 0).exec(10.0);
+
+    std::vector<double> rtt(nputs);
+    for(int i=0; i<nputs; i++) {
+        epicsTimeStamp begin, end;
+        epicsTimeGetCurrent(&begin);
+        smallChan.put().set("value", pvd::int32(i)).exec(30.0);
+        epicsTimeGetCurrent(&end);
+        rtt[i] = epicsTimeDiffInSeconds(&end, &begin);
+    }
+
+    size_t ngets = 0u;
+    epicsTimeStamp start, now;
+    epicsTimeGetCurrent(&start);
+    do {
+        bulkChan.get(30.0);
+        ngets++;
+        epicsTimeGetCurrent(&now);
+    } while(epicsTimeDiffInSeconds(&now, &start) < duration);
+
+    double elapsed = epicsTimeDiffInSeconds(&now, &start);
+
+    std::sort(rtt.begin(), rtt.end());
+    double sum = 0.0;
+    for(size_t i=0; i<rtt.size(); i++)
+        sum += rtt[i];
+
+    printf("%s %d %d %.1f %.1f %.1f %zu %.1f\n",
+           name, nelements, nputs,
+           sum*1e6/rtt.size(),
+           rtt[rtt.size()/2]*1e6,
+           rtt[std::min(rtt.size()-1u, rtt.size()*99u/100u)]*1e6,
+           ngets, ngets*double(nelements)*sizeof(double)/elapsed/1048576.0);
+}
+
+void usage()
+{
+    fprintf(stderr, "\nUsage: testShmTransport [options]\n\n"
+            "  -h: Help: Print this message\n"
+            "options:\n"
+            "  -n <elements>:     number of array elements (double), default is %d\n"
+            "  -p <puts>:         number of puts, default is %d\n"
+            "  -d <sec>:          duration of gets, default is %.1f\n"
+            "  -s <bytes>:        shared memory ring size, default is %d\n\n",
+            DEFAULT_ELEMENTS, DEFAULT_PUTS, DEFAULT_DURATION, DEFAULT_RING);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int nelements = DEFAULT_ELEMENTS, nputs = DEFAULT_PUTS, ringSize = DEFAULT_RING;
+    double duration = DEFAULT_DURATION;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "hn:p:d:s:")) != -1) {
+        switch(opt) {
+        case 'n': nelements = atoi(optarg); break;
+        case 'p': nputs = atoi(optarg); break;
+        case 'd': duration = atof(optarg); break;
+        case 's': ringSize = atoi(optarg); break;
+        case 'h': usage(); return 0;
+        default: usage(); return 1;
+        }
+    }
+
+    if(nelements<1 || nputs<1 || ringSize<1) {
+        fprintf(stderr, "Invalid options\n");
+        return 1;
+    }
+
+    try {
+        pvas::SharedPV::shared_pointer bulk(pvas::SharedPV::buildReadOnly());
+        {
+            pvd::PVStructurePtr value(pvd::getPVDataCreate()->createPVStructure(pvd::getStandardField()->scalarArray(pvd::pvDouble, "")));
+            pvd::shared_vector<double> arr(nelements, 1.0);
+            value->getSubFieldT<pvd::PVDoubleArray>("value")->replace(pvd::freeze(arr));
+            bulk->open(*value);
+        }
+
+        pvas::SharedPV::shared_pointer small(pvas::SharedPV::buildMailbox());
+        small->open(pvd::getStandardField()->scalar(pvd::pvInt, ""));
+
+        pvas::StaticProvider prov("shm");
+        prov.add("shm:bulk", bulk);
+        prov.add("shm:small", small);
+
+        // server accepts shared memory when offered
+        pva::ServerContext::shared_pointer serv(pva::ServerContext::create(pva::ServerContext::Config()
+                                                                           .config(pva::ConfigurationBuilder()
+                                                                                   .add("EPICS_PVAS_INTF_ADDR_LIST", "127.0.0.1")
+                                                                                   .add("EPICS_PVA_ADDR_LIST", "127.0.0.1")
+                                                                                   .add("EPICS_PVA_AUTO_ADDR_LIST","0")
+                                                                                   .add("EPICS_PVA_SERVER_PORT", "0")
+                                                                                   .add("EPICS_PVA_BROADCAST_PORT", "0")
+                                                                                   .add("EPICS_PVA_SHM_SIZE", ringSize)
+                                                                                   .push_map()
+                                                                                   .build())
+                                                                           .provider(prov.provider())));
+
+        pva::ClientFactory::start();
+
+        printf("# transport elements puts put_mean_us put_p50_us put_p99_us gets array_MB/s\n");
+        run(serv, "tcp", 0, nelements, nputs, duration);
+        run(serv, "shm", ringSize, nelements, nputs, duration);
+
+    }catch(std::exception& e){
+        std::cerr<<"Error: "<<e.what()<<"\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,190 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* Cost of the connection and command statistics.
+ *
+ * First, the time to record one handler duration, and to count one message,
+ * in a tight loop.  Then, starts a server in this process with many PVs,
+ * once with $EPICS_PVAS_HANDLER_TIMING=NO and once with YES, and reads all
+ * PVs with batched gets for a time.  Reports gets per second of each.
+ * Then prints the server statistics, as the 'pvasstats' iocsh command would.
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <sstream>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <epicsGetopt.h>
+#include <epicsTime.h>
+#include <epicsEvent.h>
+
+#include <pv/configuration.h>
+#include <pv/clientFactory.h>
+#include <pv/serverContext.h>
+#include <pv/standardField.h>
+#include <pv/transportStats.h>
+#include <pva/server.h>
+#include <pva/sharedstate.h>
+#include <pva/client.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+#define DEFAULT_COUNT 1000
+#define DEFAULT_WINDOW 256
+#define DEFAULT_DURATION 3.0
+
+struct Connected : public pvac::ClientProvider::ConnectAllCallback
+{
+    epicsEvent done;
+    virtual ~Connected() {}
+    virtual void connectAllDone() OVERRIDE FINAL { done.signal(); }
+};
+
+void micro()
+{
+    const size_t N = 10000000u;
+    pva::detail::LatencyHistogram hist;
+    pva::detail::TransportStats stats;
+
+    epicsTimeStamp start, end;
+
+    epicsTimeGetCurrent(&start);
+    for(size_t i=0; i<N; i++) {
+        pva::detail::LatencyTimer T(&hist);
+    }
+    epicsTimeGetCurrent(&end);
+    double timer = epicsTimeDiffInSeconds(&end, &start);
+
+    epicsTimeGetCurrent(&start);
+    for(size_t i=0; i<N; i++) {
+        stats.received(16u);
+        stats.messageReceived();
+    }
+    epicsTimeGetCurrent(&end);
+    double counter = epicsTimeDiffInSeconds(&end, &start);
+
+    printf("# operation ns/op\n");
+    printf("handler_timer %.1f\n", timer*1e9/N);
+    printf("message_count %.1f\n", counter*1e9/N);
+}
+
+void run(pvas::StaticProvider& prov, const std::vector<std::string>& names,
+         bool timing, size_t window, double duration)
+{
+    pva::ServerContext::shared_pointer serv(pva::ServerContext::create(pva::ServerContext::Config()
+                                                                       .config(pva::ConfigurationBuilder()
+                                                                               .add("EPICS_PVAS_INTF_ADDR_LIST", "127.0.0.1")
+                                                                               .add("EPICS_PVA_ADDR_LIST", "127.0.0.1")
+                                                                               .add("EPICS_PVA_AUTO_ADDR_LIST","0")
+                                                                               .add("EPICS_PVA_SERVER_PORT", "0")
+                                                                               .add("EPICS_PVA_BROADCAST_PORT", "0")
+                                                                               .add("EPICS_PVAS_HANDLER_TIMING", timing ? "YES" : "NO")
+                                                                               .push_map()
+                                                                               .build())
+                                                                       .provider(prov.provider())));
+
+    pvac::ClientProvider client("pva", pva::ConfigurationBuilder()
+                                .push_config(serv->getCurrentConfig())
+                                .push_map()
+                                .build());
+
+    std::vector<pvac::ClientChannel> channels;
+    Connected connected;
+    pvac::Operation op(client.connect(names, channels, &connected));
+    if(!connected.done.wait(30.0))
+        throw std::runtime_error("Timeout connecting");
+
+    std::vector<pvac::GetEvent> results;
+    size_t ngets = 0u;
+    epicsTimeStamp start, now;
+    epicsTimeGetCurrent(&start);
+    do {
+        size_t nok = client.get(channels, results, 30.0, pvd::PVStructure::const_shared_pointer(), window);
+        if(nok!=channels.size())
+            throw std::runtime_error("Get failed");
+        ngets += nok;
+        epicsTimeGetCurrent(&now);
+    } while(epicsTimeDiffInSeconds(&now, &start) < duration);
+
+    double elapsed = epicsTimeDiffInSeconds(&now, &start);
+    printf("%s %zu %zu %.0f\n", timing ? "YES" : "NO", names.size(), window, ngets/elapsed);
+
+    if(timing) {
+        std::ostringstream strm;
+        serv->printStats(strm, 1);
+        std::istringstream lines(strm.str());
+        std::string line;
+        while(std::getline(lines, line))
+            printf("# %s\n", line.c_str());
+    }
+}
+
+void usage()
+{
+    fprintf(stderr, "\nUsage: testStatsOverhead [options]\n\n"
+            "  -h: Help: Print this message\n"
+            "options:\n"
+            "  -n <count>:        number of PVs, default is %d\n"
+            "  -b <size>:         gets in progress, default is %d\n"
+            "  -d <sec>:          duration of each, default is %.1f\n\n",
+            DEFAULT_COUNT, DEFAULT_WINDOW, DEFAULT_DURATION);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int count = DEFAULT_COUNT, window = DEFAULT_WINDOW;
+    double duration = DEFAULT_DURATION;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "hn:b:d:")) != -1) {
+        switch(opt) {
+        case 'n': count = atoi(optarg); break;
+        case 'b': window = atoi(optarg); break;
+        case 'd': duration = atof(optarg); break;
+        case 'h': usage(); return 0;
+        default: usage(); return 1;
+        }
+    }
+
+    if(count<1 || window<0) {
+        fprintf(stderr, "Invalid options\n");
+        return 1;
+    }
+
+    try {
+        micro();
+
+        pvas::SharedPV::shared_pointer pv(pvas::SharedPV::buildReadOnly());
+        pv->open(pvd::getStandardField()->scalar(pvd::pvDouble, "alarm,timeStamp"));
+
+        std::vector<std::string> names(count);
+        pvas::StaticProvider prov("stats");
+        for(int i=0; i<count; i++) {
+            std::ostringstream strm;
+            strm<<"stats:"<<i;
+            names[i] = strm.str();
+            prov.add(names[i], pv);
+        }
+
+        pva::ClientFactory::start();
+
+        printf("# timing pvs batch gets/s\n");
+        run(prov, names, false, window, duration);
+        run(prov, names, true, window, duration);
+
+    }catch(std::exception& e){
+        std::cerr<<"Error: "<<e.what()<<"\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <vector>
+#include <string>
+
+#include <pv/transportStats.h>
+#include <pv/remote.h>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+namespace pva = epics::pvAccess;
+
+typedef pva::detail::LatencyHistogram hist_t;
+
+namespace {
+
+void testBuckets()
+{
+    testDiag("testBuckets()");
+
+    testOk1(hist_t::bucketOf(0u)==0u);
+    testOk1(hist_t::bucketOf(3u)==3u);
+    testOk1(hist_t::bucketOf(4u)==4u);
+    testOk1(hist_t::bucketOf(7u)==7u);
+    testOk1(hist_t::bucketOf(8u)==8u);
+    testOk1(hist_t::bucketOf(9u)==8u);
+    testOk1(hist_t::bucketOf(0xffffffffu)==hist_t::nBuckets-2u);
+    testOk1(hist_t::bucketOf(epicsUInt64(1u)<<32u)==hist_t::nBuckets-1u);
+    testOk1(hist_t::bucketOf(~epicsUInt64(0u))==hist_t::nBuckets-1u);
+
+    // each bucket starts where the last ends, and holds its start
+    bool ok = true;
+    for(size_t i=0; i<hist_t::nBuckets; i++) {
+        epicsUInt64 start = hist_t::bucketStart(i);
+        ok &= hist_t::bucketOf(start)==i;
+        if(i>0u)
+            ok &= hist_t::bucketOf(start-1u)==i-1u;
+    }
+    testOk(ok, "bucket boundaries");
+
+    // relative error of lower bound
+    ok = true;
+    for(epicsUInt64 v=1u; v<(epicsUInt64(1u)<<32u); v = v*3u+1u) {
+        epicsUInt64 start = hist_t::bucketStart(hist_t::bucketOf(v));
+        ok &= start<=v && (v-start)*4u <= v;
+    }
+    testOk(ok, "error <= 25%%");
+}
+
+void testPercentile()
+{
+    testDiag("testPercentile()");
+
+    hist_t hist;
+    std::vector<size_t> counts;
+    hist.snapshot(counts);
+    testOk1(counts.size()==hist_t::nBuckets);
+    testOk1(hist_t::total(counts)==0u);
+    testOk1(hist_t::percentile(counts, 0.5)==0u);
+
+    // 90 of 1us, 10 of 1ms
+    for(unsigned i=0; i<90u; i++)
+        hist.record(1000u);
+    for(unsigned i=0; i<10u; i++)
+        hist.record(1000000u);
+    hist.snapshot(counts);
+    testOk1(hist_t::total(counts)==100u);
+
+    epicsUInt64 p50 = hist_t::percentile(counts, 0.5),
+                p99 = hist_t::percentile(counts, 0.99);
+    testOk(p50>=1000u && p50<1250u, "p50 %llu", (unsigned long long)p50);
+    testOk(p99>=1000000u && p99<1250000u, "p99 %llu", (unsigned long long)p99);
+    testOk1(hist_t::percentile(counts, 1.0)==p99);
+    testOk1(hist_t::percentile(counts, 0.0)==p50);
+}
+
+void testCounters()
+{
+    testDiag("testCounters()");
+
+    pva::detail::TransportStats stats;
+    stats.received(10u);
+    stats.received(5u);
+    stats.sent(3u);
+    stats.messageReceived();
+    stats.messageSent();
+    stats.messageSent();
+    testOk1(stats.bytesRx==15u && stats.bytesTx==3u);
+    testOk1(stats.messagesRx==1u && stats.messagesTx==2u);
+
+    testOk1(std::string(pva::detail::commandName(pva::CMD_GET))=="GET");
+    testOk1(std::string(pva::detail::commandName(pva::CMD_CANCEL_REQUEST))=="CANCEL_REQUEST");
+    testOk1(pva::detail::commandName(100)==0);
+}
+
+} // namespace
+
+MAIN(testTransportStats)
+{
+    testPlan(24);
+    testBuckets();
+    testPercentile();
+    testCounters();
+    return testDone();
+}
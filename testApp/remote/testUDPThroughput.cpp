@@ -0,0 +1,204 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* UDP transport micro-benchmark.
+ *
+ * One BlockingUDPTransport fans out datagrams to a list of (loopback)
+ * addresses, as is done for search requests and beacons,
+ * and another receives them.  Reports datagrams per second,
+ * and per second of CPU time, for the sending and receiving threads.
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+
+#include <osiSock.h>
+#include <epicsGetopt.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <epicsEndian.h>
+
+#include <pv/byteBuffer.h>
+#include <pv/configuration.h>
+#include <pv/pvaConstants.h>
+#include <pv/remote.h>
+#include <pv/blockingUDP.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+#define DEFAULT_ADDRESSES 32
+#define DEFAULT_DURATION 3.0
+#define DEFAULT_PAYLOAD 64
+
+// CPU time used by the calling thread
+double threadCPU()
+{
+#ifndef _WIN32
+    rusage usage;
+#ifdef RUSAGE_THREAD
+    if(getrusage(RUSAGE_THREAD, &usage)==0)
+#else
+    if(getrusage(RUSAGE_SELF, &usage)==0)
+#endif
+        return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec*1e-6
+                + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec*1e-6;
+#endif
+    return 0.0;
+}
+
+struct DummyContext : public pva::Context
+{
+    pva::Configuration::const_shared_pointer conf;
+    DummyContext() :conf(pva::ConfigurationBuilder().push_map().build()) {}
+    virtual ~DummyContext() {}
+    virtual pvd::Timer::shared_pointer getTimer() OVERRIDE FINAL { return pvd::Timer::shared_pointer(); }
+    virtual pva::TransportRegistry* getTransportRegistry() OVERRIDE FINAL { return 0; }
+    virtual pva::Configuration::const_shared_pointer getConfiguration() OVERRIDE FINAL { return conf; }
+    virtual void newServerDetected() OVERRIDE FINAL {}
+    virtual std::tr1::shared_ptr<pva::Channel> getChannel(pva::pvAccessID) OVERRIDE FINAL { return std::tr1::shared_ptr<pva::Channel>(); }
+    virtual pva::Transport::shared_pointer getSearchTransport() OVERRIDE FINAL { return pva::Transport::shared_pointer(); }
+};
+
+// counts messages, called only from the receiver thread
+struct CountingHandler : public pva::ResponseHandler
+{
+    size_t count;
+    double cpuFirst, cpuLast;
+
+    explicit CountingHandler(pva::Context* ctxt)
+        :pva::ResponseHandler(ctxt, "Counting")
+        ,count(0u)
+        ,cpuFirst(0.0)
+        ,cpuLast(0.0)
+    {}
+    virtual ~CountingHandler() {}
+
+    virtual void handleResponse(osiSockAddr*, pva::Transport::shared_pointer const &,
+                                pvd::int8, pvd::int8, size_t,
+                                pvd::ByteBuffer*) OVERRIDE FINAL
+    {
+        if(count==0u)
+            cpuFirst = cpuLast = threadCPU();
+        else if((count%1024u)==0u)
+            cpuLast = threadCPU();
+        count++;
+    }
+};
+
+void usage()
+{
+    fprintf(stderr, "\nUsage: testUDPThroughput [options]\n\n"
+            "  -h: Help: Print this message\n"
+            "options:\n"
+            "  -a <addresses>:    length of the send address list, default is %d\n"
+            "  -p <bytes>:        message payload size, default is %d\n"
+            "  -d <sec>:          duration, default is %.1f\n\n",
+            DEFAULT_ADDRESSES, DEFAULT_PAYLOAD, DEFAULT_DURATION);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int naddrs = DEFAULT_ADDRESSES, payload = DEFAULT_PAYLOAD;
+    double duration = DEFAULT_DURATION;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "ha:p:d:")) != -1) {
+        switch(opt) {
+        case 'a': naddrs = atoi(optarg); break;
+        case 'p': payload = atoi(optarg); break;
+        case 'd': duration = atof(optarg); break;
+        case 'h': usage(); return 0;
+        default: usage(); return 1;
+        }
+    }
+
+    if(naddrs<1 || payload<0 || payload+pva::PVA_MESSAGE_HEADER_SIZE > pva::MAX_UDP_UNFRAGMENTED_SEND) {
+        fprintf(stderr, "Invalid options\n");
+        return 1;
+    }
+
+    try {
+        osiSockAttach();
+
+        DummyContext ctxt;
+        std::tr1::shared_ptr<CountingHandler> handler(new CountingHandler(&ctxt));
+        pva::BlockingUDPConnector connector(false);
+
+        osiSockAddr bindAddr;
+        memset(&bindAddr, 0, sizeof(bindAddr));
+        bindAddr.ia.sin_family = AF_INET;
+        bindAddr.ia.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        pva::BlockingUDPTransport::shared_pointer rx(connector.connect(handler, bindAddr, pva::PVA_CLIENT_PROTOCOL_REVISION));
+        pva::BlockingUDPTransport::shared_pointer tx(connector.connect(handler, bindAddr, pva::PVA_CLIENT_PROTOCOL_REVISION));
+        if(!rx || !tx)
+            throw std::runtime_error("Unable to create UDP transports");
+
+        {
+            pva::InetAddrVector addrs(naddrs, rx->getRemoteAddress());
+            std::vector<bool> unicast(naddrs, true);
+            tx->setSendAddresses(addrs, unicast);
+        }
+
+        rx->start();
+
+        pvd::ByteBuffer buf(pva::MAX_UDP_UNFRAGMENTED_SEND);
+        buf.putByte(pva::PVA_MAGIC);
+        buf.putByte(pva::PVA_CLIENT_PROTOCOL_REVISION);
+        buf.putByte(EPICS_BYTE_ORDER==EPICS_ENDIAN_BIG ? 0x80 : 0x00);
+        buf.putByte(pva::CMD_ECHO);
+        buf.putInt(payload);
+        for(int i=0; i<payload; i++)
+            buf.putByte(pvd::int8(i));
+
+        size_t sent = 0u;
+        double cpu0 = threadCPU();
+        epicsTimeStamp start, now;
+        epicsTimeGetCurrent(&start);
+
+        do {
+            // send() leaves position at the end of the message, so may be repeated
+            for(int i=0; i<100; i++)
+                tx->send(&buf);
+            sent += 100u*naddrs;
+            epicsTimeGetCurrent(&now);
+        } while(epicsTimeDiffInSeconds(&now, &start) < duration);
+
+        double txCPU = threadCPU()-cpu0;
+        double elapsed = epicsTimeDiffInSeconds(&now, &start);
+
+        // allow receiver to catch up
+        epicsThreadSleep(0.5);
+        tx->close();
+        rx->close();
+
+        double rxCPU = handler->cpuLast-handler->cpuFirst;
+
+        printf("# addresses payload sent sent/s sent/CPU-s received received/s received/CPU-s\n");
+        printf("%d %d %zu %.0f %.0f %zu %.0f %.0f\n",
+               naddrs, payload,
+               sent, sent/elapsed, txCPU>0.0 ? sent/txCPU : 0.0,
+               handler->count, handler->count/elapsed, rxCPU>0.0 ? handler->count/rxCPU : 0.0);
+
+    }catch(std::exception& e){
+        std::cerr<<"Error: "<<e.what()<<"\n";
+        return 1;
+    }
+    return 0;
+}
@@ -3,12 +3,18 @@
  * found in the file LICENSE that is included with the distribution
  */
 
+#include <vector>
+
+#include <dbDefs.h>
+#include <epicsTime.h>
+
 #include <pv/pvUnitTest.h>
 #include <testMain.h>
 
 #include <pva/client.h>
 #include <pva/sharedstate.h>
 #include <pv/current_function.h>
+#include <pv/elementPool.h>
 //#include <pv/pvAccess.h>
 
 namespace pvd = epics::pvData;
@@ -186,16 +192,154 @@ void testPutRPC()
     testEqual(reply->getSubFieldT<pvd::PVScalar>("value")->getAs<pvd::uint32>(), 100u);
 }
 
+// post() to an increasing number of subscribers.
+// Timing is reported, not tested.
+void testPostFanout()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    const size_t nsubscribers[] = {1u, 10u, 50u, 100u, 200u};
+    const size_t nposts = 1000u;
+
+    std::tr1::shared_ptr<pvas::StaticProvider> prov(new pvas::StaticProvider("test"));
+    std::tr1::shared_ptr<pvas::SharedPV> pv(pvas::SharedPV::buildReadOnly());
+
+    prov->add("pv:name", pv);
+
+    pv->open(type);
+
+    pvac::ClientProvider cli(prov->provider());
+
+    pvac::ClientChannel chan(cli.connect("pv:name"));
+
+    pvd::PVStructurePtr inst(pvd::getPVDataCreate()->createPVStructure(type));
+    pvd::BitSet changed;
+    pvd::PVScalarPtr value(inst->getSubFieldT<pvd::PVScalar>("value"));
+    changed.set(value->getFieldOffset());
+
+    std::vector<pvac::MonitorSync> mons;
+
+    pvd::uint32 count = 0u;
+    for(size_t n=0u; n<NELEMENTS(nsubscribers); n++) {
+        while(mons.size()<nsubscribers[n])
+            mons.push_back(chan.monitor());
+
+        epicsTimeStamp start, end;
+        epicsTimeGetCurrent(&start);
+        for(size_t i=0; i<nposts; i++) {
+            value->putFrom<pvd::uint32>(++count);
+            pv->post(*inst, changed);
+        }
+        epicsTimeGetCurrent(&end);
+
+        testDiag("post() to %zu subscribers takes %.2f us",
+                 mons.size(), 1e6*epicsTimeDiffInSeconds(&end, &start)/nposts);
+    }
+
+    // each subscriber's last update is the last post()
+    size_t bad = 0u;
+    for(size_t i=0; i<mons.size(); i++) {
+        pvd::uint32 last = 0u;
+        while(mons[i].poll())
+            last = mons[i].root->getSubFieldT<pvd::PVScalar>("value")->getAs<pvd::uint32>();
+        if(last!=count)
+            bad++;
+    }
+    testOk(bad==0u, "%zu of %zu subscribers missed the last update", bad, mons.size());
+
+    {
+        pvd::PVStructure::const_shared_pointer R(chan.get());
+
+        testEqual(R->getSubFieldT<pvd::PVScalar>("value")->getAs<pvd::uint32>(), count);
+    }
+}
+
+// Subscriptions to two PVs of one type, with monitor queue elements
+// of the first re-used by the second.
+void testPoolReuse()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    pva::detail::ElementPool& pool = pva::detail::ElementPool::instance();
+    const size_t limit = pool.limit();
+    pool.clear();
+    pool.setLimit(100u);
+
+    const pvd::StructureConstPtr pairType(pvd::getFieldCreate()->createFieldBuilder()
+                                          ->add("value", pvd::pvInt)
+                                          ->add("extra", pvd::pvString)
+                                          ->createStructure());
+
+    std::tr1::shared_ptr<pvas::StaticProvider> prov(new pvas::StaticProvider("test"));
+    std::tr1::shared_ptr<pvas::SharedPV> pv1(pvas::SharedPV::buildReadOnly()),
+                                         pv2(pvas::SharedPV::buildReadOnly());
+
+    prov->add("pv:one", pv1);
+    prov->add("pv:two", pv2);
+
+    {
+        pvd::PVStructurePtr inst(pvd::getPVDataCreate()->createPVStructure(pairType));
+        inst->getSubFieldT<pvd::PVInt>("value")->put(1);
+        inst->getSubFieldT<pvd::PVString>("extra")->put("one");
+        pv1->open(*inst);
+    }
+    {
+        // only value has been set
+        pvd::PVStructurePtr inst(pvd::getPVDataCreate()->createPVStructure(pairType));
+        pvd::BitSet valid;
+        inst->getSubFieldT<pvd::PVInt>("value")->put(2);
+        valid.set(inst->getSubFieldT<pvd::PVInt>("value")->getFieldOffset());
+        pv2->open(*inst, valid);
+    }
+
+    pvac::ClientProvider cli(prov->provider());
+
+    {
+        pvac::ClientChannel chan(cli.connect("pv:one"));
+        pvac::MonitorSync mon(chan.monitor());
+
+        testOk1(mon.wait(5.0) && mon.poll());
+        if(mon.root) {
+            testEqual(mon.root->getSubFieldT<pvd::PVString>("extra")->get(), "one");
+        } else {
+            testSkip(1, "No data");
+        }
+    }
+
+    pva::detail::ElementPool::Stats stats;
+    pool.getStats(stats);
+    testOk(stats.pooled>0u, "pooled %zu elements of pv:one", stats.pooled);
+
+    {
+        pvac::ClientChannel chan(cli.connect("pv:two"));
+        pvac::MonitorSync mon(chan.monitor());
+
+        testOk1(mon.wait(5.0) && mon.poll());
+        if(mon.root) {
+            testEqual(mon.root->getSubFieldT<pvd::PVInt>("value")->get(), 2);
+            // not the value of pv:one
+            testEqual(mon.root->getSubFieldT<pvd::PVString>("extra")->get(), "");
+        } else {
+            testSkip(2, "No data");
+        }
+    }
+
+    pool.clear();
+    pool.setLimit(limit);
+}
+
 } // namespace
 
 MAIN(testsharedstate)
 {
-    testPlan(19);
+    testPlan(27);
     try {
         testNoClient();
         testGetMon();
         testPutRPCCancel();
         testPutRPC();
+        testPostFanout();
+        testPoolReuse();
     }catch(std::exception& e){
         testAbort("Unexpected exception: %s", e.what());
     }
@@ -0,0 +1,183 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <pv/pvData.h>
+#include <pv/createRequest.h>
+#include <pv/monitor.h>
+#include <pv/elementPool.h>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+typedef pva::detail::ElementPool ElementPool;
+
+namespace {
+
+pvd::StructureConstPtr makeType(const char *name)
+{
+    return pvd::getFieldCreate()->createFieldBuilder()
+            ->add(name, pvd::pvInt)
+            ->add("extra", pvd::pvString)
+            ->createStructure();
+}
+
+pva::MonitorElementPtr makeElement(const pvd::StructureConstPtr& type)
+{
+    return pva::MonitorElementPtr(new pva::MonitorElement(pvd::getPVDataCreate()->createPVStructure(type)));
+}
+
+void testGetPut()
+{
+    testDiag("testGetPut()");
+
+    ElementPool& pool = ElementPool::instance();
+    pool.setLimit(4u);
+
+    pvd::StructureConstPtr A(makeType("a")), B(makeType("b"));
+
+    testOk1(!pool.get(A));
+
+    pva::MonitorElementPtr elem(makeElement(A));
+    pva::MonitorElement *raw = elem.get();
+    elem->changedBitSet->set(1);
+    elem->overrunBitSet->set(1);
+    elem->pvStructurePtr->getSubFieldT<pvd::PVInt>("a")->put(42);
+    elem->pvStructurePtr->getSubFieldT<pvd::PVString>("extra")->put("previous");
+
+    pool.put(elem);
+    testOk1(!elem);
+
+    testOk1(!pool.get(B));
+
+    elem = pool.get(A);
+    testOk1(elem.get()==raw);
+    testOk1(elem && elem->changedBitSet->isEmpty() && elem->overrunBitSet->isEmpty());
+    // values of the previous user are not kept
+    testOk1(elem && elem->pvStructurePtr->getSubFieldT<pvd::PVInt>("a")->get()==0
+            && elem->pvStructurePtr->getSubFieldT<pvd::PVString>("extra")->get().empty());
+    testOk1(!pool.get(A));
+
+    // not taken while referenced elsewhere
+    pva::MonitorElementPtr other(elem);
+    pool.put(elem);
+    testOk1(!elem);
+    testOk1(!pool.get(A));
+}
+
+void testLimit()
+{
+    testDiag("testLimit()");
+
+    ElementPool& pool = ElementPool::instance();
+    pool.clear();
+    pool.setLimit(4u);
+
+    pvd::StructureConstPtr A(makeType("a")), B(makeType("b"));
+
+    for(unsigned i=0; i<3; i++) {
+        pva::MonitorElementPtr elem(makeElement(A));
+        pool.put(elem);
+    }
+    for(unsigned i=0; i<3; i++) {
+        pva::MonitorElementPtr elem(makeElement(B));
+        pool.put(elem);
+    }
+
+    ElementPool::Stats stats;
+    pool.getStats(stats);
+    testOk(stats.pooled==4u, "pooled %zu", stats.pooled);
+
+    // A is least recently used, and is discarded first
+    size_t nA = 0u, nB = 0u;
+    while(pool.get(A)) nA++;
+    while(pool.get(B)) nB++;
+    testOk(nA==1u && nB==3u, "A %zu B %zu", nA, nB);
+
+    pool.setLimit(0u);
+    {
+        pva::MonitorElementPtr elem(makeElement(A));
+        pool.put(elem);
+    }
+    testOk1(!pool.get(A));
+}
+
+struct DummyRequester : public pva::MonitorRequester {
+    virtual ~DummyRequester() {}
+    virtual std::string getRequesterName() OVERRIDE FINAL { return "DummyRequester"; }
+    virtual void monitorConnect(pvd::Status const &, pva::MonitorPtr const &, pvd::StructureConstPtr const &) OVERRIDE FINAL {}
+    virtual void monitorEvent(pva::MonitorPtr const &) OVERRIDE FINAL {}
+    virtual void unlisten(pva::MonitorPtr const &) OVERRIDE FINAL {}
+};
+
+void testFIFO()
+{
+    testDiag("testFIFO() re-use of MonitorFIFO elements");
+
+    ElementPool& pool = ElementPool::instance();
+    pool.clear();
+    pool.setLimit(100u);
+
+    pvd::StructureConstPtr A(makeType("a"));
+    pvd::PVStructurePtr value(pvd::getPVDataCreate()->createPVStructure(A));
+    pva::MonitorRequester::shared_pointer req(new DummyRequester);
+
+    pva::MonitorFIFO::Config conf;
+    conf.maxCount = conf.defCount = 4;
+
+    ElementPool::Stats before, after;
+    {
+        pva::MonitorFIFO::shared_pointer mon(new pva::MonitorFIFO(req, pvd::createRequest(""),
+                                                                   pva::MonitorFIFO::Source::shared_pointer(), &conf));
+        mon->open(A);
+        mon->notify();
+        mon->start();
+
+        pvd::BitSet changed;
+        changed.set(0);
+        mon->post(*value, changed);
+        mon->notify();
+
+        pva::MonitorElementPtr held(mon->poll());
+        testOk1(!!held);
+
+        mon->close();
+        mon->notify();
+
+        pool.getStats(before);
+        mon->open(A);
+        pool.getStats(after);
+
+        // all but the element still held are re-used
+        testOk(after.reused-before.reused==conf.actualCount, "re-open reused %zu of %zu",
+               after.reused-before.reused, conf.actualCount+1);
+        testOk1(after.pooled==0u);
+
+        mon->release(held); // ignored, already a full set of elements
+        held.reset();
+        mon->close();
+        mon->notify();
+        mon.reset();
+    }
+
+    pool.getStats(after);
+    testOk(after.pooled==conf.actualCount+1, "pooled %zu after destroy", after.pooled);
+
+    pool.setLimit(0u);
+}
+
+} // namespace
+
+MAIN(testElementPool)
+{
+    testPlan(16);
+    testGetPut();
+    testLimit();
+    testFIFO();
+    return testDone();
+}
@@ -0,0 +1,174 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <vector>
+#include <sstream>
+
+#include <pv/introspectionRegistry.h>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+struct TestControl : public pvd::SerializableControl, public pvd::DeserializableControl
+{
+    virtual ~TestControl() {}
+    virtual void flushSerializeBuffer() OVERRIDE FINAL {}
+    virtual void ensureBuffer(std::size_t) OVERRIDE FINAL {}
+    virtual void alignBuffer(std::size_t) OVERRIDE FINAL {}
+    virtual bool directSerialize(pvd::ByteBuffer*, const char*, std::size_t, std::size_t) OVERRIDE FINAL { return false; }
+    virtual void cachedSerialize(const std::tr1::shared_ptr<const pvd::Field>& field, pvd::ByteBuffer* buffer) OVERRIDE FINAL
+    {
+        field->serialize(buffer, this);
+    }
+    virtual void ensureData(std::size_t) OVERRIDE FINAL {}
+    virtual void alignData(std::size_t) OVERRIDE FINAL {}
+    virtual bool directDeserialize(pvd::ByteBuffer*, char*, std::size_t, std::size_t) OVERRIDE FINAL { return false; }
+    virtual std::tr1::shared_ptr<const pvd::Field> cachedDeserialize(pvd::ByteBuffer* buffer) OVERRIDE FINAL
+    {
+        return pvd::getFieldCreate()->deserialize(buffer, this);
+    }
+};
+
+pvd::StructureConstPtr buildType(const std::string& id, const std::string& field)
+{
+    return pvd::getFieldCreate()->createFieldBuilder()
+            ->setId(id)
+            ->add(field, pvd::pvDouble)
+            ->addNestedStructureArray("sub")
+                ->add("x", pvd::pvInt)
+            ->endNested()
+            ->createStructure();
+}
+
+// serialize through out, then deserialize through in.
+// @returns type code sent
+pvd::int8 roundTrip(pva::IntrospectionRegistry& out, pva::IntrospectionRegistry& in,
+                    const pvd::FieldConstPtr& field, pvd::FieldConstPtr& received)
+{
+    TestControl control;
+    std::vector<char> storage(4096);
+    pvd::ByteBuffer buf(&storage[0], storage.size());
+
+    out.serialize(field, &buf, &control);
+    buf.flip();
+
+    pvd::int8 code = storage[0];
+    received = in.deserialize(&buf, &control);
+    return code;
+}
+
+void testRegistry()
+{
+    testDiag("testRegistry()");
+
+    pva::IntrospectionRegistry out, in;
+    pvd::FieldConstPtr received;
+
+    pvd::StructureConstPtr A(buildType("test:A", "value")),
+                           B(buildType("test:B", "value")),
+                           C(buildType("test:A", "other"));
+
+    testOk1(roundTrip(out, in, A, received)==pva::IntrospectionRegistry::FULL_WITH_ID_TYPE_CODE);
+    testOk1(received && *received==*A);
+    testOk1(roundTrip(out, in, A, received)==pva::IntrospectionRegistry::ONLY_ID_TYPE_CODE);
+    testOk1(received && *received==*A);
+
+    // differ only in ID, and only in field name
+    testOk1(roundTrip(out, in, B, received)==pva::IntrospectionRegistry::FULL_WITH_ID_TYPE_CODE);
+    testOk1(received && *received==*B);
+    testOk1(roundTrip(out, in, C, received)==pva::IntrospectionRegistry::FULL_WITH_ID_TYPE_CODE);
+    testOk1(received && *received==*C);
+
+    // an equal type, maybe a different instance
+    pvd::StructureConstPtr A2(buildType("test:A", "value"));
+    testOk1(roundTrip(out, in, A2, received)==pva::IntrospectionRegistry::ONLY_ID_TYPE_CODE);
+    testOk1(received && *received==*A);
+
+    testOk1(roundTrip(out, in, B, received)==pva::IntrospectionRegistry::ONLY_ID_TYPE_CODE);
+    testOk1(received && *received==*B);
+
+    out.reset();
+    in.reset();
+    testOk1(roundTrip(out, in, A, received)==pva::IntrospectionRegistry::FULL_WITH_ID_TYPE_CODE);
+    testOk1(received && *received==*A);
+}
+
+void testAliases()
+{
+    const size_t N = 100u;
+    testDiag("testAliases() with %zu equal instances", N);
+
+    pva::IntrospectionRegistry out, in;
+    pvd::FieldConstPtr received;
+
+    pvd::StructureConstPtr A(buildType("test:A", "value"));
+    testOk1(roundTrip(out, in, A, received)==pva::IntrospectionRegistry::FULL_WITH_ID_TYPE_CODE);
+
+    // equal, but perhaps not the same instance, each released after sending
+    std::vector<std::tr1::weak_ptr<const pvd::Field> > sent(N);
+    size_t bad = 0u;
+    for(size_t i=0; i<N; i++) {
+        pvd::StructureConstPtr A2(buildType("test:A", "value"));
+        sent[i] = A2;
+        if(roundTrip(out, in, A2, received)!=pva::IntrospectionRegistry::ONLY_ID_TYPE_CODE || !received || !(*received==*A))
+            bad++;
+    }
+    testOk(bad==0u, "%zu of %zu equal instances sent wrong", bad, N);
+
+    size_t alive = 0u;
+    for(size_t i=0; i<N; i++) {
+        pvd::FieldConstPtr F(sent[i].lock());
+        if(F && F!=A)
+            alive++;
+    }
+    testOk(alive==0u, "%zu of %zu released instances kept alive", alive, N);
+}
+
+void testMany()
+{
+    const size_t N = 10000u;
+    testDiag("testMany() with %zu types", N);
+
+    pva::IntrospectionRegistry out, in;
+    pvd::FieldConstPtr received;
+
+    std::vector<pvd::StructureConstPtr> types(N);
+    for(size_t i=0; i<N; i++) {
+        std::ostringstream id;
+        id<<"test:"<<i;
+        types[i] = buildType(id.str(), "value");
+    }
+
+    size_t bad = 0u;
+    for(size_t i=0; i<N; i++) {
+        if(roundTrip(out, in, types[i], received)!=pva::IntrospectionRegistry::FULL_WITH_ID_TYPE_CODE || !received || !(*received==*types[i]))
+            bad++;
+    }
+    testOk(bad==0u, "%zu of %zu first sent wrong", bad, N);
+
+    bad = 0u;
+    for(size_t i=0; i<N; i++) {
+        if(roundTrip(out, in, types[N-1u-i], received)!=pva::IntrospectionRegistry::ONLY_ID_TYPE_CODE || !received || !(*received==*types[N-1u-i]))
+            bad++;
+    }
+    testOk(bad==0u, "%zu of %zu repeats wrong", bad, N);
+}
+
+} // namespace
+
+MAIN(testIntrospectionRegistry)
+{
+    testPlan(19);
+    testRegistry();
+    testAliases();
+    testMany();
+    return testDone();
+}
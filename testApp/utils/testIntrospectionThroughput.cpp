@@ -0,0 +1,137 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+/* IntrospectionRegistry micro-benchmark.
+ *
+ * Registers many distinct structure types with one registry, as a connection
+ * carrying many types would, then serializes randomly chosen types,
+ * which are sent as their registered IDs.  Reports serializations per second.
+ */
+
+#include <iostream>
+#include <vector>
+#include <sstream>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <epicsGetopt.h>
+#include <epicsTime.h>
+
+#include <pv/introspectionRegistry.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+#define DEFAULT_TYPES 10000
+#define DEFAULT_DURATION 3.0
+
+struct NullControl : public pvd::SerializableControl
+{
+    virtual ~NullControl() {}
+    virtual void flushSerializeBuffer() OVERRIDE FINAL {}
+    virtual void ensureBuffer(std::size_t) OVERRIDE FINAL {}
+    virtual void alignBuffer(std::size_t) OVERRIDE FINAL {}
+    virtual bool directSerialize(pvd::ByteBuffer*, const char*, std::size_t, std::size_t) OVERRIDE FINAL { return false; }
+    virtual void cachedSerialize(const std::tr1::shared_ptr<const pvd::Field>& field, pvd::ByteBuffer* buffer) OVERRIDE FINAL
+    {
+        field->serialize(buffer, this);
+    }
+};
+
+void usage()
+{
+    fprintf(stderr, "\nUsage: testIntrospectionThroughput [options]\n\n"
+            "  -h: Help: Print this message\n"
+            "options:\n"
+            "  -n <types>:        number of registered types, default is %d\n"
+            "  -d <sec>:          duration, default is %.1f\n\n",
+            DEFAULT_TYPES, DEFAULT_DURATION);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int ntypes = DEFAULT_TYPES;
+    double duration = DEFAULT_DURATION;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "hn:d:")) != -1) {
+        switch(opt) {
+        case 'n': ntypes = atoi(optarg); break;
+        case 'd': duration = atof(optarg); break;
+        case 'h': usage(); return 0;
+        default: usage(); return 1;
+        }
+    }
+
+    // IDs are 16 bit
+    if(ntypes<1 || ntypes>30000) {
+        fprintf(stderr, "Invalid options (1 to 30000 types)\n");
+        return 1;
+    }
+
+    try {
+        std::vector<pvd::StructureConstPtr> types(ntypes);
+        for(int i=0; i<ntypes; i++) {
+            std::ostringstream id;
+            id<<"bench:"<<i;
+            types[i] = pvd::getFieldCreate()->createFieldBuilder()
+                    ->setId(id.str())
+                    ->add("value", pvd::pvDouble)
+                    ->addNestedStructure("alarm")
+                        ->add("severity", pvd::pvInt)
+                        ->add("status", pvd::pvInt)
+                        ->add("message", pvd::pvString)
+                    ->endNested()
+                    ->createStructure();
+        }
+
+        // random order of use
+        std::vector<size_t> order(1024u*1024u);
+        for(size_t i=0; i<order.size(); i++)
+            order[i] = size_t(rand())%types.size();
+
+        pva::IntrospectionRegistry registry;
+        NullControl control;
+        std::vector<char> storage(64u*1024u);
+        pvd::ByteBuffer buf(&storage[0], storage.size());
+
+        epicsTimeStamp start, now;
+        epicsTimeGetCurrent(&start);
+
+        for(size_t i=0; i<types.size(); i++) {
+            buf.clear();
+            registry.serialize(types[i], &buf, &control);
+        }
+
+        epicsTimeGetCurrent(&now);
+        double registerTime = epicsTimeDiffInSeconds(&now, &start);
+
+        size_t count = 0u;
+        epicsTimeGetCurrent(&start);
+        do {
+            for(size_t i=0; i<order.size(); i++) {
+                buf.clear();
+                registry.serialize(types[order[i]], &buf, &control);
+            }
+            count += order.size();
+            epicsTimeGetCurrent(&now);
+        } while(epicsTimeDiffInSeconds(&now, &start) < duration);
+
+        double elapsed = epicsTimeDiffInSeconds(&now, &start);
+
+        printf("# types register_sec serializations serializations/s\n");
+        printf("%d %.3f %zu %.0f\n", ntypes, registerTime, count, count/elapsed);
+
+    }catch(std::exception& e){
+        std::cerr<<"Error: "<<e.what()<<"\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <vector>
+
+#include <string.h>
+#include <stdlib.h>
+
+#include <pv/lzBlock.h>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+namespace pva = epics::pvAccess;
+
+namespace {
+
+// returns compressed size, or 0 if the round trip fails
+size_t roundTrip(const std::vector<char>& input)
+{
+    std::vector<char> comp(input.size() + input.size()/255u + 16u), output(input.size()+1u);
+
+    size_t n = pva::detail::lzCompress(input.empty() ? 0 : &input[0], input.size(), &comp[0], comp.size());
+    if(n==0u)
+        return 0u;
+    if(!pva::detail::lzDecompress(&comp[0], n, &output[0], input.size()))
+        return 0u;
+    if(!input.empty() && memcmp(&input[0], &output[0], input.size())!=0)
+        return 0u;
+    return n;
+}
+
+void testRoundTrip()
+{
+    testDiag("testRoundTrip()");
+
+    {
+        std::vector<char> zeros(65536, 0);
+        size_t n = roundTrip(zeros);
+        testOk(n>0u && n<1024u, "zeros %zu -> %zu", zeros.size(), n);
+    }
+    {
+        // image like.  background, and a slowly varying region
+        std::vector<char> image(256*256);
+        for(size_t i=0; i<image.size(); i++) {
+            size_t x = i%256, y = i/256;
+            image[i] = (x>64 && x<192 && y>64 && y<192) ? char((x/8+y/8)&0xff) : 0;
+        }
+        size_t n = roundTrip(image);
+        testOk(n>0u && n<image.size()/4u, "image %zu -> %zu", image.size(), n);
+    }
+    {
+        std::vector<char> noise(65536);
+        srand(42);
+        for(size_t i=0; i<noise.size(); i++)
+            noise[i] = char(rand());
+        size_t n = roundTrip(noise);
+        testOk(n>=noise.size(), "noise %zu -> %zu", noise.size(), n);
+    }
+
+    bool ok = true;
+    for(size_t len=0; len<40u; len++) {
+        std::vector<char> small(len);
+        for(size_t i=0; i<len; i++)
+            small[i] = char(i%3);
+        ok &= roundTrip(small)!=0u;
+    }
+    testOk(ok, "short blocks");
+}
+
+void testCapacity()
+{
+    testDiag("testCapacity()");
+
+    std::vector<char> input(4096), comp(4096);
+    for(size_t i=0; i<input.size(); i++)
+        input[i] = char(i*7);
+
+    size_t n = pva::detail::lzCompress(&input[0], input.size(), &comp[0], comp.size());
+    testOk(n>0u, "compressed to %zu", n);
+    testOk1(pva::detail::lzCompress(&input[0], input.size(), &comp[0], n-1u)==0u);
+}
+
+void testCorrupt()
+{
+    testDiag("testCorrupt()");
+
+    std::vector<char> input(8192);
+    for(size_t i=0; i<input.size(); i++)
+        input[i] = char((i/16)&0xff);
+
+    std::vector<char> comp(input.size()*2), output(input.size());
+    size_t n = pva::detail::lzCompress(&input[0], input.size(), &comp[0], comp.size());
+    testOk1(n>0u);
+
+    testOk1(!pva::detail::lzDecompress(&comp[0], n, &output[0], input.size()-1u));
+    testOk1(!pva::detail::lzDecompress(&comp[0], n-1u, &output[0], input.size()));
+
+    // must not crash, result is not checked
+    srand(1);
+    for(unsigned i=0; i<10000u; i++) {
+        std::vector<char> bad(comp.begin(), comp.begin()+n);
+        bad[rand()%n] ^= char(1u<<(rand()%8));
+        (void)pva::detail::lzDecompress(&bad[0], rand()%2 ? n : rand()%n, &output[0], output.size());
+    }
+    testPass("corrupt input");
+}
+
+} // namespace
+
+MAIN(testLZBlock)
+{
+    testPlan(10);
+    testRoundTrip();
+    testCapacity();
+    testCorrupt();
+    return testDone();
+}
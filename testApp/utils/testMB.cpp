@@ -0,0 +1,239 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <vector>
+#include <string>
+#include <sstream>
+
+#include <epicsVersion.h>
+#include <epicsThread.h>
+
+#define WITH_MICROBENCH
+#include <pv/pvAccessMB.h>
+#include <pv/sharedPtr.h>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+namespace mb = epics::pvAccess::mb;
+
+namespace {
+
+MB_DECLARE(testTracer, 16);
+
+void testMacros()
+{
+    testDiag("testMacros()");
+
+    MB_INC_AUTO_ID(testTracer);
+    MB_POINT(testTracer, 0, "start");
+    MB_POINT_CONDITIONAL(testTracer, 1, "skipped", false);
+    MB_POINT_CONDITIONAL(testTracer, 2, "end", true);
+
+    std::vector<mb::Point> points;
+    testTracer.collect(points);
+    testOk1(points.size()==2u);
+    if(points.size()==2u) {
+        testOk1(points[0].id==points[1].id && points[0].id!=0u);
+        testOk1(points[0].stage==0u && points[1].stage==2u);
+        testOk1(points[0].time<=points[1].time);
+    } else {
+        testSkip(3, "Wrong size");
+    }
+
+    std::ostringstream strm;
+    MB_STATS(testTracer, strm);
+    testDiag("%s", strm.str().c_str());
+    testOk1(strm.str().find("\n2 1 ")!=std::string::npos);
+    testOk1(strm.str().find(" end\n")!=std::string::npos);
+    testOk1(strm.str().find("\ntotal 1 ")!=std::string::npos);
+}
+
+void testNoID()
+{
+    testDiag("testNoID()");
+
+    mb::Tracer T("noid", 8);
+    T.point(0, "nothing");
+    T.point(0, "nothing", 0u);
+    T.point(mb::Tracer::maxStages, "out of range", 1u);
+
+    std::vector<mb::Point> points;
+    T.collect(points);
+    testOk1(points.empty());
+}
+
+void testWrap()
+{
+    testDiag("testWrap()");
+
+    mb::Tracer T("wrap", 3); // rounded to 4
+
+    for(epicsUInt64 id=1u; id<=10u; id++)
+        T.point(0, "a", id);
+
+    // may be overwriting the oldest, so the last size-1
+    std::vector<mb::Point> points;
+    T.collect(points);
+    testOk(points.size()==3u, "size %u", unsigned(points.size()));
+    if(points.size()==3u)
+        testOk1(points[0].id==8u && points[1].id==9u && points[2].id==10u);
+    else
+        testSkip(1, "Wrong size");
+}
+
+void testSelect()
+{
+    testDiag("testSelect()");
+
+    mb::Tracer T("select", 64);
+
+    for(epicsUInt64 id=1u; id<=10u; id++) {
+        T.point(0, "a", id);
+        T.point(1, "b");
+        T.point(2, "c");
+    }
+
+    std::vector<mb::Point> points;
+    T.collect(points);
+    testOk1(points.size()==30u);
+
+    T.collect(points, 1);
+    testOk1(points.size()==10u);
+
+    T.collect(points, 1, 4u);
+    testOk1(points.size()==6u && points.front().id==5u && points.front().stage==1u);
+
+    T.normalize();
+    T.collect(points, 0);
+    bool ok = points.size()==10u;
+    for(size_t i=0; i<points.size(); i++)
+        ok &= points[i].time==0u;
+    testOk(ok, "normalized");
+}
+
+void testCSV()
+{
+    testDiag("testCSV()");
+
+    mb::Tracer A("A", 64), B("B", 64);
+
+    for(epicsUInt64 id=1u; id<=5u; id++) {
+        A.point(0, "a", id);
+        A.point(1, "b");
+    }
+
+    std::ostringstream out;
+    A.csvExport(out);
+    std::istringstream in("# comment\n"+out.str()+"garbage\n");
+    B.csvImport(in);
+
+    std::vector<mb::Point> a, b;
+    A.collect(a);
+    B.collect(b);
+    bool ok = a.size()==10u && a.size()==b.size();
+    for(size_t i=0; ok && i<a.size(); i++)
+        ok &= a[i].id==b[i].id && a[i].stage==b[i].stage && a[i].time==b[i].time;
+    testOk(ok, "round trip");
+
+    std::ostringstream all;
+    mb::Tracer::exportAll(all);
+    testOk1(all.str().find("# A\n")!=std::string::npos);
+    testOk1(all.str().find("# B\n")!=std::string::npos);
+}
+
+struct Writer : public epicsThreadRunable
+{
+    mb::Tracer& T;
+    const epicsUInt64 base;
+    const epicsUInt64 count;
+    epicsThread thread;
+
+    Writer(mb::Tracer& T, epicsUInt64 base, epicsUInt64 count = 1000u)
+        :T(T), base(base), count(count)
+        ,thread(*this, "writer", epicsThreadGetStackSize(epicsThreadStackSmall))
+    {}
+    virtual ~Writer() {}
+
+    virtual void run()
+    {
+        for(epicsUInt64 i=0u; i<count; i++) {
+            T.point(0, "a", base+i);
+            T.point(1, "b");
+        }
+    }
+};
+
+void testThreads()
+{
+    testDiag("testThreads()");
+
+    mb::Tracer T("threads", 4096);
+
+    std::vector<std::tr1::shared_ptr<Writer> > writers;
+    for(size_t i=0; i<4u; i++)
+        writers.push_back(std::tr1::shared_ptr<Writer>(new Writer(T, 1u + i*1000u)));
+    for(size_t i=0; i<writers.size(); i++)
+        writers[i]->thread.start();
+
+    // read while writing
+    std::vector<mb::Point> points;
+    T.collect(points);
+    testDiag("Read %u while writing", unsigned(points.size()));
+
+    for(size_t i=0; i<writers.size(); i++)
+        writers[i]->thread.exitWait();
+
+    T.collect(points);
+    testOk(points.size()==8000u, "size %u", unsigned(points.size()));
+
+    bool ok = true;
+    for(size_t i=0; ok && i+1u<points.size(); i+=2u)
+        ok &= points[i].id==points[i+1u].id && points[i].stage==0u && points[i+1u].stage==1u;
+    testOk(ok, "pairs");
+}
+
+// more threads than maxRings, one after another
+void testRecycle()
+{
+    testDiag("testRecycle()");
+
+    const size_t nthreads = 2u*mb::Tracer::maxRings;
+    mb::Tracer T("recycle", 4096);
+
+    for(size_t i=0; i<nthreads; i++) {
+        Writer W(T, 1u + i*10u, 10u);
+        W.thread.start();
+        W.thread.exitWait();
+        // allow the thread exit hook to run
+        epicsThreadSleep(0.01);
+    }
+
+    std::vector<mb::Point> points;
+    T.collect(points);
+#if defined(EPICS_VERSION_INT) && EPICS_VERSION_INT>=VERSION_INT(3,15,0,2)
+    // rings re-used, and keep the points of earlier threads
+    testOk(points.size()==nthreads*20u, "size %u", unsigned(points.size()));
+#else
+    // only the first maxRings threads are traced
+    testOk(points.size()==mb::Tracer::maxRings*20u, "size %u", unsigned(points.size()));
+#endif
+}
+
+} // namespace
+
+MAIN(testMB)
+{
+    testPlan(20);
+    testMacros();
+    testNoID();
+    testWrap();
+    testSelect();
+    testCSV();
+    testThreads();
+    testRecycle();
+    return testDone();
+}
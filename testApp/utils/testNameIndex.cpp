@@ -0,0 +1,103 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <string>
+#include <sstream>
+
+#include <pv/nameIndex.h>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+typedef epics::pvAccess::detail::NameIndex<int> index_t;
+
+namespace {
+
+std::string nameOf(int i)
+{
+    std::ostringstream strm;
+    strm<<"pv:"<<i;
+    return strm.str();
+}
+
+void testBasic()
+{
+    testDiag("testBasic()");
+
+    index_t idx;
+    testOk1(idx.empty());
+    testOk1(!idx.find("a"));
+    testOk1(!idx.erase("a"));
+
+    testOk1(idx.insert("a", 1));
+    testOk1(idx.insert("b", 2));
+    testOk1(!idx.insert("a", 3));
+    testOk1(idx.size()==2u);
+
+    int *val = idx.find("a");
+    testOk1(val && *val==1);
+    val = idx.find("b");
+    testOk1(val && *val==2);
+    testOk1(!idx.find("c"));
+    testOk1(!idx.find(""));
+
+    testOk1(idx.erase("a"));
+    testOk1(!idx.find("a"));
+    testOk1(idx.size()==1u);
+
+    // re-use of erased slot
+    testOk1(idx.insert("a", 4));
+    val = idx.find("a");
+    testOk1(val && *val==4);
+
+    idx.clear();
+    testOk1(idx.empty() && !idx.find("b"));
+}
+
+void testMany()
+{
+    const int N = 100000;
+    testDiag("testMany() with %d names", N);
+
+    index_t idx;
+    for(int i=0; i<N; i++)
+        idx.insert(nameOf(i), i);
+    testOk1(idx.size()==size_t(N));
+
+    int bad = 0;
+    for(int i=0; i<N; i++) {
+        int *val = idx.find(nameOf(i));
+        if(!val || *val!=i)
+            bad++;
+    }
+    testOk(bad==0, "%d of %d not found", bad, N);
+
+    // erase half, which leaves tombstones, then insert others
+    for(int i=0; i<N; i+=2)
+        idx.erase(nameOf(i));
+    for(int i=N; i<2*N; i+=2)
+        idx.insert(nameOf(i), i);
+    testOk1(idx.size()==size_t(N));
+
+    bad = 0;
+    for(int i=0; i<2*N; i++) {
+        int *val = idx.find(nameOf(i));
+        bool expect = (i<N) ? (i%2)==1 : (i%2)==0;
+        if(expect ? (!val || *val!=i) : !!val)
+            bad++;
+    }
+    testOk(bad==0, "%d of %d wrong", bad, 2*N);
+}
+
+} // namespace
+
+MAIN(testNameIndex)
+{
+    testPlan(21);
+    testBasic();
+    testMany();
+    return testDone();
+}
@@ -0,0 +1,183 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <vector>
+#include <algorithm>
+
+#include <pv/slotTable.h>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+typedef epics::pvAccess::detail::SlotTable<int> table_t;
+typedef epics::pvAccess::detail::ShardedSlotTable<int> sharded_t;
+
+namespace {
+
+void testBasic()
+{
+    testDiag("testBasic()");
+
+    table_t table;
+    testOk1(table.empty());
+    testOk1(!table.find(0u));
+    testOk1(!table.find(1u));
+    testOk1(!table.erase(1u));
+
+    epicsUInt32 a = table.insert(1), b = table.insert(2);
+    testOk(a!=0u && b!=0u && a!=b, "IDs %x %x", (unsigned)a, (unsigned)b);
+    testOk1(table.size()==2u);
+
+    int *val = table.find(a);
+    testOk1(val && *val==1);
+    val = table.find(b);
+    testOk1(val && *val==2);
+
+    testOk1(table.erase(a));
+    testOk1(!table.find(a));
+    testOk1(!table.erase(a));
+    testOk1(table.size()==1u);
+
+    // slot re-used with a different ID
+    epicsUInt32 c = table.insert(3);
+    testOk(c!=a && c!=0u, "re-use %x -> %x", (unsigned)a, (unsigned)c);
+    testOk1(!table.find(a));
+    val = table.find(c);
+    testOk1(val && *val==3);
+
+    std::vector<int> values;
+    table.values(values);
+    std::sort(values.begin(), values.end());
+    testOk1(values.size()==2u && values[0]==2 && values[1]==3);
+
+    table.clear();
+    testOk1(table.empty() && !table.find(b));
+}
+
+void testGenerations()
+{
+    testDiag("testGenerations()");
+
+    // one entry at a time, so 'minFree' slots are re-used in turn until generations wrap
+    table_t table;
+    std::vector<epicsUInt32> seen;
+    bool ok = true;
+    for(unsigned i=0; i<table_t::minFree*((1u<<table_t::genBits)-1u); i++) {
+        epicsUInt32 id = table.insert(int(i));
+        ok &= id!=0u && epicsInt32(id)>0;
+        ok &= table.erase(id);
+        seen.push_back(id);
+    }
+    std::sort(seen.begin(), seen.end());
+    ok &= std::unique(seen.begin(), seen.end())==seen.end();
+    testOk(ok, "%zu unique IDs from %u slots", seen.size(), unsigned(table_t::minFree));
+
+    epicsUInt32 id = table.insert(0);
+    testOk(std::binary_search(seen.begin(), seen.end(), id), "wraps to %x", (unsigned)id);
+}
+
+void testFifo()
+{
+    testDiag("testFifo()");
+
+    table_t table;
+    const epicsUInt32 mask = epicsUInt32(table.capacity()-1u);
+    std::vector<epicsUInt32> ids;
+    for(unsigned i=0; i<table_t::minFree+2u; i++)
+        ids.push_back(table.insert(int(i)));
+    for(size_t i=0; i<ids.size(); i++)
+        table.erase(ids[i]);
+
+    // oldest free slot first
+    epicsUInt32 a = table.insert(0), b = table.insert(1);
+    testOk((a&mask)==(ids[0]&mask) && a!=ids[0], "re-use %x -> %x", (unsigned)ids[0], (unsigned)a);
+    testOk((b&mask)==(ids[1]&mask) && b!=ids[1], "re-use %x -> %x", (unsigned)ids[1], (unsigned)b);
+}
+
+void testFull()
+{
+    testDiag("testFull()");
+
+    // small table, so fewer than 'minFree' may be free
+    table_t table(0u, 8u);
+    std::vector<epicsUInt32> ids;
+    bool ok = true;
+    for(size_t i=0; i<table.capacity(); i++) {
+        ids.push_back(table.insert(int(i)));
+        ok &= ids.back()!=0u;
+    }
+    testOk(ok && table.size()==table.capacity(), "filled %zu", table.capacity());
+    testOk1(table.insert(-1)==0u);
+
+    testOk1(table.erase(ids[5]));
+    epicsUInt32 id = table.insert(-1);
+    int *val = table.find(id);
+    testOk(id!=0u && id!=ids[5] && val && *val==-1, "re-use when full %x", (unsigned)id);
+}
+
+void testShard()
+{
+    testDiag("testShard()");
+
+    table_t t1(1u, 2u), t2(2u, 2u);
+    epicsUInt32 a = t1.insert(1), b = t2.insert(2);
+    testOk1((a&3u)==1u && (b&3u)==2u);
+    testOk1(!t1.find(b) && !t2.find(a));
+    testOk1(t1.find(a) && t2.find(b));
+}
+
+void testSharded()
+{
+    const int N = 100000;
+    testDiag("testSharded() with %d IDs", N);
+
+    sharded_t table;
+    std::vector<epicsUInt32> ids(N);
+    for(int i=0; i<N; i++)
+        ids[i] = table.insert(i+1);
+    testOk1(table.size()==size_t(N));
+
+    int bad = 0;
+    for(int i=0; i<N; i++) {
+        if(table.find(ids[i])!=i+1)
+            bad++;
+    }
+    testOk(bad==0, "%d of %d not found", bad, N);
+
+    for(int i=0; i<N; i+=2)
+        table.erase(ids[i]);
+    testOk1(table.size()==size_t(N/2));
+
+    bad = 0;
+    for(int i=0; i<N; i++) {
+        int expect = (i%2) ? i+1 : 0;
+        if(table.find(ids[i])!=expect)
+            bad++;
+    }
+    testOk(bad==0, "%d of %d wrong after erase", bad, N);
+
+    testOk1(table.assign(ids[1], -1) && table.find(ids[1])==-1);
+    testOk1(!table.assign(ids[0], -1));
+    testOk1(table.erase(ids[1])==-1 && table.erase(ids[1])==0);
+
+    std::vector<int> values;
+    table.values(values);
+    testOk1(values.size()==size_t(N/2-1));
+}
+
+} // namespace
+
+MAIN(testSlotTable)
+{
+    testPlan(36);
+    testBasic();
+    testGenerations();
+    testFifo();
+    testFull();
+    testShard();
+    testSharded();
+    return testDone();
+}
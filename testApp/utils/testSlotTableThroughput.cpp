@@ -0,0 +1,179 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+/* Client response dispatch micro-benchmark.
+ *
+ * Registers many outstanding operations, as weak_ptr by ID, then looks up
+ * randomly chosen IDs, as the client does for each response received.
+ * Compares a std::map with one lock (as used previously) with ShardedSlotTable.
+ * Reports lookups per second, and register/unregister pairs per second,
+ * for each number of outstanding operations.
+ */
+
+#include <iostream>
+#include <vector>
+#include <map>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <epicsGetopt.h>
+#include <epicsTime.h>
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+
+#include <pv/sharedPtr.h>
+#include <pv/slotTable.h>
+
+namespace pva = epics::pvAccess;
+
+namespace {
+
+#define DEFAULT_DURATION 1.0
+
+typedef epicsGuard<epicsMutex> Guard;
+typedef std::tr1::shared_ptr<int> value_t;
+typedef std::tr1::weak_ptr<int> weak_t;
+
+// previous scheme.  probe for a free ID, then insert
+struct MapTable {
+    epicsMutex lock;
+    std::map<epicsInt32, weak_t> map;
+    epicsInt32 last;
+
+    MapTable() :last(0) {}
+
+    epicsInt32 insert(const weak_t& v)
+    {
+        Guard G(lock);
+        do {
+            while(map.find(++last)!=map.end()) {}
+        } while(last==0);
+        map[last] = v;
+        return last;
+    }
+    value_t find(epicsInt32 id)
+    {
+        Guard G(lock);
+        std::map<epicsInt32, weak_t>::iterator it(map.find(id));
+        return it==map.end() ? value_t() : it->second.lock();
+    }
+    void erase(epicsInt32 id)
+    {
+        Guard G(lock);
+        map.erase(id);
+    }
+};
+
+struct SlotTable {
+    pva::detail::ShardedSlotTable<weak_t> table;
+
+    epicsInt32 insert(const weak_t& v) { return table.insert(v); }
+    value_t find(epicsInt32 id) { return table.find(id).lock(); }
+    void erase(epicsInt32 id) { table.erase(id); }
+};
+
+template<typename Table>
+void run(const char *name, size_t outstanding, double duration)
+{
+    Table table;
+    value_t value(new int(42));
+
+    std::vector<epicsInt32> ids(outstanding);
+    for(size_t i=0; i<outstanding; i++)
+        ids[i] = table.insert(value);
+
+    // random order of responses
+    std::vector<size_t> order(1024u*1024u);
+    for(size_t i=0; i<order.size(); i++)
+        order[i] = size_t(rand())%outstanding;
+
+    epicsTimeStamp start, now;
+    size_t nfind = 0u, nmissing = 0u;
+    epicsTimeGetCurrent(&start);
+    do {
+        for(size_t i=0; i<order.size(); i++) {
+            if(!table.find(ids[order[i]]))
+                nmissing++;
+        }
+        nfind += order.size();
+        epicsTimeGetCurrent(&now);
+    } while(epicsTimeDiffInSeconds(&now, &start) < duration);
+    double findTime = epicsTimeDiffInSeconds(&now, &start);
+
+    // complete, and start, operations
+    size_t nchurn = 0u;
+    epicsTimeGetCurrent(&start);
+    do {
+        for(size_t i=0; i<order.size(); i++) {
+            epicsInt32& id = ids[order[i]];
+            table.erase(id);
+            id = table.insert(value);
+        }
+        nchurn += order.size();
+        epicsTimeGetCurrent(&now);
+    } while(epicsTimeDiffInSeconds(&now, &start) < duration);
+    double churnTime = epicsTimeDiffInSeconds(&now, &start);
+
+    if(nmissing)
+        throw std::runtime_error("Missing entries");
+
+    printf("%s %zu %.0f %.0f\n", name, outstanding, nfind/findTime, nchurn/churnTime);
+}
+
+void usage()
+{
+    fprintf(stderr, "\nUsage: testSlotTableThroughput [options]\n\n"
+            "  -h: Help: Print this message\n"
+            "options:\n"
+            "  -n <count>:        outstanding operations, may be repeated.  default is 16, 1024, 65536, and 1048576\n"
+            "  -d <sec>:          duration of each, default is %.1f\n\n",
+            DEFAULT_DURATION);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::vector<size_t> counts;
+    double duration = DEFAULT_DURATION;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "hn:d:")) != -1) {
+        switch(opt) {
+        case 'n': counts.push_back(atoi(optarg)); break;
+        case 'd': duration = atof(optarg); break;
+        case 'h': usage(); return 0;
+        default: usage(); return 1;
+        }
+    }
+
+    if(counts.empty()) {
+        counts.push_back(16u);
+        counts.push_back(1024u);
+        counts.push_back(65536u);
+        counts.push_back(1048576u);
+    }
+
+    for(size_t i=0; i<counts.size(); i++) {
+        if(counts[i]<1u) {
+            fprintf(stderr, "Invalid options\n");
+            return 1;
+        }
+    }
+
+    try {
+        printf("# table outstanding lookups/s churn/s\n");
+        for(size_t i=0; i<counts.size(); i++) {
+            run<MapTable>("map", counts[i], duration);
+            run<SlotTable>("slot", counts[i], duration);
+        }
+
+    }catch(std::exception& e){
+        std::cerr<<"Error: "<<e.what()<<"\n";
+        return 1;
+    }
+    return 0;
+}
@@ -8,11 +8,15 @@
 #include <epicsExit.h>
 
 int testCaProvider(void);
+int testCaQueueMerge(void);
+int testCaCallbacks(void);
 
 void pvCaAllTests(void)
 {
     testHarness();
     runTest(testCaProvider);
+    runTest(testCaQueueMerge);
+    runTest(testCaCallbacks);
 
     epicsExit(0);   /* Trigger test harness */
 }
@@ -0,0 +1,229 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+/* CA provider callback pool throughput benchmark.
+ *
+ * Feeds synthetic DBR_TIME_DOUBLE subscription events, without an IOC,
+ * to the monitor queues of many channels, as the CA client library would.
+ * Each requester is notified through a CACallbackPool, and poll()s all updates,
+ * spending some time on each as a server would to serialize and send it.
+ * Reports events per second, and updates delivered to requesters per second,
+ * for each number of workers.
+ */
+
+#include <iostream>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <epicsGetopt.h>
+#include <epicsTime.h>
+
+#include <pv/pvData.h>
+#include <pv/standardField.h>
+
+#include "caMonitorQueue.h"
+#include "caCallbackPool.h"
+
+namespace pvd = epics::pvData;
+namespace ca = epics::pvAccess::ca;
+
+namespace {
+
+#define DEFAULT_DURATION 1.0
+#define DEFAULT_CHANNELS 100
+#define DEFAULT_WORK 10.0
+
+// stand-in for DbdToPv with a double PV
+struct Conv {
+    pvd::PVDoublePtr value;
+    pvd::PVLongPtr secs;
+    pvd::PVIntPtr nsec;
+
+    explicit Conv(const pvd::PVStructurePtr& root)
+        :value(root->getSubFieldT<pvd::PVDouble>("value"))
+        ,secs(root->getSubFieldT<pvd::PVLong>("timeStamp.secondsPastEpoch"))
+        ,nsec(root->getSubFieldT<pvd::PVInt>("timeStamp.nanoseconds"))
+    {}
+
+    pvd::Status getFromDBD(const pvd::PVStructurePtr& root,
+                           const pvd::BitSet::shared_pointer& changed,
+                           struct event_handler_args& args)
+    {
+        (void)root;
+        const dbr_time_double *dbr = static_cast<const dbr_time_double*>(args.dbr);
+        value->put(dbr->value);
+        secs->put(dbr->stamp.secPastEpoch + POSIX_TIME_AT_EPICS_EPOCH);
+        nsec->put(dbr->stamp.nsec);
+        changed->set(value->getFieldOffset());
+        changed->set(secs->getFieldOffset());
+        changed->set(nsec->getFieldOffset());
+        return pvd::Status::Ok;
+    }
+};
+
+// stand-in for CAChannelMonitor and its MonitorRequester
+struct Subscription : public ca::CACallbackClient {
+    const double work;
+    const pvd::PVStructurePtr root;
+    Conv conv;
+    ca::CACMonitorQueue queue;
+    ca::CACallback::shared_pointer callback;
+    // only accessed by the worker
+    size_t delivered;
+    double last;
+
+    Subscription(double work)
+        :work(work)
+        ,root(pvd::getPVDataCreate()->createPVStructure(
+                  pvd::getStandardField()->scalar(pvd::pvDouble, "alarm,timeStamp")))
+        ,conv(root)
+        ,queue(4u, root)
+        ,delivered(0u)
+        ,last(0.0)
+    {
+        queue.start();
+    }
+    virtual ~Subscription() {}
+
+    virtual void notifyClient()
+    {
+        pvd::MonitorElementPtr element;
+        while((element = queue.poll())) {
+            double value = element->pvStructurePtr->getSubFieldT<pvd::PVDouble>("value")->get();
+            if(value < last)
+                throw std::logic_error("Out of order");
+            last = value;
+
+            // busy, as a server would be serializing and sending the update
+            epicsTimeStamp start, now;
+            epicsTimeGetCurrent(&start);
+            do {
+                epicsTimeGetCurrent(&now);
+            } while(epicsTimeDiffInSeconds(&now, &start)*1e6 < work);
+
+            delivered++;
+            // any pending event is poll()'d by this loop
+            (void)queue.release(element);
+        }
+    }
+};
+
+void run(size_t nworkers, size_t nchannels, double work, double duration)
+{
+    ca::CACallbackPool pool(nworkers);
+    pool.start();
+
+    std::vector<std::tr1::shared_ptr<Subscription> > subs(nchannels);
+    for(size_t i=0; i<nchannels; i++) {
+        subs[i].reset(new Subscription(work));
+        subs[i]->callback.reset(new ca::CACallback(subs[i], subs[i].get()));
+    }
+
+    dbr_time_double dbr;
+    dbr.status = dbr.severity = 0;
+    dbr.value = 0.0;
+    epicsTimeGetCurrent(&dbr.stamp);
+
+    struct event_handler_args args;
+    args.usr = 0;
+    args.chid = 0;
+    args.type = DBR_TIME_DOUBLE;
+    args.count = 1;
+    args.dbr = &dbr;
+    args.status = ECA_NORMAL;
+
+    size_t nevents = 0u;
+    epicsTimeStamp start, now;
+    epicsTimeGetCurrent(&start);
+    do {
+        for(size_t n=0; n<100u; n++) {
+            dbr.value += 1.0;
+            dbr.stamp.nsec = (dbr.stamp.nsec+1000u)%1000000000u;
+
+            for(size_t i=0; i<nchannels; i++) {
+                pvd::Status status;
+                if(subs[i]->queue.event(subs[i]->conv, args, status))
+                    pool.notify(subs[i]->callback);
+                nevents++;
+            }
+        }
+        epicsTimeGetCurrent(&now);
+    } while(epicsTimeDiffInSeconds(&now, &start) < duration);
+
+    // wait for queued callbacks
+    pool.stop();
+    epicsTimeGetCurrent(&now);
+    double elapsed = epicsTimeDiffInSeconds(&now, &start);
+
+    size_t ndelivered = 0u;
+    for(size_t i=0; i<nchannels; i++)
+        ndelivered += subs[i]->delivered;
+
+    printf("%zu %zu %.1f %.0f %.0f\n", nworkers, nchannels, work, nevents/elapsed, ndelivered/elapsed);
+}
+
+void usage()
+{
+    fprintf(stderr, "\nUsage: testCaCallbackPool [options]\n\n"
+            "  -h: Help: Print this message\n"
+            "options:\n"
+            "  -w <count>:        number of workers, may be repeated.  default is 1, 2, and 4\n"
+            "  -c <count>:        number of channels, default is %d\n"
+            "  -u <usec>:         time spent by the requester on each update, default is %.1f\n"
+            "  -d <sec>:          duration of each, default is %.1f\n\n",
+            DEFAULT_CHANNELS, DEFAULT_WORK, DEFAULT_DURATION);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::vector<size_t> workers;
+    int nchannels = DEFAULT_CHANNELS;
+    double work = DEFAULT_WORK;
+    double duration = DEFAULT_DURATION;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "hw:c:u:d:")) != -1) {
+        switch(opt) {
+        case 'w': workers.push_back(atoi(optarg)); break;
+        case 'c': nchannels = atoi(optarg); break;
+        case 'u': work = atof(optarg); break;
+        case 'd': duration = atof(optarg); break;
+        case 'h': usage(); return 0;
+        default: usage(); return 1;
+        }
+    }
+
+    if(workers.empty()) {
+        workers.push_back(1u);
+        workers.push_back(2u);
+        workers.push_back(4u);
+    }
+
+    if(nchannels<1 || work<0.0) {
+        fprintf(stderr, "Invalid options\n");
+        return 1;
+    }
+    for(size_t i=0; i<workers.size(); i++) {
+        if(workers[i]<1u) {
+            fprintf(stderr, "Invalid options\n");
+            return 1;
+        }
+    }
+
+    try {
+        printf("# workers channels usec/update events/s delivered/s\n");
+        for(size_t i=0; i<workers.size(); i++)
+            run(workers[i], nchannels, work, duration);
+
+    }catch(std::exception& e){
+        std::cerr<<"Error: "<<e.what()<<"\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,229 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+/* CACallbackPool.  Callbacks of one channel run in order, on one worker.
+ * Other channels use other workers.  A callback is queued at most once.
+ * stop() completes queued callbacks, and ignores later ones.
+ */
+
+#include <vector>
+#include <set>
+
+#include <compilerDependencies.h>
+#include <epicsThread.h>
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+#include <epicsEvent.h>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include "caCallbackPool.h"
+
+namespace ca = epics::pvAccess::ca;
+
+typedef epicsGuard<epicsMutex> Guard;
+
+namespace {
+
+// order and thread of all calls
+struct Log {
+    epicsMutex mutex;
+    std::vector<int> order;
+    std::vector<epicsThreadId> threads;
+
+    void add(int id)
+    {
+        Guard G(mutex);
+        order.push_back(id);
+        threads.push_back(epicsThreadGetIdSelf());
+    }
+    size_t size()
+    {
+        Guard G(mutex);
+        return order.size();
+    }
+    size_t count(int id)
+    {
+        Guard G(mutex);
+        size_t ret = 0u;
+        for(size_t i=0; i<order.size(); i++)
+            ret += order[i]==id;
+        return ret;
+    }
+};
+
+struct Client : public ca::CACallbackClient {
+    POINTER_DEFINITIONS(Client);
+    Log& log;
+    const int id;
+    epicsEvent called;
+
+    Client(Log& log, int id) :log(log), id(id) {}
+    virtual ~Client() {}
+    virtual void notifyClient() OVERRIDE FINAL
+    {
+        log.add(id);
+        called.signal();
+    }
+};
+
+// occupies its worker until release is signaled, or for 'hold' seconds
+struct Blocker : public ca::CACallbackClient {
+    POINTER_DEFINITIONS(Blocker);
+    const double hold;
+    epicsEvent started, release;
+
+    explicit Blocker(double hold=0.0) :hold(hold) {}
+    virtual ~Blocker() {}
+    virtual void notifyClient() OVERRIDE FINAL
+    {
+        started.signal();
+        if(hold>0.0)
+            epicsThreadSleep(hold);
+        else
+            release.wait();
+    }
+};
+
+void testOrder()
+{
+    testDiag("testOrder()");
+
+    ca::CACallbackPool pool(4u);
+    pool.start();
+
+    Log log;
+    int channel;
+    std::vector<Client::shared_pointer> clients;
+    std::vector<ca::CACallback::shared_pointer> callbacks;
+    for(int i=0; i<100; i++) {
+        clients.push_back(Client::shared_pointer(new Client(log, i)));
+        callbacks.push_back(ca::CACallback::shared_pointer(new ca::CACallback(clients.back(), &channel)));
+    }
+    for(size_t i=0; i<callbacks.size(); i++)
+        pool.notify(callbacks[i]);
+    pool.stop();
+
+    bool ok = log.order.size()==100u;
+    for(size_t i=0; ok && i<log.order.size(); i++)
+        ok &= log.order[i]==int(i) && log.threads[i]==log.threads[0];
+    testOk(ok, "%zu callbacks of one channel in order, on one worker", log.order.size());
+}
+
+void testSpread()
+{
+    testDiag("testSpread()");
+
+    ca::CACallbackPool pool(4u);
+    testOk1(pool.size()==4u);
+    pool.start();
+
+    Log log;
+    int channels[64];
+    Blocker::shared_pointer blocker(new Blocker);
+    ca::CACallback::shared_pointer blocked(new ca::CACallback(blocker, &channels[0]));
+    pool.notify(blocked);
+    blocker->started.wait();
+
+    std::vector<Client::shared_pointer> clients;
+    std::vector<ca::CACallback::shared_pointer> callbacks;
+    for(int i=1; i<64; i++) {
+        clients.push_back(Client::shared_pointer(new Client(log, i)));
+        callbacks.push_back(ca::CACallback::shared_pointer(new ca::CACallback(clients.back(), &channels[i])));
+        pool.notify(callbacks.back());
+    }
+
+    // channels of the other workers are not held up
+    bool ran = false;
+    for(unsigned i=0; !ran && i<500u; i++) {
+        ran = log.size()>0u;
+        if(!ran)
+            epicsThreadSleep(0.01);
+    }
+    testOk(ran, "%zu of 63 channels run while one worker is blocked", log.size());
+
+    blocker->release.signal();
+    pool.stop();
+
+    std::set<epicsThreadId> workers(log.threads.begin(), log.threads.end());
+    testOk(log.order.size()==63u && workers.size()>1u, "63 channels run on %zu workers", workers.size());
+}
+
+void testMerge()
+{
+    testDiag("testMerge()");
+
+    ca::CACallbackPool pool(2u);
+    pool.start();
+
+    Log log;
+    int channel;
+    Blocker::shared_pointer blocker(new Blocker);
+    ca::CACallback::shared_pointer blocked(new ca::CACallback(blocker, &channel));
+    Client::shared_pointer client(new Client(log, 1));
+    ca::CACallback::shared_pointer callback(new ca::CACallback(client, &channel));
+
+    pool.notify(blocked);
+    blocker->started.wait();
+
+    // queued behind the blocker
+    for(unsigned i=0; i<10u; i++)
+        pool.notify(callback);
+    blocker->release.signal();
+
+    testOk1(client->called.wait(5.0));
+    testOk(log.count(1)==1u, "10 notifications while queued merged into %zu calls", log.count(1));
+
+    // queued again once called
+    pool.notify(callback);
+    testOk1(client->called.wait(5.0));
+
+    pool.stop();
+    testOk(log.count(1)==2u, "%zu calls", log.count(1));
+}
+
+void testStop()
+{
+    testDiag("testStop()");
+
+    ca::CACallbackPool pool(1u);
+    pool.start();
+
+    Log log;
+    int channel;
+    // still running when stop() is called
+    Blocker::shared_pointer blocker(new Blocker(0.2));
+    ca::CACallback::shared_pointer blocked(new ca::CACallback(blocker, &channel));
+    pool.notify(blocked);
+    blocker->started.wait();
+
+    std::vector<Client::shared_pointer> clients;
+    std::vector<ca::CACallback::shared_pointer> callbacks;
+    for(int i=0; i<5; i++) {
+        clients.push_back(Client::shared_pointer(new Client(log, i)));
+        callbacks.push_back(ca::CACallback::shared_pointer(new ca::CACallback(clients.back(), &channel)));
+        pool.notify(callbacks.back());
+    }
+
+    pool.stop();
+    testOk(log.size()==5u, "stop() completes %zu queued callbacks", log.size());
+
+    pool.notify(callbacks[0]);
+    epicsThreadSleep(0.1);
+    testOk(log.size()==5u, "notify() after stop() ignored");
+}
+
+} // namespace
+
+MAIN(testCaCallbacks)
+{
+    testPlan(10);
+    testOrder();
+    testSpread();
+    testMerge();
+    testStop();
+    return testDone();
+}
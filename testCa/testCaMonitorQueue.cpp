@@ -0,0 +1,230 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+/* CA provider monitor queue micro-benchmark.
+ *
+ * Feeds synthetic DBR_TIME_DOUBLE subscription events, without an IOC,
+ * to a subscription queue, and poll()s and release()s after every few events
+ * as a slower client would.  Compares allocating a new structure for each event
+ * (as done previously) with CACMonitorQueue.
+ * Reports events per second, and updates delivered to the client per second,
+ * for each queue size.
+ */
+
+#include <iostream>
+#include <queue>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <epicsGetopt.h>
+#include <epicsTime.h>
+
+#include <pv/pvData.h>
+#include <pv/standardField.h>
+
+#include "caMonitorQueue.h"
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+#define DEFAULT_DURATION 1.0
+#define DEFAULT_BURST 4
+
+// stand-in for DbdToPv with a double PV
+struct Conv {
+    pvd::PVDoublePtr value;
+    pvd::PVIntPtr severity, status;
+    pvd::PVLongPtr secs;
+    pvd::PVIntPtr nsec;
+
+    explicit Conv(const pvd::PVStructurePtr& root)
+        :value(root->getSubFieldT<pvd::PVDouble>("value"))
+        ,severity(root->getSubFieldT<pvd::PVInt>("alarm.severity"))
+        ,status(root->getSubFieldT<pvd::PVInt>("alarm.status"))
+        ,secs(root->getSubFieldT<pvd::PVLong>("timeStamp.secondsPastEpoch"))
+        ,nsec(root->getSubFieldT<pvd::PVInt>("timeStamp.nanoseconds"))
+    {}
+
+    pvd::Status getFromDBD(const pvd::PVStructurePtr& root,
+                           const pvd::BitSet::shared_pointer& changed,
+                           struct event_handler_args& args)
+    {
+        (void)root;
+        const dbr_time_double *dbr = static_cast<const dbr_time_double*>(args.dbr);
+        value->put(dbr->value);
+        changed->set(value->getFieldOffset());
+        if(severity->get()!=dbr->severity) {
+            severity->put(dbr->severity);
+            status->put(dbr->status);
+            changed->set(severity->getFieldOffset());
+            changed->set(status->getFieldOffset());
+        }
+        secs->put(dbr->stamp.secPastEpoch + POSIX_TIME_AT_EPICS_EPOCH);
+        nsec->put(dbr->stamp.nsec);
+        changed->set(secs->getFieldOffset());
+        changed->set(nsec->getFieldOffset());
+        return pvd::Status::Ok;
+    }
+};
+
+// previous scheme.  new structure for each event, dropped when full
+struct AllocQueue {
+    const size_t queueSize;
+    const pvd::PVStructurePtr pvStructure;
+    pvd::MonitorElementPtr activeElement;
+    std::queue<pvd::MonitorElementPtr> queue;
+
+    AllocQueue(size_t queueSize, const pvd::PVStructurePtr& pvStructure)
+        :queueSize(queueSize)
+        ,pvStructure(pvStructure)
+        ,activeElement(new pvd::MonitorElement(pvStructure))
+    {}
+
+    void start() {}
+
+    bool event(Conv& conv, struct event_handler_args& args, pvd::Status& status)
+    {
+        status = conv.getFromDBD(pvStructure, activeElement->changedBitSet, args);
+        if(queue.size()==queueSize) {
+            *activeElement->overrunBitSet |= *activeElement->changedBitSet;
+            return false;
+        }
+        pvd::MonitorElementPtr element(new pvd::MonitorElement(
+            pvd::getPVDataCreate()->createPVStructure(pvStructure)));
+        *element->changedBitSet = *activeElement->changedBitSet;
+        *element->overrunBitSet = *activeElement->overrunBitSet;
+        queue.push(element);
+        activeElement->changedBitSet->clear();
+        activeElement->overrunBitSet->clear();
+        return true;
+    }
+    pvd::MonitorElementPtr poll()
+    {
+        pvd::MonitorElementPtr ret;
+        if(!queue.empty())
+            ret = queue.front();
+        return ret;
+    }
+    bool release(const pvd::MonitorElementPtr&)
+    {
+        queue.pop();
+        return false;
+    }
+};
+
+template<typename Queue>
+void run(const char *name, size_t queueSize, size_t burst, double duration)
+{
+    pvd::PVStructurePtr root(pvd::getPVDataCreate()->createPVStructure(
+                                 pvd::getStandardField()->scalar(pvd::pvDouble, "alarm,timeStamp")));
+    Conv conv(root);
+    Queue queue(queueSize, root);
+    queue.start();
+
+    dbr_time_double dbr;
+    dbr.status = dbr.severity = 0;
+    dbr.value = 0.0;
+    epicsTimeGetCurrent(&dbr.stamp);
+
+    struct event_handler_args args;
+    args.usr = 0;
+    args.chid = 0;
+    args.type = DBR_TIME_DOUBLE;
+    args.count = 1;
+    args.dbr = &dbr;
+    args.status = ECA_NORMAL;
+
+    size_t nevents = 0u, ndelivered = 0u;
+    epicsTimeStamp start, now;
+    epicsTimeGetCurrent(&start);
+    do {
+        for(size_t n=0; n<100000u; n++) {
+            dbr.value += 1.0;
+            dbr.stamp.nsec = (dbr.stamp.nsec+1000u)%1000000000u;
+            dbr.severity = (n&0xff)==0u;
+
+            pvd::Status status;
+            queue.event(conv, args, status);
+            nevents++;
+
+            if(nevents%burst==0u) {
+                pvd::MonitorElementPtr element;
+                while((element = queue.poll())) {
+                    ndelivered++;
+                    queue.release(element);
+                }
+            }
+        }
+        epicsTimeGetCurrent(&now);
+    } while(epicsTimeDiffInSeconds(&now, &start) < duration);
+
+    double elapsed = epicsTimeDiffInSeconds(&now, &start);
+    printf("%s %zu %zu %.0f %.0f\n", name, queueSize, burst, nevents/elapsed, ndelivered/elapsed);
+}
+
+void usage()
+{
+    fprintf(stderr, "\nUsage: testCaMonitorQueue [options]\n\n"
+            "  -h: Help: Print this message\n"
+            "options:\n"
+            "  -q <count>:        queue size, may be repeated.  default is 2, 4, and 64\n"
+            "  -b <count>:        events between client polls, default is %d\n"
+            "  -d <sec>:          duration of each, default is %.1f\n\n",
+            DEFAULT_BURST, DEFAULT_DURATION);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::vector<size_t> sizes;
+    int burst = DEFAULT_BURST;
+    double duration = DEFAULT_DURATION;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "hq:b:d:")) != -1) {
+        switch(opt) {
+        case 'q': sizes.push_back(atoi(optarg)); break;
+        case 'b': burst = atoi(optarg); break;
+        case 'd': duration = atof(optarg); break;
+        case 'h': usage(); return 0;
+        default: usage(); return 1;
+        }
+    }
+
+    if(sizes.empty()) {
+        sizes.push_back(2u);
+        sizes.push_back(4u);
+        sizes.push_back(64u);
+    }
+
+    if(burst<1) {
+        fprintf(stderr, "Invalid options\n");
+        return 1;
+    }
+    for(size_t i=0; i<sizes.size(); i++) {
+        if(sizes[i]<1u) {
+            fprintf(stderr, "Invalid options\n");
+            return 1;
+        }
+    }
+
+    try {
+        printf("# queue size burst events/s delivered/s\n");
+        for(size_t i=0; i<sizes.size(); i++) {
+            run<AllocQueue>("alloc", sizes[i], burst, duration);
+            run<pva::ca::CACMonitorQueue>("pool", sizes[i], burst, duration);
+        }
+
+    }catch(std::exception& e){
+        std::cerr<<"Error: "<<e.what()<<"\n";
+        return 1;
+    }
+    return 0;
+}
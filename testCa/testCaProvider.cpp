@@ -45,6 +45,13 @@
 #include <pv/pvIntrospect.h>
 #include <pv/pvData.h>
 
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cadef.h>
+
+#include "dbrConvert.h"
+
 // DEBUG must be 0 to run under the automated test harness
 #define DEBUG 0
 
@@ -763,9 +770,103 @@ void checkClient(const string &channelName, const string &putValue)
     client->stopEvents();
 }
 
+// DbdToPv array conversion, with reuseDbrArray() and convertDbrArray(),
+// gives the same values as PVValueArray::reuse() and std::copy() did.
+template<typename dbrT, typename pvT>
+void checkDbrConvert(const char *dbrName, const char *pvName, bool negative)
+{
+    std::vector<dbrT> dbr(1000u);
+    for(size_t i=0; i<dbr.size(); i++)
+        dbr[i] = dbrT(int(i%256u) - (negative ? 128 : 0));
+
+    typename pvT::shared_pointer oldValue(getPVDataCreate()->createPVScalarArray<pvT>()),
+                                 newValue(getPVDataCreate()->createPVScalarArray<pvT>());
+
+    // grow, shrink, and re-use, with the current array held elsewhere or not
+    const size_t counts[] = {1000u, 10u, 1000u, 0u, 500u};
+    bool ok = true;
+    for(unsigned shared=0; shared<2u; shared++) {
+        for(size_t c=0; c<sizeof(counts)/sizeof(counts[0]); c++) {
+            const size_t count = counts[c];
+            typename pvT::const_svector held;
+            std::vector<typename pvT::value_type> before;
+            if(shared) {
+                held = newValue->view();
+                before.assign(held.begin(), held.end());
+            }
+
+            {
+                typename pvT::svector temp(oldValue->reuse());
+                temp.resize(count);
+                std::copy(&dbr[0], &dbr[0] + count, temp.begin());
+                oldValue->replace(freeze(temp));
+            }
+            {
+                typename pvT::svector temp(reuseDbrArray(*newValue, count));
+                convertDbrArray(&dbr[0], count, temp.data());
+                newValue->replace(freeze(temp));
+            }
+
+            typename pvT::const_svector expect(oldValue->view()), actual(newValue->view());
+            ok &= expect.size()==count && actual.size()==count
+                    && std::equal(expect.begin(), expect.end(), actual.begin());
+            // a held array is not overwritten
+            ok &= held.size()==before.size() && std::equal(held.begin(), held.end(), before.begin());
+        }
+    }
+    testOk(ok, "convert DBR_%s to %s array", dbrName, pvName);
+}
+
+// putToDBD() of int64 and uint64 arrays, with convertDbrArray()
+// gives the same values as PVDoubleArray::putFrom() did.
+template<typename pvT>
+void checkDbrConvertPut(const char *pvName, const typename pvT::value_type *values, size_t count)
+{
+    typename pvT::svector sv(count);
+    std::copy(values, values + count, sv.begin());
+    typename pvT::const_svector src(freeze(sv));
+
+    PVDoubleArrayPtr pvDoubleArray(getPVDataCreate()->createPVScalarArray<PVDoubleArray>());
+    pvDoubleArray->putFrom(src);
+    PVDoubleArray::const_svector expect(pvDoubleArray->view());
+
+    std::vector<double> putBuffer(src.size());
+    convertDbrArray(src.data(), src.size(), &putBuffer[0]);
+
+    testOk(expect.size()==putBuffer.size() && std::equal(expect.begin(), expect.end(), putBuffer.begin()),
+           "put %s array as DBR_DOUBLE", pvName);
+}
+
+void testDbrConvert()
+{
+    testDiag("===Test DBR array conversion===");
+
+    checkDbrConvert<dbr_char_t, PVUByteArray>("CHAR", "ubyte", false);
+    checkDbrConvert<dbr_char_t, PVByteArray>("CHAR", "byte", false);
+    checkDbrConvert<dbr_short_t, PVUShortArray>("SHORT", "ushort", true);
+    checkDbrConvert<dbr_short_t, PVShortArray>("SHORT", "short", true);
+    checkDbrConvert<dbr_long_t, PVUIntArray>("LONG", "uint", true);
+    checkDbrConvert<dbr_long_t, PVIntArray>("LONG", "int", true);
+    checkDbrConvert<dbr_float_t, PVFloatArray>("FLOAT", "float", true);
+    checkDbrConvert<dbr_double_t, PVLongArray>("DOUBLE", "long", true);
+    checkDbrConvert<dbr_double_t, PVULongArray>("DOUBLE", "ulong", false);
+    checkDbrConvert<dbr_double_t, PVDoubleArray>("DOUBLE", "double", true);
+
+    // including values which a double can not hold exactly
+    const int64 longs[] = {0, 1, -1, 2147483647, -2147483647-1,
+                           (int64(1)<<53)+1, -(int64(1)<<53)-1,
+                           std::numeric_limits<int64>::max(), std::numeric_limits<int64>::min()};
+    const uint64 ulongs[] = {0u, 1u, 4294967295u, (uint64(1)<<53)+1u,
+                             std::numeric_limits<uint64>::max()};
+    checkDbrConvertPut<PVLongArray>("long", longs, sizeof(longs)/sizeof(longs[0]));
+    checkDbrConvertPut<PVULongArray>("ulong", ulongs, sizeof(ulongs)/sizeof(ulongs[0]));
+}
+
 MAIN(testCaProvider)
 {
-    testPlan(143 + EXIT_TESTS);
+    testPlan(155 + EXIT_TESTS);
+
+    testDbrConvert();
 
     TestIocPtr testIoc(new TestIoc());
     testIoc->start();  
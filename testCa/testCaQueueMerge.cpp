@@ -0,0 +1,191 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+/* CACMonitorQueue when full.  Events merged into the newest element,
+ * or kept while the client holds all elements, and the overrunBitSet.
+ */
+
+#include <pv/pvData.h>
+#include <pv/standardField.h>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include "caMonitorQueue.h"
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+// stand-in for DbdToPv.  Sets value, and alarm severity when it differs.
+struct Conv {
+    pvd::PVDoublePtr value;
+    pvd::PVIntPtr severity;
+    double nextValue;
+    int nextSeverity;
+
+    explicit Conv(const pvd::PVStructurePtr& root)
+        :value(root->getSubFieldT<pvd::PVDouble>("value"))
+        ,severity(root->getSubFieldT<pvd::PVInt>("alarm.severity"))
+        ,nextValue(0.0)
+        ,nextSeverity(0)
+    {}
+
+    pvd::Status getFromDBD(const pvd::PVStructurePtr& root,
+                           const pvd::BitSet::shared_pointer& changed,
+                           struct event_handler_args& args)
+    {
+        (void)root;
+        (void)args;
+        value->put(nextValue);
+        changed->set(value->getFieldOffset());
+        if(severity->get()!=nextSeverity) {
+            severity->put(nextSeverity);
+            changed->set(severity->getFieldOffset());
+        }
+        return pvd::Status::Ok;
+    }
+};
+
+struct Fixture {
+    pvd::PVStructurePtr root;
+    Conv conv;
+    pva::ca::CACMonitorQueue queue;
+    struct event_handler_args args;
+    size_t valueBit, severityBit;
+
+    explicit Fixture(size_t queueSize)
+        :root(pvd::getPVDataCreate()->createPVStructure(pvd::getStandardField()->scalar(pvd::pvDouble, "alarm")))
+        ,conv(root)
+        ,queue(queueSize, root)
+        ,valueBit(conv.value->getFieldOffset())
+        ,severityBit(conv.severity->getFieldOffset())
+    {
+        args.usr = 0;
+        args.chid = 0;
+        args.type = DBR_TIME_DOUBLE;
+        args.count = 1;
+        args.dbr = 0;
+        args.status = ECA_NORMAL;
+        queue.start();
+    }
+
+    // returns true if the client would be notified
+    bool event(double value, int severity = 0)
+    {
+        conv.nextValue = value;
+        conv.nextSeverity = severity;
+        pvd::Status status;
+        bool notify = queue.event(conv, args, status);
+        if(!status.isOK())
+            testFail("event() status %s", status.getMessage().c_str());
+        return notify;
+    }
+};
+
+double valueOf(const pvd::MonitorElementPtr& elem)
+{
+    return elem ? elem->pvStructurePtr->getSubFieldT<pvd::PVDouble>("value")->get() : -1.0;
+}
+
+void testMerge()
+{
+    testDiag("testMerge()");
+
+    Fixture F(2u);
+
+    testOk1(F.event(1.0));  // queue was empty
+    testOk1(!F.event(2.0)); // fills the queue
+    testOk1(!F.event(3.0)); // merged into the newest
+    testOk1(!F.event(4.0, 2)); // merged again, and severity changes
+
+    pvd::MonitorElementPtr first(F.queue.poll()), second(F.queue.poll());
+    testOk1(!F.queue.poll());
+
+    testOk(valueOf(first)==1.0, "first value %g", valueOf(first));
+    testOk1(first && first->changedBitSet->get(F.valueBit) && first->overrunBitSet->isEmpty());
+
+    testOk(valueOf(second)==4.0, "second value %g", valueOf(second));
+    if(second) {
+        testOk1(second->pvStructurePtr->getSubFieldT<pvd::PVInt>("alarm.severity")->get()==2);
+        testOk1(second->changedBitSet->get(F.valueBit) && second->changedBitSet->get(F.severityBit));
+        // value changed three times, severity once
+        testOk1(second->overrunBitSet->get(F.valueBit));
+        testOk1(!second->overrunBitSet->get(F.severityBit));
+    } else {
+        testSkip(4, "No element");
+    }
+
+    testOk1(!F.queue.release(first));
+    testOk1(!F.queue.release(second));
+}
+
+void testMergeOne()
+{
+    testDiag("testMergeOne()");
+
+    Fixture F(1u);
+
+    testOk1(F.event(1.0));
+    // merged into the element already notified
+    testOk1(!F.event(2.0));
+    testOk1(!F.event(3.0));
+
+    pvd::MonitorElementPtr elem(F.queue.poll());
+    testOk(valueOf(elem)==3.0, "value %g", valueOf(elem));
+    testOk1(elem && elem->overrunBitSet->get(F.valueBit));
+    testOk1(!F.queue.poll());
+    testOk1(!F.queue.release(elem));
+}
+
+void testClientHoldsAll()
+{
+    testDiag("testClientHoldsAll()");
+
+    Fixture F(2u);
+
+    testOk1(F.event(1.0));
+    testOk1(!F.event(2.0));
+
+    pvd::MonitorElementPtr first(F.queue.poll()), second(F.queue.poll());
+
+    // no element to queue, or merge into.  Kept until release()
+    testOk1(!F.event(3.0));
+    testOk1(!F.event(4.0, 1));
+    testOk1(!F.queue.poll());
+
+    // queued to an empty queue
+    testOk1(F.queue.release(first));
+
+    pvd::MonitorElementPtr third(F.queue.poll());
+    testOk(valueOf(third)==4.0, "value %g", valueOf(third));
+    if(third) {
+        testOk1(third->changedBitSet->get(F.valueBit) && third->changedBitSet->get(F.severityBit));
+        testOk1(third->overrunBitSet->get(F.valueBit) && !third->overrunBitSet->get(F.severityBit));
+    } else {
+        testSkip(2, "No element");
+    }
+
+    testOk1(!F.queue.release(second));
+    testOk1(!F.queue.release(third));
+
+    // stop() discards
+    testOk1(F.event(5.0));
+    F.queue.stop();
+    testOk1(!F.queue.poll());
+    testOk1(!F.event(6.0));
+}
+
+} // namespace
+
+MAIN(testCaQueueMerge)
+{
+    testPlan(35);
+    testMerge();
+    testMergeOne();
+    testClientHoldsAll();
+    return testDone();
+}
@@ -0,0 +1,153 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+/* CA array to pvData array conversion micro-benchmark.
+ *
+ * Converts a CA array into the value field of a PVScalarArray repeatedly,
+ * as the "ca" provider does for each get or monitor update.
+ * Compares PVValueArray::reuse() with std::copy (as done previously)
+ * with reuseDbrArray() and convertDbrArray().
+ * Each is run with the array held only by the field, and with a reference
+ * kept elsewhere (eg. by a queued monitor update).
+ * Reports elements per second for each DBR type, pvData type, and array length.
+ * That both give the same values is checked by testCaProvider.
+ */
+
+#include <iostream>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <epicsGetopt.h>
+#include <epicsTime.h>
+#include <cadef.h>
+
+#include <pv/pvData.h>
+
+#include "dbrConvert.h"
+
+namespace pvd = epics::pvData;
+namespace ca = epics::pvAccess::ca;
+
+namespace {
+
+#define DEFAULT_DURATION 0.5
+
+template<typename dbrT, typename pvT>
+void copyOld(const dbrT *dbr, size_t count, pvT& value)
+{
+    typename pvT::svector temp(value.reuse());
+    temp.resize(count);
+    std::copy(dbr, dbr + count, temp.begin());
+    value.replace(freeze(temp));
+}
+
+template<typename dbrT, typename pvT>
+void copyNew(const dbrT *dbr, size_t count, pvT& value)
+{
+    typename pvT::svector temp(ca::reuseDbrArray(value, count));
+    ca::convertDbrArray(dbr, count, temp.data());
+    value.replace(freeze(temp));
+}
+
+template<typename dbrT, typename pvT>
+void run(const char *dbrName, const char *pvName, size_t count, bool shared, double duration)
+{
+    std::vector<dbrT> dbr(count);
+    for(size_t i=0; i<count; i++)
+        dbr[i] = dbrT(i%100u);
+
+    typename pvT::shared_pointer value(pvd::getPVDataCreate()->createPVScalarArray<pvT>());
+
+    double rate[2];
+    for(unsigned method=0; method<2u; method++) {
+        typename pvT::const_svector held;
+        size_t nelem = 0u;
+        epicsTimeStamp start, now;
+        epicsTimeGetCurrent(&start);
+        do {
+            for(unsigned n=0; n<16u; n++) {
+                if(method==0u)
+                    copyOld(&dbr[0], count, *value);
+                else
+                    copyNew(&dbr[0], count, *value);
+                if(shared)
+                    held = value->view();
+                nelem += count;
+            }
+            epicsTimeGetCurrent(&now);
+        } while(epicsTimeDiffInSeconds(&now, &start) < duration);
+        rate[method] = nelem/epicsTimeDiffInSeconds(&now, &start);
+
+        if(value->view().size()!=count || value->view()[count-1u]!=typename pvT::value_type(dbr[count-1u]))
+            throw std::logic_error("Wrong result");
+    }
+
+    printf("%s %s %zu %s %.0f %.0f\n", dbrName, pvName, count, shared ? "shared" : "unique",
+           rate[0], rate[1]);
+}
+
+void usage()
+{
+    fprintf(stderr, "\nUsage: testDbrConvert [options]\n\n"
+            "  -h: Help: Print this message\n"
+            "options:\n"
+            "  -n <count>:        array length, may be repeated.  default is 16, 1024, 65536, and 1048576\n"
+            "  -d <sec>:          duration of each, default is %.1f\n\n",
+            DEFAULT_DURATION);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::vector<size_t> counts;
+    double duration = DEFAULT_DURATION;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "hn:d:")) != -1) {
+        switch(opt) {
+        case 'n': counts.push_back(atoi(optarg)); break;
+        case 'd': duration = atof(optarg); break;
+        case 'h': usage(); return 0;
+        default: usage(); return 1;
+        }
+    }
+
+    if(counts.empty()) {
+        counts.push_back(16u);
+        counts.push_back(1024u);
+        counts.push_back(65536u);
+        counts.push_back(1048576u);
+    }
+
+    for(size_t i=0; i<counts.size(); i++) {
+        if(counts[i]<1u) {
+            fprintf(stderr, "Invalid options\n");
+            return 1;
+        }
+    }
+
+    try {
+        printf("# dbr pvdata length storage old/s new/s\n");
+        for(size_t i=0; i<counts.size(); i++) {
+            for(unsigned shared=0; shared<2u; shared++) {
+                run<dbr_double_t, pvd::PVDoubleArray>("DOUBLE", "double", counts[i], shared, duration);
+                run<dbr_float_t, pvd::PVFloatArray>("FLOAT", "float", counts[i], shared, duration);
+                run<dbr_long_t, pvd::PVIntArray>("LONG", "int", counts[i], shared, duration);
+                run<dbr_long_t, pvd::PVUIntArray>("LONG", "uint", counts[i], shared, duration);
+                run<dbr_short_t, pvd::PVUShortArray>("SHORT", "ushort", counts[i], shared, duration);
+                run<dbr_char_t, pvd::PVByteArray>("CHAR", "byte", counts[i], shared, duration);
+                run<dbr_double_t, pvd::PVLongArray>("DOUBLE", "long", counts[i], shared, duration);
+            }
+        }
+
+    }catch(std::exception& e){
+        std::cerr<<"Error: "<<e.what()<<"\n";
+        return 1;
+    }
+    return 0;
+}